@@ -0,0 +1,115 @@
+/**
+ * Hash Benchmark
+ *
+ * Runs the same script-level hash (h = (h * 33 ^ i) & 0xFFFFF) two ways:
+ *   - native:   with the bitwise/shift operators (SHL, BXOR, BAND)
+ *   - emulated: with DIV/MUL/SUB only, the way scripts had to do it before
+ *
+ * Both must produce the same hash; the interesting number is the speedup.
+ */
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/vm.h"
+#include <chrono>
+#include <iostream>
+
+static const int ITERATIONS = 2000;
+
+struct BenchResult {
+    int hash;
+    long long instructions;
+    double millis;
+    int checks;         // DIV / MOD / LOADARG safety checks compiled
+    int checksRemoved;  // ... of which range analysis dropped
+};
+
+static bool runScript(const std::string& source, BenchResult& result) {
+    Compiler compiler;
+    std::vector<std::string> bytecode = compiler.compile(source);
+    if (compiler.hadError()) {
+        for (const auto& error : compiler.getErrors()) {
+            std::cout << "  " << error << std::endl;
+        }
+        return false;
+    }
+
+    VM vm;
+    vm.trace = false;
+
+    auto start = std::chrono::steady_clock::now();
+    vm.run(bytecode);
+    auto end = std::chrono::steady_clock::now();
+
+    result.hash = vm.vars["h"];
+    result.checks = compiler.getStats().safetyChecks;
+    result.checksRemoved = compiler.getStats().checksRemoved;
+    result.instructions = vm.stats.instructions;
+    result.millis = std::chrono::duration<double, std::milli>(end - start).count();
+    return true;
+}
+
+int main() {
+    std::string n = std::to_string(ITERATIONS);
+
+    std::string native =
+        "TAKE h = 5381;\n"
+        "TAKE i = 0;\n"
+        "LOOP i < " + n + " {\n"
+        "    h = ((h << 5) + h ^ i) & 1048575;\n"
+        "    i = i + 1;\n"
+        "}\n";
+
+    // Same hash without bit operators: modulo by DIV/MUL/SUB and XOR
+    // one bit at a time
+    std::string emulated =
+        "TAKE h = 5381;\n"
+        "TAKE i = 0;\n"
+        "TAKE a = 0;\n"
+        "TAKE b = 0;\n"
+        "TAKE x = 0;\n"
+        "TAKE bit = 0;\n"
+        "LOOP i < " + n + " {\n"
+        "    a = h * 33;\n"
+        "    a = a - (a / 1048576) * 1048576;\n"
+        "    b = i;\n"
+        "    x = 0;\n"
+        "    bit = 1;\n"
+        "    LOOP bit < 1048576 {\n"
+        "        IF a - (a / 2) * 2 != b - (b / 2) * 2 {\n"
+        "            x = x + bit;\n"
+        "        }\n"
+        "        a = a / 2;\n"
+        "        b = b / 2;\n"
+        "        bit = bit * 2;\n"
+        "    }\n"
+        "    h = x;\n"
+        "    i = i + 1;\n"
+        "}\n";
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "   CINEBREW Hash Benchmark (" << ITERATIONS << " rounds)" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    BenchResult fast, slow;
+    if (!runScript(native, fast) || !runScript(emulated, slow)) {
+        std::cout << "❌ FAILED: benchmark script did not compile" << std::endl;
+        return 1;
+    }
+
+    std::cout << "native:   hash=" << fast.hash << "  " << fast.instructions
+              << " instructions  " << fast.millis << " ms" << std::endl;
+    std::cout << "emulated: hash=" << slow.hash << "  " << slow.instructions
+              << " instructions  " << slow.millis << " ms" << std::endl;
+    std::cout << "          safety checks removed: " << slow.checksRemoved << " / "
+              << slow.checks << std::endl;
+
+    if (fast.hash != slow.hash) {
+        std::cout << "❌ FAILED: hashes differ" << std::endl;
+        return 1;
+    }
+
+    std::cout << "speedup:  " << slow.millis / fast.millis << "x ("
+              << (double)slow.instructions / fast.instructions
+              << "x fewer instructions)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * Loop Benchmark
+ *
+ * Runs small loop kernels twice:
+ *   - before: compiled without optimization (straight CodeGen)
+ *   - after:  the default optimized build (SSA IR with the loop passes:
+ *             unrolling, promotion of globals, invariant code motion,
+ *             strength reduction)
+ *
+ * Both builds must leave the same values in every script variable; the
+ * interesting numbers are the instructions executed and the time.
+ */
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/vm.h"
+#include <chrono>
+#include <iostream>
+
+static const int ITERATIONS = 2000;
+
+struct BenchResult {
+    std::map<std::string, int> vars;  // Script variables (hidden "__" ones left out)
+    long long instructions;
+    double millis;
+};
+
+static bool runScript(const std::string& source, bool optimize, BenchResult& result) {
+    CompilerOptions options;
+    options.optLevel = optimize ? 2 : 0;
+    Compiler compiler(options);
+    std::vector<std::string> bytecode = compiler.compile(source);
+    if (compiler.hadError()) {
+        for (const auto& error : compiler.getErrors()) {
+            std::cout << "  " << error << std::endl;
+        }
+        return false;
+    }
+
+    VM vm;
+    vm.trace = false;
+
+    auto start = std::chrono::steady_clock::now();
+    vm.run(bytecode);
+    auto end = std::chrono::steady_clock::now();
+
+    result.vars.clear();
+    for (const auto& var : vm.vars) {
+        if (var.first.compare(0, 2, "__") != 0) result.vars[var.first] = var.second;
+    }
+    result.instructions = vm.stats.instructions;
+    result.millis = std::chrono::duration<double, std::milli>(end - start).count();
+    return true;
+}
+
+struct Kernel {
+    const char* name;
+    std::string source;
+};
+
+int main() {
+    std::string n = std::to_string(ITERATIONS);
+
+    std::vector<Kernel> kernels = {
+        // (scale + 2) does not change inside the loop
+        {"invariant", "TAKE scale = 3;\n"
+                      "scale = scale * 2;\n"
+                      "TAKE sum = 0;\n"
+                      "TAKE i = 0;\n"
+                      "LOOP i < " + n + " {\n"
+                      "    sum = sum + i * (scale + 2);\n"
+                      "    i = i + 1;\n"
+                      "}\n"},
+
+        // (k * 12 + 7) * 4 becomes an induction variable of its own
+        {"affine", "TAKE sum = 0;\n"
+                   "FOR k = 1 TO " + n + " {\n"
+                   "    sum = (sum + (k * 12 + 7) * 4) & 1048575;\n"
+                   "}\n"},
+
+        // The inner loop always runs 4 times: unrolled
+        {"unroll", "TAKE total = 0;\n"
+                   "FOR i = 1 TO " + std::to_string(ITERATIONS / 4) + " {\n"
+                   "    FOR j = 1 TO 4 {\n"
+                   "        total = total + i * j;\n"
+                   "    }\n"
+                   "}\n"},
+
+        // Address arithmetic over a 40-column grid: row * 40 is hoisted
+        // out of the inner loop, the rest is reduced
+        {"stride", "TAKE sum = 0;\n"
+                   "TAKE base = 4096;\n"
+                   "FOR row = 0 TO " + std::to_string(ITERATIONS / 40 - 1) + " {\n"
+                   "    FOR col = 0 TO 39 {\n"
+                   "        sum = (sum + ((row * 40 + col) * 4 + base)) & 1048575;\n"
+                   "    }\n"
+                   "}\n"},
+    };
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "   CINEBREW Loop Benchmark (" << ITERATIONS << " iterations)" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    bool ok = true;
+    for (const Kernel& kernel : kernels) {
+        BenchResult before, after;
+        if (!runScript(kernel.source, false, before) || !runScript(kernel.source, true, after)) {
+            std::cout << "❌ FAILED: " << kernel.name << " did not compile" << std::endl;
+            return 1;
+        }
+
+        std::cout << kernel.name << ":" << std::endl;
+        std::cout << "  before: " << before.instructions << " instructions  "
+                  << before.millis << " ms" << std::endl;
+        std::cout << "  after:  " << after.instructions << " instructions  "
+                  << after.millis << " ms" << std::endl;
+
+        if (before.vars != after.vars) {
+            std::cout << "  ❌ FAILED: variables differ" << std::endl;
+            ok = false;
+            continue;
+        }
+        std::cout << "  speedup: " << before.millis / after.millis << "x ("
+                  << (double)before.instructions / after.instructions
+                  << "x fewer instructions)" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
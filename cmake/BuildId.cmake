@@ -0,0 +1,31 @@
+# CineBrew build id
+#
+#   cmake -DSOURCE_DIR=<src> -DOUTPUT=<header> -P BuildId.cmake
+#
+# Writes <header> defining CINEBREW_BUILD_ID: a hash of every source file
+# the generated bytecode depends on (compiler, VM, runtime). Compiled
+# programs cached by one build are never reused by another (see
+# src/compiler/compilation_cache.h). The header is only rewritten when the
+# id changes, so an unchanged tree does not recompile anything.
+
+file(GLOB_RECURSE sources RELATIVE "${SOURCE_DIR}"
+    "${SOURCE_DIR}/compiler/*.cpp" "${SOURCE_DIR}/compiler/*.h"
+    "${SOURCE_DIR}/vm/*.cpp" "${SOURCE_DIR}/vm/*.h"
+    "${SOURCE_DIR}/runtime/*.cpp" "${SOURCE_DIR}/runtime/*.h")
+list(SORT sources)
+
+set(digests "")
+foreach(source ${sources})
+    file(SHA256 "${SOURCE_DIR}/${source}" digest)
+    string(APPEND digests "${source} ${digest}\n")
+endforeach()
+string(SHA256 id "${digests}")
+string(SUBSTRING "${id}" 0 16 id)
+
+set(content "// Generated by cmake/BuildId.cmake\n#define CINEBREW_BUILD_ID \"${id}\"\n")
+if(EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" previous)
+endif()
+if(NOT "${previous}" STREQUAL "${content}")
+    file(WRITE "${OUTPUT}" "${content}")
+endif()
@@ -0,0 +1,65 @@
+# CineBrew ahead-of-time builds
+#
+#   cinebrew_add_aot_executable(<target> <script.cb> [OPT_LEVEL 0|1|2])
+#
+# Translates the script to C++ with `cinebrew aot` at build time (again
+# whenever the script or the compiler changes) and builds the result as a
+# native executable against libruntime: no VM, no bytecode at run time.
+#
+#   cinebrew_embed_script(<target> <script.cb> [NAME <namespace>] [OPT_LEVEL 0|1|2])
+#
+# Compiles the script to bytecode at build time (`cinebrew embed`) for a
+# host that runs it in the VM: <target> can #include "<namespace>.h" and
+# load <namespace>::program with Bytecode::fromEmbedded(). NAME defaults
+# to the script's file name. Builds never use the user's compilation
+# cache (--no-cache): the header always comes from the cinebrew just built.
+#
+# The optimization level defaults to 2, as for `cinebrew run`.
+
+set(CINEBREW_AOT_INCLUDE_DIR "${CMAKE_CURRENT_LIST_DIR}/../src")
+
+function(cinebrew_add_aot_executable target script)
+    cmake_parse_arguments(AOT "" "OPT_LEVEL" "" ${ARGN})
+    if(NOT DEFINED AOT_OPT_LEVEL)
+        set(AOT_OPT_LEVEL 2)
+    endif()
+
+    get_filename_component(source "${script}" ABSOLUTE)
+    set(generated "${CMAKE_CURRENT_BINARY_DIR}/${target}.aot.cpp")
+    add_custom_command(
+        OUTPUT "${generated}"
+        COMMAND cinebrew aot "${source}" -o "${generated}" -O${AOT_OPT_LEVEL}
+        DEPENDS cinebrew "${source}"
+        COMMENT "Compiling ${script} to C++"
+        VERBATIM
+    )
+
+    add_executable(${target} "${generated}")
+    target_include_directories(${target} PRIVATE "${CINEBREW_AOT_INCLUDE_DIR}")
+    target_link_libraries(${target} runtime gui)
+endfunction()
+
+function(cinebrew_embed_script target script)
+    cmake_parse_arguments(EMBED "" "NAME;OPT_LEVEL" "" ${ARGN})
+    if(NOT DEFINED EMBED_OPT_LEVEL)
+        set(EMBED_OPT_LEVEL 2)
+    endif()
+    if(NOT DEFINED EMBED_NAME)
+        get_filename_component(EMBED_NAME "${script}" NAME_WE)
+    endif()
+
+    get_filename_component(source "${script}" ABSOLUTE)
+    set(directory "${CMAKE_CURRENT_BINARY_DIR}/cinebrew_embed")
+    set(generated "${directory}/${EMBED_NAME}.h")
+    add_custom_command(
+        OUTPUT "${generated}"
+        COMMAND ${CMAKE_COMMAND} -E make_directory "${directory}"
+        COMMAND cinebrew embed "${source}" -o "${generated}" --name ${EMBED_NAME} -O${EMBED_OPT_LEVEL} --no-cache
+        DEPENDS cinebrew "${source}"
+        COMMENT "Compiling ${script} to embedded bytecode"
+        VERBATIM
+    )
+
+    target_sources(${target} PRIVATE "${generated}")
+    target_include_directories(${target} PRIVATE "${directory}")
+endfunction()
@@ -6,11 +6,23 @@
 #include "ast.h"
 #include <sstream>
 
+std::string valueTypeToString(ValueType type) {
+    switch (type) {
+        case ValueType::INT: return "INT";
+        case ValueType::FLOAT: return "FLOAT";
+        case ValueType::FIXED: return "FIXED";
+    }
+    return "UNKNOWN";
+}
+
 // ============================================================================
 // EXPRESSION TO STRING
 // ============================================================================
 
 std::string LiteralExpr::toString() const {
+    if (token.type == TokenType::FIXED_NUMBER) {
+        return value + "q";
+    }
     return value;
 }
 
@@ -22,6 +34,10 @@ std::string BinaryExpr::toString() const {
     return "(" + left->toString() + " " + op.lexeme + " " + right->toString() + ")";
 }
 
+std::string LogicalExpr::toString() const {
+    return "(" + left->toString() + " " + op.lexeme + " " + right->toString() + ")";
+}
+
 std::string UnaryExpr::toString() const {
     return "(" + op.lexeme + right->toString() + ")";
 }
@@ -36,6 +52,20 @@ std::string CallExpr::toString() const {
     return result;
 }
 
+std::string ObjectExpr::toString() const {
+    std::string result = "{";
+    for (size_t i = 0; i < fieldNames.size(); i++) {
+        if (i > 0) result += ", ";
+        result += fieldNames[i].lexeme + ": " + fieldValues[i]->toString();
+    }
+    result += "}";
+    return result;
+}
+
+std::string PropertyExpr::toString() const {
+    return object->toString() + "." + name.lexeme;
+}
+
 // ============================================================================
 // STATEMENT TO STRING
 // ============================================================================
@@ -53,6 +83,10 @@ std::string AssignmentStmt::toString() const {
     return name.lexeme + " = " + value->toString() + ";";
 }
 
+std::string PropertyAssignmentStmt::toString() const {
+    return object->toString() + "." + name.lexeme + " = " + value->toString() + ";";
+}
+
 std::string ExpressionStmt::toString() const {
     return expression->toString() + ";";
 }
@@ -70,10 +104,35 @@ std::string IfStmt::toString() const {
     return result;
 }
 
+std::string MatchStmt::toString() const {
+    std::string result = keyword.lexeme + " " + subject->toString() + " {";
+    for (const auto& c : cases) {
+        result += " CASE ";
+        for (size_t i = 0; i < c.values.size(); i++) {
+            if (i > 0) result += ", ";
+            result += c.values[i].lexeme;
+        }
+        result += " " + c.body->toString();
+    }
+    if (elseBranch) {
+        result += " ELSE " + elseBranch->toString();
+    }
+    return result + " }";
+}
+
 std::string LoopStmt::toString() const {
     return keyword.lexeme + " " + condition->toString() + " " + body->toString();
 }
 
+std::string ForStmt::toString() const {
+    std::string result = keyword.lexeme + " " + variable.lexeme + " = " + start->toString() +
+                         " TO " + limit->toString();
+    if (step) {
+        result += " STEP " + step->toString();
+    }
+    return result + " " + body->toString();
+}
+
 std::string BreakStmt::toString() const {
     return keyword.lexeme + ";";
 }
@@ -102,6 +161,9 @@ std::string BlockStmt::toString() const {
 
 std::string FunctionStmt::toString() const {
     std::string result = keyword.lexeme + " " + name.lexeme + "(";
+    if (hint != TokenType::SCENE) {
+        result = tokenTypeToString(hint) + " " + result;
+    }
     for (size_t i = 0; i < parameters.size(); i++) {
         if (i > 0) result += ", ";
         result += parameters[i].lexeme;
@@ -40,6 +40,25 @@ class Expr;
 class Stmt;
 class BlockStmt;  // Forward declaration for BlockStmt
 
+// ============================================================================
+// VALUE TYPES
+// ============================================================================
+
+/**
+ * Static type of an expression, inferred by the semantic analyzer.
+ * 
+ * Every value is 32 bits on the VM stack; the type only decides which
+ * opcodes the code generator picks (ADD vs FADD vs XMUL), so typed code
+ * never checks tags at runtime.
+ */
+enum class ValueType {
+    INT,    // 32-bit signed integer (also booleans, object handles)
+    FLOAT,  // IEEE-754 single precision, stored as its bit pattern
+    FIXED   // 16.16 fixed point, stored as a raw integer
+};
+
+std::string valueTypeToString(ValueType type);
+
 // ============================================================================
 // EXPRESSION NODES
 // ============================================================================
@@ -49,6 +68,8 @@ class BlockStmt;  // Forward declaration for BlockStmt
  */
 class Expr {
 public:
+    ValueType type = ValueType::INT;  // Set by the semantic analyzer
+    
     virtual ~Expr() = default;
     virtual std::string toString() const = 0;
 };
@@ -87,6 +108,7 @@ public:
     std::unique_ptr<Expr> left;
     Token op;
     std::unique_ptr<Expr> right;
+    ValueType operandType = ValueType::INT;  // Type both sides are converted to
     
     BinaryExpr(std::unique_ptr<Expr> l, const Token& o, std::unique_ptr<Expr> r)
         : left(std::move(l)), op(o), right(std::move(r)) {}
@@ -94,6 +116,24 @@ public:
     std::string toString() const override;
 };
 
+/**
+ * Logical expression: a && b, a OR b
+ * 
+ * Kept apart from BinaryExpr because the right side is evaluated only
+ * when the left side does not already decide the result.
+ */
+class LogicalExpr : public Expr {
+public:
+    std::unique_ptr<Expr> left;
+    Token op;  // AND or OR
+    std::unique_ptr<Expr> right;
+    
+    LogicalExpr(std::unique_ptr<Expr> l, const Token& o, std::unique_ptr<Expr> r)
+        : left(std::move(l)), op(o), right(std::move(r)) {}
+    
+    std::string toString() const override;
+};
+
 /**
  * Unary expression: -x, !x
  */
@@ -122,6 +162,39 @@ public:
     std::string toString() const override;
 };
 
+/**
+ * Object literal: {} or { x: 1, y: 2 }
+ * 
+ * Fields are added in source order, so two literals with the same field
+ * order end up sharing a hidden-class shape in the VM.
+ */
+class ObjectExpr : public Expr {
+public:
+    Token brace;  // Opening '{' (for error reporting)
+    std::vector<Token> fieldNames;
+    std::vector<std::unique_ptr<Expr>> fieldValues;
+    
+    ObjectExpr(const Token& b, std::vector<Token> names,
+               std::vector<std::unique_ptr<Expr>> values)
+        : brace(b), fieldNames(std::move(names)), fieldValues(std::move(values)) {}
+    
+    std::string toString() const override;
+};
+
+/**
+ * Property access expression: player.x
+ */
+class PropertyExpr : public Expr {
+public:
+    std::unique_ptr<Expr> object;
+    Token name;  // Property name
+    
+    PropertyExpr(std::unique_ptr<Expr> obj, const Token& n)
+        : object(std::move(obj)), name(n) {}
+    
+    std::string toString() const override;
+};
+
 // ============================================================================
 // STATEMENT NODES
 // ============================================================================
@@ -140,13 +213,16 @@ public:
  */
 class DeclarationStmt : public Stmt {
 public:
-    Token keyword;  // TAKE
+    Token keyword;  // TAKE or CONST
     Token name;
     std::unique_ptr<Expr> initializer;
     
     DeclarationStmt(const Token& kw, const Token& n, std::unique_ptr<Expr> init)
         : keyword(kw), name(n), initializer(std::move(init)) {}
     
+    // CONST: never reassigned, every use is replaced by the folded value
+    bool isConst() const { return keyword.type == TokenType::CONST; }
+    
     std::string toString() const override;
 };
 
@@ -157,6 +233,7 @@ class AssignmentStmt : public Stmt {
 public:
     Token name;
     std::unique_ptr<Expr> value;
+    ValueType targetType = ValueType::INT;  // Declared type of the variable
     
     AssignmentStmt(const Token& n, std::unique_ptr<Expr> val)
         : name(n), value(std::move(val)) {}
@@ -164,6 +241,24 @@ public:
     std::string toString() const override;
 };
 
+/**
+ * Property assignment statement: player.x = 5;
+ * 
+ * Adds the property if the object does not have it yet.
+ */
+class PropertyAssignmentStmt : public Stmt {
+public:
+    std::unique_ptr<Expr> object;
+    Token name;  // Property name
+    std::unique_ptr<Expr> value;
+    
+    PropertyAssignmentStmt(std::unique_ptr<Expr> obj, const Token& n,
+                           std::unique_ptr<Expr> val)
+        : object(std::move(obj)), name(n), value(std::move(val)) {}
+    
+    std::string toString() const override;
+};
+
 /**
  * Expression statement: x + y; (result discarded)
  */
@@ -210,6 +305,38 @@ public:
     std::string toString() const override;
 };
 
+/**
+ * Multi-way branch:
+ * 
+ *   MATCH state {
+ *       CASE 0 { ... }
+ *       CASE 1, 2 { ... }
+ *       ELSE { ... }
+ *   }
+ * 
+ * Case values are integer literals; at most one arm runs (no fall-through).
+ */
+class MatchStmt : public Stmt {
+public:
+    struct Case {
+        std::vector<Token> values;       // Literal tokens as written
+        std::vector<int> constants;      // Parsed values (filled in by semantic analysis)
+        std::unique_ptr<BlockStmt> body;
+    };
+    
+    Token keyword;  // MATCH
+    std::unique_ptr<Expr> subject;
+    std::vector<Case> cases;
+    std::unique_ptr<BlockStmt> elseBranch;  // Can be null
+    
+    MatchStmt(const Token& kw, std::unique_ptr<Expr> subj, std::vector<Case> c,
+              std::unique_ptr<BlockStmt> elseBr)
+        : keyword(kw), subject(std::move(subj)), cases(std::move(c)),
+          elseBranch(std::move(elseBr)) {}
+    
+    std::string toString() const override;
+};
+
 /**
  * Loop statement: LOOP condition { ... }
  */
@@ -226,6 +353,35 @@ public:
     std::string toString() const override;
 };
 
+/**
+ * Counted loop: FOR i = start TO limit STEP step { ... }
+ * 
+ * The bounds are inclusive and evaluated once, before the first iteration.
+ * The loop variable cannot be assigned inside the body, so it is a
+ * canonical induction variable: start, start + step, ... up to limit.
+ */
+class ForStmt : public Stmt {
+public:
+    Token keyword;   // FOR
+    Token variable;  // Induction variable
+    std::unique_ptr<Expr> start;
+    std::unique_ptr<Expr> limit;
+    std::unique_ptr<Expr> step;  // nullptr means STEP 1
+    std::unique_ptr<BlockStmt> body;
+    
+    // Induction info (filled in by semantic analysis)
+    bool constantStep = true;  // Step known at compile time
+    int stepValue = 1;         // Valid when constantStep
+    
+    ForStmt(const Token& kw, const Token& var, std::unique_ptr<Expr> s,
+            std::unique_ptr<Expr> l, std::unique_ptr<Expr> st,
+            std::unique_ptr<BlockStmt> b)
+        : keyword(kw), variable(var), start(std::move(s)), limit(std::move(l)),
+          step(std::move(st)), body(std::move(b)) {}
+    
+    std::string toString() const override;
+};
+
 /**
  * Break statement: BREAK;
  */
@@ -286,10 +442,20 @@ public:
     Token name;
     std::vector<Token> parameters;
     std::unique_ptr<BlockStmt> body;
+    TokenType hint;  // INLINE / NOINLINE / MEMO prefix, SCENE if none
+    bool pure;       // No effects, result depends only on the arguments (set by semantic analysis)
+    bool memoize;    // Pure and recursive or MEMO: results are cached by the VM
+    
+    // Parsed lazily (Parser::setLazy): `body` is null until the SCENE is
+    // first called, its tokens are [bodyStart, bodyEnd) of the stream
+    int bodyStart;
+    int bodyEnd;
+    std::vector<Token> forVariables;  // FOR variables of the skipped body
     
     FunctionStmt(const Token& kw, const Token& n,
                  std::vector<Token> params, std::unique_ptr<BlockStmt> b)
-        : keyword(kw), name(n), parameters(std::move(params)), body(std::move(b)) {}
+        : keyword(kw), name(n), parameters(std::move(params)), body(std::move(b)),
+          hint(TokenType::SCENE), pure(false), memoize(false), bodyStart(-1), bodyEnd(-1) {}
     
     std::string toString() const override;
 };
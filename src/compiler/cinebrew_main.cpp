@@ -1,22 +1,242 @@
 // Minimal CLI entrypoint for CineBrew
 // Usage:
-//   cinebrew run <file>
-//   cinebrew <file>
+//   cinebrew run <file> [options]
+//   cinebrew <file> [options]
+//   cinebrew compile <file> -o <out.cbc> [-O0|-O1|-O2]
+//   cinebrew aot <file> -o <out.cpp> [-O0|-O1|-O2]
+//   cinebrew embed <file> -o <out.h> [--name <namespace>] [-O0|-O1|-O2]
+//
+// A <file> ending in .cbc is a compiled program: it is mapped and run as is
+// (the compiler options do not apply to it).
+//
+// Options:
+//   -O0 | -O1 | -O2     optimization level (default -O2, see compiler.h)
+//   --stats             compiler and VM statistics after the run
+//   --no-cache          always compile (see compilation_cache.h)
+//   --lazy              run: compile each SCENE on its first call (-O0, see compiler.h)
+//   --inline-report     the inlining decision of every SCENE call
+//   --pass-report       time, size and changes of every compiler pass
+//   --write-profile <out>  run an instrumented build and save what it did
+//   --profile <in>      compile for a saved run (see profile.h)
+//   -o <out.cbc>        compile: where to write the bytecode file (see bytecode_file.h)
+//   -o <out.cpp>        aot: where to write the C++ source (see cpp_backend.h)
+//                       embed: where to write the bytecode header (see bytecode.h)
+//   --name <namespace>  embed: namespace of the arrays (default: the file name)
 
 #include "compiler.h"
 #include "../vm/vm.h"
+#include <cctype>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 static void printUsage() {
-    std::cerr << "Usage:\n  cinebrew run <file>\n  cinebrew <file>\n";
+    std::cerr << "Usage:\n  cinebrew run <file> [options]\n  cinebrew <file> [options]\n"
+                 "  cinebrew compile <file> -o <out.cbc> [-O0|-O1|-O2]\n"
+                 "  cinebrew aot <file> -o <out.cpp> [-O0|-O1|-O2]\n"
+                 "  cinebrew embed <file> -o <out.h> [--name <namespace>] [-O0|-O1|-O2]\n"
+                 "Options:\n"
+                 "  -O0 | -O1 | -O2        optimization level (default -O2)\n"
+                 "  --stats                compiler and VM statistics\n"
+                 "  --no-cache             always compile, do not use the compilation cache\n"
+                 "  --lazy                 compile each SCENE on its first call (implies -O0)\n"
+                 "  --inline-report        inlining decision of every SCENE call\n"
+                 "  --pass-report          time, size and changes of every compiler pass\n"
+                 "  --write-profile <out>  run an instrumented build and save a profile\n"
+                 "  --profile <in>         optimize for a saved profile\n"
+                 "  -o <out.cbc>           compile: write the bytecode for `cinebrew run <out.cbc>`\n"
+                 "  -o <out.cpp>           aot: write C++ to build against libruntime\n"
+                 "  -o <out.h>             embed: write the bytecode as a constexpr header\n"
+                 "  --name <namespace>     embed: namespace of the arrays\n";
 }
 
 int main(int argc, char* argv[]) {
-    if (argc == 2 || (argc == 3 && std::string(argv[1]) == "run")) {
-        const char* path = (argc == 2) ? argv[1] : argv[2];
+    // Split flags from positional arguments
+    bool showStats = false;
+    bool showInlining = false;
+    bool showPasses = false;
+    bool useCache = true;
+    bool lazy = false;
+    int optLevel = 2;
+    std::string writeProfile, readProfile, output, embedName;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--stats") {
+            showStats = true;
+        } else if (arg == "--inline-report") {
+            showInlining = true;
+        } else if (arg == "--pass-report") {
+            showPasses = true;
+        } else if (arg == "--no-cache") {
+            useCache = false;
+        } else if (arg == "--lazy") {
+            lazy = true;
+        } else if (arg == "-O0" || arg == "-O1" || arg == "-O2") {
+            optLevel = arg[2] - '0';
+        } else if ((arg == "--write-profile" || arg == "--profile") && i + 1 < argc) {
+            (arg == "--profile" ? readProfile : writeProfile) = argv[++i];
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--name" && i + 1 < argc) {
+            embedName = argv[++i];
+        } else if (arg.rfind("-", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage();
+            return 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    // Shared by every compile below (not aot: it does not make bytecode)
+    CompilationCache cache(useCache ? CompilationCache::defaultDirectory() : "");
+    CompilationCache* sharedCache = cache.directory().empty() ? nullptr : &cache;
+
+    if (args.size() == 2 && args[0] == "compile" && !output.empty()) {
+        const std::string& path = args.back();
+
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Error: could not open file: " << path << std::endl;
+            return 1;
+        }
+
+        std::stringstream buf;
+        buf << file.rdbuf();
+
+        CompilerOptions options;
+        options.optLevel = optLevel;
+        options.cache = sharedCache;
+        Compiler compiler(options);
+        const Bytecode& program = compiler.compileProgram(buf.str());
+        if (compiler.hadError()) {
+            std::cerr << "Compilation errors:\n";
+            for (const auto& e : compiler.getErrors()) std::cerr << "  " << e << std::endl;
+            return 1;
+        }
+
+        std::string error;
+        if (!BytecodeFile::write(program, output, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+        if (showPasses) {
+            compiler.printPassReport();
+        }
+        if (showStats) {
+            compiler.printStats();
+        }
+        return 0;
+    }
+
+    if (args.size() == 2 && args[0] == "aot" && !output.empty()) {
+        const std::string& path = args.back();
+
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Error: could not open file: " << path << std::endl;
+            return 1;
+        }
+
+        std::stringstream buf;
+        buf << file.rdbuf();
+
+        CompilerOptions options;
+        options.optLevel = optLevel;
+        Compiler compiler(options);
+        std::string cpp = compiler.compileToCpp(buf.str(), path);
+        if (compiler.hadError()) {
+            std::cerr << "Compilation errors:\n";
+            for (const auto& e : compiler.getErrors()) std::cerr << "  " << e << std::endl;
+            return 1;
+        }
+
+        std::ofstream out(output);
+        out << cpp;
+        if (!out) {
+            std::cerr << "Error: could not write file: " << output << std::endl;
+            return 1;
+        }
+        if (showPasses) {
+            compiler.printPassReport();
+        }
+        return 0;
+    }
+
+    if (args.size() == 2 && args[0] == "embed" && !output.empty()) {
+        const std::string& path = args.back();
+
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Error: could not open file: " << path << std::endl;
+            return 1;
+        }
+
+        std::stringstream buf;
+        buf << file.rdbuf();
+
+        // Default namespace: the file name without directory and extension
+        if (embedName.empty()) {
+            embedName = path.substr(path.find_last_of("/\\") + 1);
+            embedName = embedName.substr(0, embedName.find('.'));
+            for (char& c : embedName) {
+                if (!std::isalnum(static_cast<unsigned char>(c))) c = '_';
+            }
+            if (embedName.empty() || std::isdigit(static_cast<unsigned char>(embedName[0]))) {
+                embedName = "script_" + embedName;
+            }
+        }
+
+        CompilerOptions options;
+        options.optLevel = optLevel;
+        options.cache = sharedCache;
+        Compiler compiler(options);
+        const Bytecode& program = compiler.compileProgram(buf.str());
+        if (compiler.hadError()) {
+            std::cerr << "Compilation errors:\n";
+            for (const auto& e : compiler.getErrors()) std::cerr << "  " << e << std::endl;
+            return 1;
+        }
+
+        std::ofstream out(output);
+        out << program.toHeader(embedName, path);
+        if (!out) {
+            std::cerr << "Error: could not write file: " << output << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (args.size() == 1 || (args.size() == 2 && args[0] == "run")) {
+        const std::string& path = args.back();
+
+        if (path.size() > 4 && path.compare(path.size() - 4, 4, ".cbc") == 0) {
+            if (!writeProfile.empty() || !readProfile.empty()) {
+                std::cerr << "Error: profiles need the source; run the .cb file" << std::endl;
+                return 1;
+            }
+            BytecodeFile compiled;
+            if (!compiled.open(path)) {
+                std::cerr << "Error: " << compiled.getError() << std::endl;
+                return 1;
+            }
+
+            std::cout << "Running: " << path << std::endl;
+            VM vm;
+            try {
+                vm.run(compiled);
+            } catch (const std::exception& ex) {
+                std::cerr << "Runtime error: " << ex.what() << std::endl;
+                return 1;
+            }
+            if (showStats) {
+                vm.printStats();
+            }
+            return 0;
+        }
 
         std::ifstream file(path);
         if (!file.is_open()) {
@@ -29,12 +249,31 @@ int main(int argc, char* argv[]) {
         std::string source = buf.str();
         file.close();
 
+        if (lazy && (!writeProfile.empty() || !readProfile.empty())) {
+            std::cerr << "Error: --lazy runs -O0 code, profiles are for -O1 and up" << std::endl;
+            return 1;
+        }
+
         std::cout << "Compiling: " << path << std::endl;
 
-        Compiler compiler;
-        std::vector<std::string> bytecode;
+        CompilerOptions options;
+        options.optLevel = lazy ? 0 : optLevel;
+        options.cache = sharedCache;
+        options.lazy = lazy;
+        Profile profile;
+        if (!readProfile.empty()) {
+            if (!profile.load(readProfile)) {
+                std::cerr << "Error: " << profile.getError() << std::endl;
+                return 1;
+            }
+            options.profile = &profile;
+        }
+        options.instrument = !writeProfile.empty();
+
+        Compiler compiler(options);
+        const Bytecode* program = nullptr;
         try {
-            bytecode = compiler.compile(source);
+            program = &compiler.compileProgram(source);
         } catch (const std::exception& ex) {
             std::cerr << "Compilation failed: " << ex.what() << std::endl;
             return 1;
@@ -46,20 +285,45 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
-        if (bytecode.empty()) {
+        if (program->empty()) {
             std::cerr << "No bytecode produced." << std::endl;
             return 1;
         }
 
+        if (showInlining) {
+            compiler.printInlineReport();
+        }
+        if (showPasses) {
+            compiler.printPassReport();
+        }
+
         std::cout << "Running..." << std::endl;
         VM vm;
+        vm.profiling = options.instrument;
+        vm.compileScene = [&compiler](const std::string& scene, Bytecode& code) {
+            return compiler.compileScene(scene, code);
+        };
         try {
-            vm.run(bytecode);
+            vm.run(*program);
         } catch (const std::exception& ex) {
             std::cerr << "Runtime error: " << ex.what() << std::endl;
+            for (const auto& e : compiler.getErrors()) std::cerr << "  " << e << std::endl;  // --lazy
             return 1;
         }
 
+        if (!writeProfile.empty()) {
+            if (!Profile::fromRun(vm.profile, *program).save(writeProfile)) {
+                std::cerr << "Error: could not write profile: " << writeProfile << std::endl;
+                return 1;
+            }
+            std::cout << "Profile written: " << writeProfile << std::endl;
+        }
+
+        if (showStats) {
+            compiler.printStats();
+            vm.printStats();
+        }
+
         return 0;
     }
 
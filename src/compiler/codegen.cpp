@@ -7,12 +7,16 @@
 #include "codegen.h"
 #include <sstream>
 #include <iostream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 
 // ============================================================================
 // CONSTRUCTOR
 // ============================================================================
 
-CodeGenerator::CodeGenerator() : hadError_(false) {
+CodeGenerator::CodeGenerator()
+    : forCounter_(0), matchCounter_(0), propertySiteCounter_(0), hadError_(false) {
 }
 
 // ============================================================================
@@ -29,26 +33,223 @@ void CodeGenerator::error(const std::string& message) {
 // BYTECODE GENERATION
 // ============================================================================
 
-void CodeGenerator::emit(const std::string& instruction) {
-    bytecode_.push_back(instruction);
+void CodeGenerator::emit(Op op, int a, int b) {
+    bytecode_.emit(op, a, b);
 }
 
-std::string CodeGenerator::newLabel(const std::string& prefix) {
-    int count = labelCounter_[prefix]++;
-    return prefix + "_" + std::to_string(count);
+void CodeGenerator::emitName(Op op, const std::string& name, int b) {
+    bytecode_.emit(op, bytecode_.symbol(name), b);
+}
+
+void CodeGenerator::emitJump(Op op, int label) {
+    bytecode_.emitJump(op, label);
+}
+
+// Labels are numbered, not named: "else_12" only exists in disassembly
+int CodeGenerator::newLabel(const char* prefix) {
+    return bytecode_.newLabel(prefix);
+}
+
+void CodeGenerator::placeLabel(int label) {
+    bytecode_.place(label);
+}
+
+int CodeGenerator::newPropertySite() {
+    // Every GETPROP/SETPROP gets its own inline-cache slot in the VM
+    return propertySiteCounter_++;
+}
+
+// ============================================================================
+// TYPED CODE
+// ============================================================================
+
+/**
+ * Convert the value on top of the stack from one static type to another.
+ * Nothing is emitted when the types already match.
+ */
+void CodeGenerator::emitConversion(ValueType from, ValueType to) {
+    Op opcode = conversionOp(from, to);
+    if (opcode != Op::NOP) emit(opcode);
+}
+
+Op CodeGenerator::conversionOp(ValueType from, ValueType to) {
+    if (from == ValueType::INT && to == ValueType::FLOAT) return Op::I2F;
+    if (from == ValueType::FLOAT && to == ValueType::INT) return Op::F2I;
+    if (from == ValueType::INT && to == ValueType::FIXED) return Op::I2X;
+    if (from == ValueType::FIXED && to == ValueType::INT) return Op::X2I;
+    if (from == ValueType::FLOAT && to == ValueType::FIXED) return Op::F2X;
+    if (from == ValueType::FIXED && to == ValueType::FLOAT) return Op::X2F;
+    return Op::NOP;
+}
+
+std::string CodeGenerator::conversionOpcode(ValueType from, ValueType to) {
+    return Bytecode::opName(conversionOp(from, to));
+}
+
+/**
+ * Pick the type-specialized variant of an integer opcode.
+ * 
+ *   FLOAT: ADD -> FADD, LT -> FLT, ...
+ *   FIXED: only MUL and DIV differ (XMUL, XDIV); addition and comparisons
+ *          on 16.16 values are plain integer operations.
+ */
+Op CodeGenerator::typedOp(Op op, ValueType type) {
+    if (type == ValueType::FLOAT) {
+        switch (op) {
+            case Op::ADD: return Op::FADD;
+            case Op::SUB: return Op::FSUB;
+            case Op::MUL: return Op::FMUL;
+            case Op::DIV: return Op::FDIV;
+            case Op::EQ: return Op::FEQ;
+            case Op::NE: return Op::FNE;
+            case Op::GT: return Op::FGT;
+            case Op::LT: return Op::FLT;
+            case Op::GE: return Op::FGE;
+            case Op::LE: return Op::FLE;
+            default: return op;
+        }
+    }
+    if (type == ValueType::FIXED && op == Op::MUL) return Op::XMUL;
+    if (type == ValueType::FIXED && op == Op::DIV) return Op::XDIV;
+    return op;
+}
+
+std::string CodeGenerator::typedOpcode(const std::string& opcode, ValueType type) {
+    Op op;
+    if (!Bytecode::lookupOp(opcode, op)) return opcode;
+    return Bytecode::opName(typedOp(op, type));
+}
+
+/**
+ * Push both operands of a binary expression, each converted to the
+ * operation's type.
+ */
+void CodeGenerator::emitOperands(BinaryExpr* expr) {
+    visitExpr(expr->left.get());
+    emitConversion(expr->left->type, expr->operandType);
+    visitExpr(expr->right.get());
+    emitConversion(expr->right->type, expr->operandType);
+}
+
+// ============================================================================
+// CONDITIONS
+// ============================================================================
+
+/**
+ * Map a comparison operator to its (INT) opcode.
+ * Returns false if `op` is not a comparison.
+ */
+bool CodeGenerator::comparisonOp(const std::string& op, Op& opcode) {
+    if (op == "==") opcode = Op::EQ;
+    else if (op == "!=") opcode = Op::NE;
+    else if (op == ">") opcode = Op::GT;
+    else if (op == "<") opcode = Op::LT;
+    else if (op == ">=") opcode = Op::GE;
+    else if (op == "<=") opcode = Op::LE;
+    else return false;
+    return true;
+}
+
+bool CodeGenerator::comparisonOpcode(const std::string& op, std::string& opcode) {
+    Op compare;
+    if (!comparisonOp(op, compare)) return false;
+    opcode = Bytecode::opName(compare);
+    return true;
+}
+
+// The comparison that is true exactly when `opcode` is false
+Op CodeGenerator::invertComparison(Op opcode) {
+    switch (opcode) {
+        case Op::EQ: return Op::NE;
+        case Op::NE: return Op::EQ;
+        case Op::GT: return Op::LE;
+        case Op::LE: return Op::GT;
+        case Op::LT: return Op::GE;
+        default: return Op::LT;  // GE
+    }
+}
+
+std::string CodeGenerator::invertComparison(const std::string& opcode) {
+    Op op;
+    Bytecode::lookupOp(opcode, op);
+    return Bytecode::opName(invertComparison(op));
+}
+
+/**
+ * Jump to `label` when the condition is false, fall through when true.
+ * 
+ * && and || become jump chains, so their right side only runs when it
+ * can still change the outcome:
+ * 
+ *   IF a && b { ... }        IF a || b { ... }
+ *     a; JZ else               a; JNZ then
+ *     b; JZ else               b; JZ else
+ *     ...                    then: ...
+ */
+void CodeGenerator::emitJumpIfFalse(Expr* condition, int label) {
+    if (LogicalExpr* logical = dynamic_cast<LogicalExpr*>(condition)) {
+        if (logical->op.type == TokenType::AND) {
+            emitJumpIfFalse(logical->left.get(), label);
+            emitJumpIfFalse(logical->right.get(), label);
+        } else {
+            int trueLabel = newLabel("or_true");
+            emitJumpIfTrue(logical->left.get(), trueLabel);
+            emitJumpIfFalse(logical->right.get(), label);
+            placeLabel(trueLabel);
+        }
+        return;
+    }
+    
+    UnaryExpr* unary = dynamic_cast<UnaryExpr*>(condition);
+    if (unary && unary->op.type == TokenType::BANG) {
+        emitJumpIfTrue(unary->right.get(), label);
+        return;
+    }
+    
+    visitExpr(condition);
+    emitJump(Op::JZ, label);
+}
+
+// Mirror image of emitJumpIfFalse
+void CodeGenerator::emitJumpIfTrue(Expr* condition, int label) {
+    if (LogicalExpr* logical = dynamic_cast<LogicalExpr*>(condition)) {
+        if (logical->op.type == TokenType::OR) {
+            emitJumpIfTrue(logical->left.get(), label);
+            emitJumpIfTrue(logical->right.get(), label);
+        } else {
+            int falseLabel = newLabel("and_false");
+            emitJumpIfFalse(logical->left.get(), falseLabel);
+            emitJumpIfTrue(logical->right.get(), label);
+            placeLabel(falseLabel);
+        }
+        return;
+    }
+    
+    UnaryExpr* unary = dynamic_cast<UnaryExpr*>(condition);
+    if (unary && unary->op.type == TokenType::BANG) {
+        emitJumpIfFalse(unary->right.get(), label);
+        return;
+    }
+    
+    visitExpr(condition);
+    emitJump(Op::JNZ, label);
 }
 
 // ============================================================================
 // MAIN GENERATION FUNCTION
 // ============================================================================
 
-std::vector<std::string> CodeGenerator::generate(std::unique_ptr<Program>& program) {
-    bytecode_.clear();
-    labelCounter_.clear();
+Bytecode CodeGenerator::generate(std::unique_ptr<Program>& program) {
+    bytecode_ = Bytecode();
+    forCounter_ = 0;
+    matchCounter_ = 0;
+    propertySiteCounter_ = 0;
+    loops_.clear();
     hadError_ = false;
     errorMessage_ = "";
     
     visitProgram(program.get());
+    bytecode_.link();
     
     return bytecode_;
 }
@@ -58,26 +259,69 @@ std::vector<std::string> CodeGenerator::generate(std::unique_ptr<Program>& progr
 // ============================================================================
 
 void CodeGenerator::visitProgram(Program* program) {
-    // Generate code for all statements
+    // Generate top-level code first, then SCENE bodies after it, so the
+    // main program never falls through into a function body
+    std::vector<FunctionStmt*> functions;
     for (auto& stmt : program->statements) {
-        visitStmt(stmt.get());
+        if (FunctionStmt* func = dynamic_cast<FunctionStmt*>(stmt.get())) {
+            functions.push_back(func);
+        } else {
+            visitStmt(stmt.get());
+        }
+    }
+    
+    int halt = bytecode_.namedLabel("HALT");
+    bool lazy = false;
+    if (!functions.empty()) {
+        emitJump(Op::JMP, halt);
+        for (FunctionStmt* func : functions) {
+            visitFunction(func);
+            lazy = lazy || !func->body;
+        }
     }
     
     // Add HALT label at end
-    emit("HALT:");
+    placeLabel(halt);
+    
+    // SCENEs compiled lazily are appended after HALT: stop here
+    if (lazy) emit(Op::RET);
+}
+
+/**
+ * Lazy compilation: appends the code of a SCENE parsed (and analyzed)
+ * after generate() to `program`, the one generate() returned or the VM's
+ * copy of it, and links it. Returns the pc of the SCENE's label, -1 on
+ * error.
+ */
+int CodeGenerator::generateScene(FunctionStmt* stmt, Bytecode& program) {
+    std::swap(bytecode_, program);
+    hadError_ = false;
+    errorMessage_ = "";
+    visitFunction(stmt);
+    bytecode_.link();
+    std::swap(bytecode_, program);
+    return hadError_ ? -1 : program.findLabel(stmt->name.lexeme);
 }
 
 void CodeGenerator::visitStmt(Stmt* stmt) {
+    size_t start = bytecode_.size();
+    
     if (DeclarationStmt* decl = dynamic_cast<DeclarationStmt*>(stmt)) {
         visitDeclaration(decl);
     } else if (AssignmentStmt* assign = dynamic_cast<AssignmentStmt*>(stmt)) {
         visitAssignment(assign);
+    } else if (PropertyAssignmentStmt* propAssign = dynamic_cast<PropertyAssignmentStmt*>(stmt)) {
+        visitPropertyAssignment(propAssign);
     } else if (PrintStmt* print = dynamic_cast<PrintStmt*>(stmt)) {
         visitPrint(print);
     } else if (IfStmt* ifStmt = dynamic_cast<IfStmt*>(stmt)) {
         visitIf(ifStmt);
     } else if (LoopStmt* loop = dynamic_cast<LoopStmt*>(stmt)) {
         visitLoop(loop);
+    } else if (ForStmt* forStmt = dynamic_cast<ForStmt*>(stmt)) {
+        visitFor(forStmt);
+    } else if (MatchStmt* matchStmt = dynamic_cast<MatchStmt*>(stmt)) {
+        visitMatch(matchStmt);
     } else if (BreakStmt* brk = dynamic_cast<BreakStmt*>(stmt)) {
         visitBreak(brk);
     } else if (ContinueStmt* cont = dynamic_cast<ContinueStmt*>(stmt)) {
@@ -89,10 +333,15 @@ void CodeGenerator::visitStmt(Stmt* stmt) {
     } else if (BlockStmt* block = dynamic_cast<BlockStmt*>(stmt)) {
         visitBlock(block);
     } else if (ExpressionStmt* expr = dynamic_cast<ExpressionStmt*>(stmt)) {
+        // The result is not used: pop it, or a LOOP calling clearScreen()
+        // every frame grows the stack forever
         visitExpr(expr->expression.get());
-        // Expression result is on stack, but we discard it
-        // (In a more sophisticated system, we'd pop it)
+        emit(Op::POP);
     }
+    
+    // Every statement leaves the stack as it found it; the VM checks this
+    // at the first instruction of each one (debug builds)
+    if (bytecode_.size() > start) bytecode_.code[start].statement = true;
 }
 
 // ============================================================================
@@ -100,48 +349,71 @@ void CodeGenerator::visitStmt(Stmt* stmt) {
 // ============================================================================
 
 void CodeGenerator::visitDeclaration(DeclarationStmt* stmt) {
+    // Every use of a CONST was replaced by its value: nothing to store
+    if (stmt->isConst()) return;
+    
     // Generate code for initializer expression
     visitExpr(stmt->initializer.get());
     
     // Store in variable
-    emit("STORE " + stmt->name.lexeme);
+    emitName(Op::STORE, stmt->name.lexeme);
 }
 
 void CodeGenerator::visitAssignment(AssignmentStmt* stmt) {
-    // Generate code for value expression
+    // Generate code for value expression, converted to the variable's type
     visitExpr(stmt->value.get());
+    emitConversion(stmt->value->type, stmt->targetType);
     
-    // Store in variable
-    emit("STORE " + stmt->name.lexeme);
+    // Store in parameter slot or variable
+    auto param = params_.find(stmt->name.lexeme);
+    if (param != params_.end()) {
+        emit(Op::STOREARG, param->second);
+    } else {
+        emitName(Op::STORE, stmt->name.lexeme);
+    }
+}
+
+void CodeGenerator::visitPropertyAssignment(PropertyAssignmentStmt* stmt) {
+    // Stack: [obj, value] -> SETPROP -> []
+    visitExpr(stmt->object.get());
+    visitExpr(stmt->value.get());
+    emitConversion(stmt->value->type, ValueType::INT);  // Fields hold INT
+    emitName(Op::SETPROP, stmt->name.lexeme, newPropertySite());
 }
 
 void CodeGenerator::visitPrint(PrintStmt* stmt) {
     // Generate code for expression
     visitExpr(stmt->expression.get());
     
-    // Print top of stack
-    emit("PRINT");
+    // Print top of stack in its own format
+    switch (stmt->expression->type) {
+        case ValueType::FLOAT: emit(Op::FPRINT); break;
+        case ValueType::FIXED: emit(Op::XPRINT); break;
+        default: emit(Op::PRINT); break;
+    }
+    
+    // PRINT leaves the value on the stack; a string literal is printed
+    // directly by PUSH and never pushed
+    LiteralExpr* literal = dynamic_cast<LiteralExpr*>(stmt->expression.get());
+    if (!literal || literal->token.type != TokenType::STRING) emit(Op::POP);
 }
 
 void CodeGenerator::visitIf(IfStmt* stmt) {
-    // Generate code for condition
-    visitExpr(stmt->condition.get());
-    
     // Create labels
-    std::string elseLabel = newLabel("else");
-    std::string endLabel = newLabel("end_if");
+    int elseLabel = newLabel("else");
+    int endLabel = newLabel("end_if");
     
     // Jump to else if condition is false (0)
-    emit("JZ " + elseLabel);
+    emitJumpIfFalse(stmt->condition.get(), elseLabel);
     
     // Generate then branch
     visitBlock(stmt->thenBranch.get());
     
     // Jump to end (skip else)
-    emit("JMP " + endLabel);
+    emitJump(Op::JMP, endLabel);
     
     // Else label
-    emit(elseLabel + ":");
+    placeLabel(elseLabel);
     
     // Generate else branch (if exists)
     if (stmt->elseBranch) {
@@ -149,74 +421,248 @@ void CodeGenerator::visitIf(IfStmt* stmt) {
     }
     
     // End label
-    emit(endLabel + ":");
+    placeLabel(endLabel);
 }
 
 void CodeGenerator::visitLoop(LoopStmt* stmt) {
     // Create labels
-    std::string loopLabel = newLabel("loop");
-    std::string endLabel = newLabel("end_loop");
+    int loopLabel = newLabel("loop");
+    int endLabel = newLabel("end_loop");
     
     // Loop start
-    emit(loopLabel + ":");
-    
-    // Generate condition
-    visitExpr(stmt->condition.get());
+    placeLabel(loopLabel);
     
     // Jump to end if condition is false (0)
-    emit("JZ " + endLabel);
+    emitJumpIfFalse(stmt->condition.get(), endLabel);
     
-    // Generate body
+    // Generate body (CONTINUE re-tests the condition)
+    loops_.push_back({loopLabel, endLabel});
     visitBlock(stmt->body.get());
+    loops_.pop_back();
     
     // Jump back to loop start
-    emit("JMP " + loopLabel);
+    emitJump(Op::JMP, loopLabel);
     
     // End label
-    emit(endLabel + ":");
+    placeLabel(endLabel);
+}
+
+/**
+ * FOR i = a TO b STEP s { body }
+ * 
+ *     <a>; STORE i
+ *     <b>; STORE __for_limit_N        (skipped when b is a literal)
+ *     <s>; STORE __for_step_N         (skipped when s is a literal)
+ *     FORPREP i <limit> <step> end_for
+ *   for:
+ *     <body>
+ *   for_next:
+ *     FORLOOP i <limit> <step> for
+ *   end_for:
+ * 
+ * <limit>/<step> are integer immediates or hidden variable names. FORLOOP
+ * does the increment, the bound test and the back-edge in one dispatch.
+ */
+void CodeGenerator::visitFor(ForStmt* stmt) {
+    std::string id = std::to_string(forCounter_++);
+    int bodyLabel = newLabel("for");
+    int nextLabel = newLabel("for_next");
+    int endLabel = newLabel("end_for");
+    int var = bytecode_.symbol(stmt->variable.lexeme);
+    
+    visitExpr(stmt->start.get());
+    emit(Op::STORE, var);
+    
+    // Bounds are evaluated once, before the first iteration: an immediate,
+    // or a hidden variable (a symbol)
+    int limit;
+    bool limitIsName = false;
+    LiteralExpr* limitLit = dynamic_cast<LiteralExpr*>(stmt->limit.get());
+    if (limitLit && limitLit->token.type == TokenType::NUMBER) {
+        limit = std::stoi(limitLit->value);
+    } else {
+        limit = bytecode_.symbol("__for_limit_" + id);
+        limitIsName = true;
+        visitExpr(stmt->limit.get());
+        emit(Op::STORE, limit);
+    }
+    
+    int step;
+    bool stepIsName = false;
+    if (stmt->constantStep) {
+        step = stmt->stepValue;
+    } else {
+        step = bytecode_.symbol("__for_step_" + id);
+        stepIsName = true;
+        visitExpr(stmt->step.get());
+        emit(Op::STORE, step);
+    }
+    
+    bytecode_.emitFor(Op::FORPREP, var, limit, limitIsName, step, stepIsName, endLabel);
+    placeLabel(bodyLabel);
+    
+    loops_.push_back({nextLabel, endLabel});
+    visitBlock(stmt->body.get());
+    loops_.pop_back();
+    
+    placeLabel(nextLabel);
+    bytecode_.emitFor(Op::FORLOOP, var, limit, limitIsName, step, stepIsName, bodyLabel);
+    placeLabel(endLabel);
+}
+
+/**
+ * MATCH x { CASE ... }
+ * 
+ * Dense case values (at least half of the range [min, max] used) become a
+ * single JMPTABLE, so dispatch costs the same for any number of arms:
+ * 
+ *     <x>
+ *     JMPTABLE <min> <default> <label for min> <label for min+1> ...
+ * 
+ * Sparse values become a balanced binary decision tree over a hidden
+ * variable: O(log n) comparisons instead of an O(n) IF chain.
+ */
+void CodeGenerator::visitMatch(MatchStmt* stmt) {
+    std::string id = std::to_string(matchCounter_++);
+    int endLabel = newLabel("end_match");
+    int defaultLabel = stmt->elseBranch ? newLabel("match_else") : endLabel;
+    
+    CaseTargets targets;
+    std::vector<int> caseLabels;
+    for (size_t i = 0; i < stmt->cases.size(); i++) {
+        caseLabels.push_back(newLabel("match_case"));
+        for (int value : stmt->cases[i].constants) {
+            targets.push_back({value, caseLabels.back()});
+        }
+    }
+    std::sort(targets.begin(), targets.end());
+    
+    // Dispatch
+    long long range = targets.empty() ? 0 :
+        (long long)targets.back().first - targets.front().first + 1;
+    bool dense = targets.size() >= 3 && range <= 2 * (long long)targets.size() && range <= 1024;
+    
+    if (dense) {
+        visitExpr(stmt->subject.get());
+        std::vector<int> table;
+        size_t next = 0;
+        for (long long v = targets.front().first; v <= targets.back().first; v++) {
+            if (next < targets.size() && targets[next].first == v) {
+                table.push_back(targets[next++].second);
+            } else {
+                table.push_back(defaultLabel);  // Hole in the range
+            }
+        }
+        bytecode_.emitTable(targets.front().first, defaultLabel, table);
+    } else {
+        int subject = bytecode_.symbol("__match_" + id);
+        visitExpr(stmt->subject.get());
+        emit(Op::STORE, subject);
+        emitDecisionTree(subject, targets, 0, targets.size(), defaultLabel);
+    }
+    
+    // Arms (no fall-through)
+    for (size_t i = 0; i < stmt->cases.size(); i++) {
+        placeLabel(caseLabels[i]);
+        visitBlock(stmt->cases[i].body.get());
+        emitJump(Op::JMP, endLabel);
+    }
+    if (stmt->elseBranch) {
+        placeLabel(defaultLabel);
+        visitBlock(stmt->elseBranch.get());
+    }
+    placeLabel(endLabel);
 }
 
-void CodeGenerator::visitBreak(BreakStmt* stmt) {
-    // BREAK jumps to end of loop
-    // For simplicity, we'll use a label (in a more sophisticated system,
-    // we'd track the current loop's end label)
-    std::string endLabel = newLabel("end_loop");
-    emit("JMP " + endLabel);
-    // Note: This is simplified - in production, we'd track loop context
+/**
+ * Binary search over targets[lo, hi): split on the middle value with LT
+ * until at most 3 candidates are left, then test those with EQ.
+ */
+void CodeGenerator::emitDecisionTree(int subject, const CaseTargets& targets,
+                                     size_t lo, size_t hi, int defaultLabel) {
+    if (hi - lo <= 3) {
+        for (size_t i = lo; i < hi; i++) {
+            emit(Op::LOAD, subject);
+            emit(Op::PUSH, targets[i].first);
+            emit(Op::EQ);
+            emitJump(Op::JNZ, targets[i].second);
+        }
+        emitJump(Op::JMP, defaultLabel);
+        return;
+    }
+    
+    size_t mid = lo + (hi - lo) / 2;
+    int lowerLabel = newLabel("match_lt");
+    emit(Op::LOAD, subject);
+    emit(Op::PUSH, targets[mid].first);
+    emit(Op::LT);
+    emitJump(Op::JNZ, lowerLabel);
+    emitDecisionTree(subject, targets, mid, hi, defaultLabel);
+    placeLabel(lowerLabel);
+    emitDecisionTree(subject, targets, lo, mid, defaultLabel);
 }
 
-void CodeGenerator::visitContinue(ContinueStmt* stmt) {
-    // CONTINUE jumps to start of loop
-    // For simplicity, we'll use a label
-    std::string loopLabel = newLabel("loop");
-    emit("JMP " + loopLabel);
-    // Note: This is simplified - in production, we'd track loop context
+void CodeGenerator::visitBreak(BreakStmt*) {
+    // BREAK jumps past the end of the innermost loop
+    if (loops_.empty()) {
+        error("BREAK outside of a loop");
+        return;
+    }
+    emitJump(Op::JMP, loops_.back().breakLabel);
+}
+
+void CodeGenerator::visitContinue(ContinueStmt*) {
+    // CONTINUE jumps to the innermost loop's condition / FORLOOP
+    if (loops_.empty()) {
+        error("CONTINUE outside of a loop");
+        return;
+    }
+    emitJump(Op::JMP, loops_.back().continueLabel);
 }
 
 void CodeGenerator::visitReturn(ReturnStmt* stmt) {
     if (stmt->value) {
-        // Generate code for return value
+        // Generate code for return value (SCENEs return INT)
         visitExpr(stmt->value.get());
+        emitConversion(stmt->value->type, ValueType::INT);
     } else {
         // No return value, push 0
-        emit("PUSH 0");
+        emit(Op::PUSH, 0);
     }
     
     // Return from function
-    emit("RET");
+    emit(Op::RET);
 }
 
 void CodeGenerator::visitFunction(FunctionStmt* stmt) {
     // Function label
-    emit(stmt->name.lexeme + ":");
+    placeLabel(bytecode_.namedLabel(stmt->name.lexeme));
+    bytecode_.setArity(stmt->name.lexeme, (int)stmt->parameters.size());
+    
+    // Not parsed yet (lazy): compiled by the first call to come here
+    if (!stmt->body) {
+        emitName(Op::COMPILE, stmt->name.lexeme);
+        return;
+    }
+    
+    // Parameters are read with LOADARG / written with STOREARG
+    std::unordered_map<std::string, int> outerParams = params_;
+    std::vector<LoopLabels> outerLoops = loops_;
+    loops_.clear();
+    params_.clear();
+    for (size_t i = 0; i < stmt->parameters.size(); i++) {
+        params_[stmt->parameters[i].lexeme] = (int)i;
+    }
     
     // Generate function body
     visitBlock(stmt->body.get());
+    params_ = outerParams;
+    loops_ = outerLoops;
     
     // If no explicit return, add one
     // (In a more sophisticated system, we'd check if last statement is RET)
-    emit("PUSH 0");
-    emit("RET");
+    emit(Op::PUSH, 0);
+    emit(Op::RET);
 }
 
 void CodeGenerator::visitBlock(BlockStmt* stmt) {
@@ -237,104 +683,180 @@ void CodeGenerator::visitExpr(Expr* expr) {
         visitVariable(var);
     } else if (BinaryExpr* bin = dynamic_cast<BinaryExpr*>(expr)) {
         visitBinary(bin);
+    } else if (LogicalExpr* logical = dynamic_cast<LogicalExpr*>(expr)) {
+        visitLogical(logical);
     } else if (UnaryExpr* un = dynamic_cast<UnaryExpr*>(expr)) {
         visitUnary(un);
     } else if (CallExpr* call = dynamic_cast<CallExpr*>(expr)) {
         visitCall(call);
+    } else if (ObjectExpr* obj = dynamic_cast<ObjectExpr*>(expr)) {
+        visitObject(obj);
+    } else if (PropertyExpr* prop = dynamic_cast<PropertyExpr*>(expr)) {
+        visitProperty(prop);
     }
 }
 
 void CodeGenerator::visitLiteral(LiteralExpr* expr) {
     // Push literal value onto stack
-    emit("PUSH " + expr->value);
+    switch (expr->token.type) {
+        case TokenType::TRUE_KW:
+            emit(Op::PUSH, 1);
+            break;
+        case TokenType::FALSE_KW:
+            emit(Op::PUSH, 0);
+            break;
+        case TokenType::FLOAT_NUMBER: {
+            // The bit pattern, and the source text for disassembly
+            float value = std::stof(expr->value);
+            int bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            emit(Op::FPUSH, bits, bytecode_.symbol(expr->value));
+            break;
+        }
+        case TokenType::FIXED_NUMBER: {
+            // 16.16: the raw integer is value * 65536
+            long long raw = std::llround(std::stod(expr->value) * 65536.0);
+            emit(Op::PUSH, (int)raw);
+            break;
+        }
+        case TokenType::STRING: {
+            // Printed without surrounding whitespace, as the text form always was
+            size_t first = expr->value.find_first_not_of(" \t");
+            size_t last = expr->value.find_last_not_of(" \t");
+            emitName(Op::PUSHSTR, first == std::string::npos ? "" : expr->value.substr(first, last - first + 1));
+            break;
+        }
+        default:
+            emit(Op::PUSH, std::stoi(expr->value));
+            break;
+    }
 }
 
 void CodeGenerator::visitVariable(VariableExpr* expr) {
-    // Load variable value onto stack
-    emit("LOAD " + expr->name.lexeme);
+    // Load parameter or variable value onto stack
+    auto param = params_.find(expr->name.lexeme);
+    if (param != params_.end()) {
+        emit(Op::LOADARG, param->second);
+    } else {
+        emitName(Op::LOAD, expr->name.lexeme);
+    }
 }
 
 void CodeGenerator::visitBinary(BinaryExpr* expr) {
-    // Generate code for left operand
-    visitExpr(expr->left.get());
-    
-    // Generate code for right operand
-    visitExpr(expr->right.get());
+    // Generate code for both operands (promoted to the operation's type)
+    emitOperands(expr);
     
     // Generate operation based on operator
     std::string op = expr->op.lexeme;
+    ValueType type = expr->operandType;
+    Op compare;
     
-    if (op == "+") {
-        emit("ADD");
+    if (comparisonOp(op, compare)) {
+        emit(typedOp(compare, type));
+    } else if (op == "+") {
+        emit(typedOp(Op::ADD, type));
     } else if (op == "-") {
-        emit("SUB");
+        emit(typedOp(Op::SUB, type));
     } else if (op == "*") {
-        emit("MUL");
+        emit(typedOp(Op::MUL, type));
     } else if (op == "/") {
-        emit("DIV");
-    } else if (op == "==") {
-        emit("EQ");
-    } else if (op == "!=") {
-        // a != b: push a, push b, EQ gives (a == b), then invert
-        // Stack: [a, b] -> EQ -> [result] where result is 1 if equal, 0 if not
-        // We want: 1 if not equal, 0 if equal
-        // So: result = 1 - (a == b)
-        emit("EQ");
-        emit("PUSH 1");
-        emit("SUB");  // 1 - (a == b)
-    } else if (op == ">") {
-        emit("GT");
-    } else if (op == "<") {
-        emit("LT");
-    } else if (op == ">=") {
-        // a >= b: push a, push b, LT gives (a < b), then invert
-        // Stack: [a, b] -> LT -> [result] where result is 1 if a < b, 0 otherwise
-        // We want: 1 if a >= b, 0 if a < b
-        // So: result = 1 - (a < b)
-        emit("LT");
-        emit("PUSH 1");
-        emit("SUB");  // 1 - (a < b)
-    } else if (op == "<=") {
-        // a <= b: push a, push b, GT gives (a > b), then invert
-        // Stack: [a, b] -> GT -> [result] where result is 1 if a > b, 0 otherwise
-        // We want: 1 if a <= b, 0 if a > b
-        // So: result = 1 - (a > b)
-        emit("GT");
-        emit("PUSH 1");
-        emit("SUB");  // 1 - (a > b)
+        emit(typedOp(Op::DIV, type));
+    } else if (op == "%") {
+        emit(Op::MOD);
+    } else if (op == "&") {
+        emit(Op::BAND);
+    } else if (op == "|") {
+        emit(Op::BOR);
+    } else if (op == "^") {
+        emit(Op::BXOR);
+    } else if (op == "<<") {
+        emit(Op::SHL);
+    } else if (op == ">>") {
+        emit(Op::SHR);
     } else {
         error("Unknown binary operator: " + op);
     }
 }
 
 void CodeGenerator::visitUnary(UnaryExpr* expr) {
-    // Generate code for operand
-    visitExpr(expr->right.get());
-    
-    // Generate operation based on operator
     std::string op = expr->op.lexeme;
     
     if (op == "-") {
-        // Negate: 0 - x
-        emit("PUSH 0");
-        emit("SUB");
-    } else if (op == "!") {
-        // Logical NOT: 1 - x (if x is 0 or 1)
-        emit("PUSH 1");
-        emit("SUB");
+        // Negate: 0 - x (the 0 goes first: SUB computes below - top).
+        // A zero bit pattern is also 0.0f and 0.0 in 16.16.
+        emit(Op::PUSH, 0);
+        visitExpr(expr->right.get());
+        emit(typedOp(Op::SUB, expr->type));
+        return;
+    }
+    
+    if (op == "!") {
+        // !(a < b) folds into the inverse comparison (a >= b). Not for FLOAT:
+        // with NaN both a < b and a >= b are false.
+        BinaryExpr* bin = dynamic_cast<BinaryExpr*>(expr->right.get());
+        Op compare;
+        if (bin && comparisonOp(bin->op.lexeme, compare) &&
+            bin->operandType != ValueType::FLOAT) {
+            emitOperands(bin);
+            emit(invertComparison(compare));
+            return;
+        }
+        
+        // Logical NOT: x == 0
+        visitExpr(expr->right.get());
+        emit(Op::PUSH, 0);
+        emit(Op::EQ);
     } else {
         error("Unknown unary operator: " + op);
     }
 }
 
+void CodeGenerator::visitLogical(LogicalExpr* expr) {
+    // Used as a value: branch on the condition and push 0 or 1
+    int falseLabel = newLabel("logic_false");
+    int endLabel = newLabel("logic_end");
+    
+    emitJumpIfFalse(expr, falseLabel);
+    emit(Op::PUSH, 1);
+    emitJump(Op::JMP, endLabel);
+    placeLabel(falseLabel);
+    emit(Op::PUSH, 0);
+    placeLabel(endLabel);
+}
+
 void CodeGenerator::visitCall(CallExpr* expr) {
-    // Generate code for all arguments (in order)
+    // Type conversions compile to a single conversion opcode
+    ValueType target;
+    if (SemanticAnalyzer::conversionTarget(expr->callee.lexeme, target)) {
+        visitExpr(expr->arguments[0].get());
+        emitConversion(expr->arguments[0]->type, target);
+        return;
+    }
+    
+    // Generate code for all arguments (in order), converted to INT
     for (auto& arg : expr->arguments) {
         visitExpr(arg.get());
+        emitConversion(arg->type, ValueType::INT);
     }
     
     // Call function with argument count
     int argCount = expr->arguments.size();
-    emit("CALL " + expr->callee.lexeme + " " + std::to_string(argCount));
+    emitName(Op::CALL, expr->callee.lexeme, argCount);
 }
 
+void CodeGenerator::visitObject(ObjectExpr* expr) {
+    // Allocate an empty object, then add fields in source order.
+    // INITPROP leaves the object on the stack for the next field.
+    emit(Op::NEWOBJ);
+    for (size_t i = 0; i < expr->fieldNames.size(); i++) {
+        visitExpr(expr->fieldValues[i].get());
+        emitConversion(expr->fieldValues[i]->type, ValueType::INT);
+        emitName(Op::INITPROP, expr->fieldNames[i].lexeme, newPropertySite());
+    }
+}
+
+void CodeGenerator::visitProperty(PropertyExpr* expr) {
+    // Stack: [obj] -> GETPROP -> [value]
+    visitExpr(expr->object.get());
+    emitName(Op::GETPROP, expr->name.lexeme, newPropertySite());
+}
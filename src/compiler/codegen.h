@@ -18,6 +18,10 @@
  *   - Statement nodes → Control flow instructions
  *   - Function nodes → Function definition bytecode
  * 
+ * Instructions go straight into a typed Bytecode buffer (opcode and
+ * operands, see ../vm/bytecode.h), never through text. Jumps name their
+ * label by id and are backpatched once all labels are placed.
+ * 
  * ============================================================================
  */
 
@@ -26,6 +30,7 @@
 
 #include "ast.h"
 #include "semantic.h"
+#include "../vm/bytecode.h"
 #include <vector>
 #include <string>
 #include <memory>
@@ -41,31 +46,80 @@ public:
     CodeGenerator();
     
     // Main function: generate bytecode from AST
-    std::vector<std::string> generate(std::unique_ptr<Program>& program);
+    Bytecode generate(std::unique_ptr<Program>& program);
+    
+    // Lazy compilation: a SCENE parsed after generate(), appended to that
+    // program (pc of its label, -1 on error)
+    int generateScene(FunctionStmt* stmt, Bytecode& program);
     
     // Get generated bytecode
-    std::vector<std::string> getBytecode() const { return bytecode_; }
+    const Bytecode& getBytecode() const { return bytecode_; }
     
     // Check if there were any errors
     bool hadError() const { return hadError_; }
     
     // Get error message
     std::string getError() const { return errorMessage_; }
+    
+    // Opcode selection
+    static Op conversionOp(ValueType from, ValueType to);  // NOP if none needed
+    static Op typedOp(Op op, ValueType type);
+    static bool comparisonOp(const std::string& op, Op& opcode);
+    static Op invertComparison(Op opcode);
+    
+    // ... by name, for the IR builder
+    static std::string conversionOpcode(ValueType from, ValueType to);  // "" if none needed
+    static std::string typedOpcode(const std::string& opcode, ValueType type);
+    static bool comparisonOpcode(const std::string& op, std::string& opcode);
+    static std::string invertComparison(const std::string& opcode);
 
 private:
     // ========================================================================
     // STATE
     // ========================================================================
-    std::vector<std::string> bytecode_;
-    std::unordered_map<std::string, int> labelCounter_;  // For unique labels
+    Bytecode bytecode_;
+    int forCounter_;    // FOR statements so far (names their hidden variables)
+    int matchCounter_;  // MATCH statements so far
+    int propertySiteCounter_;  // Next inline-cache site id for GETPROP/SETPROP
+    std::unordered_map<std::string, int> params_;  // Current SCENE's parameters (name -> index)
+    
+    // Jump targets of the enclosing loops, innermost last
+    struct LoopLabels {
+        int continueLabel;
+        int breakLabel;
+    };
+    std::vector<LoopLabels> loops_;
     bool hadError_;
     std::string errorMessage_;
     
     // ========================================================================
     // BYTECODE GENERATION
     // ========================================================================
-    void emit(const std::string& instruction);
-    std::string newLabel(const std::string& prefix);
+    void emit(Op op, int a = 0, int b = 0);
+    void emitName(Op op, const std::string& name, int b = 0);  // Operand a is a symbol
+    void emitJump(Op op, int label);
+    int newLabel(const char* prefix);
+    void placeLabel(int label);
+    int newPropertySite();
+    
+    // ========================================================================
+    // TYPED CODE
+    // ========================================================================
+    void emitConversion(ValueType from, ValueType to);
+    void emitOperands(BinaryExpr* expr);
+    
+    // ========================================================================
+    // CONDITIONS (short-circuit jumps for IF / LOOP / && / ||)
+    // ========================================================================
+    void emitJumpIfFalse(Expr* condition, int label);
+    void emitJumpIfTrue(Expr* condition, int label);
+    
+    // ========================================================================
+    // MATCH DISPATCH
+    // ========================================================================
+    typedef std::vector<std::pair<int, int>> CaseTargets;  // Sorted (value, label)
+    void emitDecisionTree(int subject, const CaseTargets& targets,
+                          size_t lo, size_t hi, int defaultLabel);
     
     // ========================================================================
     // ERROR HANDLING
@@ -82,9 +136,12 @@ private:
     // Statements
     void visitDeclaration(DeclarationStmt* stmt);
     void visitAssignment(AssignmentStmt* stmt);
+    void visitPropertyAssignment(PropertyAssignmentStmt* stmt);
     void visitPrint(PrintStmt* stmt);
     void visitIf(IfStmt* stmt);
     void visitLoop(LoopStmt* stmt);
+    void visitFor(ForStmt* stmt);
+    void visitMatch(MatchStmt* stmt);
     void visitBreak(BreakStmt* stmt);
     void visitContinue(ContinueStmt* stmt);
     void visitReturn(ReturnStmt* stmt);
@@ -95,8 +152,11 @@ private:
     void visitLiteral(LiteralExpr* expr);
     void visitVariable(VariableExpr* expr);
     void visitBinary(BinaryExpr* expr);
+    void visitLogical(LogicalExpr* expr);
     void visitUnary(UnaryExpr* expr);
     void visitCall(CallExpr* expr);
+    void visitObject(ObjectExpr* expr);
+    void visitProperty(PropertyExpr* expr);
 };
 
 #endif // CODEGEN_H
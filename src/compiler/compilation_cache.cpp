@@ -0,0 +1,121 @@
+/**
+ * CINEBREW Compilation Cache - Implementation
+ */
+
+#include "compilation_cache.h"
+#include "../vm/bytecode_file.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <tuple>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+CompilationCache::CompilationCache(const std::string& directory, long long limit)
+    : directory_(directory), limit_(limit), hits_(0), misses_(0), evictions_(0) {}
+
+std::string CompilationCache::defaultDirectory() {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) return std::string(xdg) + "/cinebrew";
+    const char* home = std::getenv("HOME");
+    if (home && *home) return std::string(home) + "/.cache/cinebrew";
+    return "";
+}
+
+std::string CompilationCache::hash(const std::string& key) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", hash);
+    return hex;
+}
+
+std::string CompilationCache::pathOf(const std::string& key) const {
+    return directory_ + "/" + hash(key) + ".cbc";
+}
+
+// An entry whose stored key differs (another text with the same hash) is
+// a miss; storing this key replaces it
+bool CompilationCache::load(const std::string& key, Bytecode& program) {
+    BytecodeFile file;
+    if (directory_.empty() || !file.open(pathOf(key)) || file.note() != key) {
+        misses_++;
+        return false;
+    }
+    program = file.program();
+    hits_++;
+
+    // Most recently used (an entry evicted meanwhile is simply not touched)
+    std::error_code ignored;
+    fs::last_write_time(pathOf(key), fs::file_time_type::clock::now(), ignored);
+    return true;
+}
+
+/**
+ * Writes the entry next to its final name and renames it into place, so
+ * no process ever maps half a file. The temporary name is the writer's
+ * own (process id and a count of the stores in this process), so
+ * concurrent stores of one key never write the same file.
+ */
+bool CompilationCache::store(const std::string& key, const Bytecode& program) {
+    if (directory_.empty()) return false;
+    std::error_code error;
+    fs::create_directories(directory_, error);
+
+    std::string path = pathOf(key);
+    static std::atomic<unsigned> stores(0);
+    std::string temporary = path + "." + std::to_string(getpid()) + "-" + std::to_string(stores++) + ".tmp";
+    std::string message;
+    if (!BytecodeFile::write(program, temporary, message, key)) {
+        fs::remove(temporary, error);
+        return false;
+    }
+    fs::rename(temporary, path, error);
+    if (error) {
+        fs::remove(temporary, error);
+        return false;
+    }
+    evict(hash(key) + ".cbc");
+    return true;
+}
+
+// Deletes the least recently used entries (but not the file `keep`) until
+// the directory fits in the limit
+void CompilationCache::evict(const std::string& keep) {
+    std::vector<std::tuple<fs::file_time_type, long long, std::string>> entries;
+    long long total = 0;
+    std::error_code error;
+    for (fs::directory_iterator it(directory_, error), end; !error && it != end; it.increment(error)) {
+        if (it->path().extension() != ".cbc") continue;
+        std::error_code gone;  // Removed by another process meanwhile
+        long long size = (long long)it->file_size(gone);
+        if (gone) continue;
+        fs::file_time_type used = it->last_write_time(gone);
+        if (gone) continue;
+        total += size;
+        entries.emplace_back(used, size, it->path().filename().string());
+    }
+    if (total <= limit_) return;
+
+    std::sort(entries.begin(), entries.end());
+    for (const auto& entry : entries) {
+        if (total <= limit_) break;
+        if (std::get<2>(entry) == keep) continue;
+        std::error_code ignored;
+        if (fs::remove(directory_ + "/" + std::get<2>(entry), ignored)) evictions_++;
+        total -= std::get<1>(entry);
+    }
+}
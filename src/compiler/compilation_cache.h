@@ -0,0 +1,73 @@
+/**
+ * CINEBREW Compilation Cache
+ *
+ * ============================================================================
+ * WHAT IS IT?
+ * ============================================================================
+ *
+ * Compiled programs kept on disk between runs, so that starting the same
+ * script again skips the compiler:
+ *
+ *   $XDG_CACHE_HOME/cinebrew/3f9a0c1d5e7b2a48.cbc     (~/.cache/cinebrew if unset)
+ *
+ * An entry is looked up by a key: the text of everything the bytecode
+ * depends on, i.e. the source, the compiler's build id and the options
+ * (see Compiler::compileProgram, which consults the cache when
+ * CompilerOptions::cache is set). An edited script, another -O level or a
+ * rebuilt compiler simply get another entry. The file name is a hash of
+ * the key (FNV-1a, 64 bits); the whole key is stored in the entry and
+ * compared on load, so two keys with the same hash never share bytecode.
+ * The entries are .cbc files (../vm/bytecode_file.h), so a cinebrew build
+ * with another instruction layout refuses them and compiles again.
+ *
+ * Many cinebrew processes may share the directory:
+ *
+ *   - an entry is written to a temporary file and renamed into place, so
+ *     a reader sees the whole old file or the whole new one
+ *   - a hit sets the entry's modification time: the least recently used
+ *     entries are the oldest ones
+ *   - after a store, the oldest entries are deleted until the directory
+ *     holds at most `limit` bytes (an entry being read stays readable, it
+ *     is only unlinked)
+ *
+ * ============================================================================
+ */
+
+#ifndef COMPILATION_CACHE_H
+#define COMPILATION_CACHE_H
+
+#include "../vm/bytecode.h"
+#include <string>
+
+class CompilationCache {
+public:
+    static const long long DEFAULT_LIMIT = 64LL << 20;  // Bytes on disk
+
+    explicit CompilationCache(const std::string& directory, long long limit = DEFAULT_LIMIT);
+
+    // $XDG_CACHE_HOME/cinebrew, else $HOME/.cache/cinebrew ("" if neither is set)
+    static std::string defaultDirectory();
+
+    // The entry name for a key: 16 hex digits
+    static std::string hash(const std::string& key);
+
+    bool load(const std::string& key, Bytecode& program);          // false: a miss
+    bool store(const std::string& key, const Bytecode& program);   // false if it could not be written
+
+    const std::string& directory() const { return directory_; }
+    long long hits() const { return hits_; }
+    long long misses() const { return misses_; }
+    long long evictions() const { return evictions_; }
+
+private:
+    std::string directory_;
+    long long limit_;
+    long long hits_;
+    long long misses_;
+    long long evictions_;
+
+    std::string pathOf(const std::string& key) const;  // Named by hash(key)
+    void evict(const std::string& keep);
+};
+
+#endif // COMPILATION_CACHE_H
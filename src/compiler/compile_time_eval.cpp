@@ -0,0 +1,109 @@
+/**
+ * Compile-Time Evaluator Implementation
+ *
+ * The sandboxed VM and the instruction whitelist.
+ */
+
+#include "compile_time_eval.h"
+#include <unordered_set>
+
+// Opcodes that only touch the stack, the current frame and the pc
+static const std::unordered_set<int> SAFE_OPCODES = {
+    (int)Op::NOP, (int)Op::LABEL,
+    (int)Op::PUSH, (int)Op::FPUSH, (int)Op::DUP, (int)Op::POP, (int)Op::SWAP,
+    (int)Op::ADD, (int)Op::SUB, (int)Op::MUL, (int)Op::NEG, (int)Op::DIVNZ, (int)Op::MODNZ,
+    (int)Op::BAND, (int)Op::BOR, (int)Op::BXOR, (int)Op::SHL, (int)Op::SHR,
+    (int)Op::FADD, (int)Op::FSUB, (int)Op::FMUL, (int)Op::FDIV,
+    (int)Op::FEQ, (int)Op::FNE, (int)Op::FGT, (int)Op::FLT, (int)Op::FGE, (int)Op::FLE,
+    (int)Op::XMUL, (int)Op::XDIVNZ, (int)Op::I2F, (int)Op::F2I, (int)Op::I2X, (int)Op::X2I,
+    (int)Op::F2X, (int)Op::X2F,
+    (int)Op::EQ, (int)Op::NE, (int)Op::GT, (int)Op::LT, (int)Op::GE, (int)Op::LE,
+    (int)Op::JMP, (int)Op::JZ, (int)Op::JNZ, (int)Op::JMPTABLE,
+    (int)Op::LOADARG, (int)Op::LOADARGU, (int)Op::STOREARG, (int)Op::ENTER,
+    (int)Op::LOADLOCAL, (int)Op::STORELOCAL, (int)Op::RET,
+};
+
+CompileTimeEvaluator::CompileTimeEvaluator(const Bytecode& bytecode, long long budget)
+    : budget_(budget), evaluated_(0), fallbacks_(0) {
+    vm_.trace = false;
+    vm_.load(bytecode);
+}
+
+bool CompileTimeEvaluator::evaluate(const std::string& callee, const std::vector<int>& args,
+                                    int& result) {
+    // Non-PURE built-ins are not candidates at all
+    if (vm_.runtime.isBuiltin(callee) && vm_.runtime.getPurity(callee) != Purity::PURE) {
+        return false;
+    }
+
+    std::string key = callee;
+    for (int arg : args) {
+        key += " " + std::to_string(arg);
+    }
+    auto cached = cache_.find(key);
+    Outcome outcome = cached != cache_.end() ? cached->second : run(callee, args);
+    cache_[key] = outcome;
+
+    if (!outcome.ok) {
+        fallbacks_++;
+        return false;
+    }
+    evaluated_++;
+    result = outcome.value;
+    return true;
+}
+
+/**
+ * Calls the SCENE as the program would (arguments, then CALL), with the
+ * pc starting past the end so that its RET leaves the loop.
+ */
+CompileTimeEvaluator::Outcome CompileTimeEvaluator::run(const std::string& callee,
+                                                        const std::vector<int>& args) {
+    vm_.stack.clear();
+    vm_.callstack.clear();
+    vm_.pc = vm_.programSize();
+    for (int arg : args) {
+        vm_.push(arg);
+    }
+
+    Instruction call = {Op::CALL, 0, false, 0, (int)args.size(), 0, -1, -1};
+    if (!allowed(call, callee)) return {false, 0};
+    if (!vm_.runtime.isBuiltin(callee) && vm_.findLabel(callee) < 0) return {false, 0};
+    vm_.call(callee, (int)args.size());
+
+    static const std::string none;
+    long long steps = 0;
+    while (!vm_.callstack.empty()) {
+        if (vm_.pc < 0 || vm_.pc >= vm_.programSize()) return {false, 0};
+        if (++steps > budget_) return {false, 0};
+        const Instruction& instruction = vm_.instructionAt(vm_.pc);
+        const std::string& name = instruction.op == Op::CALL ? vm_.program().symbols[instruction.a] : none;
+        if (!allowed(instruction, name)) return {false, 0};
+        vm_.step();
+    }
+
+    if (vm_.stack.size() != 1) return {false, 0};
+    return {true, vm_.stack.back()};
+}
+
+/**
+ * Whether the instruction can run without an effect the program would
+ * notice. Looks at the current stack for calls and divisions; `name` is
+ * the callee of a CALL.
+ */
+bool CompileTimeEvaluator::allowed(const Instruction& instruction, const std::string& name) {
+    // A zero divisor is reported by the VM: leave it for run time
+    if (instruction.op == Op::DIV || instruction.op == Op::MOD || instruction.op == Op::XDIV) {
+        return !vm_.stack.empty() && vm_.stack.back() != 0;
+    }
+
+    if (instruction.op == Op::CALL) {
+        if (vm_.runtime.isBuiltin(name)) {
+            return vm_.runtime.getPurity(name) == Purity::PURE;
+        }
+        return vm_.findLabel(name) >= 0;
+    }
+
+    // Not PUSHSTR either: PUSH "text" prints the text
+    return SAFE_OPCODES.count((int)instruction.op) > 0;
+}
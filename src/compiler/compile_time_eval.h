@@ -0,0 +1,73 @@
+/**
+ * CINEBREW Compile-Time Evaluator
+ *
+ * ============================================================================
+ * WHAT DOES IT DO?
+ * ============================================================================
+ *
+ * Runs a SCENE call whose arguments are all constants during compilation
+ * and hands the result to the ConstantFolder, which replaces the call by
+ * a literal:
+ *
+ *   SCENE factorial(n) {
+ *       IF n <= 1 { SHOT 1; }
+ *       SHOT n * factorial(n - 1);
+ *   }
+ *   TAKE size = factorial(10);     →   TAKE size = 3628800;
+ *
+ * The call runs on a VM of its own (a sandbox) over the unoptimized
+ * bytecode of the program. Every instruction is checked before it runs;
+ * the evaluation is given up, and the call left for run time, as soon as
+ * the SCENE would do something a literal cannot stand for:
+ *
+ *   - read or write a global (LOAD, STORE; a FOR loop counts too, its
+ *     variable is a global)
+ *   - print, or touch an object
+ *   - call a built-in that is not PURE (keyPressed, random, print, ...)
+ *   - divide by zero (the VM reports it at run time)
+ *   - run for more than the instruction budget
+ *
+ * Results are cached by SCENE and arguments.
+ *
+ * ============================================================================
+ */
+
+#ifndef COMPILE_TIME_EVAL_H
+#define COMPILE_TIME_EVAL_H
+
+#include "../vm/vm.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class CompileTimeEvaluator {
+public:
+    static const long long DEFAULT_BUDGET = 100000;  // Instructions per call
+
+    // bytecode: the whole program, as CodeGen generates it
+    explicit CompileTimeEvaluator(const Bytecode& bytecode, long long budget = DEFAULT_BUDGET);
+
+    // Run callee(args...); false if it has to wait for run time
+    bool evaluate(const std::string& callee, const std::vector<int>& args, int& result);
+
+    // Statistics (one per call site asked about)
+    int evaluatedCount() const { return evaluated_; }  // Replaced by their result
+    int fallbackCount() const { return fallbacks_; }   // Left as a run-time call
+
+private:
+    struct Outcome {
+        bool ok;
+        int value;
+    };
+
+    long long budget_;
+    VM vm_;
+    std::unordered_map<std::string, Outcome> cache_;  // "callee arg arg ..." -> result
+    int evaluated_;
+    int fallbacks_;
+
+    Outcome run(const std::string& callee, const std::vector<int>& args);
+    bool allowed(const Instruction& instruction, const std::string& name);
+};
+
+#endif // COMPILE_TIME_EVAL_H
@@ -5,55 +5,406 @@
  */
 
 #include "compiler.h"
+#include "cinebrew_build_id.h"
+#include <chrono>
+#include <iomanip>
 #include <iostream>
 
-Compiler::Compiler() : hadError_(false) {
+Compiler::Compiler(const CompilerOptions& options) : options_(options), hadError_(false) {
     // Lexer, Parser, SemanticAnalyzer, and CodeGenerator
     // are created on-demand in compile() method
 }
 
+// Wall time of one stage, in milliseconds
+class StageTimer {
+public:
+    StageTimer() : start_(std::chrono::steady_clock::now()) {}
+    double millis() const {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_;
+        return elapsed.count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
 std::vector<std::string> Compiler::compile(const std::string& source) {
+    return compileProgram(source).disassemble();
+}
+
+/**
+ * Stages 1-4b: the checked, folded AST (nullptr after an error). Starts a
+ * new compile: errors and statistics are reset.
+ */
+std::unique_ptr<Program> Compiler::frontEnd(const std::string& source) {
     errors_.clear();
-    bytecode_.clear();
+    program_ = Bytecode();
+    stats_ = CompileStats();
     hadError_ = false;
+    bool optimize = options_.optLevel >= 1;
+    bool lazy = options_.lazy && !optimize;
+    tokens_.clear();
+    ast_.reset();
+    analyzer_.reset();
+    folder_.reset();
+    codegen_.reset();
+    deferred_.clear();
     
     // Stage 1: Lexing
+    StageTimer lexTime;
     Lexer lexer(source);
     std::vector<Token> tokens = lexer.tokenize();
+    stats_.passes.push_back({"lex", lexTime.millis(), -1, -1, 0});
     if (lexer.hadError()) {
         errors_.push_back("Lexer: " + lexer.getError());
         hadError_ = true;
-        return bytecode_;
+        return nullptr;
     }
     
     // Stage 2: Parsing
+    StageTimer parseTime;
     Parser parser(tokens);
+    parser.setLazy(lazy);
     std::unique_ptr<Program> program = parser.parse();
+    stats_.passes.push_back({"parse", parseTime.millis(), -1, -1, 0});
     if (parser.hadError()) {
         errors_.push_back("Parser: " + parser.getError());
         hadError_ = true;
-        return bytecode_;
+        return nullptr;
     }
     
     // Stage 3: Semantic Analysis
-    SemanticAnalyzer analyzer;
-    analyzer.analyze(program);
-    if (analyzer.hadError()) {
-        errors_ = analyzer.getErrors();
+    StageTimer semanticTime;
+    auto analyzer = std::make_unique<SemanticAnalyzer>();
+    analyzer->analyze(program);
+    stats_.passes.push_back({"semantic", semanticTime.millis(), -1, -1, 0});
+    if (analyzer->hadError()) {
+        errors_ = analyzer->getErrors();
         hadError_ = true;
-        return bytecode_;
+        return nullptr;
+    }
+    
+    // Stage 4: Constant Folding (CONSTs are inlined even when not optimizing)
+    StageTimer foldTime;
+    auto folder = std::make_unique<ConstantFolder>(optimize);
+    folder->fold(program);
+    stats_.passes.push_back({"fold", foldTime.millis(), -1, -1,
+                             folder->foldedCount() + folder->propagatedCount()});
+    if (folder->hadError()) {
+        errors_ = folder->getErrors();
+        hadError_ = true;
+        return nullptr;
+    }
+    stats_.constantsFolded = folder->foldedCount();
+    stats_.constantsPropagated = folder->propagatedCount();
+    
+    // The deferred SCENEs are checked and folded later, against the same
+    // globals and CONSTs
+    if (lazy) {
+        tokens_ = std::move(tokens);
+        analyzer_ = std::move(analyzer);
+        folder_ = std::move(folder);
+    }
+    
+    // Stage 4b: Compile-time calls, run on the folded program's bytecode;
+    // folding again propagates what they return
+    if (options_.optLevel >= 2) {
+        StageTimer evalTime;
+        CodeGenerator reference;
+        CompileTimeEvaluator evaluator(reference.generate(program));
+        ConstantFolder refold(true);
+        refold.setEvaluator(&evaluator);
+        refold.fold(program);
+        stats_.constantsFolded += refold.foldedCount();
+        stats_.constantsPropagated += refold.propagatedCount();
+        stats_.callsEvaluated = evaluator.evaluatedCount();
+        stats_.callsDeferred = evaluator.fallbackCount();
+        stats_.passes.push_back({"compile-time-calls", evalTime.millis(), -1, -1,
+                                 evaluator.evaluatedCount()});
     }
     
-    // Stage 4: Code Generation
-    CodeGenerator codegen;
-    bytecode_ = codegen.generate(program);
-    if (codegen.hadError()) {
-        errors_.push_back("CodeGen: " + codegen.getError());
+    return program;
+}
+
+/**
+ * Stage 5 of optimized builds: the SSA IR of the program after the IR
+ * passes of the optimization level (nullptr if it fails to verify). At -O0
+ * the IR is built but not optimized (only the AOT backend asks for it).
+ */
+std::unique_ptr<IRModule> Compiler::buildIR(Program* program) {
+    StageTimer buildTime;
+    IRBuilder builder;
+    std::unique_ptr<IRModule> module = builder.build(program);
+    stats_.passes.push_back({"ir-build", buildTime.millis(), -1, module->instructionCount(), 0});
+    if (options_.optLevel < 1) return module;
+    
+    IRPassManager passes;
+    const Inliner* inlining = nullptr;
+    const RangeAnalysis* rangeAnalysis = nullptr;
+    addIRPasses(passes, inlining, rangeAnalysis);
+    bool verified = passes.run(*module);
+    for (const PassRecord& record : passes.records()) {
+        stats_.passes.push_back({"ir " + record.name, record.millis, record.sizeBefore,
+                                 record.sizeAfter, record.changes});
+    }
+    if (!verified) {
+        for (const std::string& error : passes.getErrors()) {
+            errors_.push_back("IR: " + error);
+        }
         hadError_ = true;
-        return bytecode_;
+        return nullptr;
+    }
+    stats_.irPassChanges = passes.changeCounts();
+    if (inlining) stats_.inlineDecisions = inlining->getDecisions();
+    if (rangeAnalysis) {
+        stats_.safetyChecks = rangeAnalysis->checkCount();
+        stats_.checksRemoved = rangeAnalysis->removedCount();
+    }
+    return module;
+}
+
+/**
+ * With a cache, a program compiled before with the same options is loaded
+ * instead (a failed compile is never stored: its errors are reported
+ * every time).
+ */
+const Bytecode& Compiler::compileProgram(const std::string& source) {
+    CompilationCache* cache = options_.profile || options_.lazy ? nullptr : options_.cache;
+    if (!cache) return compileSource(source);
+
+    StageTimer lookupTime;
+    std::string key = cacheKey(source);
+    Bytecode cached;
+    if (cache->load(key, cached)) {
+        errors_.clear();
+        stats_ = CompileStats();
+        hadError_ = false;
+        program_ = std::move(cached);
+        stats_.fromCache = true;
+        stats_.generatedSize = stats_.finalSize = (int)program_.size();
+        stats_.passes.push_back({"cache", lookupTime.millis(), -1, (int)program_.size(), 0});
+        return program_;
+    }
+
+    compileSource(source);
+    if (!hadError_) {
+        StageTimer storeTime;
+        cache->store(key, program_);
+        stats_.passes.push_back({"cache", storeTime.millis(), -1, -1, 0});
+    }
+    return program_;
+}
+
+const char* Compiler::buildId() {
+    return CINEBREW_BUILD_ID;
+}
+
+// Everything the bytecode depends on
+std::string Compiler::cacheKey(const std::string& source) const {
+    std::string options = std::string("cinebrew ") + buildId() + " -O" + std::to_string(options_.optLevel) +
+                          (options_.instrument ? " instrument" : "") + "\n";
+    return options + source;
+}
+
+const Bytecode& Compiler::compileSource(const std::string& source) {
+    std::unique_ptr<Program> program = frontEnd(source);
+    if (!program) return program_;
+    bool optimize = options_.optLevel >= 1;
+    
+    // Stage 5: Code Generation (optimized builds go through the SSA IR, and
+    // are linked after Stage 6)
+    if (optimize) {
+        std::unique_ptr<IRModule> module = buildIR(program.get());
+        if (!module) return program_;
+        
+        StageTimer lowerTime;
+        int irSize = module->instructionCount();
+        IRLowering lowering(options_.profile, options_.instrument);
+        program_ = lowering.lower(*module);
+        stats_.blocksMoved = lowering.movedBlockCount();
+        stats_.passes.push_back({"lower", lowerTime.millis(), irSize, (int)program_.size(),
+                                 lowering.movedBlockCount()});
+        stats_.generatedSize = (int)program_.size();
+    } else {
+        StageTimer codegenTime;
+        auto codegen = std::make_unique<CodeGenerator>();
+        program_ = codegen->generate(program);
+        stats_.passes.push_back({"codegen", codegenTime.millis(), -1, (int)program_.size(), 0});
+        if (codegen->hadError()) {
+            errors_.push_back("CodeGen: " + codegen->getError());
+            hadError_ = true;
+            return program_;
+        }
+        stats_.generatedSize = stats_.finalSize = (int)program_.size();
+        
+        for (auto& stmt : program->statements) {
+            FunctionStmt* func = dynamic_cast<FunctionStmt*>(stmt.get());
+            if (func && !func->body) deferred_[func->name.lexeme] = func;
+        }
+        stats_.scenesDeferred = (int)deferred_.size();
+        if (!deferred_.empty()) {
+            codegen_ = std::move(codegen);
+            ast_ = std::move(program);
+        }
+        return program_;
+    }
+    
+    // Stage 6: Bytecode Optimization (dead code, then peephole; the
+    // peephole rewrites can leave more dead labels behind)
+    if (optimize) {
+        std::vector<std::string> scenes;
+        for (auto& stmt : program->statements) {
+            if (FunctionStmt* func = dynamic_cast<FunctionStmt*>(stmt.get())) {
+                scenes.push_back(func->name.lexeme);
+            }
+        }
+        StageTimer dceTime;
+        int before = (int)program_.size();
+        DeadCodeEliminator dce(scenes);
+        dce.run(program_);
+        stats_.branchesResolved = dce.resolvedBranchCount();
+        stats_.scenesRemoved = dce.removedSceneCount();
+        stats_.passes.push_back({"dead-code", dceTime.millis(), before, (int)program_.size(),
+                                 dce.removedCount()});
+        
+        // Superinstructions for the sequences the profiled run spent time in
+        std::set<std::string> superinstructions;
+        if (options_.profile) {
+            for (const std::string& rule : PeepholeOptimizer::superinstructionNames()) {
+                if (options_.profile->isHot(options_.profile->superinstructionCount(rule))) {
+                    superinstructions.insert(rule);
+                    stats_.superinstructions.push_back(rule);
+                }
+            }
+        }
+        StageTimer peepholeTime;
+        before = (int)program_.size();
+        PeepholeOptimizer peephole(superinstructions);
+        peephole.run(program_);
+        stats_.peepholeRewrites = peephole.ruleCounts();
+        stats_.passes.push_back({"peephole", peepholeTime.millis(), before, (int)program_.size(),
+                                 peephole.rewriteCount()});
+        if (peephole.rewriteCount() > 0) {
+            StageTimer again;
+            before = (int)program_.size();
+            dce.run(program_);
+            stats_.branchesResolved += dce.resolvedBranchCount();
+            stats_.scenesRemoved += dce.removedSceneCount();
+            stats_.passes.push_back({"dead-code", again.millis(), before, (int)program_.size(),
+                                     dce.removedCount()});
+        }
     }
     
-    return bytecode_;
+    // What the passes deleted no longer needs its symbols and labels
+    StageTimer linkTime;
+    program_.compact();
+    program_.link();
+    for (auto& stmt : program->statements) {
+        if (FunctionStmt* func = dynamic_cast<FunctionStmt*>(stmt.get())) {
+            program_.setArity(func->name.lexeme, (int)func->parameters.size());
+        }
+    }
+    stats_.passes.push_back({"link", linkTime.millis(), (int)program_.size(), (int)program_.size(), 0});
+    stats_.finalSize = (int)program_.size();
+    
+    return program_;
+}
+
+std::string Compiler::compileToCpp(const std::string& source, const std::string& sourceName) {
+    std::unique_ptr<Program> program = frontEnd(source);
+    if (!program) return "";
+    std::unique_ptr<IRModule> module = buildIR(program.get());
+    if (!module) return "";
+    
+    StageTimer emitTime;
+    CppBackend backend;
+    std::string cpp = backend.generate(*module, sourceName);
+    stats_.passes.push_back({"c++", emitTime.millis(), module->instructionCount(), -1, 0});
+    if (backend.hadError()) {
+        errors_.push_back("C++: " + backend.getError());
+        hadError_ = true;
+        return "";
+    }
+    return cpp;
+}
+
+/**
+ * Stages 2-5 for one deferred SCENE: its body is parsed from the tokens
+ * kept by compileProgram(), then checked, folded and generated at the end
+ * of `program`. A SCENE is compiled at most once.
+ */
+int Compiler::compileScene(const std::string& scene, Bytecode& program) {
+    auto found = deferred_.find(scene);
+    if (found == deferred_.end()) {
+        errors_.push_back("Lazy: no SCENE '" + scene + "' to compile");
+        hadError_ = true;
+        return -1;
+    }
+    FunctionStmt* function = found->second;
+    deferred_.erase(found);
+    
+    StageTimer sceneTime;
+    int before = (int)program.size();
+    std::vector<Token> body(tokens_.begin() + function->bodyStart, tokens_.begin() + function->bodyEnd);
+    body.push_back(Token(TokenType::END_OF_FILE, "", tokens_[function->bodyEnd].line));
+    Parser parser(body);
+    std::unique_ptr<Program> parsed = parser.parse();
+    if (parser.hadError()) {
+        errors_.push_back("Parser: " + parser.getError());
+        hadError_ = true;
+        return -1;
+    }
+    function->body = std::make_unique<BlockStmt>(std::move(parsed->statements));
+    
+    if (!analyzer_->analyzeScene(function)) {
+        for (const std::string& error : analyzer_->getErrors()) errors_.push_back(error);
+        hadError_ = true;
+        return -1;
+    }
+    folder_->foldScene(function);
+    if (folder_->hadError()) {
+        for (const std::string& error : folder_->getErrors()) errors_.push_back(error);
+        hadError_ = true;
+        return -1;
+    }
+    int entry = codegen_->generateScene(function, program);
+    if (entry < 0) {
+        errors_.push_back("CodeGen: " + codegen_->getError());
+        hadError_ = true;
+        return -1;
+    }
+    stats_.scenesCompiled++;
+    stats_.passes.push_back({"scene " + scene, sceneTime.millis(), before, (int)program.size(), 0});
+    return entry;
+}
+
+/**
+ * The IR pipeline of the optimization level. An instrumented build keeps
+ * every call and FOR loop, so the profile sees them all.
+ */
+void Compiler::addIRPasses(IRPassManager& passes, const Inliner*& inliner,
+                           const RangeAnalysis*& ranges) const {
+    if (!options_.instrument) {
+        auto inlining = std::make_unique<Inliner>(Inliner::DEFAULT_THRESHOLD, options_.profile);
+        inliner = inlining.get();  // The manager owns it
+        passes.add(std::move(inlining));
+    }
+    passes.add(std::make_unique<RemoveTrivialPhis>());
+    passes.add(std::make_unique<MergeBlocks>());
+    passes.add(std::make_unique<DeadValueElimination>());
+    if (options_.optLevel < 2) return;
+
+    if (!options_.instrument) passes.add(std::make_unique<LoopUnroll>());
+    passes.add(std::make_unique<PromoteGlobals>());
+    passes.add(std::make_unique<LoopInvariantCodeMotion>());
+    passes.add(std::make_unique<StrengthReduction>());
+    passes.add(std::make_unique<CommonSubexpressionElimination>());
+    passes.add(std::make_unique<RemoveTrivialPhis>());
+    passes.add(std::make_unique<MergeBlocks>());
+    passes.add(std::make_unique<DeadValueElimination>());
+    auto analysis = std::make_unique<RangeAnalysis>();
+    ranges = analysis.get();
+    passes.add(std::move(analysis));
 }
 
 bool Compiler::hadError() const {
@@ -65,6 +416,86 @@ std::vector<std::string> Compiler::getErrors() const {
 }
 
 std::vector<std::string> Compiler::getBytecode() const {
-    return bytecode_;
+    return program_.disassemble();
+}
+
+void Compiler::printInlineReport() const {
+    std::cout << "Inlining decisions:" << std::endl;
+    if (stats_.inlineDecisions.empty()) {
+        std::cout << "  (no SCENE calls)" << std::endl;
+    }
+    for (const std::string& decision : stats_.inlineDecisions) {
+        std::cout << "  " << decision << std::endl;
+    }
+}
+
+void Compiler::printPassReport() const {
+    std::cout << "Passes (-O" << options_.optLevel << "):" << std::endl;
+    std::cout << "  " << std::left << std::setw(26) << "pass" << std::right << std::setw(10) << "ms"
+              << std::setw(18) << "size" << std::setw(10) << "changes" << std::endl;
+    double total = 0;
+    for (const PassRecord& pass : stats_.passes) {
+        std::string size = pass.sizeAfter < 0 ? "-" :
+                           pass.sizeBefore < 0 ? std::to_string(pass.sizeAfter) :
+                           std::to_string(pass.sizeBefore) + " -> " + std::to_string(pass.sizeAfter);
+        std::cout << "  " << std::left << std::setw(26) << pass.name << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(10) << pass.millis << std::setw(18) << size
+                  << std::setw(10) << pass.changes << std::endl;
+        total += pass.millis;
+    }
+    std::cout << "  " << std::left << std::setw(26) << "total" << std::right << std::setw(10) << total
+              << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+
+void Compiler::printStats() const {
+    int removed = stats_.generatedSize - stats_.finalSize;
+    std::cout << "Compiler statistics:" << std::endl;
+    if (options_.cache) {
+        std::cout << "  compilation cache:     " << options_.cache->hits() << " hits / "
+                  << options_.cache->misses() << " misses";
+        if (options_.cache->evictions() > 0) std::cout << ", " << options_.cache->evictions() << " evicted";
+        std::cout << " (" << options_.cache->directory() << ")" << std::endl;
+    }
+    if (stats_.fromCache) {
+        std::cout << "  bytecode size:         " << stats_.finalSize << " instructions (from the cache, no pass ran)"
+                  << std::endl;
+        return;
+    }
+    if (stats_.scenesDeferred > 0) {
+        std::cout << "  lazy scenes compiled:  " << stats_.scenesCompiled << " / " << stats_.scenesDeferred
+                  << std::endl;
+    }
+    std::cout << "  constants folded:      " << stats_.constantsFolded << std::endl;
+    std::cout << "  constants propagated:  " << stats_.constantsPropagated << std::endl;
+    std::cout << "  branches resolved:     " << stats_.branchesResolved << std::endl;
+    std::cout << "  scenes removed:        " << stats_.scenesRemoved << std::endl;
+    std::cout << "  calls evaluated:       " << stats_.callsEvaluated << " ("
+              << stats_.callsDeferred << " left to run time)" << std::endl;
+    std::cout << "  safety checks removed: " << stats_.checksRemoved << " / " << stats_.safetyChecks;
+    if (stats_.safetyChecks > 0) {
+        std::cout << " (" << (100.0 * stats_.checksRemoved / stats_.safetyChecks) << "%)";
+    }
+    std::cout << std::endl;
+    if (options_.profile) {
+        std::cout << "  profile blocks moved:  " << stats_.blocksMoved << std::endl;
+        std::cout << "  superinstructions:     ";
+        for (const std::string& rule : stats_.superinstructions) std::cout << rule << " ";
+        if (stats_.superinstructions.empty()) std::cout << "(none hot)";
+        std::cout << std::endl;
+    }
+    for (const auto& pass : stats_.irPassChanges) {
+        std::cout << "  ir " << pass.first << ": " << pass.second << std::endl;
+    }
+    for (const auto& rule : stats_.peepholeRewrites) {
+        std::cout << "  peephole " << rule.first << ": " << rule.second << std::endl;
+    }
+    std::cout << "  bytecode size:         " << stats_.generatedSize << " -> "
+              << stats_.finalSize << " instructions";
+    if (stats_.generatedSize > 0) {
+        std::cout << " (-" << (100.0 * removed / stats_.generatedSize) << "%)";
+    }
+    std::cout << std::endl;
 }
 
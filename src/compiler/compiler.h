@@ -3,6 +3,26 @@
  * 
  * Complete compiler that ties together all stages:
  * Lexer → Parser → Semantic Analyzer → Code Generator
+ *
+ * The optimization level picks the passes in between:
+ *
+ *   -O0  CONSTs inlined, CodeGen straight from the AST, no bytecode
+ *        passes: the fastest compile (hot reload while editing)
+ *   -O1  constant folding, SSA IR with inlining and cleanup, dead code
+ *        and peephole passes
+ *   -O2  everything: also compile-time calls, the loop passes, CSE and
+ *        range analysis (shipping builds)
+ *
+ * The result is a typed Bytecode (../vm/bytecode.h) for the VM; no text
+ * is made at any level (IRLowering and the bytecode passes of -O1 and up
+ * work on instructions too). compileToCpp() stops at the IR and hands it
+ * to the C++ backend instead.
+ *
+ * CompilerOptions::lazy (-O0 only) defers the SCENEs: the parser only
+ * finds where each body ends, and the program gets a COMPILE stub per
+ * SCENE. The VM calls compileScene() (VM::compileScene) the first time
+ * one is called, which parses, checks and generates that body and appends
+ * it to the running program; SCENEs never called are never compiled.
  */
 
 #ifndef COMPILER_H
@@ -11,10 +31,65 @@
 #include "lexer.h"
 #include "parser.h"
 #include "semantic.h"
+#include "constant_folder.h"
+#include "compile_time_eval.h"
 #include "codegen.h"
+#include "ir_builder.h"
+#include "ir_pass.h"
+#include "ir_lowering.h"
+#include "cpp_backend.h"
+#include "inliner.h"
+#include "loop_opt.h"
+#include "cse.h"
+#include "range_analysis.h"
+#include "dead_code.h"
+#include "peephole.h"
+#include "profile.h"
+#include "compilation_cache.h"
 #include <string>
 #include <vector>
+#include <map>
 #include <memory>
+#include <unordered_map>
+
+/**
+ * Compiler Options
+ */
+struct CompilerOptions {
+    int optLevel = 2;                  // 0, 1 or 2 (-O0 / -O1 / -O2, see above)
+    bool instrument = false;           // Count branches and loops for a profile (PROFBR,
+                                       // PROFLOOP); keeps every CALL and FOR loop (-O1 and up)
+    const Profile* profile = nullptr;  // Recorded run to optimize for (see profile.h; -O1 and up)
+    CompilationCache* cache = nullptr;  // Reuse earlier compiles (see compilation_cache.h;
+                                        // not with a profile)
+    bool lazy = false;                  // Compile SCENEs on their first call (-O0, no cache;
+                                        // see compileScene)
+};
+
+/**
+ * Compiler Statistics (what the optimization passes did)
+ */
+struct CompileStats {
+    int constantsFolded = 0;      // Expressions replaced by a literal
+    int constantsPropagated = 0;  // Variable reads replaced by a literal
+    int callsEvaluated = 0;       // Calls with constant arguments run at compile time
+    int callsDeferred = 0;        // ... that had side effects and stay calls
+    int generatedSize = 0;        // Instructions produced by CodeGen / IR lowering
+    int finalSize = 0;            // Instructions after the bytecode passes
+    int branchesResolved = 0;     // JZ/JNZ on a constant
+    int scenesRemoved = 0;        // SCENEs nothing can call
+    int safetyChecks = 0;         // DIV / MOD / XDIV / LOADARG in the optimized IR
+    int checksRemoved = 0;        // ... proven unnecessary by range analysis
+    int blocksMoved = 0;          // Blocks laid out by the profile
+    std::vector<std::string> superinstructions;   // Enabled by the profile
+    std::map<std::string, int> irPassChanges;     // IR pass name -> changes
+    std::map<std::string, int> peepholeRewrites;  // Rule name -> times applied
+    std::vector<std::string> inlineDecisions;     // One line per SCENE call site
+    std::vector<PassRecord> passes;               // Every stage and pass, in running order
+    bool fromCache = false;                       // Loaded from CompilerOptions::cache: no pass ran
+    int scenesDeferred = 0;                       // Left as COMPILE stubs (CompilerOptions::lazy)
+    int scenesCompiled = 0;                       // ... compiled since, by compileScene()
+};
 
 /**
  * Compiler Class
@@ -23,11 +98,29 @@
  */
 class Compiler {
 public:
-    Compiler();
+    // Identity of this compiler build: a hash of the compiler, VM and
+    // runtime sources (cmake/BuildId.cmake), part of the cache keys
+    static const char* buildId();
+
+    explicit Compiler(const CompilerOptions& options = CompilerOptions());
+    
+    // Main function: compile source code to bytecode (or take it from
+    // options.cache)
+    const Bytecode& compileProgram(const std::string& source);
     
-    // Main function: compile source code to bytecode
+    // The same, disassembled (for reading and tests)
     std::vector<std::string> compile(const std::string& source);
     
+    // Ahead of time: the optimized IR as one C++ source file, no VM (see
+    // cpp_backend.h); "" after an error
+    std::string compileToCpp(const std::string& source, const std::string& sourceName);
+    
+    // Lazy mode: appends a deferred SCENE of the last compileProgram() to
+    // `program` (that program, or the VM's copy of it) and returns the pc
+    // of its label; -1 (see getErrors) if it does not compile. The
+    // Compiler must outlive the run.
+    int compileScene(const std::string& scene, Bytecode& program);
+    
     // Check if compilation was successful
     bool hadError() const;
     
@@ -35,16 +128,39 @@ public:
     std::vector<std::string> getErrors() const;
     
     // Get generated bytecode
+    const Bytecode& getProgram() const { return program_; }
     std::vector<std::string> getBytecode() const;
+    
+    // Get optimization statistics of the last compile()
+    const CompileStats& getStats() const { return stats_; }
+    void printStats() const;
+    void printInlineReport() const;
+    void printPassReport() const;
 
 private:
     // Note: Lexer, Parser, SemanticAnalyzer, and CodeGenerator
     // are created on-demand in compile() method because they require
     // constructor arguments (source, tokens, etc.)
     
+    CompilerOptions options_;
     std::vector<std::string> errors_;
-    std::vector<std::string> bytecode_;
+    Bytecode program_;
+    CompileStats stats_;
     bool hadError_;
+    
+    // Lazy mode: what compileScene() needs after compileProgram() returned
+    std::vector<Token> tokens_;
+    std::unique_ptr<Program> ast_;
+    std::unique_ptr<SemanticAnalyzer> analyzer_;
+    std::unique_ptr<ConstantFolder> folder_;
+    std::unique_ptr<CodeGenerator> codegen_;
+    std::unordered_map<std::string, FunctionStmt*> deferred_;  // Not compiled yet
+
+    const Bytecode& compileSource(const std::string& source);
+    std::string cacheKey(const std::string& source) const;
+    std::unique_ptr<Program> frontEnd(const std::string& source);
+    std::unique_ptr<IRModule> buildIR(Program* program);
+    void addIRPasses(IRPassManager& passes, const Inliner*& inliner, const RangeAnalysis*& ranges) const;
 };
 
 #endif // COMPILER_H
@@ -0,0 +1,462 @@
+/**
+ * Constant Folder Implementation
+ *
+ * Folds literal subexpressions and propagates constant globals.
+ */
+
+#include "constant_folder.h"
+#include "semantic.h"
+#include "compile_time_eval.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+ConstantFolder::ConstantFolder(bool optimize)
+    : optimize_(optimize), inConstInitializer_(false), evaluator_(nullptr), folded_(0), propagated_(0) {
+}
+
+void ConstantFolder::fold(std::unique_ptr<Program>& program) {
+    candidates_.clear();
+    constants_.clear();
+    params_.clear();
+    errors_.clear();
+    folded_ = 0;
+    propagated_ = 0;
+
+    if (optimize_) {
+        findCandidates(program.get());
+    }
+
+    for (auto& stmt : program->statements) {
+        foldStmt(stmt.get());
+    }
+}
+
+// ============================================================================
+// ANALYSIS
+// ============================================================================
+
+/**
+ * A top-level TAKE can be propagated when nothing else ever writes the
+ * variable: no assignment anywhere, no FOR using it as loop variable.
+ */
+void ConstantFolder::findCandidates(Program* program) {
+    std::unordered_map<std::string, int> writes;
+    for (auto& stmt : program->statements) {
+        countWrites(stmt.get(), writes);
+    }
+
+    for (auto& stmt : program->statements) {
+        DeclarationStmt* decl = dynamic_cast<DeclarationStmt*>(stmt.get());
+        if (decl && !decl->isConst() && writes[decl->name.lexeme] == 1) {
+            candidates_.insert(decl->name.lexeme);
+        }
+    }
+}
+
+void ConstantFolder::countWrites(Stmt* stmt, std::unordered_map<std::string, int>& writes) {
+    if (DeclarationStmt* decl = dynamic_cast<DeclarationStmt*>(stmt)) {
+        writes[decl->name.lexeme]++;
+    } else if (AssignmentStmt* assign = dynamic_cast<AssignmentStmt*>(stmt)) {
+        writes[assign->name.lexeme] += 2;  // Never a candidate
+    } else if (ForStmt* loop = dynamic_cast<ForStmt*>(stmt)) {
+        writes[loop->variable.lexeme] += 2;
+        countWrites(loop->body.get(), writes);
+    } else if (IfStmt* ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        countWrites(ifStmt->thenBranch.get(), writes);
+        if (ifStmt->elseBranch) countWrites(ifStmt->elseBranch.get(), writes);
+    } else if (LoopStmt* loop = dynamic_cast<LoopStmt*>(stmt)) {
+        countWrites(loop->body.get(), writes);
+    } else if (MatchStmt* match = dynamic_cast<MatchStmt*>(stmt)) {
+        for (auto& c : match->cases) countWrites(c.body.get(), writes);
+        if (match->elseBranch) countWrites(match->elseBranch.get(), writes);
+    } else if (FunctionStmt* func = dynamic_cast<FunctionStmt*>(stmt)) {
+        countWrites(func->body.get(), writes);
+    } else if (BlockStmt* block = dynamic_cast<BlockStmt*>(stmt)) {
+        for (auto& inner : block->statements) countWrites(inner.get(), writes);
+    }
+}
+
+// ============================================================================
+// STATEMENTS
+// ============================================================================
+
+void ConstantFolder::foldStmt(Stmt* stmt) {
+    if (DeclarationStmt* decl = dynamic_cast<DeclarationStmt*>(stmt)) {
+        inConstInitializer_ = decl->isConst();
+        foldExpr(decl->initializer);
+        inConstInitializer_ = false;
+
+        Constant value;
+        const std::string& name = decl->name.lexeme;
+        if (asConstant(decl->initializer.get(), value)) {
+            if (decl->isConst() || candidates_.count(name)) {
+                constants_[name] = value;
+            }
+        } else if (decl->isConst()) {
+            errors_.push_back("Line " + std::to_string(decl->name.line) + ": CONST '" + name +
+                              "' cannot be evaluated at compile time (division by zero?)");
+        }
+    } else if (AssignmentStmt* assign = dynamic_cast<AssignmentStmt*>(stmt)) {
+        foldExpr(assign->value);
+    } else if (PropertyAssignmentStmt* prop = dynamic_cast<PropertyAssignmentStmt*>(stmt)) {
+        foldExpr(prop->object);
+        foldExpr(prop->value);
+    } else if (PrintStmt* print = dynamic_cast<PrintStmt*>(stmt)) {
+        foldExpr(print->expression);
+    } else if (IfStmt* ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        foldExpr(ifStmt->condition);
+        foldBlock(ifStmt->thenBranch.get());
+        if (ifStmt->elseBranch) foldBlock(ifStmt->elseBranch.get());
+    } else if (LoopStmt* loop = dynamic_cast<LoopStmt*>(stmt)) {
+        foldExpr(loop->condition);
+        foldBlock(loop->body.get());
+    } else if (ForStmt* loop = dynamic_cast<ForStmt*>(stmt)) {
+        foldExpr(loop->start);
+        foldExpr(loop->limit);
+        if (loop->step) {
+            foldExpr(loop->step);
+            // A folded step (STEP -SPEED) becomes a FORLOOP immediate
+            Constant step;
+            if (!loop->constantStep && asConstant(loop->step.get(), step) && step.bits != 0) {
+                loop->constantStep = true;
+                loop->stepValue = step.bits;
+            }
+        }
+        foldBlock(loop->body.get());
+    } else if (MatchStmt* match = dynamic_cast<MatchStmt*>(stmt)) {
+        foldExpr(match->subject);
+        for (auto& c : match->cases) foldBlock(c.body.get());
+        if (match->elseBranch) foldBlock(match->elseBranch.get());
+    } else if (ReturnStmt* ret = dynamic_cast<ReturnStmt*>(stmt)) {
+        if (ret->value) foldExpr(ret->value);
+    } else if (FunctionStmt* func = dynamic_cast<FunctionStmt*>(stmt)) {
+        // Parameters hide globals of the same name
+        std::unordered_set<std::string> outerParams = params_;
+        params_.clear();
+        for (const Token& param : func->parameters) {
+            params_.insert(param.lexeme);
+        }
+        if (func->body) foldBlock(func->body.get());  // Else not parsed yet (lazy)
+        params_ = outerParams;
+    } else if (BlockStmt* block = dynamic_cast<BlockStmt*>(stmt)) {
+        foldBlock(block);
+    } else if (ExpressionStmt* exprStmt = dynamic_cast<ExpressionStmt*>(stmt)) {
+        foldExpr(exprStmt->expression);
+    }
+}
+
+// The body of a lazily parsed SCENE, with the constants of the program
+// folded before (CONSTs are top-level, so they are all known by then)
+void ConstantFolder::foldScene(FunctionStmt* stmt) {
+    errors_.clear();
+    foldStmt(stmt);
+}
+
+void ConstantFolder::foldBlock(BlockStmt* block) {
+    for (auto& stmt : block->statements) {
+        foldStmt(stmt.get());
+    }
+}
+
+// ============================================================================
+// EXPRESSIONS
+// ============================================================================
+
+/**
+ * Fold children first, then replace `expr` with a literal if all of its
+ * operands turned out to be constants.
+ */
+void ConstantFolder::foldExpr(std::unique_ptr<Expr>& expr) {
+    Expr* e = expr.get();
+    Constant result;
+
+    if (VariableExpr* var = dynamic_cast<VariableExpr*>(e)) {
+        auto it = constants_.find(var->name.lexeme);
+        if (it != constants_.end() && !params_.count(var->name.lexeme)) {
+            expr = makeLiteral(it->second, var->name.line);
+            propagated_++;
+        }
+        return;
+    }
+
+    if (BinaryExpr* bin = dynamic_cast<BinaryExpr*>(e)) {
+        foldExpr(bin->left);
+        foldExpr(bin->right);
+        Constant a, b;
+        if (folding() && asConstant(bin->left.get(), a) && asConstant(bin->right.get(), b) &&
+            convert(a, bin->operandType, a) && convert(b, bin->operandType, b) &&
+            evalBinary(bin->op.lexeme, bin->operandType, a, b, result)) {
+            expr = makeLiteral(result, bin->op.line);
+            folded_++;
+        }
+        return;
+    }
+
+    if (LogicalExpr* logical = dynamic_cast<LogicalExpr*>(e)) {
+        foldExpr(logical->left);
+        foldExpr(logical->right);
+        Constant a, b;
+        if (!folding() || !asConstant(logical->left.get(), a)) return;
+
+        bool isAnd = logical->op.type == TokenType::AND;
+        if (isTruthy(a) != isAnd) {
+            // false && x, true || x: the right side never runs
+            expr = makeLiteral({ValueType::INT, isAnd ? 0 : 1}, logical->op.line);
+            folded_++;
+        } else if (asConstant(logical->right.get(), b)) {
+            expr = makeLiteral({ValueType::INT, isTruthy(b) ? 1 : 0}, logical->op.line);
+            folded_++;
+        }
+        return;
+    }
+
+    if (UnaryExpr* unary = dynamic_cast<UnaryExpr*>(e)) {
+        foldExpr(unary->right);
+        Constant v;
+        if (!folding() || !asConstant(unary->right.get(), v)) return;
+
+        if (unary->op.type == TokenType::BANG) {
+            expr = makeLiteral({ValueType::INT, v.bits == 0 ? 1 : 0}, unary->op.line);
+            folded_++;
+        } else if (evalBinary("-", v.type, {v.type, 0}, v, result)) {
+            // Same as the generated code: 0 - x
+            expr = makeLiteral(result, unary->op.line);
+            folded_++;
+        }
+        return;
+    }
+
+    if (CallExpr* call = dynamic_cast<CallExpr*>(e)) {
+        for (auto& arg : call->arguments) {
+            foldExpr(arg);
+        }
+        ValueType target;
+        Constant v;
+        if (folding() && SemanticAnalyzer::conversionTarget(call->callee.lexeme, target) &&
+            call->arguments.size() == 1 && asConstant(call->arguments[0].get(), v) &&
+            convert(v, target, result)) {
+            expr = makeLiteral(result, call->callee.line);
+            folded_++;
+            return;
+        }
+
+        // A call with constant arguments: run it now if it has no effects
+        if (!folding() || !evaluator_ ||
+            SemanticAnalyzer::conversionTarget(call->callee.lexeme, target)) {
+            return;
+        }
+        std::vector<int> args;
+        for (auto& arg : call->arguments) {
+            if (!asConstant(arg.get(), v) || !convert(v, ValueType::INT, v)) return;
+            args.push_back(v.bits);
+        }
+        int value;
+        if (evaluator_->evaluate(call->callee.lexeme, args, value)) {
+            expr = makeLiteral({ValueType::INT, value}, call->callee.line);
+            folded_++;
+        }
+        return;
+    }
+
+    if (ObjectExpr* obj = dynamic_cast<ObjectExpr*>(e)) {
+        for (auto& value : obj->fieldValues) {
+            foldExpr(value);
+        }
+        return;
+    }
+
+    if (PropertyExpr* prop = dynamic_cast<PropertyExpr*>(e)) {
+        foldExpr(prop->object);
+        return;
+    }
+}
+
+// ============================================================================
+// EVALUATION
+// ============================================================================
+
+static float bitsToFloat(int bits) {
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static int floatToBits(float f) {
+    int bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+bool ConstantFolder::asConstant(Expr* expr, Constant& out) {
+    LiteralExpr* lit = dynamic_cast<LiteralExpr*>(expr);
+    if (!lit) return false;
+
+    try {
+        switch (lit->token.type) {
+            case TokenType::NUMBER:
+                out = {ValueType::INT, std::stoi(lit->value)};
+                return true;
+            case TokenType::TRUE_KW:
+                out = {ValueType::INT, 1};
+                return true;
+            case TokenType::FALSE_KW:
+                out = {ValueType::INT, 0};
+                return true;
+            case TokenType::FLOAT_NUMBER:
+                out = {ValueType::FLOAT, floatToBits(std::stof(lit->value))};
+                return true;
+            case TokenType::FIXED_NUMBER:
+                out = {ValueType::FIXED, (int)std::llround(std::stod(lit->value) * 65536.0)};
+                return true;
+            default:
+                return false;  // Strings
+        }
+    } catch (const std::exception&) {
+        return false;  // Out of range: leave it to the code generator
+    }
+}
+
+/**
+ * Build a literal that the code generator turns back into exactly `value`.
+ */
+std::unique_ptr<Expr> ConstantFolder::makeLiteral(const Constant& value, int line) {
+    char text[64];
+    TokenType tokenType;
+
+    switch (value.type) {
+        case ValueType::FLOAT:
+            std::snprintf(text, sizeof(text), "%.9g", bitsToFloat(value.bits));
+            tokenType = TokenType::FLOAT_NUMBER;
+            break;
+        case ValueType::FIXED:
+            // raw / 65536 is exact in a double, so codegen recovers `raw`
+            std::snprintf(text, sizeof(text), "%.17g", value.bits / 65536.0);
+            tokenType = TokenType::FIXED_NUMBER;
+            break;
+        default:
+            std::snprintf(text, sizeof(text), "%d", value.bits);
+            tokenType = TokenType::NUMBER;
+            break;
+    }
+
+    std::unique_ptr<LiteralExpr> lit =
+        std::make_unique<LiteralExpr>(Token(tokenType, text, text, line), text);
+    lit->type = value.type;
+    return lit;
+}
+
+// Same conversions as the VM's I2F / F2I / I2X / X2I / F2X / X2F
+bool ConstantFolder::convert(Constant value, ValueType to, Constant& out) {
+    if (value.type == to) {
+        out = value;
+        return true;
+    }
+
+    if (value.type == ValueType::INT) {
+        if (to == ValueType::FLOAT) out = {to, floatToBits((float)value.bits)};
+        else out = {to, (int)((int64_t)value.bits * 65536)};
+        return true;
+    }
+
+    if (value.type == ValueType::FIXED) {
+        if (to == ValueType::INT) out = {to, value.bits / 65536};
+        else out = {to, floatToBits((float)value.bits / 65536)};
+        return true;
+    }
+
+    // FLOAT -> INT / FIXED: only fold when the result fits
+    double f = bitsToFloat(value.bits);
+    double scaled = (to == ValueType::FIXED) ? f * 65536.0 : f;
+    if (!(scaled > -2147483648.0 && scaled < 2147483647.0)) {
+        return false;
+    }
+    if (to == ValueType::INT) out = {to, (int)f};
+    else out = {to, (int)std::lround(bitsToFloat(value.bits) * 65536)};
+    return true;
+}
+
+/**
+ * Evaluate `a op b` with both operands already converted to `type`.
+ * Returns false for anything that must stay a runtime operation
+ * (division by zero).
+ */
+bool ConstantFolder::evalBinary(const std::string& op, ValueType type, Constant a, Constant b,
+                                Constant& out) {
+    // Comparisons: INT and FIXED compare raw values, FLOAT compares floats
+    bool cmp;
+    bool isComparison = true;
+    if (type == ValueType::FLOAT) {
+        float x = bitsToFloat(a.bits), y = bitsToFloat(b.bits);
+        if (op == "==") cmp = x == y;
+        else if (op == "!=") cmp = x != y;
+        else if (op == "<") cmp = x < y;
+        else if (op == ">") cmp = x > y;
+        else if (op == "<=") cmp = x <= y;
+        else if (op == ">=") cmp = x >= y;
+        else isComparison = false;
+    } else {
+        int x = a.bits, y = b.bits;
+        if (op == "==") cmp = x == y;
+        else if (op == "!=") cmp = x != y;
+        else if (op == "<") cmp = x < y;
+        else if (op == ">") cmp = x > y;
+        else if (op == "<=") cmp = x <= y;
+        else if (op == ">=") cmp = x >= y;
+        else isComparison = false;
+    }
+    if (isComparison) {
+        out = {ValueType::INT, cmp ? 1 : 0};
+        return true;
+    }
+
+    out.type = type;
+
+    if (type == ValueType::FLOAT) {
+        float x = bitsToFloat(a.bits), y = bitsToFloat(b.bits);
+        float r;
+        if (op == "+") r = x + y;
+        else if (op == "-") r = x - y;
+        else if (op == "*") r = x * y;
+        else if (op == "/" && y != 0.0f) r = x / y;
+        else return false;
+        out.bits = floatToBits(r);
+        return true;
+    }
+
+    unsigned int ux = (unsigned int)a.bits, uy = (unsigned int)b.bits;
+    int x = a.bits, y = b.bits;
+
+    // Wrapping add / sub are the same for INT and FIXED
+    if (op == "+") { out.bits = (int)(ux + uy); return true; }
+    if (op == "-") { out.bits = (int)(ux - uy); return true; }
+
+    if (type == ValueType::FIXED) {
+        if (op == "*") { out.bits = (int)(((int64_t)x * y) >> 16); return true; }
+        if (op == "/" && y != 0) { out.bits = (int)(((int64_t)x * 65536) / y); return true; }
+        return false;
+    }
+
+    if (op == "*") { out.bits = (int)(ux * uy); return true; }
+    if (op == "/") {
+        if (y == 0) return false;
+        out.bits = (y == -1) ? (int)(0u - ux) : x / y;
+        return true;
+    }
+    if (op == "%") {
+        if (y == 0) return false;
+        out.bits = (y == -1) ? 0 : x % y;
+        return true;
+    }
+    if (op == "&") { out.bits = x & y; return true; }
+    if (op == "|") { out.bits = x | y; return true; }
+    if (op == "^") { out.bits = x ^ y; return true; }
+    if (op == "<<") { out.bits = (int)(ux << (y & 31)); return true; }
+    if (op == ">>") { out.bits = x >> (y & 31); return true; }
+    return false;
+}
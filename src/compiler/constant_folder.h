@@ -0,0 +1,114 @@
+/**
+ * CINEBREW Constant Folder
+ *
+ * ============================================================================
+ * WHAT DOES IT DO?
+ * ============================================================================
+ *
+ * An AST pass that runs between semantic analysis and code generation:
+ *
+ *   Source → Lexer → Parser → Semantic → ConstantFolder → CodeGen → Bytecode
+ *
+ * 1. Constant folding: operators whose operands are all literals are
+ *    evaluated at compile time, with the same INT / FLOAT / FIXED rules
+ *    as the VM:
+ *
+ *      TAKE x = (3 + 5) * 2;     →   TAKE x = 16;
+ *
+ * 2. Constant propagation: a top-level TAKE with a constant initializer
+ *    that is never reassigned is replaced by its value at every use, and
+ *    so is every CONST:
+ *
+ *      TAKE KEY_UP = 82;
+ *      keyPressed(KEY_UP);       →   keyPressed(82);   (no LOAD)
+ *
+ * 3. Compile-time calls (with an evaluator set): a SCENE called with
+ *    constant arguments is run by the CompileTimeEvaluator and the call
+ *    replaced by its result, unless the SCENE has side effects:
+ *
+ *      TAKE size = factorial(10);   →   TAKE size = 3628800;
+ *
+ * Division by zero is never folded; it is left for the VM to report.
+ *
+ * ============================================================================
+ */
+
+#ifndef CONSTANT_FOLDER_H
+#define CONSTANT_FOLDER_H
+
+#include "ast.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+class CompileTimeEvaluator;
+
+class ConstantFolder {
+public:
+    // optimize = false only evaluates CONST initializers and inlines CONSTs
+    // (CONST inlining is a language guarantee, not an optimization)
+    explicit ConstantFolder(bool optimize = true);
+
+    // Main function: rewrite the program in place
+    void fold(std::unique_ptr<Program>& program);
+    void foldScene(FunctionStmt* stmt);  // Lazy compilation: a SCENE parsed after fold()
+
+    // Run calls with constant arguments through this evaluator (not owned)
+    void setEvaluator(CompileTimeEvaluator* evaluator) { evaluator_ = evaluator; }
+
+    // Check if there were any errors (a CONST that could not be folded)
+    bool hadError() const { return !errors_.empty(); }
+    std::vector<std::string> getErrors() const { return errors_; }
+
+    // Statistics
+    int foldedCount() const { return folded_; }          // Expressions replaced by a literal
+    int propagatedCount() const { return propagated_; }  // Variable reads replaced by a literal
+
+private:
+    // A compile-time value: the same 32 bits the VM would hold
+    struct Constant {
+        ValueType type;
+        int bits;  // INT value, float bit pattern or 16.16 raw value
+    };
+
+    // ========================================================================
+    // STATE
+    // ========================================================================
+    bool optimize_;
+    bool inConstInitializer_;  // Always fold while evaluating a CONST
+    std::unordered_set<std::string> candidates_;          // Globals assigned exactly once
+    std::unordered_map<std::string, Constant> constants_; // Known values by name
+    std::unordered_set<std::string> params_;              // Current SCENE's parameters
+    std::vector<std::string> errors_;
+    CompileTimeEvaluator* evaluator_;
+    int folded_;
+    int propagated_;
+
+    // ========================================================================
+    // ANALYSIS
+    // ========================================================================
+    void findCandidates(Program* program);
+    void countWrites(Stmt* stmt, std::unordered_map<std::string, int>& writes);
+
+    // ========================================================================
+    // REWRITING
+    // ========================================================================
+    void foldStmt(Stmt* stmt);
+    void foldBlock(BlockStmt* block);
+    void foldExpr(std::unique_ptr<Expr>& expr);
+
+    // ========================================================================
+    // EVALUATION (mirrors the VM opcodes)
+    // ========================================================================
+    static bool asConstant(Expr* expr, Constant& out);
+    static std::unique_ptr<Expr> makeLiteral(const Constant& value, int line);
+    static bool convert(Constant value, ValueType to, Constant& out);
+    static bool evalBinary(const std::string& op, ValueType type, Constant a, Constant b,
+                           Constant& out);
+    static bool isTruthy(const Constant& value) { return value.bits != 0; }
+    bool folding() const { return optimize_ || inConstInitializer_; }
+};
+
+#endif // CONSTANT_FOLDER_H
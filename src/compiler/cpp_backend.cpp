@@ -0,0 +1,604 @@
+/**
+ * C++ Backend Implementation
+ *
+ * SSA IR → C++ source.
+ */
+
+#include "cpp_backend.h"
+#include "../vm/memo_cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+
+// The VM opcodes UNARY / BINARY can carry; each has a cb_<opcode> helper
+// in the prelude
+static const char* const HELPERS[] = {
+    "ADD", "SUB", "MUL", "NEG", "DIV", "MOD", "DIVNZ", "MODNZ",
+    "BAND", "BOR", "BXOR", "SHL", "SHR",
+    "FADD", "FSUB", "FMUL", "FDIV", "FEQ", "FNE", "FGT", "FLT", "FGE", "FLE",
+    "XMUL", "XDIV", "XDIVNZ",
+    "I2F", "F2I", "I2X", "X2I", "F2X", "X2F",
+    "EQ", "NE", "GT", "LT", "GE", "LE",
+};
+
+// Same semantics as the VM's instructions (vm.cpp); the errors have no pc
+static const char* const PRELUDE = R"(// ---- VM semantics (see src/vm/vm.cpp) ----
+
+const int FIXED_ONE = 65536;
+
+inline float cb_float(int bits) { float f; std::memcpy(&f, &bits, sizeof(f)); return f; }
+inline int cb_bits(float f) { int bits; std::memcpy(&bits, &f, sizeof(bits)); return bits; }
+
+inline int cb_ADD(int a, int b) { return (int)((unsigned int)a + (unsigned int)b); }
+inline int cb_SUB(int a, int b) { return (int)((unsigned int)a - (unsigned int)b); }
+inline int cb_MUL(int a, int b) { return (int)((unsigned int)a * (unsigned int)b); }
+inline int cb_NEG(int a) { return (int)(0u - (unsigned int)a); }
+inline int cb_DIVNZ(int a, int b) { return a / b; }
+inline int cb_MODNZ(int a, int b) { return a % b; }
+inline int cb_DIV(int a, int b) {
+    if (b == 0) {
+        std::cerr << "ERROR: Division by zero" << std::endl;
+        return 0;
+    }
+    return b == -1 ? cb_NEG(a) : a / b;
+}
+inline int cb_MOD(int a, int b) {
+    if (b == 0) {
+        std::cerr << "ERROR: Modulo by zero" << std::endl;
+        return 0;
+    }
+    return b == -1 ? 0 : a % b;
+}
+
+inline int cb_BAND(int a, int b) { return a & b; }
+inline int cb_BOR(int a, int b) { return a | b; }
+inline int cb_BXOR(int a, int b) { return a ^ b; }
+inline int cb_SHL(int a, int b) { return (int)((unsigned int)a << (b & 31)); }
+inline int cb_SHR(int a, int b) { return a >> (b & 31); }
+
+inline int cb_FADD(int a, int b) { return cb_bits(cb_float(a) + cb_float(b)); }
+inline int cb_FSUB(int a, int b) { return cb_bits(cb_float(a) - cb_float(b)); }
+inline int cb_FMUL(int a, int b) { return cb_bits(cb_float(a) * cb_float(b)); }
+inline int cb_FDIV(int a, int b) { return cb_bits(cb_float(a) / cb_float(b)); }
+inline int cb_FEQ(int a, int b) { return cb_float(a) == cb_float(b); }
+inline int cb_FNE(int a, int b) { return cb_float(a) != cb_float(b); }
+inline int cb_FGT(int a, int b) { return cb_float(a) > cb_float(b); }
+inline int cb_FLT(int a, int b) { return cb_float(a) < cb_float(b); }
+inline int cb_FGE(int a, int b) { return cb_float(a) >= cb_float(b); }
+inline int cb_FLE(int a, int b) { return cb_float(a) <= cb_float(b); }
+
+inline int cb_XMUL(int a, int b) { return (int)(((int64_t)a * b) >> 16); }
+inline int cb_XDIVNZ(int a, int b) { return (int)(((int64_t)a * FIXED_ONE) / b); }
+inline int cb_XDIV(int a, int b) {
+    if (b == 0) {
+        std::cerr << "ERROR: Division by zero" << std::endl;
+        return 0;
+    }
+    return cb_XDIVNZ(a, b);
+}
+
+inline int cb_I2F(int a) { return cb_bits((float)a); }
+inline int cb_F2I(int a) { return (int)cb_float(a); }
+inline int cb_I2X(int a) { return (int)((int64_t)a * FIXED_ONE); }
+inline int cb_X2I(int a) { return a / FIXED_ONE; }
+inline int cb_F2X(int a) { return (int)std::lround(cb_float(a) * FIXED_ONE); }
+inline int cb_X2F(int a) { return cb_bits((float)a / FIXED_ONE); }
+
+inline int cb_EQ(int a, int b) { return a == b; }
+inline int cb_NE(int a, int b) { return a != b; }
+inline int cb_GT(int a, int b) { return a > b; }
+inline int cb_LT(int a, int b) { return a < b; }
+inline int cb_GE(int a, int b) { return a >= b; }
+inline int cb_LE(int a, int b) { return a <= b; }
+
+// FORPREP: does the body run at least once? FORLOOP: var += step, again?
+// 64-bit so stepping past INT_MAX ends the loop instead of wrapping
+inline bool cb_forprep(int var, int limit, int step) {
+    if (step == 0) {
+        std::cerr << "ERROR: FOR step is 0" << std::endl;
+        return false;
+    }
+    return step > 0 ? var <= limit : var >= limit;
+}
+inline bool cb_forloop(int& var, int limit, int step) {
+    if (step == 0) {
+        std::cerr << "ERROR: FOR step is 0" << std::endl;
+        return false;
+    }
+    long long value = (long long)var + step;
+    var = (int)value;
+    return step > 0 ? value <= limit : value >= limit;
+}
+
+Runtime runtime;  // Seeds random()
+std::vector<int> builtinArgs;
+)";
+
+// One object: a slot per property name of the program (handles start at 1)
+static const char* const OBJECTS = R"(
+// ---- Objects (see src/vm/object.h) ----
+
+struct Object {
+    int value[PROPERTY_COUNT];
+    bool has[PROPERTY_COUNT];
+};
+std::vector<Object> objects;
+
+inline int cb_newobj() {
+    objects.push_back(Object());
+    return (int)objects.size();
+}
+inline int cb_getprop(int handle, int property, const char* name) {
+    if (handle >= 1 && handle <= (int)objects.size() && objects[handle - 1].has[property]) {
+        return objects[handle - 1].value[property];
+    }
+    std::cerr << "WARNING: Property '" << name << "' not found, using 0" << std::endl;
+    return 0;
+}
+inline void cb_setprop(int handle, int property, int value, const char* opcode) {
+    if (handle < 1 || handle > (int)objects.size()) {
+        std::cerr << "ERROR: " << opcode << " on invalid object " << handle << std::endl;
+        return;
+    }
+    objects[handle - 1].value[property] = value;
+    objects[handle - 1].has[property] = true;
+}
+)";
+
+// Direct-mapped like the VM's MemoCache: a new key overwrites its slot
+static const char* const MEMO = R"(
+// ---- Memoized SCENEs (see src/vm/memo_cache.h) ----
+
+template <int N>
+struct Memo {
+    static const int SIZE = 4096;
+    struct Entry {
+        bool used;
+        int args[N + 1];
+        int value;
+    };
+    std::vector<Entry> entries = std::vector<Entry>(SIZE);
+
+    Entry& slot(const int* args) {
+        unsigned int hash = 2166136261u;
+        for (int i = 0; i < N; i++) hash = (hash ^ (unsigned int)args[i]) * 16777619u;
+        return entries[hash & (SIZE - 1)];
+    }
+    bool get(const int* args, int& value) {
+        Entry& entry = slot(args);
+        if (!entry.used || !std::equal(args, args + N, entry.args)) return false;
+        value = entry.value;
+        return true;
+    }
+    void put(const int* args, int value) {
+        Entry& entry = slot(args);
+        entry.used = true;
+        std::copy(args, args + N, entry.args);
+        entry.value = value;
+    }
+};
+)";
+
+void CppBackend::error(const std::string& message) {
+    if (!hadError_) error_ = message;
+    hadError_ = true;
+}
+
+std::string CppBackend::generate(const IRModule& module, const std::string& sourceName) {
+    out_.str("");
+    scenes_.clear();
+    properties_.clear();
+    hadError_ = false;
+    error_.clear();
+
+    for (const auto& function : module.functions) {
+        if (!function->isMain) scenes_[function->name] = function.get();
+    }
+
+    out_ << "// Generated by cinebrew aot from " << sourceName << ": do not edit.\n"
+         << "// Build it against libruntime (see cmake/CineBrewAOT.cmake).\n\n"
+         << "#include \"runtime/runtime.h\"\n"
+         << "#include <algorithm>\n#include <cmath>\n#include <cstdint>\n#include <cstring>\n"
+         << "#include <iostream>\n#include <vector>\n\n"
+         << "namespace cinebrew_aot {\n\n";
+    emitPrelude(module);
+    emitGlobals(module);
+
+    // Declarations first: SCENEs call each other in any order
+    for (const auto& function : module.functions) {
+        out_ << signature(*function) << ";\n";
+    }
+    for (const auto& function : module.functions) {
+        out_ << "\n";
+        emitFunction(*function);
+    }
+
+    out_ << "\n}  // namespace cinebrew_aot\n\n"
+         << "#ifndef CINEBREW_AOT_NO_MAIN\n"
+         << "int main() {\n    cinebrew_aot::run();\n    return 0;\n}\n"
+         << "#endif\n";
+    return out_.str();
+}
+
+// ============================================================================
+// PRELUDE AND GLOBALS
+// ============================================================================
+
+void CppBackend::emitPrelude(const IRModule& module) {
+    out_ << PRELUDE;
+
+    bool objects = false, memo = false;
+    for (const auto& function : module.functions) {
+        if (function->memoized && function->paramCount <= MemoCache::MAX_ARGS) memo = true;
+        for (const auto& block : function->blocks) {
+            for (const auto& instr : block->instrs) {
+                switch (instr->op) {
+                    case IROp::GETPROP: case IROp::SETPROP: case IROp::INITPROP:
+                        properties_.insert({instr->name, (int)properties_.size()});
+                        objects = true;
+                        break;
+                    case IROp::NEWOBJ:
+                        objects = true;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    if (objects) {
+        out_ << "\nconst int PROPERTY_COUNT = " << std::max<size_t>(properties_.size(), 1) << ";\n";
+        out_ << OBJECTS;
+    }
+    if (memo) out_ << MEMO;
+}
+
+void CppBackend::emitGlobals(const IRModule& module) {
+    std::vector<std::string> names;
+    auto add = [&](const std::string& name) {
+        if (std::find(names.begin(), names.end(), name) == names.end()) names.push_back(name);
+    };
+    for (const auto& function : module.functions) {
+        for (const auto& block : function->blocks) {
+            for (const auto& instr : block->instrs) {
+                if (instr->op == IROp::LOAD || instr->op == IROp::STORE) {
+                    add(instr->name);
+                } else if (instr->op == IROp::FORPREP || instr->op == IROp::FORLOOP) {
+                    add(instr->name);
+                    if (forOperand(instr->limit) != instr->limit) add(instr->limit);
+                    if (forOperand(instr->step) != instr->step) add(instr->step);
+                }
+            }
+        }
+    }
+
+    out_ << "\n// ---- Global variables ----\n\nstruct Globals {\n";
+    for (const std::string& name : names) {
+        out_ << "    int " << member(name) << " = 0;\n";
+    }
+    out_ << "};\nGlobals globals;\n\n";
+}
+
+// ============================================================================
+// FUNCTIONS
+// ============================================================================
+
+std::string CppBackend::signature(const IRFunction& function) const {
+    if (function.isMain) return "void run()";
+    std::string text = "int scene_" + function.name + "(";
+    for (int i = 0; i < function.paramCount; i++) {
+        text += (i > 0 ? ", int a" : "int a") + std::to_string(i);
+    }
+    return text + ")";
+}
+
+void CppBackend::emitFunction(const IRFunction& function) {
+    std::vector<IRBlock*> order = function.reversePostorder();
+
+    std::unordered_map<const IRValue*, int> uses;
+    for (IRBlock* block : order) {
+        for (const auto& instr : block->instrs) {
+            for (const IRValue* value : instr->operands) uses[value]++;
+        }
+    }
+
+    out_ << signature(function) << " {\n";
+    // Every value is declared up front: gotos may not skip an initialization
+    for (IRBlock* block : order) {
+        for (const auto& instr : block->instrs) {
+            const IRValue* v = instr.get();
+            bool inlined = v->op == IROp::CONST || v->op == IROp::STRING || v->op == IROp::PARAM;
+            if (v->hasResult() && !inlined && (uses[v] > 0 || v->op == IROp::PHI)) {
+                out_ << "    int v" << v->id << " = 0;\n";
+            }
+        }
+    }
+
+    bool memoized = function.memoized && !function.isMain && function.paramCount <= MemoCache::MAX_ARGS;
+    if (memoized) {
+        out_ << "    static Memo<" << function.paramCount << "> memo;\n";
+        out_ << "    const int key[] = {";
+        for (int i = 0; i < function.paramCount; i++) out_ << (i > 0 ? ", a" : "a") << i;
+        if (function.paramCount == 0) out_ << "0";
+        out_ << "};\n";
+        out_ << "    int remembered;\n";
+        out_ << "    if (memo.get(key, remembered)) return remembered;\n";
+    }
+
+    for (size_t i = 0; i < order.size(); i++) {
+        if (i > 0) out_ << "b" << order[i]->id << ":\n";
+        for (const auto& instr : order[i]->instrs) {
+            if (instr->op == IROp::PHI || instr->isTerminator()) continue;
+            emitInstruction(instr.get(), uses);
+        }
+        emitTerminator(function, order[i]);
+    }
+    out_ << "}\n";
+}
+
+void CppBackend::emitInstruction(const IRValue* instr, const std::unordered_map<const IRValue*, int>& uses) {
+    std::string expression;
+    switch (instr->op) {
+        case IROp::CONST: case IROp::STRING: case IROp::PARAM:
+            return;  // Written where they are used
+
+        case IROp::LOAD:
+            expression = global(instr->name);
+            break;
+
+        case IROp::STORE:
+            out_ << "    " << global(instr->name) << " = " << operand(instr->operands[0]) << ";\n";
+            return;
+
+        case IROp::UNARY: case IROp::BINARY:
+            if (!isHelper(instr->name)) {
+                error("no C++ for opcode " + instr->name);
+                return;
+            }
+            expression = "cb_" + instr->name + "(" + operand(instr->operands[0]);
+            if (instr->op == IROp::BINARY) expression += ", " + operand(instr->operands[1]);
+            expression += ")";
+            break;
+
+        case IROp::CALL: {
+            auto scene = scenes_.find(instr->name);
+            if (runtime_.isBuiltin(instr->name)) {
+                // The VM's call of a built-in: the arguments as a vector
+                std::string args;
+                for (size_t i = 0; i < instr->operands.size(); i++) {
+                    args += (i > 0 ? ", " : "") + operand(instr->operands[i]);
+                }
+                out_ << "    builtinArgs.assign({" << args << "});\n";
+                expression = "Runtime::" + instr->name + "Impl(builtinArgs)";
+            } else if (scene != scenes_.end()) {
+                // Missing arguments read as 0, extra ones are never read
+                expression = "scene_" + instr->name + "(";
+                for (int i = 0; i < scene->second->paramCount; i++) {
+                    if (i > 0) expression += ", ";
+                    expression += i < (int)instr->operands.size() ? operand(instr->operands[i]) : "0";
+                }
+                expression += ")";
+            } else {
+                error("call of unknown SCENE '" + instr->name + "'");
+                return;
+            }
+            break;
+        }
+
+        case IROp::NEWOBJ:
+            expression = "cb_newobj()";
+            break;
+
+        case IROp::GETPROP:
+            expression = "cb_getprop(" + operand(instr->operands[0]) + ", " +
+                         std::to_string(properties_[instr->name]) + ", " + quote(instr->name) + ")";
+            break;
+
+        case IROp::INITPROP: case IROp::SETPROP:
+            out_ << "    cb_setprop(" << operand(instr->operands[0]) << ", " << properties_[instr->name] << ", "
+                 << operand(instr->operands[1]) << ", \""
+                 << (instr->op == IROp::INITPROP ? "INITPROP" : "SETPROP") << "\");\n";
+            if (instr->op == IROp::SETPROP) return;
+            expression = operand(instr->operands[0]);  // The object, for the next field
+            break;
+
+        case IROp::PRINT: {
+            const IRValue* value = instr->operands[0];
+            out_ << "    std::cout << ";
+            if (value->op == IROp::STRING) {
+                // Printed as it stands in the source, like PUSH "text" / PRINT
+                std::string text = value->name;
+                text.erase(0, std::min(text.find_first_not_of(" \t\r\n"), text.size()));
+                text.erase(text.find_last_not_of(" \t\r\n") + 1);
+                out_ << quote(text);
+            } else if (instr->name == "FPRINT") {
+                out_ << "cb_float(" << operand(value) << ")";
+            } else if (instr->name == "XPRINT") {
+                out_ << "(double)" << operand(value) << " / FIXED_ONE";
+            } else {
+                out_ << operand(value);
+            }
+            out_ << " << std::endl;\n";
+            return;
+        }
+
+        default:
+            return;
+    }
+
+    auto used = uses.find(instr);
+    if (used == uses.end() || used->second == 0) {
+        out_ << "    " << expression << ";\n";
+    } else {
+        out_ << "    v" << instr->id << " = " << expression << ";\n";
+    }
+}
+
+/**
+ * Jump along the edge block -> block->succs[succ]: the parallel copy into
+ * the successor's phis (all read before any is written), then the goto.
+ */
+void CppBackend::emitEdge(const IRBlock* block, size_t succ, const std::string& indent) {
+    const IRBlock* target = block->succs[succ];
+    std::vector<IRValue*> phis = target->phis();
+
+    // The n-th edge block -> target is the n-th `block` in target->preds
+    int nth = 0;
+    for (size_t k = 0; k < succ; k++) {
+        if (block->succs[k] == target) nth++;
+    }
+    size_t edge = 0;
+    for (int seen = nth; edge < target->preds.size(); edge++) {
+        if (target->preds[edge] == block && seen-- == 0) break;
+    }
+
+    std::vector<const IRValue*> copies;
+    for (const IRValue* phi : phis) {
+        if (phi->operands[edge] != phi) copies.push_back(phi);
+    }
+    if (copies.size() == 1) {
+        out_ << indent << "v" << copies[0]->id << " = " << operand(copies[0]->operands[edge]) << ";\n";
+    } else if (!copies.empty()) {
+        out_ << indent << "{\n";
+        for (size_t i = 0; i < copies.size(); i++) {
+            out_ << indent << "    int t" << i << " = " << operand(copies[i]->operands[edge]) << ";\n";
+        }
+        for (size_t i = 0; i < copies.size(); i++) {
+            out_ << indent << "    v" << copies[i]->id << " = t" << i << ";\n";
+        }
+        out_ << indent << "}\n";
+    }
+    out_ << indent << "goto b" << target->id << ";\n";
+}
+
+void CppBackend::emitTerminator(const IRFunction& function, const IRBlock* block) {
+    const IRValue* term = block->terminator();
+    bool memoized = function.memoized && function.paramCount <= MemoCache::MAX_ARGS;
+
+    switch (term->op) {
+        case IROp::JUMP:
+            emitEdge(block, 0, "    ");
+            break;
+
+        case IROp::BRANCH:
+            out_ << "    if (" << operand(term->operands[0]) << " != 0) {\n";
+            emitEdge(block, 0, "        ");
+            out_ << "    } else {\n";
+            emitEdge(block, 1, "        ");
+            out_ << "    }\n";
+            break;
+
+        case IROp::SWITCH: {
+            out_ << "    switch (" << operand(term->operands[0]) << ") {\n";
+            for (size_t succ = 0; succ + 1 < block->succs.size(); succ++) {
+                bool any = false;
+                for (const auto& c : term->cases) {
+                    if (c.second != (int)succ) continue;
+                    out_ << "        case " << literal(c.first) << ":\n";
+                    any = true;
+                }
+                if (any) emitEdge(block, succ, "            ");
+            }
+            out_ << "        default:\n";
+            emitEdge(block, block->succs.size() - 1, "            ");
+            out_ << "    }\n";
+            break;
+        }
+
+        case IROp::FORPREP: case IROp::FORLOOP: {
+            // FORPREP enters the body if in range; FORLOOP loops back if so
+            const char* helper = term->op == IROp::FORPREP ? "cb_forprep(" : "cb_forloop(";
+            out_ << "    if (" << helper << global(term->name) << ", " << forOperand(term->limit) << ", "
+                 << forOperand(term->step) << ")) {\n";
+            emitEdge(block, 0, "        ");
+            out_ << "    } else {\n";
+            emitEdge(block, 1, "        ");
+            out_ << "    }\n";
+            break;
+        }
+
+        case IROp::RETURN:
+            if (memoized) out_ << "    memo.put(key, " << operand(term->operands[0]) << ");\n";
+            out_ << "    return " << operand(term->operands[0]) << ";\n";
+            break;
+
+        case IROp::EXIT:
+            out_ << "    return;\n";
+            break;
+
+        default:
+            error(std::string("unexpected terminator ") + irOpName(term->op));
+            break;
+    }
+}
+
+// ============================================================================
+// OPERANDS
+// ============================================================================
+
+std::string CppBackend::operand(const IRValue* value) const {
+    switch (value->op) {
+        case IROp::CONST: return literal(value->imm);
+        case IROp::PARAM: return "a" + std::to_string(value->imm);
+        case IROp::STRING: return "0";  // Only POUR can use a string (the VM pushes 0 too)
+        default: return "v" + std::to_string(value->id);
+    }
+}
+
+// A FOR bound or step: an immediate, or a global read when the loop tests
+std::string CppBackend::forOperand(const std::string& operand) const {
+    errno = 0;
+    char* end = nullptr;
+    long value = std::strtol(operand.c_str(), &end, 10);
+    if (!operand.empty() && *end == '\0' && errno == 0 && value >= INT_MIN && value <= INT_MAX) {
+        return literal((int)value);
+    }
+    return global(operand);
+}
+
+// Hidden globals of the compiler ("__for_limit_0") cannot clash with a
+// user's "g_" name
+std::string CppBackend::member(const std::string& name) {
+    if (name.rfind("__", 0) == 0) return "hidden_" + name.substr(2);
+    return "g_" + name;
+}
+
+std::string CppBackend::global(const std::string& name) {
+    return "globals." + member(name);
+}
+
+std::string CppBackend::literal(int value) {
+    if (value == INT_MIN) return "(-2147483647 - 1)";
+    return std::to_string(value);
+}
+
+std::string CppBackend::quote(const std::string& text) {
+    std::string quoted = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += (char)c;
+        } else if (c == '\n') {
+            quoted += "\\n";
+        } else if (c == '\t') {
+            quoted += "\\t";
+        } else if (c < 0x20 || c == 0x7f) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\%03o", c);
+            quoted += escape;
+        } else {
+            quoted += (char)c;
+        }
+    }
+    return quoted + "\"";
+}
+
+bool CppBackend::isHelper(const std::string& opcode) {
+    for (const char* helper : HELPERS) {
+        if (opcode == helper) return true;
+    }
+    return false;
+}
@@ -0,0 +1,78 @@
+/**
+ * CINEBREW C++ Backend (ahead-of-time compilation)
+ *
+ * ============================================================================
+ * WHAT DOES IT DO?
+ * ============================================================================
+ *
+ * Translates the optimized SSA IR into one C++ source file that needs no
+ * VM at all (`cinebrew aot game.cb -o game.cpp`):
+ *
+ *   SCENE add(a, b)                 int scene_add(int a0, int a1) {
+ *     RETURN a + b;                     int v2 = 0;
+ *                                       v2 = cb_ADD(a0, a1);
+ *                                       return v2;
+ *                                   }
+ *
+ *   - every SCENE becomes a C++ function of int parameters, the main
+ *     program becomes run(); all of them live in namespace cinebrew_aot
+ *   - global variables are the members of one struct (`globals`)
+ *   - every SSA value is a local; blocks are labels, terminators gotos,
+ *     and phis become parallel copies on the edges into their block
+ *   - arithmetic goes through small inline helpers with exactly the VM's
+ *     semantics (wrapping, division by zero, 16.16 fixed, float bits)
+ *   - built-ins are direct calls of the Runtime's implementations
+ *   - objects and memoized SCENEs get a small heap / result cache in the
+ *     file itself, only when the program uses them
+ *
+ * The file compiles with the host compiler against libruntime (and libgui,
+ * which the drawing built-ins need); cmake/CineBrewAOT.cmake does both.
+ *
+ * ============================================================================
+ */
+
+#ifndef CPP_BACKEND_H
+#define CPP_BACKEND_H
+
+#include "ir.h"
+#include <string>
+#include <sstream>
+#include <unordered_map>
+
+class CppBackend {
+public:
+    // Main function: the C++ source of the whole module
+    std::string generate(const IRModule& module, const std::string& sourceName);
+
+    bool hadError() const { return hadError_; }
+    const std::string& getError() const { return error_; }
+
+private:
+    Runtime runtime_;  // Which CALLs are built-ins
+    std::ostringstream out_;
+    std::unordered_map<std::string, const IRFunction*> scenes_;
+    std::unordered_map<std::string, int> properties_;  // Property name -> slot
+    bool hadError_ = false;
+    std::string error_;
+
+    void error(const std::string& message);
+
+    void emitPrelude(const IRModule& module);
+    void emitGlobals(const IRModule& module);
+    void emitFunction(const IRFunction& function);
+    void emitInstruction(const IRValue* instr, const std::unordered_map<const IRValue*, int>& uses);
+    void emitTerminator(const IRFunction& function, const IRBlock* block);
+    void emitEdge(const IRBlock* block, size_t succ, const std::string& indent);
+
+    std::string operand(const IRValue* value) const;
+    std::string forOperand(const std::string& operand) const;
+    std::string signature(const IRFunction& function) const;
+
+    static std::string member(const std::string& name);  // Of struct Globals
+    static std::string global(const std::string& name);
+    static std::string literal(int value);
+    static std::string quote(const std::string& text);
+    static bool isHelper(const std::string& opcode);
+};
+
+#endif // CPP_BACKEND_H
@@ -0,0 +1,153 @@
+/**
+ * Common Subexpression Elimination Implementation
+ */
+
+#include "cse.h"
+#include <algorithm>
+
+int CommonSubexpressionElimination::run(IRFunction& function) {
+    available_.clear();
+    replaced_.clear();
+    children_.clear();
+    globals_.clear();
+    same_.clear();
+
+    IRDominators dominators(function);
+    for (IRBlock* block : dominators.order()) {
+        if (IRBlock* parent = dominators.idom(block)) children_[parent].push_back(block);
+    }
+    if (function.entry()) visit(function.entry());
+    if (replaced_.empty()) return 0;
+
+    // Phis can use values defined further down (loop back edges)
+    for (auto& block : function.blocks) {
+        for (auto& instr : block->instrs) {
+            for (IRValue*& operand : instr->operands) {
+                auto found = replaced_.find(operand);
+                if (found != replaced_.end()) operand = found->second;
+            }
+        }
+        auto& instrs = block->instrs;
+        instrs.erase(std::remove_if(instrs.begin(), instrs.end(),
+                                    [&](const std::unique_ptr<IRValue>& instr) {
+                                        return replaced_.count(instr.get()) > 0;
+                                    }),
+                     instrs.end());
+    }
+    return (int)replaced_.size();
+}
+
+/**
+ * Preorder over the dominator tree: what a block makes available is seen
+ * by the blocks it dominates, and dropped on the way back up.
+ */
+void CommonSubexpressionElimination::visit(IRBlock* block) {
+    std::vector<std::string> added;
+    std::unordered_map<std::string, const IRValue*> saved = globals_;
+    // Entered from anywhere but the dominator: a global may have changed
+    if (block->preds.size() != 1) globals_.clear();
+
+    for (auto& instr : block->instrs) {
+        IRValue* value = instr.get();
+        for (IRValue*& operand : value->operands) {
+            auto found = replaced_.find(operand);
+            if (found != replaced_.end()) operand = found->second;
+        }
+
+        switch (value->op) {
+            case IROp::LOAD:
+                if (!globals_.count(value->name)) globals_[value->name] = value;
+                same_[value] = globals_[value->name];
+                continue;
+            case IROp::STORE:
+            case IROp::FORPREP:
+            case IROp::FORLOOP:
+                globals_.erase(value->name);
+                continue;
+            case IROp::CALL:
+                if (value->hasSideEffects()) globals_.clear();
+                break;
+            default:
+                break;
+        }
+
+        std::string k = key(value);
+        if (k.empty()) continue;
+        auto found = available_.find(k);
+        if (found != available_.end()) {
+            if (cheap(value)) {
+                same_[value] = found->second;
+            } else {
+                replaced_[value] = found->second;
+            }
+        } else {
+            available_[k] = value;
+            added.push_back(k);
+        }
+    }
+
+    for (IRBlock* child : children_[block]) {
+        visit(child);
+    }
+    for (const std::string& k : added) {
+        available_.erase(k);
+    }
+    globals_ = saved;
+}
+
+/**
+ * LOAD d, PUSH 3, MUL costs as much as keeping the result in a local
+ * slot: arithmetic on variables and constants alone is recomputed (but
+ * still numbered, so (d * 3 + 4) is shared).
+ */
+bool CommonSubexpressionElimination::cheap(const IRValue* value) {
+    if (value->op != IROp::UNARY && value->op != IROp::BINARY) return false;
+    for (const IRValue* operand : value->operands) {
+        if (operand->op != IROp::CONST && operand->op != IROp::LOAD && operand->op != IROp::PARAM) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * What the value computes, or "" if it cannot be shared. Constants are
+ * compared by value (every use site has its own CONST); LOADs and cheap
+ * values by the first one that computed the same thing.
+ */
+std::string CommonSubexpressionElimination::key(const IRValue* value) const {
+    std::string head;
+    switch (value->op) {
+        case IROp::UNARY:
+        case IROp::BINARY: {
+            if (value->hasSideEffects()) return "";
+            head = value->name;
+            break;
+        }
+        case IROp::CALL:
+            if (value->hasSideEffects()) return "";
+            head = "call " + value->name;
+            break;
+        case IROp::PHI:
+            head = "phi b" + std::to_string(value->block->id);
+            break;
+        default:
+            return "";
+    }
+
+    std::vector<std::string> operands;
+    for (const IRValue* operand : value->operands) {
+        if (operand->op == IROp::CONST) {
+            operands.push_back("#" + std::to_string((int)operand->type) + ":" + std::to_string(operand->imm));
+        } else if (same_.count(operand)) {
+            operands.push_back("%" + std::to_string(same_.at(operand)->id));
+        } else {
+            operands.push_back("%" + std::to_string(operand->id));
+        }
+    }
+    if (value->isCommutative()) std::sort(operands.begin(), operands.end());
+
+    std::string k = head + " " + std::to_string((int)value->type);
+    for (const std::string& operand : operands) k += " " + operand;
+    return k;
+}
@@ -0,0 +1,61 @@
+/**
+ * CINEBREW Common Subexpression Elimination
+ *
+ * ============================================================================
+ * WHAT DOES IT DO?
+ * ============================================================================
+ *
+ * Computes an expression once when it appears several times with the
+ * same operands:
+ *
+ *   IF paddleY > getScreenHeight() - 100 {      %0 = call getScreenHeight
+ *       paddleY = getScreenHeight() - 100;      %1 = SUB %0, 100
+ *   }                                           branch (paddleY > %1)
+ *                                               ...  store paddleY, %1
+ *
+ * Value numbering over the dominator tree: an instruction is replaced by
+ * an identical one in a block that dominates it (or earlier in its own
+ * block), so the earlier result is always available. Candidates:
+ *
+ *   - UNARY / BINARY arithmetic (not DIV / MOD: they report errors)
+ *   - calls of PURE built-ins (abs, min, max) and FRAME_STABLE ones
+ *     (getScreenHeight, keyPressed, ...): a SCENE runs within one frame,
+ *     and so does the main program
+ *   - phis of the same block with the same incoming values
+ *
+ * Two LOADs of a global count as the same operand when nothing can have
+ * written it in between (no STORE, FOR step, SCENE or effectful call, and
+ * no join on the way). The LOADs themselves stay: reusing one would need
+ * a local slot, which costs as much as the LOAD. The same goes for
+ * arithmetic on variables and constants alone (d * 3): it is recomputed,
+ * but (d * 3 + 4) * 2 is shared.
+ *
+ * ============================================================================
+ */
+
+#ifndef CSE_H
+#define CSE_H
+
+#include "ir_pass.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class CommonSubexpressionElimination : public IRPass {
+public:
+    std::string name() const override { return "cse"; }
+    int run(IRFunction& function) override;
+
+private:
+    std::unordered_map<std::string, IRValue*> available_;  // Key -> dominating value
+    std::unordered_map<const IRValue*, IRValue*> replaced_;
+    std::unordered_map<const IRBlock*, std::vector<IRBlock*>> children_;
+    std::unordered_map<std::string, const IRValue*> globals_;     // Global -> first LOAD since it last changed
+    std::unordered_map<const IRValue*, const IRValue*> same_;     // Kept, but numbered like an earlier value
+
+    void visit(IRBlock* block);
+    std::string key(const IRValue* value) const;
+    static bool cheap(const IRValue* value);
+};
+
+#endif // CSE_H
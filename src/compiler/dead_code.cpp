@@ -0,0 +1,214 @@
+/**
+ * Dead Code Eliminator Implementation
+ *
+ * Removes bytecode that can never execute.
+ */
+
+#include "dead_code.h"
+
+// SCENEs the game loop calls by name, even if the script never does
+static const char* GAME_LOOP_SCENES[] = {"update", "render"};
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+DeadCodeEliminator::DeadCodeEliminator(const std::vector<std::string>& scenes)
+    : scenes_(scenes.begin(), scenes.end()), removed_(0), resolved_(0), removedScenes_(0), haltLabel_(-1) {
+}
+
+void DeadCodeEliminator::run(Bytecode& bytecode) {
+    size_t before = bytecode.size();
+    resolved_ = 0;
+    removedScenes_ = 0;
+
+    namedLabels_.clear();
+    sceneLabels_.assign(bytecode.labels.size(), false);
+    for (size_t label = 0; label < bytecode.labels.size(); label++) {
+        if (bytecode.labels[label].name < 0) continue;
+        const std::string& name = bytecode.symbols[bytecode.labels[label].name];
+        namedLabels_[name] = (int)label;
+        sceneLabels_[label] = scenes_.count(name) > 0;
+    }
+    auto halt = namedLabels_.find("HALT");
+    haltLabel_ = halt == namedLabels_.end() ? -1 : halt->second;
+
+    bool changed = true;
+    while (changed) {
+        changed = resolveConstantBranches(bytecode);
+        changed = removeUnreachable(bytecode) || changed;
+        changed = removeJumpsToNext(bytecode) || changed;
+        changed = removeUnusedLabels(bytecode) || changed;
+    }
+
+    removed_ = (int)(before - bytecode.size());
+}
+
+// ============================================================================
+// STEPS
+// ============================================================================
+
+/**
+ * PUSH <n> directly followed by JZ/JNZ: the outcome is known. One pass
+ * that copies what stays; a branch that goes away can make the PUSH
+ * before it meet the next JZ/JNZ, which is resolved in the same pass.
+ */
+bool DeadCodeEliminator::resolveConstantBranches(Bytecode& program) {
+    std::vector<Instruction> kept;
+    kept.reserve(program.code.size());
+    bool changed = false;
+    for (const Instruction& instruction : program.code) {
+        bool branch = instruction.op == Op::JZ || instruction.op == Op::JNZ;
+        if (!branch || kept.empty() || kept.back().op != Op::PUSH) {
+            kept.push_back(instruction);  // Not a constant branch
+            continue;
+        }
+
+        bool taken = (instruction.op == Op::JZ) == (kept.back().a == 0);
+        if (taken) {
+            kept.back() = {Op::JMP, 0, false, 0, 0, 0, instruction.label, -1};
+        } else {
+            kept.pop_back();
+        }
+        resolved_++;
+        changed = true;
+    }
+    program.code.swap(kept);
+    return changed;
+}
+
+/**
+ * Mark everything reachable from the entry points, then drop the rest.
+ */
+bool DeadCodeEliminator::removeUnreachable(Bytecode& program) {
+    std::vector<Instruction>& code = program.code;
+    std::vector<size_t> placed(program.labels.size(), code.size());
+    for (size_t i = 0; i < code.size(); i++) {
+        if (code[i].op == Op::LABEL) placed[code[i].label] = i;
+    }
+
+    std::vector<bool> reachable(code.size(), false);
+    std::vector<size_t> worklist;
+    worklist.push_back(0);
+    for (const char* scene : GAME_LOOP_SCENES) {
+        auto label = namedLabels_.find(scene);
+        if (scenes_.count(scene) && label != namedLabels_.end()) worklist.push_back(placed[label->second]);
+    }
+
+    std::vector<int> targets;
+    while (!worklist.empty()) {
+        size_t i = worklist.back();
+        worklist.pop_back();
+        if (i >= code.size() || reachable[i]) continue;
+        reachable[i] = true;
+
+        targets.clear();
+        jumpTargets(program, code[i], targets);
+        for (int target : targets) {
+            worklist.push_back(placed[target]);
+        }
+        if (!endsBlock(code[i].op)) worklist.push_back(i + 1);
+    }
+
+    std::vector<Instruction> kept;
+    kept.reserve(code.size());
+    for (size_t i = 0; i < code.size(); i++) {
+        bool label = code[i].op == Op::LABEL;
+        // HALT: marks the end of the program, keep it even if nothing jumps there
+        if (reachable[i] || (label && code[i].label == haltLabel_)) {
+            kept.push_back(code[i]);
+        } else if (label && sceneLabels_[code[i].label]) {
+            removedScenes_++;
+        }
+    }
+
+    bool changed = kept.size() != code.size();
+    code.swap(kept);
+    return changed;
+}
+
+/**
+ * JMP L where L: is among the labels right after it.
+ */
+bool DeadCodeEliminator::removeJumpsToNext(Bytecode& program) {
+    std::vector<Instruction>& code = program.code;
+    std::vector<Instruction> kept;
+    kept.reserve(code.size());
+    for (size_t i = 0; i < code.size(); i++) {
+        bool toNext = false;
+        for (size_t j = i + 1; code[i].op == Op::JMP && j < code.size() && code[j].op == Op::LABEL; j++) {
+            if (code[j].label == code[i].label) {
+                toNext = true;
+                break;
+            }
+        }
+        if (!toNext) kept.push_back(code[i]);
+    }
+
+    bool changed = kept.size() != code.size();
+    code.swap(kept);
+    return changed;
+}
+
+bool DeadCodeEliminator::removeUnusedLabels(Bytecode& program) {
+    std::vector<Instruction>& code = program.code;
+    std::vector<bool> used(program.labels.size(), false);
+    std::vector<int> targets;
+    for (const Instruction& instruction : code) {
+        targets.clear();
+        jumpTargets(program, instruction, targets);
+        for (int target : targets) {
+            used[target] = true;
+        }
+    }
+
+    std::vector<Instruction> kept;
+    kept.reserve(code.size());
+    for (const Instruction& instruction : code) {
+        // SCENE labels are looked up by name (game loop), keep them
+        if (instruction.op == Op::LABEL && instruction.label != haltLabel_ && !used[instruction.label] &&
+            !sceneLabels_[instruction.label]) {
+            continue;
+        }
+        kept.push_back(instruction);
+    }
+
+    bool changed = kept.size() != code.size();
+    code.swap(kept);
+    return changed;
+}
+
+// ============================================================================
+// INSTRUCTION HELPERS
+// ============================================================================
+
+/**
+ * Labels an instruction can transfer control to (a LABEL falls through
+ * and jumps nowhere).
+ */
+void DeadCodeEliminator::jumpTargets(const Bytecode& program, const Instruction& instruction,
+                                     std::vector<int>& targets) const {
+    switch (instruction.op) {
+        case Op::LABEL:
+            break;
+        case Op::CALL: {
+            // CALLs to built-ins have no label
+            auto label = namedLabels_.find(program.symbols[instruction.a]);
+            if (label != namedLabels_.end()) targets.push_back(label->second);
+            break;
+        }
+        case Op::JMPTABLE:
+            targets.push_back(instruction.label);
+            targets.insert(targets.end(), program.tables.begin() + instruction.b,
+                           program.tables.begin() + instruction.b + instruction.c);
+            break;
+        default:
+            // JMP, JZ, JNZ, the J<cmp> superinstructions, FORPREP, FORLOOP
+            if (instruction.label >= 0) targets.push_back(instruction.label);
+            break;
+    }
+}
+
+bool DeadCodeEliminator::endsBlock(Op op) {
+    return op == Op::JMP || op == Op::RET || op == Op::JMPTABLE;
+}
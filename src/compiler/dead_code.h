@@ -0,0 +1,75 @@
+/**
+ * CINEBREW Dead Code Eliminator
+ *
+ * ============================================================================
+ * WHAT DOES IT DO?
+ * ============================================================================
+ *
+ * A pass over the generated bytecode (the instructions IRLowering emits,
+ * before they are linked) that deletes instructions which can never run:
+ *
+ * 1. Constant branches: PUSH 1 / JZ else_0 never jumps, so both go;
+ *    PUSH 0 / JZ else_0 always jumps and becomes JMP else_0.
+ *
+ * 2. Unreachable code: everything not reachable from the first
+ *    instruction, a SCENE the game loop calls (update / render) or a
+ *    CALL in reachable code. This removes the PUSH 0 / RET after a body
+ *    that already ends in SHOT, and whole SCENEs nobody calls.
+ *
+ * 3. Jumps to the next instruction and labels nothing jumps to.
+ *
+ * The steps feed each other, so they are repeated until nothing changes.
+ *
+ * ============================================================================
+ */
+
+#ifndef DEAD_CODE_H
+#define DEAD_CODE_H
+
+#include "../vm/bytecode.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+class DeadCodeEliminator {
+public:
+    // scenes: names of every SCENE in the program (their labels)
+    explicit DeadCodeEliminator(const std::vector<std::string>& scenes);
+
+    // Main function: rewrite the bytecode in place (before link(), see
+    // Bytecode::compact)
+    void run(Bytecode& bytecode);
+
+    // Statistics
+    int removedCount() const { return removed_; }             // Instructions deleted
+    int resolvedBranchCount() const { return resolved_; }     // Constant JZ/JNZ resolved
+    int removedSceneCount() const { return removedScenes_; }  // SCENEs never called
+
+private:
+    std::unordered_set<std::string> scenes_;
+    int removed_;
+    int resolved_;
+    int removedScenes_;
+
+    // Per run: the named labels (SCENE entries, HALT) by name
+    std::unordered_map<std::string, int> namedLabels_;
+    std::vector<bool> sceneLabels_;  // By label id
+    int haltLabel_;                  // -1 if there is none
+
+    // ========================================================================
+    // STEPS (each returns true if it changed the bytecode)
+    // ========================================================================
+    bool resolveConstantBranches(Bytecode& program);
+    bool removeUnreachable(Bytecode& program);
+    bool removeJumpsToNext(Bytecode& program);
+    bool removeUnusedLabels(Bytecode& program);
+
+    // ========================================================================
+    // INSTRUCTION HELPERS
+    // ========================================================================
+    void jumpTargets(const Bytecode& program, const Instruction& instruction, std::vector<int>& targets) const;
+    static bool endsBlock(Op op);  // Never falls through
+};
+
+#endif // DEAD_CODE_H
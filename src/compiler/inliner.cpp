@@ -0,0 +1,234 @@
+/**
+ * Inliner Implementation
+ */
+
+#include "inliner.h"
+#include <deque>
+#include <functional>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+const int Inliner::DEFAULT_THRESHOLD;
+
+Inliner::Inliner(int threshold, const Profile* profile) : threshold_(threshold), profile_(profile) {
+}
+
+int Inliner::run(IRFunction&) {
+    return 0;
+}
+
+/**
+ * Instructions the body costs at a call site (phis and parameters are
+ * free, a JUMP usually disappears once blocks are merged).
+ */
+int Inliner::cost(const IRFunction& function) {
+    int count = 0;
+    for (const auto& block : function.blocks) {
+        for (const auto& instr : block->instrs) {
+            if (instr->op != IROp::PHI && instr->op != IROp::PARAM && instr->op != IROp::JUMP) count++;
+        }
+    }
+    return count;
+}
+
+// ============================================================================
+// DECISIONS
+// ============================================================================
+
+int Inliner::runOnModule(IRModule& module) {
+    decisions_.clear();
+
+    std::map<std::string, IRFunction*> scenes;
+    for (auto& function : module.functions) {
+        if (!function->isMain) scenes[function->name] = function.get();
+    }
+
+    // Call graph: SCENEs each function calls
+    auto callees = [&](const IRFunction* function) {
+        std::set<std::string> names;
+        for (const auto& block : function->blocks) {
+            for (const auto& instr : block->instrs) {
+                if (instr->op == IROp::CALL && scenes.count(instr->name)) names.insert(instr->name);
+            }
+        }
+        return names;
+    };
+    std::map<const IRFunction*, std::set<std::string>> graph;
+    for (auto& function : module.functions) {
+        graph[function.get()] = callees(function.get());
+    }
+
+    // Recursive: the SCENE can reach itself
+    std::set<std::string> recursive;
+    for (const auto& scene : scenes) {
+        std::set<std::string> seen;
+        std::vector<std::string> work(graph[scene.second].begin(), graph[scene.second].end());
+        while (!work.empty()) {
+            std::string name = work.back();
+            work.pop_back();
+            if (name == scene.first) {
+                recursive.insert(scene.first);
+                break;
+            }
+            if (!seen.insert(name).second) continue;
+            for (const std::string& next : graph[scenes[name]]) work.push_back(next);
+        }
+    }
+
+    // Callees before callers (postorder over the call graph)
+    std::vector<IRFunction*> order;
+    std::set<const IRFunction*> visited;
+    std::function<void(IRFunction*)> visit = [&](IRFunction* function) {
+        if (!visited.insert(function).second) return;
+        for (const std::string& name : graph[function]) visit(scenes[name]);
+        order.push_back(function);
+    };
+    for (auto& function : module.functions) {
+        visit(function.get());
+    }
+
+    int inlined = 0;
+    for (IRFunction* caller : order) {
+        std::deque<IRBlock*> work;
+        for (auto& block : caller->blocks) work.push_back(block.get());
+
+        while (!work.empty()) {
+            IRBlock* block = work.front();
+            work.pop_front();
+
+            for (size_t i = 0; i < block->instrs.size(); i++) {
+                IRValue* instr = block->instrs[i].get();
+                if (instr->op != IROp::CALL || !scenes.count(instr->name)) continue;
+
+                const IRFunction* callee = scenes[instr->name];
+                int size = cost(*callee);
+                std::string site = caller->name + ": ";
+                long long calls = profile_ ? profile_->callCount(callee->name) : 0;
+                bool hot = profile_ && profile_->isHot(calls);
+                int threshold = hot ? threshold_ * HOT_FACTOR : threshold_;
+                std::string reason;
+                if (recursive.count(callee->name)) {
+                    reason = "recursive";
+                } else if (callee->memoized) {
+                    reason = "memoized";
+                } else if (callee->inlineHint == InlineHint::NEVER) {
+                    reason = "NOINLINE";
+                } else if (callee->inlineHint != InlineHint::ALWAYS) {
+                    if (profile_ && calls == 0) {
+                        reason = "cold: never called in the profile";
+                    } else if (!callees(callee).empty()) {
+                        reason = "calls other SCENEs";
+                    } else if (size > threshold) {
+                        reason = std::to_string(size) + " instructions > " + std::to_string(threshold);
+                    }
+                }
+
+                if (!reason.empty()) {
+                    decisions_.push_back(site + "kept CALL " + callee->name + " (" + reason + ")");
+                    continue;
+                }
+
+                decisions_.push_back(site + "inlined " + callee->name + " (" + std::to_string(size) +
+                                     " instructions" +
+                                     (callee->inlineHint == InlineHint::ALWAYS ? ", INLINE" : "") +
+                                     (hot ? ", hot: " + std::to_string(calls) + " calls" : "") + ")");
+                // The rest of the block moved; scan it next (the copied
+                // body was already processed as the callee)
+                work.push_front(inlineCall(*caller, block, i, *callee));
+                inlined++;
+                break;
+            }
+        }
+        caller->removeUnreachableBlocks();
+    }
+    return inlined;
+}
+
+// ============================================================================
+// TRANSFORMATION
+// ============================================================================
+
+IRBlock* Inliner::inlineCall(IRFunction& caller, IRBlock* block, size_t index,
+                             const IRFunction& callee) {
+    IRValue* call = block->instrs[index].get();
+
+    // Split the block after the call; the second half keeps the successors
+    IRBlock* after = caller.addBlock("after_" + callee.name);
+    for (size_t i = index + 1; i < block->instrs.size(); i++) {
+        block->instrs[i]->block = after;
+        after->instrs.push_back(std::move(block->instrs[i]));
+    }
+    block->instrs.resize(index + 1);
+    after->succs = block->succs;
+    for (IRBlock* succ : block->succs) {
+        for (IRBlock*& pred : succ->preds) {
+            if (pred == block) pred = after;
+        }
+    }
+    block->succs.clear();
+
+    // Copy the blocks, then the instructions, then the operands (a phi may
+    // use a value defined further down)
+    std::unordered_map<const IRBlock*, IRBlock*> blocks;
+    std::unordered_map<const IRValue*, IRValue*> values;
+    for (const auto& source : callee.blocks) {
+        blocks[source.get()] = caller.addBlock(source->hint);
+    }
+
+    std::vector<std::pair<IRBlock*, const IRValue*>> returns;
+    for (const auto& source : callee.blocks) {
+        IRBlock* copy = blocks[source.get()];
+        for (const auto& instr : source->instrs) {
+            if (instr->op == IROp::PARAM) {
+                values[instr.get()] = call->operands[instr->imm];
+            } else if (instr->op == IROp::RETURN) {
+                caller.append(copy, IROp::JUMP, ValueType::INT);
+                returns.push_back({copy, instr->operands[0]});
+            } else {
+                IRValue* clone = caller.append(copy, instr->op, instr->type);
+                clone->imm = instr->imm;
+                clone->name = instr->name;
+                clone->limit = instr->limit;
+                clone->step = instr->step;
+                clone->cases = instr->cases;
+                clone->purity = instr->purity;
+                clone->site = instr->site;
+                values[instr.get()] = clone;
+            }
+        }
+    }
+    for (const auto& source : callee.blocks) {
+        for (const auto& instr : source->instrs) {
+            auto clone = values.find(instr.get());
+            if (clone == values.end() || instr->op == IROp::PARAM) continue;
+            for (IRValue* operand : instr->operands) {
+                clone->second->operands.push_back(values[operand]);
+            }
+        }
+        IRBlock* copy = blocks[source.get()];
+        for (IRBlock* pred : source->preds) copy->preds.push_back(blocks[pred]);
+        for (IRBlock* succ : source->succs) copy->succs.push_back(blocks[succ]);
+    }
+
+    // Every SHOT continues after the call
+    IRValue* result;
+    if (returns.empty()) {
+        result = caller.insert(after, 0, IROp::CONST, ValueType::INT);  // Never returns
+    } else if (returns.size() == 1) {
+        IRFunction::addEdge(returns[0].first, after);
+        result = values[returns[0].second];
+    } else {
+        result = caller.insert(after, 0, IROp::PHI, ValueType::INT);
+        for (const auto& ret : returns) {
+            IRFunction::addEdge(ret.first, after);
+            result->operands.push_back(values[ret.second]);
+        }
+    }
+    caller.replaceAllUses(call, result);
+
+    block->instrs.pop_back();
+    caller.append(block, IROp::JUMP, ValueType::INT);
+    IRFunction::addEdge(block, blocks[callee.entry()]);
+    return after;
+}
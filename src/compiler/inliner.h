@@ -0,0 +1,77 @@
+/**
+ * CINEBREW Inliner
+ *
+ * ============================================================================
+ * WHAT DOES IT DO?
+ * ============================================================================
+ *
+ * Replaces a CALL of a small SCENE with a copy of the SCENE's body, so
+ * helpers like
+ *
+ *   SCENE clamp(v) { IF v > 100 { SHOT 100; } SHOT v; }
+ *
+ * no longer pay for CALL, the Frame, LOADARG and RET. Parameters become
+ * the call's argument values (plain SSA values, no copies), each SHOT
+ * jumps to the code after the call, and a phi merges the results when
+ * there are several SHOTs.
+ *
+ * ============================================================================
+ * COST MODEL
+ * ============================================================================
+ *
+ * A SCENE is inlined automatically when it is a leaf (calls no other
+ * SCENE, built-ins are fine) and its body is at most `threshold` IR
+ * instructions. Functions are processed callees first, so a SCENE whose
+ * own calls were all inlined counts as a leaf.
+ *
+ *   INLINE SCENE f(...)    - inline at every call, whatever its size
+ *   NOINLINE SCENE f(...)  - never inline
+ *   MEMO SCENE f(...)      - never inline (the VM caches its results)
+ *
+ * Recursive SCENEs (anything on a call cycle) are never inlined, with or
+ * without INLINE. The SCENE itself stays in the module; dead code
+ * elimination drops it when no call is left.
+ *
+ * With a profile (see profile.h), a hot SCENE may be HOT_FACTOR times
+ * the threshold, and a SCENE the profiled run never called is not
+ * inlined at all (unless INLINE): its calls are cold code.
+ *
+ * ============================================================================
+ */
+
+#ifndef INLINER_H
+#define INLINER_H
+
+#include "ir_pass.h"
+#include "profile.h"
+#include <string>
+#include <vector>
+
+class Inliner : public IRPass {
+public:
+    static const int DEFAULT_THRESHOLD = 12;
+    static const int HOT_FACTOR = 4;  // Threshold multiplier for hot SCENEs
+
+    explicit Inliner(int threshold = DEFAULT_THRESHOLD, const Profile* profile = nullptr);
+
+    std::string name() const override { return "inline"; }
+    int run(IRFunction& function) override;  // Needs the module: no-op
+    int runOnModule(IRModule& module) override;
+
+    // One line per call site: "main: inlined clamp (6 instructions)"
+    const std::vector<std::string>& getDecisions() const { return decisions_; }
+
+private:
+    int threshold_;
+    const Profile* profile_;
+    std::vector<std::string> decisions_;
+
+    static int cost(const IRFunction& function);
+
+    // Replace block->instrs[index] (a CALL of callee) with callee's body;
+    // returns the block holding the code that followed the call
+    static IRBlock* inlineCall(IRFunction& caller, IRBlock* block, size_t index,
+                               const IRFunction& callee);
+};
+
+#endif // INLINER_H
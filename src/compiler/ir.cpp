@@ -0,0 +1,574 @@
+/**
+ * Mid-Level IR Implementation
+ *
+ * IR data structures, CFG editing, printing and the verifier.
+ */
+
+#include "ir.h"
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+// ============================================================================
+// OPERATIONS
+// ============================================================================
+
+const char* irOpName(IROp op) {
+    switch (op) {
+        case IROp::CONST: return "const";
+        case IROp::STRING: return "string";
+        case IROp::PARAM: return "param";
+        case IROp::LOAD: return "load";
+        case IROp::UNARY: return "unary";
+        case IROp::BINARY: return "binary";
+        case IROp::CALL: return "call";
+        case IROp::NEWOBJ: return "newobj";
+        case IROp::GETPROP: return "getprop";
+        case IROp::INITPROP: return "initprop";
+        case IROp::PHI: return "phi";
+        case IROp::STORE: return "store";
+        case IROp::SETPROP: return "setprop";
+        case IROp::PRINT: return "print";
+        case IROp::JUMP: return "jump";
+        case IROp::BRANCH: return "branch";
+        case IROp::SWITCH: return "switch";
+        case IROp::FORPREP: return "forprep";
+        case IROp::FORLOOP: return "forloop";
+        case IROp::RETURN: return "ret";
+        case IROp::EXIT: return "exit";
+    }
+    return "?";
+}
+
+bool IRValue::hasResult() const {
+    switch (op) {
+        case IROp::CONST: case IROp::STRING: case IROp::PARAM: case IROp::LOAD:
+        case IROp::UNARY: case IROp::BINARY: case IROp::CALL: case IROp::NEWOBJ:
+        case IROp::GETPROP: case IROp::INITPROP: case IROp::PHI:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool IRValue::isTerminator() const {
+    switch (op) {
+        case IROp::JUMP: case IROp::BRANCH: case IROp::SWITCH: case IROp::FORPREP:
+        case IROp::FORLOOP: case IROp::RETURN: case IROp::EXIT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool IRValue::hasSideEffects() const {
+    switch (op) {
+        case IROp::CONST: case IROp::STRING: case IROp::PARAM: case IROp::LOAD:
+        case IROp::UNARY: case IROp::PHI:
+            return false;
+        case IROp::BINARY:
+            // Integer division reports division by zero; the unchecked
+            // forms are only safe where RangeAnalysis left them
+            return name == "DIV" || name == "MOD" || name == "XDIV" ||
+                   name == "DIVNZ" || name == "MODNZ" || name == "XDIVNZ";
+        case IROp::CALL:
+            return purity == Purity::EFFECTFUL;
+        default:
+            // Calls, object operations (allocation, inline-cache counters),
+            // stores, prints and control flow
+            return true;
+    }
+}
+
+bool IRValue::isCommutative() const {
+    static const char* const opcodes[] = {
+        "ADD", "MUL", "BAND", "BOR", "BXOR", "EQ", "NE", "FADD", "FMUL", "FEQ", "FNE", "XMUL",
+    };
+    if (op != IROp::BINARY) return false;
+    for (const char* opcode : opcodes) {
+        if (name == opcode) return true;
+    }
+    return false;
+}
+
+// ============================================================================
+// BLOCKS
+// ============================================================================
+
+IRValue* IRBlock::terminator() const {
+    if (instrs.empty() || !instrs.back()->isTerminator()) return nullptr;
+    return instrs.back().get();
+}
+
+std::vector<IRValue*> IRBlock::phis() const {
+    std::vector<IRValue*> result;
+    for (const auto& instr : instrs) {
+        if (instr->op != IROp::PHI) break;
+        result.push_back(instr.get());
+    }
+    return result;
+}
+
+// ============================================================================
+// FUNCTIONS
+// ============================================================================
+
+IRBlock* IRFunction::addBlock(const std::string& hint) {
+    blocks.push_back(std::make_unique<IRBlock>(nextBlockId++, hint));
+    return blocks.back().get();
+}
+
+IRValue* IRFunction::append(IRBlock* block, IROp op, ValueType type) {
+    return insert(block, block->instrs.size(), op, type);
+}
+
+IRValue* IRFunction::insert(IRBlock* block, size_t index, IROp op, ValueType type) {
+    auto value = std::make_unique<IRValue>(nextValueId++, op, type);
+    value->block = block;
+    IRValue* raw = value.get();
+    block->instrs.insert(block->instrs.begin() + index, std::move(value));
+    return raw;
+}
+
+void IRFunction::addEdge(IRBlock* from, IRBlock* to) {
+    from->succs.push_back(to);
+    to->preds.push_back(from);
+}
+
+/**
+ * Remove the edge from->succs[succIndex], and the phi operands that came
+ * in along it. The succ slot itself is erased, so callers that keep
+ * terminator data indexed by successor must adjust it.
+ */
+void IRFunction::removeEdge(IRBlock* from, size_t succIndex) {
+    IRBlock* to = from->succs[succIndex];
+
+    // The n-th edge from -> to is the n-th `from` in to->preds
+    int nth = 0;
+    for (size_t i = 0; i < succIndex; i++) {
+        if (from->succs[i] == to) nth++;
+    }
+    size_t predIndex = 0;
+    for (size_t i = 0; i < to->preds.size(); i++) {
+        if (to->preds[i] == from && nth-- == 0) {
+            predIndex = i;
+            break;
+        }
+    }
+
+    to->preds.erase(to->preds.begin() + predIndex);
+    for (IRValue* phi : to->phis()) {
+        phi->operands.erase(phi->operands.begin() + predIndex);
+    }
+    from->succs.erase(from->succs.begin() + succIndex);
+}
+
+void IRFunction::replaceAllUses(IRValue* from, IRValue* to) {
+    for (auto& block : blocks) {
+        for (auto& instr : block->instrs) {
+            for (IRValue*& operand : instr->operands) {
+                if (operand == from) operand = to;
+            }
+        }
+    }
+}
+
+int IRFunction::countUses(IRValue* value) const {
+    int uses = 0;
+    for (const auto& block : blocks) {
+        for (const auto& instr : block->instrs) {
+            for (IRValue* operand : instr->operands) {
+                if (operand == value) uses++;
+            }
+        }
+    }
+    return uses;
+}
+
+void IRFunction::removeUnreachableBlocks() {
+    std::unordered_set<IRBlock*> reachable;
+    for (IRBlock* block : reversePostorder()) {
+        reachable.insert(block);
+    }
+
+    // Detach dead blocks from the live ones first (their phi operands go too)
+    for (auto& block : blocks) {
+        if (reachable.count(block.get())) continue;
+        while (!block->succs.empty()) {
+            removeEdge(block.get(), block->succs.size() - 1);
+        }
+    }
+
+    blocks.erase(std::remove_if(blocks.begin(), blocks.end(),
+                                [&](const std::unique_ptr<IRBlock>& block) {
+                                    return !reachable.count(block.get());
+                                }),
+                 blocks.end());
+}
+
+std::vector<IRBlock*> IRFunction::reversePostorder() const {
+    std::vector<IRBlock*> order;
+    if (blocks.empty()) return order;
+
+    // Iterative DFS: (block, successors visited so far). Successors are
+    // visited last-first so the first one (then / loop body) comes right
+    // after its block in the order, which lowering uses as the layout.
+    std::unordered_set<IRBlock*> visited;
+    std::vector<std::pair<IRBlock*, size_t>> stack;
+    stack.push_back({entry(), 0});
+    visited.insert(entry());
+    while (!stack.empty()) {
+        IRBlock* block = stack.back().first;
+        size_t& next = stack.back().second;
+        if (next < block->succs.size()) {
+            IRBlock* succ = block->succs[block->succs.size() - 1 - next++];
+            if (!visited.count(succ)) {
+                visited.insert(succ);
+                stack.push_back({succ, 0});
+            }
+        } else {
+            order.push_back(block);
+            stack.pop_back();
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// ============================================================================
+// DOMINATORS
+// ============================================================================
+
+/**
+ * Cooper, Harvey & Kennedy, "A Simple, Fast Dominance Algorithm": iterate
+ * idom over the blocks in reverse postorder until nothing changes.
+ */
+IRDominators::IRDominators(const IRFunction& function) : rpo_(function.reversePostorder()) {
+    for (size_t i = 0; i < rpo_.size(); i++) index_[rpo_[i]] = (int)i;
+    idom_.assign(rpo_.size(), -1);
+    if (rpo_.empty()) return;
+
+    idom_[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = 1; b < rpo_.size(); b++) {
+            int newIdom = -1;
+            for (IRBlock* pred : rpo_[b]->preds) {
+                auto p = index_.find(pred);
+                if (p == index_.end() || idom_[p->second] < 0) continue;
+                if (newIdom < 0) {
+                    newIdom = p->second;
+                    continue;
+                }
+                int x = p->second, y = newIdom;
+                while (x != y) {
+                    while (x > y) x = idom_[x];
+                    while (y > x) y = idom_[y];
+                }
+                newIdom = x;
+            }
+            if (newIdom != idom_[b]) {
+                idom_[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+}
+
+IRBlock* IRDominators::idom(const IRBlock* block) const {
+    auto found = index_.find(block);
+    if (found == index_.end() || found->second == 0) return nullptr;
+    return rpo_[idom_[found->second]];
+}
+
+bool IRDominators::dominates(const IRBlock* a, const IRBlock* b) const {
+    auto ia = index_.find(a), ib = index_.find(b);
+    if (ia == index_.end() || ib == index_.end()) return false;
+    int x = ib->second;
+    while (x != ia->second && x != 0) x = idom_[x];
+    return x == ia->second;
+}
+
+// ============================================================================
+// PRINTING
+// ============================================================================
+
+static std::string valueName(const IRValue* value) {
+    return "%" + std::to_string(value->id);
+}
+
+static std::string blockName(const IRBlock* block) {
+    return "b" + std::to_string(block->id);
+}
+
+static std::string instructionToString(const IRValue* instr) {
+    std::ostringstream out;
+    if (instr->hasResult()) {
+        out << valueName(instr) << " = ";
+    }
+
+    switch (instr->op) {
+        case IROp::CONST:
+            out << "const " << instr->imm;
+            if (instr->type != ValueType::INT) out << " : " << valueTypeToString(instr->type);
+            break;
+        case IROp::STRING: out << "string \"" << instr->name << "\""; break;
+        case IROp::PARAM:
+            out << "param " << instr->imm;
+            if (instr->name == "LOADARGU") out << " unchecked";
+            break;
+        case IROp::UNARY: case IROp::BINARY: case IROp::PRINT: out << instr->name; break;
+        case IROp::LOAD: case IROp::STORE: case IROp::CALL:
+        case IROp::GETPROP: case IROp::INITPROP: case IROp::SETPROP:
+            out << irOpName(instr->op) << " " << instr->name;
+            if (instr->purity == Purity::PURE) out << " pure";
+            if (instr->purity == Purity::FRAME_STABLE) out << " frame-stable";
+            break;
+        case IROp::FORPREP: case IROp::FORLOOP:
+            out << irOpName(instr->op) << " " << instr->name << " " << instr->limit << " "
+                << instr->step;
+            break;
+        default: out << irOpName(instr->op); break;
+    }
+
+    for (size_t i = 0; i < instr->operands.size(); i++) {
+        out << (i == 0 ? " " : ", ") << valueName(instr->operands[i]);
+    }
+
+    const std::vector<IRBlock*>& succs = instr->block->succs;
+    if (instr->op == IROp::SWITCH) {
+        out << " [";
+        for (size_t i = 0; i < instr->cases.size(); i++) {
+            out << (i == 0 ? "" : ", ") << instr->cases[i].first << ": "
+                << blockName(succs[instr->cases[i].second]);
+        }
+        out << "] default " << blockName(succs.back());
+    } else if (instr->isTerminator()) {
+        for (size_t i = 0; i < succs.size(); i++) {
+            out << (i == 0 && instr->operands.empty() ? " " : ", ") << blockName(succs[i]);
+        }
+    }
+    return out.str();
+}
+
+std::string irFunctionToString(const IRFunction& function) {
+    std::ostringstream out;
+    out << (function.isMain ? "main" : "scene " + function.name + "(" +
+                                           std::to_string(function.paramCount) + ")")
+        << ":" << std::endl;
+    for (const auto& block : function.blocks) {
+        out << blockName(block.get()) << ":";
+        if (!block->preds.empty()) {
+            out << "  ; preds";
+            for (IRBlock* pred : block->preds) out << " " << blockName(pred);
+        }
+        out << std::endl;
+        for (const auto& instr : block->instrs) {
+            out << "  " << instructionToString(instr.get()) << std::endl;
+        }
+    }
+    return out.str();
+}
+
+std::string IRModule::toString() const {
+    std::string result;
+    for (const auto& function : functions) {
+        result += irFunctionToString(*function);
+    }
+    return result;
+}
+
+int IRModule::instructionCount() const {
+    int count = 0;
+    for (const auto& function : functions) {
+        for (const auto& block : function->blocks) {
+            count += (int)block->instrs.size();
+        }
+    }
+    return count;
+}
+
+// ============================================================================
+// VERIFIER
+// ============================================================================
+
+bool IRVerifier::verify(const IRModule& module) {
+    errors_.clear();
+    bool ok = true;
+    for (const auto& function : module.functions) {
+        std::vector<std::string> saved = errors_;
+        ok = verify(*function) && ok;
+        saved.insert(saved.end(), errors_.begin(), errors_.end());
+        errors_ = saved;
+    }
+    return ok;
+}
+
+void IRVerifier::error(const IRFunction& function, const std::string& message) {
+    errors_.push_back("IR " + (function.isMain ? std::string("main") : function.name) + ": " +
+                      message);
+}
+
+// Expected operand count per operation (-1: any)
+static int expectedOperands(const IRValue* instr) {
+    switch (instr->op) {
+        case IROp::CONST: case IROp::STRING: case IROp::PARAM: case IROp::LOAD:
+        case IROp::NEWOBJ: case IROp::JUMP: case IROp::FORPREP: case IROp::FORLOOP:
+        case IROp::EXIT:
+            return 0;
+        case IROp::UNARY: case IROp::GETPROP: case IROp::STORE: case IROp::PRINT:
+        case IROp::BRANCH: case IROp::SWITCH: case IROp::RETURN:
+            return 1;
+        case IROp::BINARY: case IROp::INITPROP: case IROp::SETPROP:
+            return 2;
+        default:
+            return -1;  // CALL, PHI
+    }
+}
+
+static size_t expectedSuccessors(const IRValue* instr, size_t actual) {
+    switch (instr->op) {
+        case IROp::JUMP: return 1;
+        case IROp::BRANCH: case IROp::FORPREP: case IROp::FORLOOP: return 2;
+        case IROp::SWITCH: return actual >= 1 ? actual : 1;
+        default: return 0;  // RETURN, EXIT
+    }
+}
+
+bool IRVerifier::verify(const IRFunction& function) {
+    errors_.clear();
+    if (function.blocks.empty()) {
+        error(function, "no blocks");
+        return false;
+    }
+    if (!function.entry()->preds.empty()) {
+        error(function, "entry block has predecessors");
+    }
+
+    std::unordered_map<const IRValue*, const IRBlock*> defined;
+    std::unordered_map<const IRValue*, size_t> position;
+    std::unordered_set<const IRBlock*> inFunction;
+    for (const auto& block : function.blocks) {
+        inFunction.insert(block.get());
+        for (size_t i = 0; i < block->instrs.size(); i++) {
+            defined[block->instrs[i].get()] = block.get();
+            position[block->instrs[i].get()] = i;
+        }
+    }
+
+    // Structure and CFG consistency
+    for (const auto& block : function.blocks) {
+        std::string where = "b" + std::to_string(block->id);
+        if (!block->terminator()) {
+            error(function, where + " does not end in a terminator");
+            continue;
+        }
+
+        bool pastPhis = false;
+        for (size_t i = 0; i < block->instrs.size(); i++) {
+            const IRValue* instr = block->instrs[i].get();
+            if (instr->block != block.get()) {
+                error(function, where + ": %" + std::to_string(instr->id) + " has a wrong parent block");
+            }
+            if (instr->isTerminator() && i + 1 != block->instrs.size()) {
+                error(function, where + ": terminator in the middle of the block");
+            }
+            if (instr->op == IROp::PHI) {
+                if (pastPhis) error(function, where + ": phi after a non-phi instruction");
+                if (instr->operands.size() != block->preds.size()) {
+                    error(function, where + ": phi %" + std::to_string(instr->id) +
+                                        " has " + std::to_string(instr->operands.size()) +
+                                        " operands for " + std::to_string(block->preds.size()) +
+                                        " predecessors");
+                }
+            } else {
+                pastPhis = true;
+            }
+
+            int expected = expectedOperands(instr);
+            if (expected >= 0 && (int)instr->operands.size() != expected) {
+                error(function, where + ": %" + std::to_string(instr->id) + " (" +
+                                    irOpName(instr->op) + ") has " +
+                                    std::to_string(instr->operands.size()) + " operands");
+            }
+            for (const IRValue* operand : instr->operands) {
+                if (!operand || !defined.count(operand)) {
+                    error(function, where + ": %" + std::to_string(instr->id) +
+                                        " uses a value from outside the function");
+                } else if (!operand->hasResult()) {
+                    error(function, where + ": %" + std::to_string(instr->id) +
+                                        " uses an instruction without a result");
+                }
+            }
+        }
+
+        const IRValue* term = block->terminator();
+        if (block->succs.size() != expectedSuccessors(term, block->succs.size())) {
+            error(function, where + ": " + irOpName(term->op) + " has " +
+                                std::to_string(block->succs.size()) + " successors");
+        }
+        if (term->op == IROp::SWITCH) {
+            for (const auto& c : term->cases) {
+                if (c.second < 0 || c.second + 1 >= (int)block->succs.size()) {
+                    error(function, where + ": switch case targets a bad successor");
+                }
+            }
+        }
+
+        for (const IRBlock* succ : block->succs) {
+            if (!inFunction.count(succ)) {
+                error(function, where + ": successor outside the function");
+                continue;
+            }
+            size_t out = std::count(block->succs.begin(), block->succs.end(), succ);
+            size_t in = std::count(succ->preds.begin(), succ->preds.end(), block.get());
+            if (out != in) error(function, where + ": succs and preds disagree");
+        }
+        for (const IRBlock* pred : block->preds) {
+            if (!inFunction.count(pred) ||
+                std::find(pred->succs.begin(), pred->succs.end(), block.get()) == pred->succs.end()) {
+                error(function, where + ": predecessor does not branch here");
+            }
+        }
+    }
+    if (!errors_.empty()) return false;
+
+    if (function.reversePostorder().size() != function.blocks.size()) {
+        error(function, "has unreachable blocks");
+        return false;
+    }
+    IRDominators dominators(function);
+    auto dominates = [&](const IRBlock* a, const IRBlock* b) {
+        return dominators.dominates(a, b);
+    };
+
+    // Every use is dominated by its definition
+    for (const auto& block : function.blocks) {
+        for (const auto& instr : block->instrs) {
+            for (size_t k = 0; k < instr->operands.size(); k++) {
+                const IRValue* operand = instr->operands[k];
+                const IRBlock* defBlock = defined[operand];
+                bool ok;
+                if (instr->op == IROp::PHI) {
+                    // Must be available at the end of the k-th predecessor
+                    ok = dominates(defBlock, block->preds[k]);
+                } else if (defBlock == block.get()) {
+                    ok = position[operand] < position[instr.get()];
+                } else {
+                    ok = dominates(defBlock, block.get());
+                }
+                if (!ok) {
+                    error(function, "b" + std::to_string(block->id) + ": %" +
+                                        std::to_string(instr->id) + " uses %" +
+                                        std::to_string(operand->id) +
+                                        " before it is defined");
+                }
+            }
+        }
+    }
+
+    return errors_.empty();
+}
@@ -0,0 +1,212 @@
+/**
+ * CINEBREW Mid-Level IR
+ *
+ * ============================================================================
+ * WHAT IS IT?
+ * ============================================================================
+ *
+ * A control-flow graph of basic blocks in SSA form, between the AST and
+ * the bytecode:
+ *
+ *   AST → IRBuilder → IR → IRPassManager (passes + verifier) → IRLowering → Bytecode
+ *
+ * Every instruction that produces a value is defined exactly once and is
+ * referred to by pointer, so passes see data flow directly instead of
+ * re-parsing "LOAD x" strings or walking unique_ptr trees:
+ *
+ *   TAKE y = x * 2 + 1;         b0:
+ *                                 %0 = load x
+ *                                 %1 = const 2
+ *                                 %2 = MUL %0, %1
+ *                                 %3 = const 1
+ *                                 %4 = ADD %2, %3
+ *                                 store y, %4
+ *
+ * Global variables stay in memory (load / store): any CALL may change
+ * them. SCENE parameters are SSA values; reassigning one creates a new
+ * value and phis merge them where control flow joins.
+ *
+ * Arithmetic carries the typed VM opcode (ADD, FADD, XMUL, I2F, ...), so
+ * the IR has exactly the VM's semantics and lowering stays trivial.
+ *
+ * ============================================================================
+ */
+
+#ifndef IR_H
+#define IR_H
+
+#include "ast.h"
+#include "../runtime/runtime.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+struct IRBlock;
+struct IRFunction;
+
+/**
+ * IR Operations
+ */
+enum class IROp {
+    // Values
+    CONST,      // imm: INT value, 16.16 raw value or float bits (see type)
+    STRING,     // name: string literal (only POUR uses strings)
+    PARAM,      // imm: parameter index, the argument's value on entry; name: LOADARG / LOADARGU
+    LOAD,       // name: global variable
+    UNARY,      // name: VM opcode (NEG, I2F, F2I, ...); operands: value
+    BINARY,     // name: VM opcode (ADD, FADD, XMUL, LT, ...); operands: left, right
+    CALL,       // name: SCENE or built-in; operands: arguments
+    NEWOBJ,     // New empty object
+    GETPROP,    // name: property; operands: object
+    INITPROP,   // name: property; operands: object, value; result: the object
+    PHI,        // operands: one incoming value per predecessor, same order as preds
+
+    // Effects (no value)
+    STORE,      // name: global variable; operands: value
+    SETPROP,    // name: property; operands: object, value
+    PRINT,      // name: PRINT / FPRINT / XPRINT; operands: value
+
+    // Terminators (last instruction of every block)
+    JUMP,       // succs: target
+    BRANCH,     // operands: condition; succs: if non-zero, if zero
+    SWITCH,     // operands: subject; cases: (value, succ index); last succ: default
+    FORPREP,    // name: variable; limit, step: immediates or globals; succs: body, exit
+    FORLOOP,    // same operands as FORPREP; succs: body, exit
+    RETURN,     // operands: value (SCENEs)
+    EXIT        // End of the main program
+};
+
+const char* irOpName(IROp op);
+
+/**
+ * One instruction. Instructions that produce a value are SSA values.
+ */
+struct IRValue {
+    int id;
+    IROp op;
+    ValueType type;
+    std::vector<IRValue*> operands;
+    int imm;
+    std::string name;                          // Variable / callee / property / opcode
+    std::string limit, step;                   // FORPREP / FORLOOP operands
+    std::vector<std::pair<int, int>> cases;    // SWITCH: (case value, succ index)
+    Purity purity;                             // CALL: the built-in's; SCENEs are EFFECTFUL
+    std::string site;                          // BRANCH / FORLOOP: "line.n" key in a Profile
+    IRBlock* block;
+
+    IRValue(int id, IROp op, ValueType type)
+        : id(id), op(op), type(type), imm(0), purity(Purity::EFFECTFUL), block(nullptr) {}
+
+    bool hasResult() const;
+    bool isTerminator() const;
+    bool hasSideEffects() const;  // Must run even if its result is unused
+    bool isCommutative() const;   // BINARY whose operands can be swapped
+};
+
+/**
+ * Basic block: phis first, then ordinary instructions, then one terminator.
+ */
+struct IRBlock {
+    int id;
+    std::string hint;                          // Label prefix (else, loop, ...)
+    std::vector<std::unique_ptr<IRValue>> instrs;
+    std::vector<IRBlock*> preds;               // One entry per incoming edge
+    std::vector<IRBlock*> succs;
+
+    IRBlock(int id, const std::string& hint) : id(id), hint(hint) {}
+
+    IRValue* terminator() const;
+    std::vector<IRValue*> phis() const;
+};
+
+/**
+ * INLINE / NOINLINE hint of a SCENE
+ */
+enum class InlineHint { DEFAULT, ALWAYS, NEVER };
+
+/**
+ * A SCENE, or the main program (isMain). blocks[0] is the entry.
+ */
+struct IRFunction {
+    std::string name;
+    int paramCount;
+    bool isMain;
+    InlineHint inlineHint;
+    bool memoized;  // Pure and recursive or MEMO: results cached by the VM
+    std::vector<std::unique_ptr<IRBlock>> blocks;
+    int nextValueId;
+    int nextBlockId;
+
+    IRFunction(const std::string& name, int paramCount, bool isMain)
+        : name(name), paramCount(paramCount), isMain(isMain), inlineHint(InlineHint::DEFAULT),
+          memoized(false), nextValueId(0), nextBlockId(0) {}
+
+    IRBlock* entry() const { return blocks.empty() ? nullptr : blocks[0].get(); }
+    IRBlock* addBlock(const std::string& hint);
+
+    // New instruction appended to `block` (before nothing: callers keep the
+    // terminator last) or inserted at `index`
+    IRValue* append(IRBlock* block, IROp op, ValueType type);
+    IRValue* insert(IRBlock* block, size_t index, IROp op, ValueType type);
+
+    // CFG editing
+    static void addEdge(IRBlock* from, IRBlock* to);
+    void removeEdge(IRBlock* from, size_t succIndex);  // Also drops phi operands
+    void replaceAllUses(IRValue* from, IRValue* to);
+    int countUses(IRValue* value) const;
+    void removeUnreachableBlocks();
+
+    // Blocks in reverse postorder from the entry (reachable blocks only)
+    std::vector<IRBlock*> reversePostorder() const;
+};
+
+/**
+ * Dominator tree of a function's reachable blocks. a dominates b when
+ * every path from the entry to b goes through a (a block dominates itself).
+ */
+class IRDominators {
+public:
+    explicit IRDominators(const IRFunction& function);
+    bool dominates(const IRBlock* a, const IRBlock* b) const;
+    IRBlock* idom(const IRBlock* block) const;  // nullptr for the entry
+    const std::vector<IRBlock*>& order() const { return rpo_; }  // Reverse postorder
+
+private:
+    std::vector<IRBlock*> rpo_;
+    std::unordered_map<const IRBlock*, int> index_;
+    std::vector<int> idom_;  // Index into rpo_ of the immediate dominator
+};
+
+/**
+ * The whole program: main first, then one function per SCENE.
+ */
+struct IRModule {
+    std::vector<std::unique_ptr<IRFunction>> functions;
+    std::string toString() const;
+    int instructionCount() const;  // Over every block of every function
+};
+
+std::string irFunctionToString(const IRFunction& function);
+
+/**
+ * IR Verifier
+ *
+ * Checks the invariants every pass may rely on:
+ *   - every block ends in exactly one terminator, phis come first
+ *   - preds/succs agree, phis have one operand per predecessor
+ *   - operand counts and kinds match the operation
+ *   - every operand is defined in the same function and dominates its use
+ */
+class IRVerifier {
+public:
+    bool verify(const IRModule& module);
+    bool verify(const IRFunction& function);
+    const std::vector<std::string>& getErrors() const { return errors_; }
+
+private:
+    std::vector<std::string> errors_;
+    void error(const IRFunction& function, const std::string& message);
+};
+
+#endif // IR_H
@@ -0,0 +1,619 @@
+/**
+ * IR Builder Implementation
+ *
+ * AST → SSA IR.
+ */
+
+#include "ir_builder.h"
+#include "codegen.h"
+#include "semantic.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+IRBuilder::IRBuilder() : function_(nullptr), current_(nullptr), hiddenCounter_(0), line_(0) {
+    runtime_ = std::make_unique<Runtime>();
+}
+
+std::unique_ptr<IRModule> IRBuilder::build(Program* program) {
+    auto module = std::make_unique<IRModule>();
+    hiddenCounter_ = 0;
+    line_ = 0;
+    sitesOnLine_.clear();
+
+    // Main program: every top-level statement except SCENEs
+    std::vector<Stmt*> mainBody;
+    std::vector<FunctionStmt*> scenes;
+    for (auto& stmt : program->statements) {
+        if (FunctionStmt* func = dynamic_cast<FunctionStmt*>(stmt.get())) {
+            scenes.push_back(func);
+        } else {
+            mainBody.push_back(stmt.get());
+        }
+    }
+
+    module->functions.push_back(std::make_unique<IRFunction>("main", 0, true));
+    buildFunction(module->functions.back().get(), nullptr, mainBody);
+
+    for (FunctionStmt* scene : scenes) {
+        module->functions.push_back(std::make_unique<IRFunction>(
+            scene->name.lexeme, (int)scene->parameters.size(), false));
+        if (scene->hint == TokenType::INLINE) {
+            module->functions.back()->inlineHint = InlineHint::ALWAYS;
+        } else if (scene->hint == TokenType::NOINLINE) {
+            module->functions.back()->inlineHint = InlineHint::NEVER;
+        }
+        module->functions.back()->memoized = scene->memoize;
+        std::vector<Stmt*> body;
+        for (auto& stmt : scene->body->statements) {
+            body.push_back(stmt.get());
+        }
+        buildFunction(module->functions.back().get(), scene, body);
+    }
+
+    // Code after SHOT / BREAK / CONTINUE was built into blocks nothing reaches
+    for (auto& function : module->functions) {
+        function->removeUnreachableBlocks();
+    }
+    return module;
+}
+
+void IRBuilder::buildFunction(IRFunction* function, FunctionStmt* scene,
+                              const std::vector<Stmt*>& body) {
+    function_ = function;
+    currentDef_.clear();
+    incompletePhis_.clear();
+    sealed_.clear();
+    loops_.clear();
+    params_.clear();
+
+    IRBlock* entry = function_->addBlock("entry");
+    sealBlock(entry);
+    startBlock(entry);
+
+    // Parameter values on entry; later assignments create new SSA values
+    if (scene) {
+        for (size_t i = 0; i < scene->parameters.size(); i++) {
+            params_[scene->parameters[i].lexeme] = (int)i;
+            IRValue* param = emit(IROp::PARAM, ValueType::INT);
+            param->imm = (int)i;
+            param->name = "LOADARG";
+            writeParam((int)i, entry, param);
+        }
+    }
+
+    for (Stmt* stmt : body) {
+        buildStmt(stmt);
+    }
+
+    // Falling off the end: main exits, a SCENE returns 0
+    if (function_->isMain) {
+        emit(IROp::EXIT, ValueType::INT);
+    } else {
+        emit(IROp::RETURN, ValueType::INT, {constant(0)});
+    }
+}
+
+// ============================================================================
+// SSA
+// ============================================================================
+
+void IRBuilder::writeParam(int index, IRBlock* block, IRValue* value) {
+    currentDef_[block][index] = value;
+}
+
+IRValue* IRBuilder::readParam(int index, IRBlock* block) {
+    auto& defs = currentDef_[block];
+    auto it = defs.find(index);
+    if (it != defs.end()) {
+        return it->second;
+    }
+
+    IRValue* value;
+    size_t phiCount = block->phis().size();
+    if (!sealed_.count(block)) {
+        // Predecessors still unknown (loop header): operands come at sealing
+        value = function_->insert(block, phiCount, IROp::PHI, ValueType::INT);
+        incompletePhis_[block].push_back({index, value});
+    } else if (block->preds.empty()) {
+        // Unreachable block: any value will do
+        value = function_->insert(block, phiCount, IROp::CONST, ValueType::INT);
+    } else if (block->preds.size() == 1) {
+        value = readParam(index, block->preds[0]);
+    } else {
+        // Write first so a loop through this block finds the phi
+        value = function_->insert(block, phiCount, IROp::PHI, ValueType::INT);
+        writeParam(index, block, value);
+        addPhiOperands(index, value);
+    }
+    writeParam(index, block, value);
+    return value;
+}
+
+void IRBuilder::addPhiOperands(int index, IRValue* phi) {
+    for (IRBlock* pred : phi->block->preds) {
+        phi->operands.push_back(readParam(index, pred));
+    }
+}
+
+void IRBuilder::sealBlock(IRBlock* block) {
+    for (const auto& pending : incompletePhis_[block]) {
+        addPhiOperands(pending.first, pending.second);
+    }
+    incompletePhis_.erase(block);
+    sealed_.insert(block);
+}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+IRValue* IRBuilder::emit(IROp op, ValueType type, const std::vector<IRValue*>& operands) {
+    IRValue* value = function_->append(current_, op, type);
+    value->operands = operands;
+    return value;
+}
+
+IRValue* IRBuilder::constant(int bits, ValueType type) {
+    IRValue* value = emit(IROp::CONST, type);
+    value->imm = bits;
+    return value;
+}
+
+IRValue* IRBuilder::convert(IRValue* value, ValueType to) {
+    std::string opcode = CodeGenerator::conversionOpcode(value->type, to);
+    if (opcode.empty()) return value;
+    IRValue* converted = emit(IROp::UNARY, to, {value});
+    converted->name = opcode;
+    return converted;
+}
+
+void IRBuilder::jump(IRBlock* target) {
+    emit(IROp::JUMP, ValueType::INT);
+    IRFunction::addEdge(current_, target);
+}
+
+void IRBuilder::branch(IRValue* condition, IRBlock* ifTrue, IRBlock* ifFalse) {
+    IRValue* instr = emit(IROp::BRANCH, ValueType::INT, {condition});
+    instr->site = nextSite();
+    IRFunction::addEdge(current_, ifTrue);
+    IRFunction::addEdge(current_, ifFalse);
+}
+
+/**
+ * Profiles refer to branches and loops by source line, so a profile
+ * recorded from one build applies to any other build of the same source.
+ */
+std::string IRBuilder::nextSite() {
+    if (line_ == 0) return "";
+    return std::to_string(line_) + "." + std::to_string(sitesOnLine_[line_]++);
+}
+
+void IRBuilder::startBlock(IRBlock* block) {
+    current_ = block;
+}
+
+void IRBuilder::startUnreachable() {
+    IRBlock* dead = function_->addBlock("dead");
+    sealBlock(dead);
+    startBlock(dead);
+}
+
+// ============================================================================
+// STATEMENTS
+// ============================================================================
+
+void IRBuilder::buildStmt(Stmt* stmt) {
+    if (DeclarationStmt* decl = dynamic_cast<DeclarationStmt*>(stmt)) {
+        // Every use of a CONST was replaced by its value: nothing to store
+        if (decl->isConst()) return;
+        IRValue* store = emit(IROp::STORE, ValueType::INT, {buildExpr(decl->initializer.get())});
+        store->name = decl->name.lexeme;
+    } else if (AssignmentStmt* assign = dynamic_cast<AssignmentStmt*>(stmt)) {
+        IRValue* value = convert(buildExpr(assign->value.get()), assign->targetType);
+        auto param = params_.find(assign->name.lexeme);
+        if (param != params_.end()) {
+            writeParam(param->second, current_, value);
+        } else {
+            IRValue* store = emit(IROp::STORE, ValueType::INT, {value});
+            store->name = assign->name.lexeme;
+        }
+    } else if (PropertyAssignmentStmt* prop = dynamic_cast<PropertyAssignmentStmt*>(stmt)) {
+        IRValue* object = buildExpr(prop->object.get());
+        IRValue* value = convert(buildExpr(prop->value.get()), ValueType::INT);  // Fields hold INT
+        IRValue* set = emit(IROp::SETPROP, ValueType::INT, {object, value});
+        set->name = prop->name.lexeme;
+    } else if (PrintStmt* print = dynamic_cast<PrintStmt*>(stmt)) {
+        IRValue* value = buildExpr(print->expression.get());
+        IRValue* out = emit(IROp::PRINT, ValueType::INT, {value});
+        switch (print->expression->type) {
+            case ValueType::FLOAT: out->name = "FPRINT"; break;
+            case ValueType::FIXED: out->name = "XPRINT"; break;
+            default: out->name = "PRINT"; break;
+        }
+    } else if (IfStmt* ifStmt = dynamic_cast<IfStmt*>(stmt)) {
+        buildIf(ifStmt);
+    } else if (LoopStmt* loop = dynamic_cast<LoopStmt*>(stmt)) {
+        buildLoop(loop);
+    } else if (ForStmt* forStmt = dynamic_cast<ForStmt*>(stmt)) {
+        buildFor(forStmt);
+    } else if (MatchStmt* match = dynamic_cast<MatchStmt*>(stmt)) {
+        buildMatch(match);
+    } else if (dynamic_cast<BreakStmt*>(stmt)) {
+        jump(loops_.back().breakTarget);
+        startUnreachable();
+    } else if (dynamic_cast<ContinueStmt*>(stmt)) {
+        jump(loops_.back().continueTarget);
+        startUnreachable();
+    } else if (ReturnStmt* ret = dynamic_cast<ReturnStmt*>(stmt)) {
+        // SCENEs return INT
+        IRValue* value = ret->value ? convert(buildExpr(ret->value.get()), ValueType::INT)
+                                    : constant(0);
+        emit(IROp::RETURN, ValueType::INT, {value});
+        startUnreachable();
+    } else if (BlockStmt* block = dynamic_cast<BlockStmt*>(stmt)) {
+        buildBlock(block);
+    } else if (ExpressionStmt* exprStmt = dynamic_cast<ExpressionStmt*>(stmt)) {
+        buildExpr(exprStmt->expression.get());  // Result unused
+    }
+}
+
+void IRBuilder::buildBlock(BlockStmt* block) {
+    for (auto& stmt : block->statements) {
+        buildStmt(stmt.get());
+    }
+}
+
+void IRBuilder::buildIf(IfStmt* stmt) {
+    IRBlock* thenBlock = function_->addBlock("then");
+    IRBlock* elseBlock = function_->addBlock("else");
+    IRBlock* endBlock = function_->addBlock("end_if");
+
+    line_ = stmt->keyword.line;
+    buildCondition(stmt->condition.get(), thenBlock, elseBlock);
+    line_ = 0;
+    sealBlock(thenBlock);
+    sealBlock(elseBlock);
+
+    startBlock(thenBlock);
+    buildBlock(stmt->thenBranch.get());
+    jump(endBlock);
+
+    startBlock(elseBlock);
+    if (stmt->elseBranch) {
+        buildBlock(stmt->elseBranch.get());
+    }
+    jump(endBlock);
+
+    sealBlock(endBlock);
+    startBlock(endBlock);
+}
+
+void IRBuilder::buildLoop(LoopStmt* stmt) {
+    IRBlock* header = function_->addBlock("loop");
+    IRBlock* body = function_->addBlock("loop_body");
+    IRBlock* exit = function_->addBlock("end_loop");
+
+    jump(header);
+    startBlock(header);  // Sealed after the back edge exists
+    line_ = stmt->keyword.line;
+    buildCondition(stmt->condition.get(), body, exit);
+    line_ = 0;
+    sealBlock(body);
+
+    // CONTINUE re-tests the condition
+    loops_.push_back({header, exit});
+    startBlock(body);
+    buildBlock(stmt->body.get());
+    jump(header);
+    loops_.pop_back();
+
+    sealBlock(header);
+    sealBlock(exit);
+    startBlock(exit);
+}
+
+/**
+ * FOR keeps the FORPREP / FORLOOP superinstructions: the loop variable is
+ * a global, and the bounds are immediates or hidden globals, as in CodeGen.
+ */
+void IRBuilder::buildFor(ForStmt* stmt) {
+    std::string id = std::to_string(hiddenCounter_++);
+    std::string var = stmt->variable.lexeme;
+
+    IRValue* start = emit(IROp::STORE, ValueType::INT, {buildExpr(stmt->start.get())});
+    start->name = var;
+
+    // Bounds are evaluated once, before the first iteration
+    std::string limit;
+    LiteralExpr* limitLit = dynamic_cast<LiteralExpr*>(stmt->limit.get());
+    if (limitLit && limitLit->token.type == TokenType::NUMBER) {
+        limit = limitLit->value;
+    } else {
+        limit = "__for_limit_" + id;
+        IRValue* store = emit(IROp::STORE, ValueType::INT, {buildExpr(stmt->limit.get())});
+        store->name = limit;
+    }
+
+    std::string step;
+    if (stmt->constantStep) {
+        step = std::to_string(stmt->stepValue);
+    } else {
+        step = "__for_step_" + id;
+        IRValue* store = emit(IROp::STORE, ValueType::INT, {buildExpr(stmt->step.get())});
+        store->name = step;
+    }
+
+    IRBlock* body = function_->addBlock("for");
+    IRBlock* next = function_->addBlock("for_next");
+    IRBlock* exit = function_->addBlock("end_for");
+
+    IRValue* prep = emit(IROp::FORPREP, ValueType::INT);
+    prep->name = var;
+    prep->limit = limit;
+    prep->step = step;
+    IRFunction::addEdge(current_, body);
+    IRFunction::addEdge(current_, exit);
+
+    loops_.push_back({next, exit});
+    startBlock(body);  // Sealed after the FORLOOP back edge exists
+    buildBlock(stmt->body.get());
+    jump(next);
+    loops_.pop_back();
+
+    sealBlock(next);
+    startBlock(next);
+    IRValue* loop = emit(IROp::FORLOOP, ValueType::INT);
+    line_ = stmt->keyword.line;
+    loop->site = nextSite();
+    line_ = 0;
+    loop->name = var;
+    loop->limit = limit;
+    loop->step = step;
+    IRFunction::addEdge(current_, body);
+    IRFunction::addEdge(current_, exit);
+
+    sealBlock(body);
+    sealBlock(exit);
+    startBlock(exit);
+}
+
+/**
+ * One SWITCH terminator; lowering picks a jump table or a decision tree.
+ */
+void IRBuilder::buildMatch(MatchStmt* stmt) {
+    IRValue* subject = buildExpr(stmt->subject.get());
+    IRValue* dispatch = emit(IROp::SWITCH, ValueType::INT, {subject});
+    IRBlock* from = current_;
+
+    std::vector<IRBlock*> arms;
+    for (size_t i = 0; i < stmt->cases.size(); i++) {
+        arms.push_back(function_->addBlock("match_case"));
+        IRFunction::addEdge(from, arms.back());
+        for (int value : stmt->cases[i].constants) {
+            dispatch->cases.push_back({value, (int)i});
+        }
+    }
+    IRBlock* elseBlock = stmt->elseBranch ? function_->addBlock("match_else") : nullptr;
+    IRBlock* endBlock = function_->addBlock("end_match");
+    IRFunction::addEdge(from, elseBlock ? elseBlock : endBlock);
+
+    // Arms (no fall-through)
+    for (size_t i = 0; i < arms.size(); i++) {
+        sealBlock(arms[i]);
+        startBlock(arms[i]);
+        buildBlock(stmt->cases[i].body.get());
+        jump(endBlock);
+    }
+    if (elseBlock) {
+        sealBlock(elseBlock);
+        startBlock(elseBlock);
+        buildBlock(stmt->elseBranch.get());
+        jump(endBlock);
+    }
+
+    sealBlock(endBlock);
+    startBlock(endBlock);
+}
+
+// ============================================================================
+// CONDITIONS
+// ============================================================================
+
+void IRBuilder::buildCondition(Expr* condition, IRBlock* ifTrue, IRBlock* ifFalse) {
+    if (LogicalExpr* logical = dynamic_cast<LogicalExpr*>(condition)) {
+        bool isAnd = logical->op.type == TokenType::AND;
+        IRBlock* right = function_->addBlock(isAnd ? "and" : "or");
+        if (isAnd) {
+            buildCondition(logical->left.get(), right, ifFalse);
+        } else {
+            buildCondition(logical->left.get(), ifTrue, right);
+        }
+        sealBlock(right);
+        startBlock(right);
+        buildCondition(logical->right.get(), ifTrue, ifFalse);
+        return;
+    }
+
+    UnaryExpr* unary = dynamic_cast<UnaryExpr*>(condition);
+    if (unary && unary->op.type == TokenType::BANG) {
+        buildCondition(unary->right.get(), ifFalse, ifTrue);
+        return;
+    }
+
+    branch(buildExpr(condition), ifTrue, ifFalse);
+}
+
+// ============================================================================
+// EXPRESSIONS
+// ============================================================================
+
+IRValue* IRBuilder::buildExpr(Expr* expr) {
+    if (LiteralExpr* lit = dynamic_cast<LiteralExpr*>(expr)) {
+        return buildLiteral(lit);
+    }
+    if (VariableExpr* var = dynamic_cast<VariableExpr*>(expr)) {
+        auto param = params_.find(var->name.lexeme);
+        if (param != params_.end()) {
+            return readParam(param->second, current_);
+        }
+        IRValue* load = emit(IROp::LOAD, expr->type);
+        load->name = var->name.lexeme;
+        return load;
+    }
+    if (BinaryExpr* bin = dynamic_cast<BinaryExpr*>(expr)) {
+        return buildBinary(bin);
+    }
+    if (LogicalExpr* logical = dynamic_cast<LogicalExpr*>(expr)) {
+        // Used as a value: branch, then merge 1 / 0 with a phi
+        IRBlock* ifTrue = function_->addBlock("logic_true");
+        IRBlock* ifFalse = function_->addBlock("logic_false");
+        IRBlock* end = function_->addBlock("logic_end");
+        buildCondition(logical, ifTrue, ifFalse);
+        sealBlock(ifTrue);
+        sealBlock(ifFalse);
+
+        startBlock(ifTrue);
+        IRValue* one = constant(1);
+        jump(end);
+        startBlock(ifFalse);
+        IRValue* zero = constant(0);
+        jump(end);
+
+        sealBlock(end);
+        startBlock(end);
+        IRValue* phi = function_->insert(end, 0, IROp::PHI, ValueType::INT);
+        phi->operands = {one, zero};  // Same order as end->preds
+        return phi;
+    }
+    if (UnaryExpr* unary = dynamic_cast<UnaryExpr*>(expr)) {
+        return buildUnary(unary);
+    }
+    if (CallExpr* call = dynamic_cast<CallExpr*>(expr)) {
+        return buildCall(call);
+    }
+    if (ObjectExpr* obj = dynamic_cast<ObjectExpr*>(expr)) {
+        return buildObject(obj);
+    }
+    if (PropertyExpr* prop = dynamic_cast<PropertyExpr*>(expr)) {
+        IRValue* get = emit(IROp::GETPROP, ValueType::INT, {buildExpr(prop->object.get())});
+        get->name = prop->name.lexeme;
+        return get;
+    }
+    return constant(0);
+}
+
+IRValue* IRBuilder::buildLiteral(LiteralExpr* expr) {
+    switch (expr->token.type) {
+        case TokenType::TRUE_KW:
+            return constant(1);
+        case TokenType::FALSE_KW:
+            return constant(0);
+        case TokenType::FLOAT_NUMBER: {
+            float f = std::strtof(expr->value.c_str(), nullptr);
+            int bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            return constant(bits, ValueType::FLOAT);
+        }
+        case TokenType::FIXED_NUMBER:
+            // 16.16: the raw integer is value * 65536
+            return constant((int)std::llround(std::stod(expr->value) * 65536.0), ValueType::FIXED);
+        case TokenType::STRING: {
+            IRValue* text = emit(IROp::STRING, ValueType::INT);
+            text->name = expr->value;
+            return text;
+        }
+        default:
+            return constant((int)std::strtoll(expr->value.c_str(), nullptr, 10));
+    }
+}
+
+IRValue* IRBuilder::buildBinary(BinaryExpr* expr) {
+    // Both operands are promoted to the operation's type
+    IRValue* left = convert(buildExpr(expr->left.get()), expr->operandType);
+    IRValue* right = convert(buildExpr(expr->right.get()), expr->operandType);
+
+    std::string op = expr->op.lexeme;
+    std::string opcode;
+    if (CodeGenerator::comparisonOpcode(op, opcode)) {
+        opcode = CodeGenerator::typedOpcode(opcode, expr->operandType);
+    } else if (op == "+") opcode = CodeGenerator::typedOpcode("ADD", expr->operandType);
+    else if (op == "-") opcode = CodeGenerator::typedOpcode("SUB", expr->operandType);
+    else if (op == "*") opcode = CodeGenerator::typedOpcode("MUL", expr->operandType);
+    else if (op == "/") opcode = CodeGenerator::typedOpcode("DIV", expr->operandType);
+    else if (op == "%") opcode = "MOD";
+    else if (op == "&") opcode = "BAND";
+    else if (op == "|") opcode = "BOR";
+    else if (op == "^") opcode = "BXOR";
+    else if (op == "<<") opcode = "SHL";
+    else opcode = "SHR";
+
+    IRValue* value = emit(IROp::BINARY, expr->type, {left, right});
+    value->name = opcode;
+    return value;
+}
+
+IRValue* IRBuilder::buildUnary(UnaryExpr* expr) {
+    if (expr->op.lexeme == "-") {
+        IRValue* operand = buildExpr(expr->right.get());
+        if (expr->type == ValueType::FLOAT) {
+            // 0.0 - x (a zero bit pattern is 0.0f)
+            IRValue* value = emit(IROp::BINARY, ValueType::FLOAT, {constant(0, ValueType::FLOAT), operand});
+            value->name = "FSUB";
+            return value;
+        }
+        IRValue* value = emit(IROp::UNARY, expr->type, {operand});
+        value->name = "NEG";
+        return value;
+    }
+
+    // !(a < b) is a >= b, except for FLOAT (NaN compares false both ways)
+    BinaryExpr* bin = dynamic_cast<BinaryExpr*>(expr->right.get());
+    std::string compare;
+    if (bin && CodeGenerator::comparisonOpcode(bin->op.lexeme, compare) &&
+        bin->operandType != ValueType::FLOAT) {
+        IRValue* left = convert(buildExpr(bin->left.get()), bin->operandType);
+        IRValue* right = convert(buildExpr(bin->right.get()), bin->operandType);
+        IRValue* value = emit(IROp::BINARY, ValueType::INT, {left, right});
+        value->name = CodeGenerator::invertComparison(compare);
+        return value;
+    }
+
+    // Logical NOT: x == 0
+    IRValue* operand = buildExpr(expr->right.get());
+    IRValue* value = emit(IROp::BINARY, ValueType::INT, {operand, constant(0)});
+    value->name = "EQ";
+    return value;
+}
+
+IRValue* IRBuilder::buildCall(CallExpr* expr) {
+    // int() / float() / fixed() are conversions, not calls
+    ValueType target;
+    if (SemanticAnalyzer::conversionTarget(expr->callee.lexeme, target)) {
+        return convert(buildExpr(expr->arguments[0].get()), target);
+    }
+
+    std::vector<IRValue*> args;
+    for (auto& arg : expr->arguments) {
+        args.push_back(convert(buildExpr(arg.get()), ValueType::INT));
+    }
+    IRValue* call = emit(IROp::CALL, ValueType::INT, args);
+    call->name = expr->callee.lexeme;
+    call->purity = runtime_->getPurity(call->name);  // Built-ins win over SCENEs, as in the VM
+    return call;
+}
+
+IRValue* IRBuilder::buildObject(ObjectExpr* expr) {
+    // INITPROP yields the object again, so fields chain in source order
+    IRValue* object = emit(IROp::NEWOBJ, ValueType::INT);
+    for (size_t i = 0; i < expr->fieldNames.size(); i++) {
+        IRValue* value = convert(buildExpr(expr->fieldValues[i].get()), ValueType::INT);
+        object = emit(IROp::INITPROP, ValueType::INT, {object, value});
+        object->name = expr->fieldNames[i].lexeme;
+    }
+    return object;
+}
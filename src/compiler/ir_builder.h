@@ -0,0 +1,107 @@
+/**
+ * CINEBREW IR Builder
+ *
+ * ============================================================================
+ * WHAT DOES IT DO?
+ * ============================================================================
+ *
+ * Translates the analyzed AST into the SSA IR (see ir.h). Control flow
+ * statements become basic blocks; && and || become branches, exactly like
+ * the short-circuit jumps CodeGen emits.
+ *
+ * SSA construction follows Braun et al., "Simple and Efficient
+ * Construction of Static Single Assignment Form": the current value of
+ * each SCENE parameter is tracked per block, and reading a parameter in a
+ * block with several predecessors creates a phi. Blocks are "sealed" once
+ * all their predecessors are known (loop headers only after the body).
+ * Phis that turn out to merge a single value are left for the
+ * RemoveTrivialPhis pass.
+ *
+ * ============================================================================
+ */
+
+#ifndef IR_BUILDER_H
+#define IR_BUILDER_H
+
+#include "ast.h"
+#include "ir.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+class IRBuilder {
+public:
+    IRBuilder();
+
+    // Main function: build the IR for the whole program
+    std::unique_ptr<IRModule> build(Program* program);
+
+private:
+    // ========================================================================
+    // STATE
+    // ========================================================================
+    IRFunction* function_;
+    IRBlock* current_;
+    std::unordered_map<std::string, int> params_;  // Current SCENE's parameters
+    int hiddenCounter_;                            // __for_limit_N / __for_step_N
+    int line_;                                     // IF / LOOP / FOR being built (0: none)
+    std::unordered_map<int, int> sitesOnLine_;     // Profile sites handed out per line
+    std::unique_ptr<Runtime> runtime_;             // Purity of built-in calls
+
+    struct LoopTargets {
+        IRBlock* continueTarget;
+        IRBlock* breakTarget;
+    };
+    std::vector<LoopTargets> loops_;
+
+    // SSA construction (per function)
+    std::unordered_map<IRBlock*, std::unordered_map<int, IRValue*>> currentDef_;
+    std::unordered_map<IRBlock*, std::vector<std::pair<int, IRValue*>>> incompletePhis_;
+    std::unordered_set<IRBlock*> sealed_;
+
+    // ========================================================================
+    // SSA
+    // ========================================================================
+    void writeParam(int index, IRBlock* block, IRValue* value);
+    IRValue* readParam(int index, IRBlock* block);
+    void addPhiOperands(int index, IRValue* phi);
+    void sealBlock(IRBlock* block);
+
+    // ========================================================================
+    // HELPERS
+    // ========================================================================
+    IRValue* emit(IROp op, ValueType type, const std::vector<IRValue*>& operands = {});
+    IRValue* constant(int bits, ValueType type = ValueType::INT);
+    IRValue* convert(IRValue* value, ValueType to);
+    void jump(IRBlock* target);
+    void branch(IRValue* condition, IRBlock* ifTrue, IRBlock* ifFalse);
+    void startBlock(IRBlock* block);
+    void startUnreachable();  // After BREAK / CONTINUE / SHOT
+    std::string nextSite();   // "line.n": the n-th branch / loop of the current line
+
+    // ========================================================================
+    // AST WALKING
+    // ========================================================================
+    void buildFunction(IRFunction* function, FunctionStmt* scene,
+                       const std::vector<Stmt*>& body);
+    void buildStmt(Stmt* stmt);
+    void buildBlock(BlockStmt* block);
+    void buildIf(IfStmt* stmt);
+    void buildLoop(LoopStmt* stmt);
+    void buildFor(ForStmt* stmt);
+    void buildMatch(MatchStmt* stmt);
+
+    IRValue* buildExpr(Expr* expr);
+    IRValue* buildBinary(BinaryExpr* expr);
+    IRValue* buildUnary(UnaryExpr* expr);
+    IRValue* buildCall(CallExpr* expr);
+    IRValue* buildObject(ObjectExpr* expr);
+    IRValue* buildLiteral(LiteralExpr* expr);
+
+    // Branch to ifTrue / ifFalse, short-circuiting && || and !
+    void buildCondition(Expr* condition, IRBlock* ifTrue, IRBlock* ifFalse);
+};
+
+#endif // IR_BUILDER_H
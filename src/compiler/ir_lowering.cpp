@@ -0,0 +1,690 @@
+/**
+ * IR Lowering Implementation
+ *
+ * SSA IR → stack bytecode.
+ */
+
+#include "ir_lowering.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+IRLowering::IRLowering(const Profile* profile, bool instrument)
+    : profile_(profile), instrument_(instrument), haltLabel_(-1), propertySiteCounter_(0), movedBlocks_(0),
+      slotCount_(0), memoTable_(-1) {
+}
+
+Bytecode IRLowering::lower(IRModule& module) {
+    bytecode_ = Bytecode();
+    haltLabel_ = bytecode_.namedLabel("HALT");
+    propertySiteCounter_ = 0;
+    movedBlocks_ = 0;
+
+    // Same layout as CodeGen: main, then the SCENEs, then HALT:
+    std::vector<IRFunction*> order;
+    for (auto& function : module.functions) {
+        order.push_back(function.get());
+    }
+    if (profile_) {
+        // Hottest SCENEs first (main stays first: it starts at pc 0)
+        std::stable_sort(order.begin(), order.end(), [&](const IRFunction* a, const IRFunction* b) {
+            if (a->isMain || b->isMain) return a->isMain && !b->isMain;
+            return profile_->callCount(a->name) > profile_->callCount(b->name);
+        });
+    }
+    bool hasScenes = module.functions.size() > 1;
+    for (IRFunction* function : order) {
+        lowerFunction(*function, hasScenes);
+    }
+    bytecode_.place(haltLabel_);
+    return std::move(bytecode_);
+}
+
+void IRLowering::emitOp(const std::string& opcode, int a) {
+    Op op;
+    if (Bytecode::lookupOp(opcode, op)) {
+        bytecode_.emit(op, a);
+    } else {
+        bytecode_.emit(Op::INVALID, bytecode_.symbol(opcode));  // Reported by the VM if it runs
+    }
+}
+
+// ============================================================================
+// PREPARATION
+// ============================================================================
+
+/**
+ * A phi's copies run at the end of the predecessor. If that predecessor
+ * can also go elsewhere, put the copies in a new block on the edge (after
+ * assignHomes: an edge whose values are all coalesced needs no block).
+ */
+void IRLowering::splitCriticalEdges(IRFunction& function) {
+    size_t count = function.blocks.size();
+    for (size_t b = 0; b < count; b++) {
+        IRBlock* block = function.blocks[b].get();
+        if (block->succs.size() < 2) continue;
+
+        for (size_t i = 0; i < block->succs.size(); i++) {
+            IRBlock* succ = block->succs[i];
+            if (succ->preds.size() < 2 || succ->phis().empty()) continue;
+
+            // The n-th edge block -> succ is the n-th `block` in succ->preds
+            int nth = 0;
+            for (size_t k = 0; k < i; k++) {
+                if (block->succs[k] == succ) nth++;
+            }
+            size_t edge = 0;
+            for (int seen = nth; edge < succ->preds.size(); edge++) {
+                if (succ->preds[edge] == block && seen-- == 0) break;
+            }
+            bool copies = false;
+            for (const IRValue* phi : succ->phis()) {
+                if (needsCopy(phi, phi->operands[edge])) copies = true;
+            }
+            if (!copies) continue;
+
+            IRBlock* middle = function.addBlock("edge");
+            home_[function.append(middle, IROp::JUMP, ValueType::INT)] = Home::NONE;
+            for (IRBlock*& pred : succ->preds) {
+                if (pred == block && nth-- == 0) {
+                    pred = middle;
+                    break;
+                }
+            }
+            middle->preds.push_back(block);
+            middle->succs.push_back(succ);
+            block->succs[i] = middle;
+        }
+    }
+}
+
+/**
+ * How often the profiled run took the edge block -> succs[succ]; -1 if
+ * the profile does not say (not a profiled branch).
+ */
+long long IRLowering::edgeCount(const IRBlock* block, size_t succ) const {
+    const IRValue* term = block->terminator();
+    long long taken, notTaken;
+    if (term->op == IROp::BRANCH && !term->site.empty() && profile_->branchCounts(term->site, taken, notTaken)) {
+        return succ == 0 ? taken : notTaken;
+    }
+    return -1;
+}
+
+/**
+ * Chains of blocks: starting from the first unplaced block (in reverse
+ * postorder), keep appending the successor the profile says is most
+ * likely; unknown edges keep reverse postorder. A block is cold when
+ * every edge into it is cold (never taken, or out of a cold block); a
+ * chain never crosses between warm and cold blocks, and the cold ones all
+ * go last.
+ */
+std::vector<IRBlock*> IRLowering::profileLayout(const std::vector<IRBlock*>& order) {
+    std::unordered_map<const IRBlock*, size_t> position;
+    for (size_t i = 0; i < order.size(); i++) position[order[i]] = i;
+
+    // Back edges come from blocks not decided yet; they cannot warm a
+    // block the loop's entry edges left cold
+    std::unordered_set<const IRBlock*> warm;
+    for (size_t i = 0; i < order.size(); i++) {
+        IRBlock* block = order[i];
+        bool isWarm = i == 0;
+        for (IRBlock* pred : block->preds) {
+            if (!warm.count(pred)) continue;
+            for (size_t k = 0; k < pred->succs.size(); k++) {
+                if (pred->succs[k] == block && edgeCount(pred, k) != 0) isWarm = true;
+            }
+        }
+        if (isWarm) warm.insert(block);
+    }
+
+    std::vector<IRBlock*> layout, cold;
+    std::unordered_set<const IRBlock*> placed;
+    for (IRBlock* seed : order) {
+        std::vector<IRBlock*>& chain = warm.count(seed) ? layout : cold;
+        for (IRBlock* block = seed; block && !placed.count(block);) {
+            chain.push_back(block);
+            placed.insert(block);
+
+            IRBlock* next = nullptr;
+            long long best = 0;
+            for (size_t k = 0; k < block->succs.size(); k++) {
+                IRBlock* succ = block->succs[k];
+                if (placed.count(succ) || warm.count(block) != warm.count(succ)) continue;
+                long long count = edgeCount(block, k);
+                if (!next || count > best || (count == best && position[succ] < position[next])) {
+                    next = succ;
+                    best = count;
+                }
+            }
+            block = next;
+        }
+    }
+    layout.insert(layout.end(), cold.begin(), cold.end());
+
+    for (size_t i = 0; i < layout.size(); i++) {
+        if (layout[i] != order[i]) movedBlocks_++;
+    }
+    return layout;
+}
+
+/**
+ * The first instruction after instrs[index] that is not pushed where it
+ * is used.
+ */
+const IRValue* IRLowering::nextComputation(const IRBlock* block, size_t index) {
+    for (size_t i = index + 1; i < block->instrs.size(); i++) {
+        IROp op = block->instrs[i]->op;
+        if (op != IROp::CONST && op != IROp::STRING && op != IROp::PARAM) return block->instrs[i].get();
+    }
+    return nullptr;
+}
+
+/**
+ * a < b is b > a (also for FLOAT: NaN fails both); "" if not a
+ * comparison with an order.
+ */
+std::string IRLowering::flippedComparison(const std::string& opcode) {
+    static const char* const pairs[][2] = {
+        {"LT", "GT"}, {"GT", "LT"}, {"LE", "GE"}, {"GE", "LE"},
+        {"FLT", "FGT"}, {"FGT", "FLT"}, {"FLE", "FGE"}, {"FGE", "FLE"},
+    };
+    for (const auto& pair : pairs) {
+        if (opcode == pair[0]) return pair[1];
+    }
+    return "";
+}
+
+bool IRLowering::isDenseSwitch(const IRValue* dispatch) {
+    if (dispatch->cases.size() < 3) return false;
+    int lo = dispatch->cases[0].first, hi = lo;
+    for (const auto& c : dispatch->cases) {
+        lo = std::min(lo, c.first);
+        hi = std::max(hi, c.first);
+    }
+    long long range = (long long)hi - lo + 1;
+    return range <= 2 * (long long)dispatch->cases.size() && range <= 1024;
+}
+
+/**
+ * Decide where each value lives (see ir_lowering.h), then give every
+ * local a frame slot.
+ */
+void IRLowering::assignHomes(const std::vector<IRBlock*>& layout) {
+    home_.clear();
+    slot_.clear();
+    swapped_.clear();
+    slotCount_ = 0;
+
+    std::unordered_map<const IRValue*, int> uses;
+    std::unordered_map<const IRValue*, const IRValue*> user;
+    std::unordered_map<const IRValue*, std::vector<const IRValue*>> users;
+    for (IRBlock* block : layout) {
+        for (auto& instr : block->instrs) {
+            for (IRValue* operand : instr->operands) {
+                uses[operand]++;
+                user[operand] = instr.get();
+                users[operand].push_back(instr.get());
+            }
+        }
+    }
+
+    for (IRBlock* block : layout) {
+        for (size_t i = 0; i < block->instrs.size(); i++) {
+            const IRValue* v = block->instrs[i].get();
+            if (!v->hasResult()) {
+                home_[v] = Home::NONE;
+            } else if (v->op == IROp::CONST || v->op == IROp::STRING || v->op == IROp::PARAM) {
+                home_[v] = Home::REMAT;
+            } else if (v->op == IROp::LOAD && uses[v] == 1 && i + 1 < block->instrs.size() &&
+                       user[v] == nextComputation(block, i)) {
+                // Read where it is used: nothing in between can store
+                home_[v] = Home::REMAT;
+            } else if (v->op == IROp::PHI) {
+                home_[v] = Home::LOCAL;
+            } else if (uses[v] == 0) {
+                home_[v] = Home::DISCARD;
+            } else {
+                const IRValue* u = user[v];
+                // A decision tree re-reads its subject for every comparison
+                bool stack = uses[v] == 1 && u->block == v->block && u->op != IROp::PHI &&
+                             !(u->op == IROp::SWITCH && !isDenseSwitch(u) && u->cases.size() != 1);
+                home_[v] = stack ? Home::STACK : Home::LOCAL;
+            }
+        }
+    }
+
+    // `local + temp` is emitted as `temp + local` (`local < temp` as
+    // `temp > local`): the temporary can stay on the stack. Constants go
+    // right, where the peephole rules look for them. `100 / temp` pushes
+    // the constant after the temporary and SWAPs.
+    for (IRBlock* block : layout) {
+        for (auto& instr : block->instrs) {
+            IRValue* v = instr.get();
+            if (v->op != IROp::BINARY) continue;
+            bool tempRight = home_[v->operands[0]] != Home::STACK && home_[v->operands[1]] == Home::STACK;
+            bool constLeft = v->operands[0]->op == IROp::CONST && v->operands[1]->op != IROp::CONST;
+            std::string flipped = flippedComparison(v->name);
+            if ((tempRight || constLeft) && (v->isCommutative() || !flipped.empty())) {
+                std::swap(v->operands[0], v->operands[1]);
+                if (!flipped.empty()) v->name = flipped;
+            } else if (tempRight && home_[v->operands[0]] == Home::REMAT) {
+                swapped_.insert(v);
+            }
+        }
+    }
+
+    // Simulate the VM stack: an instruction's stack operands must be its
+    // first operands and sit on top of the stack in order. Demote to
+    // locals until that holds everywhere.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (IRBlock* block : layout) {
+            std::vector<const IRValue*> pending;
+            for (auto& instr : block->instrs) {
+                const IRValue* v = instr.get();
+                if (v->op == IROp::PHI || home_[v] == Home::REMAT) continue;
+
+                std::vector<const IRValue*> onStack;
+                bool prefix = true;
+                for (const IRValue* operand : v->operands) {
+                    if (swapped_.count(v) && operand == v->operands[0]) continue;
+                    if (home_[operand] == Home::STACK) {
+                        if (!prefix) onStack.push_back(nullptr);  // Forces a mismatch
+                        onStack.push_back(operand);
+                    } else {
+                        prefix = false;
+                    }
+                }
+
+                bool valid = std::find(onStack.begin(), onStack.end(), nullptr) == onStack.end() &&
+                             onStack.size() <= pending.size() &&
+                             std::equal(onStack.begin(), onStack.end(), pending.end() - onStack.size());
+                if (!valid) {
+                    for (const IRValue* operand : onStack) {
+                        if (operand) home_[operand] = Home::LOCAL;
+                    }
+                    changed = true;
+                    break;
+                }
+
+                pending.resize(pending.size() - onStack.size());
+                if (home_[v] == Home::STACK) pending.push_back(v);
+            }
+            if (changed) break;
+        }
+    }
+
+    for (IRBlock* block : layout) {
+        for (auto& instr : block->instrs) {
+            if (home_[instr.get()] == Home::LOCAL && instr->op == IROp::PHI) {
+                slot_[instr.get()] = slotCount_++;
+            }
+        }
+    }
+
+    // Loop-carried first: a phi at or above the value's block (a loop
+    // header) saves a copy on every iteration, one below only on exit
+    std::unordered_map<const IRBlock*, size_t> position;
+    for (size_t i = 0; i < layout.size(); i++) position[layout[i]] = i;
+
+    for (IRBlock* block : layout) {
+        for (auto& instr : block->instrs) {
+            const IRValue* v = instr.get();
+            if (home_[v] != Home::LOCAL || v->op == IROp::PHI) continue;
+
+            std::vector<const IRValue*> phis;
+            for (const IRValue* u : users[v]) {
+                if (u->op == IROp::PHI && std::find(phis.begin(), phis.end(), u) == phis.end()) phis.push_back(u);
+            }
+            std::stable_sort(phis.begin(), phis.end(), [&](const IRValue* a, const IRValue* b) {
+                return (position[a->block] <= position[block]) > (position[b->block] <= position[block]);
+            });
+
+            slot_[v] = -1;
+            for (const IRValue* phi : phis) {
+                if (coalesces(v, phi, users)) {
+                    slot_[v] = slot_[phi];
+                    break;
+                }
+            }
+            if (slot_[v] < 0) slot_[v] = slotCount_++;
+        }
+    }
+}
+
+/**
+ * Can `value` live in `phi`'s slot? It feeds the phi on edges out of its
+ * own block B, so from its definition on the slot holds the phi's next
+ * value. That is fine if the phi's current value is dead by then: not
+ * read after the value in B, nor anywhere B reaches before control gets
+ * back to the phi's block. The value's other uses must see it in the
+ * slot: later in B, in a block only B enters, or in phi copies on edges
+ * out of B.
+ */
+bool IRLowering::coalesces(const IRValue* value, const IRValue* phi,
+                           const std::unordered_map<const IRValue*, std::vector<const IRValue*>>& users) const {
+    IRBlock* block = value->block;
+    IRBlock* target = phi->block;
+
+    // Blocks reachable from B without passing through the phi's block
+    std::unordered_set<const IRBlock*> reached;
+    std::vector<IRBlock*> work;
+    for (IRBlock* succ : block->succs) work.push_back(succ);
+    while (!work.empty()) {
+        IRBlock* b = work.back();
+        work.pop_back();
+        if (b == target || b == block || !reached.insert(b).second) continue;
+        for (IRBlock* succ : b->succs) work.push_back(succ);
+    }
+
+    for (size_t i = 0; i < target->preds.size(); i++) {
+        if (phi->operands[i] == value && target->preds[i] != block) return false;
+        if (target->preds[i] != block && !reached.count(target->preds[i])) continue;
+        for (const IRValue* other : target->phis()) {
+            if (other->operands[i] == phi) return false;  // Reads the old value on the edge
+        }
+    }
+
+    for (const IRValue* u : users.at(value)) {
+        if (u == phi) continue;
+        if (u->op == IROp::PHI) {
+            // Copied out on an edge leaving B
+            if (u->block == target) return false;
+            for (size_t i = 0; i < u->operands.size(); i++) {
+                if (u->operands[i] == value && u->block->preds[i] != block) return false;
+            }
+            continue;
+        }
+        if (u->block != block && (u->block->preds.size() != 1 || u->block->preds[0] != block ||
+                                  std::find(u->block->succs.begin(), u->block->succs.end(), target) !=
+                                      u->block->succs.end())) {
+            return false;
+        }
+    }
+
+    auto found = users.find(phi);
+    if (found == users.end()) return true;
+    for (const IRValue* u : found->second) {
+        if (u == value || (u->op == IROp::PHI && u->block == target)) continue;  // Edges: see above
+        if (reached.count(u->block)) return false;
+        if (u->block == block) {
+            // Must come before the value
+            for (auto& instr : block->instrs) {
+                if (instr.get() == value) return false;
+                if (instr.get() == u) break;
+            }
+        }
+    }
+    return true;
+}
+
+bool IRLowering::needsCopy(const IRValue* phi, const IRValue* incoming) const {
+    if (incoming == phi) return false;
+    auto home = home_.find(incoming);
+    return !(home != home_.end() && home->second == Home::LOCAL && slot_.at(incoming) == slot_.at(phi));
+}
+
+// ============================================================================
+// EMISSION
+// ============================================================================
+
+void IRLowering::lowerFunction(IRFunction& function, bool haltAfterMain) {
+    assignHomes(function.reversePostorder());
+    splitCriticalEdges(function);
+    std::vector<IRBlock*> layout = function.reversePostorder();
+    if (profile_) layout = profileLayout(layout);
+
+    labels_.clear();
+    for (size_t i = 0; i < layout.size(); i++) {
+        labels_[layout[i]] = i == 0 ? bytecode_.namedLabel(function.name)
+                                    : bytecode_.newLabel(Bytecode::internPrefix(layout[i]->hint));
+    }
+
+    if (!function.isMain) {
+        bytecode_.place(labels_[layout[0]]);
+    }
+    memoTable_ = function.memoized ? bytecode_.symbol(function.name) : -1;
+    if (memoTable_ >= 0) {
+        bytecode_.emit(Op::MEMOGET, memoTable_);
+    }
+    if (slotCount_ > 0) {
+        bytecode_.emit(Op::ENTER, slotCount_);
+    }
+
+    for (size_t i = 0; i < layout.size(); i++) {
+        IRBlock* block = layout[i];
+        if (i > 0) bytecode_.place(labels_[block]);
+
+        for (auto& instr : block->instrs) {
+            if (instr->op == IROp::PHI || instr->isTerminator()) continue;
+            lowerInstruction(instr.get());
+        }
+        emitPhiCopies(block);
+        lowerTerminator(block, i + 1 < layout.size() ? layout[i + 1] : nullptr, haltAfterMain);
+    }
+}
+
+void IRLowering::pushOperand(const IRValue* value) {
+    switch (home_[value]) {
+        case Home::STACK:
+            break;  // Already on top
+        case Home::LOCAL:
+            bytecode_.emit(Op::LOADLOCAL, slot_[value]);
+            break;
+        default:
+            if (value->op == IROp::PARAM) {
+                emitOp(value->name, value->imm);
+            } else if (value->op == IROp::LOAD) {
+                bytecode_.emit(Op::LOAD, bytecode_.symbol(value->name));
+            } else if (value->op == IROp::STRING) {
+                // Printed without surrounding whitespace, as CodeGen does
+                size_t first = value->name.find_first_not_of(" \t");
+                size_t last = value->name.find_last_not_of(" \t");
+                std::string text = first == std::string::npos ? "" : value->name.substr(first, last - first + 1);
+                bytecode_.emit(Op::PUSHSTR, bytecode_.symbol(text));
+            } else if (value->type == ValueType::FLOAT) {
+                // The bit pattern, and the shortest text that reads back as it
+                float f;
+                std::memcpy(&f, &value->imm, sizeof(f));
+                char text[32];
+                std::snprintf(text, sizeof(text), "%.9g", f);
+                bytecode_.emit(Op::FPUSH, value->imm, bytecode_.symbol(text));
+            } else {
+                bytecode_.emit(Op::PUSH, value->imm);
+            }
+            break;
+    }
+}
+
+void IRLowering::lowerInstruction(IRValue* instr) {
+    if (home_[instr] == Home::REMAT) return;  // Pushed where it is used
+
+    if (swapped_.count(instr) && home_[instr->operands[1]] == Home::STACK) {
+        pushOperand(instr->operands[0]);
+        bytecode_.emit(Op::SWAP);
+    } else {
+        for (const IRValue* operand : instr->operands) {
+            pushOperand(operand);
+        }
+    }
+
+    switch (instr->op) {
+        case IROp::LOAD: bytecode_.emit(Op::LOAD, bytecode_.symbol(instr->name)); break;
+        case IROp::STORE: bytecode_.emit(Op::STORE, bytecode_.symbol(instr->name)); break;
+        case IROp::UNARY: case IROp::BINARY: emitOp(instr->name); break;
+        case IROp::CALL:
+            bytecode_.emit(Op::CALL, bytecode_.symbol(instr->name), (int)instr->operands.size());
+            break;
+        case IROp::NEWOBJ: bytecode_.emit(Op::NEWOBJ); break;
+        case IROp::GETPROP: case IROp::INITPROP: case IROp::SETPROP: {
+            // Every site gets its own inline-cache slot in the VM
+            Op op = instr->op == IROp::GETPROP ? Op::GETPROP : instr->op == IROp::INITPROP ? Op::INITPROP : Op::SETPROP;
+            bytecode_.emit(op, bytecode_.symbol(instr->name), propertySiteCounter_++);
+            break;
+        }
+        case IROp::PRINT:
+            emitOp(instr->name);
+            // PRINT leaves the value on the stack; a string literal is
+            // printed directly by PUSH and never pushed
+            if (instr->operands[0]->op != IROp::STRING) bytecode_.emit(Op::POP);
+            break;
+        default:
+            break;
+    }
+
+    if (home_[instr] == Home::LOCAL) {
+        bytecode_.emit(Op::STORELOCAL, slot_[instr]);
+    } else if (home_[instr] == Home::DISCARD) {
+        bytecode_.emit(Op::POP);
+    }
+}
+
+/**
+ * Parallel copy into the successor's phi slots: push every incoming
+ * value first, then store them, so phis reading each other stay correct.
+ */
+void IRLowering::emitPhiCopies(IRBlock* block) {
+    if (block->succs.size() != 1) return;
+    IRBlock* succ = block->succs[0];
+    std::vector<IRValue*> phis = succ->phis();
+    if (phis.empty()) return;
+
+    size_t edge = std::find(succ->preds.begin(), succ->preds.end(), block) - succ->preds.begin();
+    // Values computed straight into the phi's slot need no copy
+    std::vector<IRValue*> copies;
+    for (IRValue* phi : phis) {
+        if (needsCopy(phi, phi->operands[edge])) copies.push_back(phi);
+    }
+    for (IRValue* phi : copies) {
+        pushOperand(phi->operands[edge]);
+    }
+    for (size_t i = copies.size(); i-- > 0;) {
+        bytecode_.emit(Op::STORELOCAL, slot_[copies[i]]);
+    }
+}
+
+void IRLowering::lowerTerminator(IRBlock* block, IRBlock* next, bool haltAfterMain) {
+    IRValue* term = block->terminator();
+    const std::vector<IRBlock*>& succs = block->succs;
+
+    switch (term->op) {
+        case IROp::JUMP:
+            if (succs[0] != next) bytecode_.emitJump(Op::JMP, labels_[succs[0]]);
+            break;
+
+        case IROp::BRANCH:
+            pushOperand(term->operands[0]);
+            if (instrument_ && !term->site.empty()) bytecode_.emit(Op::PROFBR, bytecode_.symbol(term->site));
+            if (succs[0] == next) {
+                bytecode_.emitJump(Op::JZ, labels_[succs[1]]);
+            } else if (succs[1] == next) {
+                bytecode_.emitJump(Op::JNZ, labels_[succs[0]]);
+            } else {
+                bytecode_.emitJump(Op::JZ, labels_[succs[1]]);
+                bytecode_.emitJump(Op::JMP, labels_[succs[0]]);
+            }
+            break;
+
+        case IROp::SWITCH: {
+            int defaultLabel = labels_[succs.back()];
+            std::vector<std::pair<int, int>> targets;
+            for (const auto& c : term->cases) {
+                targets.push_back({c.first, labels_[succs[c.second]]});
+            }
+            std::sort(targets.begin(), targets.end());
+
+            if (isDenseSwitch(term)) {
+                pushOperand(term->operands[0]);
+                std::vector<int> entries;
+                size_t n = 0;
+                for (long long v = targets.front().first; v <= targets.back().first; v++) {
+                    if (n < targets.size() && targets[n].first == v) {
+                        entries.push_back(targets[n++].second);
+                    } else {
+                        entries.push_back(defaultLabel);  // Hole in the range
+                    }
+                }
+                bytecode_.emitTable(targets.front().first, defaultLabel, entries);
+            } else {
+                emitDecisionTree(term->operands[0], targets, 0, targets.size(), defaultLabel);
+            }
+            break;
+        }
+
+        case IROp::FORPREP:
+            emitForOperands(Op::FORPREP, term, labels_[succs[1]]);
+            if (succs[0] != next) bytecode_.emitJump(Op::JMP, labels_[succs[0]]);
+            break;
+
+        case IROp::FORLOOP:
+            if (instrument_ && !term->site.empty()) bytecode_.emit(Op::PROFLOOP, bytecode_.symbol(term->site));
+            emitForOperands(Op::FORLOOP, term, labels_[succs[0]]);
+            if (succs[1] != next) bytecode_.emitJump(Op::JMP, labels_[succs[1]]);
+            break;
+
+        case IROp::RETURN:
+            pushOperand(term->operands[0]);
+            if (memoTable_ >= 0) bytecode_.emit(Op::MEMOPUT, memoTable_);
+            bytecode_.emit(Op::RET);
+            break;
+
+        case IROp::EXIT:
+            if (next || haltAfterMain) bytecode_.emitJump(Op::JMP, haltLabel_);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * FORPREP / FORLOOP: the IR keeps the limit and step as text, an
+ * immediate ("10", "-1") or the name of a global.
+ */
+void IRLowering::emitForOperands(Op op, const IRValue* term, int label) {
+    int operands[2] = {0, 0};
+    bool names[2] = {false, false};
+    const std::string* texts[2] = {&term->limit, &term->step};
+    for (int i = 0; i < 2; i++) {
+        const std::string& text = *texts[i];
+        names[i] = !(std::isdigit(static_cast<unsigned char>(text[0])) || text[0] == '-');
+        operands[i] = names[i] ? bytecode_.symbol(text) : std::atoi(text.c_str());
+    }
+    bytecode_.emitFor(op, bytecode_.symbol(term->name), operands[0], names[0], operands[1], names[1], label);
+}
+
+/**
+ * Binary search over targets[lo, hi), as in CodeGen::emitDecisionTree.
+ */
+void IRLowering::emitDecisionTree(const IRValue* subject, const std::vector<std::pair<int, int>>& targets,
+                                  size_t lo, size_t hi, int defaultLabel) {
+    if (hi - lo <= 3) {
+        for (size_t i = lo; i < hi; i++) {
+            pushOperand(subject);
+            bytecode_.emit(Op::PUSH, targets[i].first);
+            bytecode_.emit(Op::EQ);
+            bytecode_.emitJump(Op::JNZ, targets[i].second);
+        }
+        bytecode_.emitJump(Op::JMP, defaultLabel);
+        return;
+    }
+
+    size_t mid = lo + (hi - lo) / 2;
+    int lowerLabel = bytecode_.newLabel("match_lt");
+    pushOperand(subject);
+    bytecode_.emit(Op::PUSH, targets[mid].first);
+    bytecode_.emit(Op::LT);
+    bytecode_.emitJump(Op::JNZ, lowerLabel);
+    emitDecisionTree(subject, targets, mid, hi, defaultLabel);
+    bytecode_.place(lowerLabel);
+    emitDecisionTree(subject, targets, lo, mid, defaultLabel);
+}
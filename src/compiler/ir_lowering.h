@@ -0,0 +1,101 @@
+/**
+ * CINEBREW IR Lowering
+ *
+ * ============================================================================
+ * WHAT DOES IT DO?
+ * ============================================================================
+ *
+ * Turns the SSA IR back into stack bytecode ("stackification"). Every
+ * instruction is emitted at its own position; what differs is where its
+ * result lives until it is used:
+ *
+ *   - stack: used once, in the same block, by an instruction whose other
+ *     stack operands nest properly. The value just stays on the VM stack
+ *     (this is every temporary of an ordinary expression).
+ *   - rematerialized: constants and parameters are re-pushed at each use
+ *     (PUSH / FPUSH / LOADARG), a LOAD used by the very next instruction
+ *     is read there.
+ *   - local: anything else (several uses, used in another block, phis)
+ *     gets a frame slot: ENTER n reserves the slots on entry, STORELOCAL k
+ *     / LOADLOCAL k access them.
+ *
+ * Phis become copies into their slot at the end of each predecessor;
+ * critical edges that need copies are split so the copies only run on
+ * their own edge. A value that feeds a phi is computed straight into the
+ * phi's slot when the phi's old value is dead by then (the loop-carried
+ * values of a loop usually need no copy at all).
+ *
+ * Blocks are emitted in reverse postorder. With a profile (see
+ * profile.h) they are laid out as chains instead: each block is followed
+ * by its most likely successor, so the hot path falls through, and blocks
+ * the profiled run never reached go to the end of the function. SCENEs
+ * are then emitted hottest first, right after the main program.
+ * Instrumented builds count every branch and FOR loop (PROFBR, PROFLOOP).
+ *
+ * ============================================================================
+ */
+
+#ifndef IR_LOWERING_H
+#define IR_LOWERING_H
+
+#include "ir.h"
+#include "profile.h"
+#include "../vm/bytecode.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+class IRLowering {
+public:
+    explicit IRLowering(const Profile* profile = nullptr, bool instrument = false);
+
+    // Main function: bytecode for the whole module (same layout as CodeGen),
+    // not linked yet: the bytecode passes run first (Bytecode::compact)
+    Bytecode lower(IRModule& module);
+
+    // Blocks the profile moved away from their reverse-postorder position
+    int movedBlockCount() const { return movedBlocks_; }
+
+private:
+    enum class Home { NONE, STACK, REMAT, LOCAL, DISCARD };
+
+    const Profile* profile_;
+    bool instrument_;
+    Bytecode bytecode_;
+    int haltLabel_;
+    int propertySiteCounter_;
+    int movedBlocks_;
+
+    // Per function
+    std::unordered_map<const IRValue*, Home> home_;
+    std::unordered_map<const IRValue*, int> slot_;
+    std::unordered_set<const IRValue*> swapped_;  // Constant left operand pushed second, then SWAP
+    std::unordered_map<const IRBlock*, int> labels_;
+    int slotCount_;
+    int memoTable_;  // Symbol of the SCENE if memoized (MEMOGET / MEMOPUT), -1 otherwise
+
+    void emitOp(const std::string& opcode, int a = 0);  // Named by the IR (ADD, LOADARG, PRINT, ...)
+    void emitForOperands(Op op, const IRValue* term, int label);
+
+    void splitCriticalEdges(IRFunction& function);
+    std::vector<IRBlock*> profileLayout(const std::vector<IRBlock*>& order);
+    long long edgeCount(const IRBlock* block, size_t succ) const;
+    static bool isDenseSwitch(const IRValue* dispatch);
+    static std::string flippedComparison(const std::string& opcode);
+    static const IRValue* nextComputation(const IRBlock* block, size_t index);
+    void assignHomes(const std::vector<IRBlock*>& layout);
+    bool coalesces(const IRValue* value, const IRValue* phi,
+                   const std::unordered_map<const IRValue*, std::vector<const IRValue*>>& users) const;
+    bool needsCopy(const IRValue* phi, const IRValue* incoming) const;
+
+    void lowerFunction(IRFunction& function, bool haltAfterMain);
+    void lowerInstruction(IRValue* instr);
+    void lowerTerminator(IRBlock* block, IRBlock* next, bool haltAfterMain);
+    void emitPhiCopies(IRBlock* block);
+    void pushOperand(const IRValue* value);
+    void emitDecisionTree(const IRValue* subject, const std::vector<std::pair<int, int>>& targets,
+                          size_t lo, size_t hi, int defaultLabel);
+};
+
+#endif // IR_LOWERING_H
@@ -0,0 +1,178 @@
+/**
+ * IR Pass Manager and Basic Passes
+ */
+
+#include "ir_pass.h"
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+
+// ============================================================================
+// PASS MANAGER
+// ============================================================================
+
+IRPassManager::IRPassManager(bool verifyEach) : verifyEach_(verifyEach) {
+}
+
+void IRPassManager::add(std::unique_ptr<IRPass> pass) {
+    passes_.push_back(std::move(pass));
+}
+
+bool IRPassManager::run(IRModule& module) {
+    errors_.clear();
+    changes_.clear();
+    records_.clear();
+
+    if (verifyEach_ && !verify(module, "IR construction")) return false;
+
+    for (auto& pass : passes_) {
+        int before = module.instructionCount();
+        auto start = std::chrono::steady_clock::now();
+        int changes = pass->runOnModule(module);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        changes_[pass->name()] += changes;
+        records_.push_back({pass->name(), elapsed.count(), before, module.instructionCount(), changes});
+
+        if (verifyEach_ && changes > 0 && !verify(module, pass->name())) return false;
+    }
+    return true;
+}
+
+bool IRPassManager::verify(const IRModule& module, const std::string& after) {
+    IRVerifier verifier;
+    if (verifier.verify(module)) return true;
+
+    for (const std::string& error : verifier.getErrors()) {
+        errors_.push_back("after " + after + ": " + error);
+    }
+    return false;
+}
+
+// ============================================================================
+// TRIVIAL PHIS
+// ============================================================================
+
+int RemoveTrivialPhis::run(IRFunction& function) {
+    int removed = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& block : function.blocks) {
+            for (IRValue* phi : block->phis()) {
+                IRValue* same = nullptr;
+                bool trivial = true;
+                for (IRValue* operand : phi->operands) {
+                    if (operand == phi || operand == same) continue;
+                    if (same) {
+                        trivial = false;
+                        break;
+                    }
+                    same = operand;
+                }
+                if (!trivial || !same) continue;
+
+                // Replacing may make phis that used this one trivial too
+                function.replaceAllUses(phi, same);
+                auto& instrs = block->instrs;
+                instrs.erase(std::find_if(instrs.begin(), instrs.end(),
+                                          [&](const std::unique_ptr<IRValue>& v) {
+                                              return v.get() == phi;
+                                          }));
+                removed++;
+                changed = true;
+            }
+        }
+    }
+    return removed;
+}
+
+// ============================================================================
+// DEAD VALUES
+// ============================================================================
+
+int DeadValueElimination::run(IRFunction& function) {
+    int removed = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        std::unordered_set<IRValue*> used;
+        for (auto& block : function.blocks) {
+            for (auto& instr : block->instrs) {
+                for (IRValue* operand : instr->operands) {
+                    // A phi feeding only itself is still dead
+                    if (operand != instr.get()) used.insert(operand);
+                }
+            }
+        }
+
+        for (auto& block : function.blocks) {
+            auto& instrs = block->instrs;
+            size_t before = instrs.size();
+            instrs.erase(std::remove_if(instrs.begin(), instrs.end(),
+                                        [&](const std::unique_ptr<IRValue>& v) {
+                                            return v->hasResult() && !v->hasSideEffects() &&
+                                                   !used.count(v.get());
+                                        }),
+                         instrs.end());
+            if (instrs.size() != before) {
+                removed += (int)(before - instrs.size());
+                changed = true;
+            }
+        }
+    }
+    return removed;
+}
+
+// ============================================================================
+// MERGE BLOCKS
+// ============================================================================
+
+int MergeBlocks::run(IRFunction& function) {
+    int merged = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& blockPtr : function.blocks) {
+            IRBlock* block = blockPtr.get();
+            IRValue* term = block->terminator();
+            if (!term || term->op != IROp::JUMP) continue;
+
+            IRBlock* next = block->succs[0];
+            if (next == block || next == function.entry() || next->preds.size() != 1) continue;
+
+            // Single predecessor: its phis are plain copies
+            for (IRValue* phi : next->phis()) {
+                function.replaceAllUses(phi, phi->operands[0]);
+            }
+
+            // Move next's instructions (minus phis) over block's JUMP
+            block->instrs.pop_back();
+            for (auto& instr : next->instrs) {
+                if (instr->op == IROp::PHI) continue;
+                instr->block = block;
+                block->instrs.push_back(std::move(instr));
+            }
+            next->instrs.clear();
+
+            // block takes over next's outgoing edges
+            block->succs = next->succs;
+            for (IRBlock* succ : next->succs) {
+                for (IRBlock*& pred : succ->preds) {
+                    if (pred == next) pred = block;
+                }
+            }
+            next->succs.clear();
+            next->preds.clear();
+
+            function.blocks.erase(std::find_if(function.blocks.begin(), function.blocks.end(),
+                                               [&](const std::unique_ptr<IRBlock>& b) {
+                                                   return b.get() == next;
+                                               }));
+            merged++;
+            changed = true;
+            break;  // blocks changed under the iterator
+        }
+    }
+    return merged;
+}
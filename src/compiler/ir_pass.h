@@ -0,0 +1,119 @@
+/**
+ * CINEBREW IR Passes
+ *
+ * ============================================================================
+ * PASS MANAGER
+ * ============================================================================
+ *
+ * An IRPass transforms one IRFunction and reports how many changes it
+ * made. IRPassManager runs its passes in order over every function of the
+ * module and runs the IRVerifier on the builder's output and after every
+ * pass, so a broken pass is caught by name instead of as wrong bytecode:
+ *
+ *   IRPassManager passes;
+ *   passes.add(std::make_unique<RemoveTrivialPhis>());
+ *   passes.add(std::make_unique<DeadValueElimination>());
+ *   if (!passes.run(*module)) { ... passes.getErrors() ... }
+ *
+ * Every run of a pass is recorded with its wall time (verification not
+ * included), the module's size before and after, and its change count.
+ *
+ * ============================================================================
+ */
+
+#ifndef IR_PASS_H
+#define IR_PASS_H
+
+#include "ir.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+class IRPass {
+public:
+    virtual ~IRPass() {}
+    virtual std::string name() const = 0;
+
+    // Transform the function; returns the number of changes (0: untouched)
+    virtual int run(IRFunction& function) = 0;
+
+    // Whole-module passes (the inliner) override this instead
+    virtual int runOnModule(IRModule& module) {
+        int changes = 0;
+        for (auto& function : module.functions) {
+            changes += run(*function);
+        }
+        return changes;
+    }
+};
+
+/**
+ * What one pass did (also used by the Compiler for its AST and bytecode
+ * passes). Sizes are IR instructions for IR passes, bytecode instructions
+ * for bytecode passes, -1 where there is no instruction count (the AST).
+ */
+struct PassRecord {
+    std::string name;
+    double millis;
+    int sizeBefore;
+    int sizeAfter;
+    int changes;
+};
+
+class IRPassManager {
+public:
+    explicit IRPassManager(bool verifyEach = true);
+
+    void add(std::unique_ptr<IRPass> pass);
+
+    // Run every pass over every function; false if verification failed
+    bool run(IRModule& module);
+
+    const std::vector<std::string>& getErrors() const { return errors_; }
+    const std::map<std::string, int>& changeCounts() const { return changes_; }  // Pass name -> changes
+    const std::vector<PassRecord>& records() const { return records_; }          // In running order
+
+private:
+    std::vector<std::unique_ptr<IRPass>> passes_;
+    bool verifyEach_;
+    std::vector<std::string> errors_;
+    std::map<std::string, int> changes_;
+    std::vector<PassRecord> records_;
+
+    bool verify(const IRModule& module, const std::string& after);
+};
+
+// ============================================================================
+// PASSES
+// ============================================================================
+
+/**
+ * phi(x, x, ...) or phi(x, self, ...) is just x.
+ */
+class RemoveTrivialPhis : public IRPass {
+public:
+    std::string name() const override { return "trivial-phis"; }
+    int run(IRFunction& function) override;
+};
+
+/**
+ * Delete values nobody uses and that have no side effects.
+ */
+class DeadValueElimination : public IRPass {
+public:
+    std::string name() const override { return "dead-values"; }
+    int run(IRFunction& function) override;
+};
+
+/**
+ * Merge a block into its only predecessor when that predecessor jumps
+ * straight to it, so straight-line code is one block.
+ */
+class MergeBlocks : public IRPass {
+public:
+    std::string name() const override { return "merge-blocks"; }
+    int run(IRFunction& function) override;
+};
+
+#endif // IR_PASS_H
@@ -18,16 +18,27 @@ void Lexer::initializeKeywords() {
     if (!keywords_.empty()) return;  // Already initialized
     
     keywords_["TAKE"] = TokenType::TAKE;
+    keywords_["CONST"] = TokenType::CONST;
     keywords_["POUR"] = TokenType::POUR;
     keywords_["SCENE"] = TokenType::SCENE;
+    keywords_["INLINE"] = TokenType::INLINE;
+    keywords_["NOINLINE"] = TokenType::NOINLINE;
+    keywords_["MEMO"] = TokenType::MEMO;
     keywords_["SHOT"] = TokenType::SHOT;
     keywords_["IF"] = TokenType::IF;
     keywords_["ELSE"] = TokenType::ELSE;
     keywords_["LOOP"] = TokenType::LOOP;
+    keywords_["FOR"] = TokenType::FOR;
+    keywords_["TO"] = TokenType::TO;
+    keywords_["STEP"] = TokenType::STEP;
+    keywords_["MATCH"] = TokenType::MATCH;
+    keywords_["CASE"] = TokenType::CASE;
     keywords_["BREAK"] = TokenType::BREAK;
     keywords_["CONTINUE"] = TokenType::CONTINUE;
     keywords_["true"] = TokenType::TRUE_KW;
     keywords_["false"] = TokenType::FALSE_KW;
+    keywords_["AND"] = TokenType::AND;
+    keywords_["OR"] = TokenType::OR;
 }
 
 // ============================================================================
@@ -188,6 +199,14 @@ void Lexer::scanToken() {
             addToken(TokenType::COMMA);
             break;
             
+        case '.':
+            addToken(TokenType::DOT);
+            break;
+            
+        case ':':
+            addToken(TokenType::COLON);
+            break;
+            
         // ====================================================================
         // OPERATORS (may be multi-character)
         // ====================================================================
@@ -214,6 +233,30 @@ void Lexer::scanToken() {
             addToken(TokenType::SLASH);
             break;
             
+        case '%':
+            addToken(TokenType::PERCENT);
+            break;
+            
+        case '&':
+            if (match('&')) {
+                addToken(TokenType::AND);        // &&
+            } else {
+                addToken(TokenType::AMPERSAND);  // &
+            }
+            break;
+            
+        case '|':
+            if (match('|')) {
+                addToken(TokenType::OR);         // ||
+            } else {
+                addToken(TokenType::PIPE);       // |
+            }
+            break;
+            
+        case '^':
+            addToken(TokenType::CARET);
+            break;
+            
         case '=':
             if (match('=')) {
                 addToken(TokenType::EQUAL_EQUAL);  // ==
@@ -226,14 +269,15 @@ void Lexer::scanToken() {
             if (match('=')) {
                 addToken(TokenType::BANG_EQUAL);  // !=
             } else {
-                error("Unexpected character '!' (did you mean '!='?)");
-                addToken(TokenType::ERROR);
+                addToken(TokenType::BANG);        // !
             }
             break;
             
         case '>':
             if (match('=')) {
                 addToken(TokenType::GREATER_EQUAL);  // >=
+            } else if (match('>')) {
+                addToken(TokenType::GREATER_GREATER); // >>
             } else {
                 addToken(TokenType::GREATER);       // >
             }
@@ -242,6 +286,8 @@ void Lexer::scanToken() {
         case '<':
             if (match('=')) {
                 addToken(TokenType::LESS_EQUAL);     // <=
+            } else if (match('<')) {
+                addToken(TokenType::LESS_LESS);      // <<
             } else {
                 addToken(TokenType::LESS);           // <
             }
@@ -311,19 +357,28 @@ void Lexer::scanNumber() {
         advance();
     }
     
-    // Check for decimal point (not supported yet, but prepare for future)
+    TokenType type = TokenType::NUMBER;
+    
+    // Fractional part: 3.5 is a float literal
     if (peek() == '.' && isDigit(peekNext())) {
-        // Decimal number (for future)
         advance();  // Consume '.'
         while (isDigit(peek())) {
             advance();
         }
-        error("Floating point numbers not yet supported");
+        type = TokenType::FLOAT_NUMBER;
+    }
+    
+    // 'q' suffix: 16.16 fixed-point literal (1.5q, 2q)
+    if (peek() == 'q' && !isAlphaNumeric(peekNext())) {
+        std::string value = getCurrentLexeme();
+        advance();  // Consume 'q'
+        addToken(TokenType::FIXED_NUMBER, value);
+        return;
     }
     
     // Extract number value
     std::string value = getCurrentLexeme();
-    addToken(TokenType::NUMBER, value);
+    addToken(type, value);
 }
 
 // ============================================================================
@@ -0,0 +1,674 @@
+/**
+ * Loop Optimizer Implementation
+ */
+
+#include "loop_opt.h"
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+// ============================================================================
+// LOOPS
+// ============================================================================
+
+std::vector<IRLoop> findLoops(const IRFunction& function) {
+    IRDominators dominators(function);
+    const std::vector<IRBlock*>& rpo = dominators.order();
+    std::unordered_map<const IRBlock*, int> index;
+    for (size_t i = 0; i < rpo.size(); i++) index[rpo[i]] = (int)i;
+
+    // One loop per header; several back edges (CONTINUE) share it
+    std::map<int, IRLoop> byHeader;
+    for (IRBlock* block : rpo) {
+        for (IRBlock* succ : block->succs) {
+            if (!dominators.dominates(succ, block)) continue;
+
+            IRLoop& loop = byHeader[index[succ]];
+            loop.header = succ;
+            loop.contains.insert(succ);
+            if (std::find(loop.latches.begin(), loop.latches.end(), block) == loop.latches.end()) {
+                loop.latches.push_back(block);
+            }
+
+            // Everything that reaches the back edge without passing the header
+            std::vector<IRBlock*> work = {block};
+            while (!work.empty()) {
+                IRBlock* b = work.back();
+                work.pop_back();
+                if (!loop.contains.insert(b).second) continue;
+                for (IRBlock* pred : b->preds) {
+                    if (index.count(pred)) work.push_back(pred);
+                }
+            }
+        }
+    }
+
+    std::vector<IRLoop> loops;
+    for (auto& entry : byHeader) {
+        IRLoop& loop = entry.second;
+        for (IRBlock* block : rpo) {
+            if (loop.contains.count(block)) loop.blocks.push_back(block);
+        }
+
+        std::vector<IRBlock*> outside;
+        for (IRBlock* pred : loop.header->preds) {
+            if (!loop.contains.count(pred)) outside.push_back(pred);
+        }
+        if (outside.size() == 1) loop.preheader = outside[0];
+        loops.push_back(std::move(loop));
+    }
+
+    for (IRLoop& loop : loops) {
+        for (const IRLoop& other : loops) {
+            if (&other != &loop && other.contains.count(loop.header)) loop.depth++;
+        }
+    }
+    std::stable_sort(loops.begin(), loops.end(),
+                     [](const IRLoop& a, const IRLoop& b) { return a.depth < b.depth; });
+    return loops;
+}
+
+// ============================================================================
+// LOOP PASS HELPERS
+// ============================================================================
+
+int LoopPass::runOnModule(IRModule& module) {
+    scenes_.clear();
+    for (auto& function : module.functions) {
+        if (!function->isMain) scenes_.insert(function->name);
+    }
+
+    int changes = 0;
+    for (auto& function : module.functions) {
+        changes += run(*function);
+    }
+    return changes;
+}
+
+bool LoopPass::callsScene(const IRLoop& loop) const {
+    for (IRBlock* block : loop.blocks) {
+        for (auto& instr : block->instrs) {
+            if (instr->op == IROp::CALL && scenes_.count(instr->name)) return true;
+        }
+    }
+    return false;
+}
+
+IRValue* LoopPass::insertBeforeTerminator(IRFunction& function, IRBlock* block, IROp op, ValueType type) {
+    return function.insert(block, block->instrs.size() - 1, op, type);
+}
+
+IRValue* LoopPass::constantBeforeTerminator(IRFunction& function, IRBlock* block, int value) {
+    IRValue* constant = insertBeforeTerminator(function, block, IROp::CONST, ValueType::INT);
+    constant->imm = value;
+    return constant;
+}
+
+// FOR limit / step: an immediate, or a hidden global
+static bool immediate(const std::string& operand, int& value) {
+    if (operand.empty() || !(std::isdigit(static_cast<unsigned char>(operand[0])) || operand[0] == '-')) {
+        return false;
+    }
+    value = std::stoi(operand);
+    return true;
+}
+
+static IRValue* lookup(const std::unordered_map<const IRValue*, IRValue*>& map, IRValue* value) {
+    auto it = map.find(value);
+    return it == map.end() ? value : it->second;
+}
+
+// ============================================================================
+// UNROLLING
+// ============================================================================
+
+int LoopUnroll::run(IRFunction& function) {
+    int unrolled = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::vector<IRLoop> loops = findLoops(function);
+        for (auto it = loops.rbegin(); it != loops.rend(); ++it) {  // Innermost first
+            if (unroll(function, *it)) {
+                unrolled++;
+                changed = true;
+                break;  // The CFG changed
+            }
+        }
+    }
+    return unrolled;
+}
+
+/**
+ * FOR var = <const> TO <imm> STEP <imm> with a one-block body:
+ *
+ *   pre:  STORE var, c; FORPREP   →   pre:    STORE var, c; JUMP unroll
+ *   for:  body; FORLOOP               unroll: body[var=c]; body[var=c+s]; ...
+ *                                             STORE var, <value after the loop>
+ */
+bool LoopUnroll::unroll(IRFunction& function, const IRLoop& loop) {
+    IRBlock* body = loop.header;
+    IRBlock* pre = loop.preheader;
+    if (!pre || loop.blocks.size() != 1) return false;
+
+    IRValue* latch = body->terminator();
+    IRValue* prep = pre->terminator();
+    if (latch->op != IROp::FORLOOP || prep->op != IROp::FORPREP || body->succs[0] != body) return false;
+    IRBlock* exit = body->succs[1];
+    if (pre->succs[0] != body || pre->succs[1] != exit) return false;
+
+    int limit, step;
+    if (!immediate(latch->limit, limit) || !immediate(latch->step, step) || step == 0) return false;
+
+    // The start value: the STORE to the variable just before FORPREP
+    const std::string& var = latch->name;
+    IRValue* startValue = nullptr;
+    for (size_t i = pre->instrs.size() - 1; i-- > 0;) {
+        IRValue* instr = pre->instrs[i].get();
+        if (instr->op == IROp::CALL && scenes_.count(instr->name)) return false;
+        if (instr->op == IROp::STORE && instr->name == var) {
+            startValue = instr->operands[0];
+            break;
+        }
+    }
+    if (!startValue || startValue->op != IROp::CONST) return false;
+
+    // Trip count, the way the VM runs it (64-bit, so no wrap)
+    long long value = startValue->imm;
+    int trips = 0;
+    while ((step > 0 ? value <= limit : value >= limit) && trips <= MAX_TRIPS) {
+        trips++;
+        value += step;
+    }
+    int size = 0;
+    bool writesVar = false;  // Else every LOAD var is a constant
+    for (auto& instr : body->instrs) {
+        if (instr->op == IROp::PHI || instr->isTerminator()) continue;
+        size++;
+        if ((instr->op == IROp::STORE && instr->name == var) ||
+            (instr->op == IROp::CALL && scenes_.count(instr->name))) {
+            writesVar = true;
+        }
+    }
+    if (trips == 0 || trips > MAX_TRIPS || size * trips > MAX_INSTRUCTIONS) return false;
+
+    size_t entryEdge = std::find(body->preds.begin(), body->preds.end(), pre) - body->preds.begin();
+    size_t backEdge = std::find(body->preds.begin(), body->preds.end(), body) - body->preds.begin();
+
+    IRBlock* copies = function.addBlock("unroll");
+    std::unordered_map<const IRValue*, IRValue*> current;  // Body value -> this iteration's copy
+    for (IRValue* phi : body->phis()) {
+        current[phi] = phi->operands[entryEdge];
+    }
+
+    auto storeVar = [&](long long v) {
+        IRValue* constant = function.append(copies, IROp::CONST, ValueType::INT);
+        constant->imm = (int)v;
+        IRValue* store = function.append(copies, IROp::STORE, ValueType::INT);
+        store->name = var;
+        store->operands.push_back(constant);
+    };
+
+    std::unordered_map<const IRValue*, IRValue*> last;
+    value = startValue->imm;
+    for (int trip = 0; trip < trips; trip++, value += step) {
+        if (writesVar) storeVar(value);
+        for (auto& instr : body->instrs) {
+            if (instr->op == IROp::PHI || instr->isTerminator()) continue;
+            if (!writesVar && instr->op == IROp::LOAD && instr->name == var) {
+                IRValue* constant = function.append(copies, IROp::CONST, ValueType::INT);
+                constant->imm = (int)value;
+                current[instr.get()] = constant;
+                continue;
+            }
+            IRValue* clone = function.append(copies, instr->op, instr->type);
+            clone->imm = instr->imm;
+            clone->name = instr->name;
+            clone->limit = instr->limit;
+            clone->step = instr->step;
+            clone->cases = instr->cases;
+            clone->purity = instr->purity;
+            for (IRValue* operand : instr->operands) {
+                clone->operands.push_back(lookup(current, operand));
+            }
+            current[instr.get()] = clone;
+        }
+
+        // Phis take their back-edge value for the next iteration
+        last = current;
+        std::vector<IRValue*> phis = body->phis();
+        std::vector<IRValue*> next;
+        for (IRValue* phi : phis) next.push_back(lookup(current, phi->operands[backEdge]));
+        for (size_t i = 0; i < phis.size(); i++) current[phis[i]] = next[i];
+    }
+    storeVar(value);  // What FORLOOP leaves in the variable
+    function.append(copies, IROp::JUMP, ValueType::INT);
+
+    // The preheader always enters the copies (trips > 0)
+    function.removeEdge(pre, 1);
+
+    // The copies leave to the exit instead of the body
+    size_t exitEdge = std::find(exit->preds.begin(), exit->preds.end(), body) - exit->preds.begin();
+    for (IRValue* phi : exit->phis()) {
+        phi->operands[exitEdge] = lookup(last, phi->operands[exitEdge]);
+    }
+    exit->preds[exitEdge] = copies;
+    copies->succs.push_back(exit);
+    body->succs.pop_back();
+
+    pre->instrs.pop_back();
+    function.append(pre, IROp::JUMP, ValueType::INT);
+    pre->succs[0] = copies;
+    copies->preds.push_back(pre);
+    body->preds.erase(body->preds.begin() + entryEdge);
+    for (IRValue* phi : body->phis()) {
+        phi->operands.erase(phi->operands.begin() + entryEdge);
+    }
+
+    function.removeUnreachableBlocks();
+    return true;
+}
+
+// ============================================================================
+// PROMOTION OF GLOBALS
+// ============================================================================
+
+int PromoteGlobals::run(IRFunction& function) {
+    int promoted = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        IRDominators dominators(function);
+        for (const IRLoop& loop : findLoops(function)) {  // Outermost first
+            if (!loop.preheader || callsScene(loop)) continue;
+
+            // FORPREP / FORLOOP read their variable and bounds by name
+            std::set<std::string> accessed, byName;
+            for (IRBlock* block : loop.blocks) {
+                for (auto& instr : block->instrs) {
+                    if (instr->op == IROp::LOAD || instr->op == IROp::STORE) {
+                        accessed.insert(instr->name);
+                    } else if (instr->op == IROp::FORPREP || instr->op == IROp::FORLOOP) {
+                        byName.insert(instr->name);
+                        byName.insert(instr->limit);
+                        byName.insert(instr->step);
+                    }
+                }
+            }
+            // The preheader LOADs the global and the exits STORE it: both
+            // are only as harmless as in the original program if the
+            // global already exists, i.e. a STORE dominates the preheader
+            std::set<std::string> assigned;
+            for (const IRBlock* block = loop.preheader; block; block = dominators.idom(block)) {
+                for (auto& instr : block->instrs) {
+                    if (instr->op == IROp::STORE) assigned.insert(instr->name);
+                }
+            }
+
+            for (const std::string& global : accessed) {
+                if (byName.count(global) || !assigned.count(global)) continue;
+                promote(function, loop, global);
+                promoted++;
+                changed = true;
+            }
+            if (changed) break;  // Blocks were added; find the loops again
+        }
+    }
+
+    RemoveTrivialPhis trivial;
+    trivial.run(function);
+    return promoted;
+}
+
+/**
+ * SSA renaming of one global over the loop body: a phi wherever control
+ * flow merges inside the loop (the trivial ones are removed afterwards).
+ */
+void PromoteGlobals::promote(IRFunction& function, const IRLoop& loop, const std::string& global) {
+    ValueType type = ValueType::INT;
+    for (IRBlock* block : loop.blocks) {
+        for (auto& instr : block->instrs) {
+            if (instr->op == IROp::LOAD && instr->name == global) type = instr->type;
+        }
+    }
+
+    IRValue* initial = insertBeforeTerminator(function, loop.preheader, IROp::LOAD, type);
+    initial->name = global;
+
+    std::unordered_map<const IRBlock*, IRValue*> phis, atEnd;
+    for (IRBlock* block : loop.blocks) {
+        if (block == loop.header || block->preds.size() > 1) {
+            phis[block] = function.insert(block, 0, IROp::PHI, type);
+        }
+    }
+
+    bool stored = false;
+    for (IRBlock* block : loop.blocks) {
+        // Inside a reducible loop only the header has outside predecessors,
+        // and a single predecessor comes earlier in reverse postorder
+        IRValue* current = phis.count(block) ? phis[block] : atEnd[block->preds[0]];
+        auto& instrs = block->instrs;
+        for (size_t i = 0; i < instrs.size();) {
+            IRValue* instr = instrs[i].get();
+            if (instr->op == IROp::LOAD && instr->name == global) {
+                function.replaceAllUses(instr, current);
+            } else if (instr->op == IROp::STORE && instr->name == global) {
+                current = instr->operands[0];
+                stored = true;
+            } else {
+                i++;
+                continue;
+            }
+            instrs.erase(instrs.begin() + i);
+        }
+        atEnd[block] = current;
+    }
+
+    for (auto& entry : phis) {
+        for (IRBlock* pred : entry.first->preds) {
+            entry.second->operands.push_back(loop.contains.count(pred) ? atEnd[pred] : initial);
+        }
+    }
+    if (!stored) return;
+
+    // Store the value back on every way out of the loop
+    std::vector<IRBlock*> blocks = loop.blocks;
+    for (IRBlock* block : blocks) {
+        auto storeAt = [&](IRBlock* target, size_t index) {
+            IRValue* store = function.insert(target, index, IROp::STORE, ValueType::INT);
+            store->name = global;
+            store->operands.push_back(atEnd[block]);
+        };
+
+        if (block->succs.empty()) {  // SHOT or the end of the program
+            storeAt(block, block->instrs.size() - 1);
+            continue;
+        }
+        for (size_t i = 0; i < block->succs.size(); i++) {
+            IRBlock* succ = block->succs[i];
+            if (loop.contains.count(succ)) continue;
+            if (block->succs.size() == 1) {
+                storeAt(block, block->instrs.size() - 1);
+                continue;
+            }
+
+            // Split the exit edge: the store must not run on the other edges
+            int nth = 0;
+            for (size_t k = 0; k < i; k++) {
+                if (block->succs[k] == succ) nth++;
+            }
+            IRBlock* edge = function.addBlock("loop_exit");
+            function.append(edge, IROp::JUMP, ValueType::INT);
+            storeAt(edge, 0);
+            for (IRBlock*& pred : succ->preds) {
+                if (pred == block && nth-- == 0) {
+                    pred = edge;
+                    break;
+                }
+            }
+            edge->preds.push_back(block);
+            edge->succs.push_back(succ);
+            block->succs[i] = edge;
+        }
+    }
+}
+
+// ============================================================================
+// INVARIANT CODE MOTION
+// ============================================================================
+
+int LoopInvariantCodeMotion::run(IRFunction& function) {
+    int hoisted = 0;
+    std::vector<IRLoop> loops = findLoops(function);
+
+    // Innermost first: a value hoisted into an inner preheader is still in
+    // the outer loop and may move again
+    for (auto it = loops.rbegin(); it != loops.rend(); ++it) {
+        const IRLoop& loop = *it;
+        if (!loop.preheader) continue;
+
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            for (IRBlock* block : loop.blocks) {
+                auto& instrs = block->instrs;
+                for (size_t i = 0; i < instrs.size();) {
+                    IRValue* instr = instrs[i].get();
+                    // Not DIV / MOD (may trap) nor calls with effects
+                    bool invariant = (instr->op == IROp::CONST || instr->op == IROp::UNARY ||
+                                      instr->op == IROp::BINARY || instr->op == IROp::CALL) &&
+                                     !instr->hasSideEffects();
+                    for (IRValue* operand : instr->operands) {
+                        if (loop.has(operand)) invariant = false;
+                    }
+                    if (!invariant) {
+                        i++;
+                        continue;
+                    }
+
+                    IRBlock* pre = loop.preheader;
+                    std::unique_ptr<IRValue> value = std::move(instrs[i]);
+                    instrs.erase(instrs.begin() + i);
+                    value->block = pre;
+                    pre->instrs.insert(pre->instrs.end() - 1, std::move(value));
+                    if (instr->op != IROp::CONST) hoisted++;
+                    moved = true;
+                }
+            }
+        }
+    }
+    return hoisted;
+}
+
+// ============================================================================
+// STRENGTH REDUCTION
+// ============================================================================
+
+namespace {
+
+/**
+ * value = scale * iv + offset + sum(coefficient * term), the terms being
+ * loop invariants. Arithmetic is modulo 2^32, like the VM's.
+ */
+struct Affine {
+    const IRValue* iv = nullptr;  // Header phi, or the FORLOOP for a FOR variable
+    uint32_t scale = 1;
+    uint32_t offset = 0;
+    std::vector<std::pair<uint32_t, IRValue*>> terms;
+    int ops = 0;  // Instructions it replaces
+
+    void multiply(uint32_t factor) {
+        scale *= factor;
+        offset *= factor;
+        for (auto& term : terms) term.first *= factor;
+    }
+};
+
+struct Induction {
+    IRValue* start;     // Value on entry (nullptr: LOAD the FOR variable)
+    uint32_t step;
+    IRValue* update;    // After it, the IV has advanced (nullptr: before FORLOOP)
+};
+
+}  // namespace
+
+int StrengthReduction::run(IRFunction& function) {
+    int reduced = 0;
+    std::vector<IRLoop> loops = findLoops(function);
+
+    for (const IRLoop& loop : loops) {
+        IRBlock* pre = loop.preheader;
+        IRBlock* header = loop.header;
+        if (!pre || loop.latches.size() != 1 || header->preds.size() != 2) continue;
+        IRBlock* latch = loop.latches[0];
+        size_t entryEdge = header->preds[0] == pre ? 0 : 1;
+
+        // Basic induction variables: phi(start, phi + c) ...
+        std::unordered_map<const IRValue*, Induction> ivs;
+        for (IRValue* phi : header->phis()) {
+            IRValue* next = phi->operands[1 - entryEdge];
+            if (phi->type != ValueType::INT || next->op != IROp::BINARY || next->operands.size() != 2) continue;
+            IRValue* a = next->operands[0];
+            IRValue* b = next->operands[1];
+            if (next->name == "ADD" && a == phi && b->op == IROp::CONST) {
+                ivs[phi] = {phi->operands[entryEdge], (uint32_t)b->imm, next};
+            } else if (next->name == "ADD" && b == phi && a->op == IROp::CONST) {
+                ivs[phi] = {phi->operands[entryEdge], (uint32_t)a->imm, next};
+            } else if (next->name == "SUB" && a == phi && b->op == IROp::CONST) {
+                ivs[phi] = {phi->operands[entryEdge], 0u - (uint32_t)b->imm, next};
+            }
+        }
+
+        // ... and the variable of a FOR whose FORLOOP closes this loop
+        IRValue* forLoop = latch->terminator();
+        int forStep = 0;
+        bool forIV = forLoop->op == IROp::FORLOOP && latch->succs[0] == header &&
+                     immediate(forLoop->step, forStep) && !callsScene(loop);
+        for (IRBlock* block : loop.blocks) {
+            for (auto& instr : block->instrs) {
+                if (!forIV) break;
+                if ((instr->op == IROp::STORE && instr->name == forLoop->name) ||
+                    ((instr->op == IROp::FORPREP || instr->op == IROp::FORLOOP) &&
+                     instr.get() != forLoop && instr->name == forLoop->name)) {
+                    forIV = false;
+                }
+            }
+        }
+        if (forIV) ivs[forLoop] = {nullptr, (uint32_t)forStep, nullptr};
+        if (ivs.empty()) continue;
+
+        // Affine form of every loop value, in definition order
+        std::unordered_map<const IRValue*, Affine> affine;
+        std::unordered_map<const IRValue*, std::vector<IRValue*>> users;
+        for (IRBlock* block : loop.blocks) {
+            for (auto& instr : block->instrs) {
+                IRValue* v = instr.get();
+                for (IRValue* operand : v->operands) users[operand].push_back(v);
+
+                if (ivs.count(v)) {
+                    affine[v].iv = v;
+                    continue;
+                }
+                if (forIV && v->op == IROp::LOAD && v->name == forLoop->name) {
+                    affine[v].iv = forLoop;
+                    continue;
+                }
+                if (v->op != IROp::BINARY || v->type != ValueType::INT) continue;
+
+                IRValue* a = v->operands[0];
+                IRValue* b = v->operands[1];
+                auto invariant = [&](IRValue* x) { return !loop.has(x) || x->op == IROp::CONST; };
+                Affine result;
+                if ((v->name == "MUL" || v->name == "SHL") && affine.count(a) && b->op == IROp::CONST) {
+                    if (v->name == "SHL" && (b->imm < 0 || b->imm > 30)) continue;
+                    result = affine[a];
+                    result.multiply(v->name == "SHL" ? 1u << b->imm : (uint32_t)b->imm);
+                } else if (v->name == "MUL" && affine.count(b) && a->op == IROp::CONST) {
+                    result = affine[b];
+                    result.multiply((uint32_t)a->imm);
+                } else if ((v->name == "ADD" || v->name == "SUB") && affine.count(a) && invariant(b)) {
+                    result = affine[a];
+                    uint32_t sign = v->name == "SUB" ? 0u - 1u : 1u;
+                    if (b->op == IROp::CONST) {
+                        result.offset += sign * (uint32_t)b->imm;
+                    } else {
+                        result.terms.push_back({sign, b});
+                    }
+                } else if ((v->name == "ADD" || v->name == "SUB") && affine.count(b) && invariant(a)) {
+                    result = affine[b];
+                    if (v->name == "SUB") result.multiply(0u - 1u);  // a - affine
+                    if (a->op == IROp::CONST) {
+                        result.offset += (uint32_t)a->imm;
+                    } else {
+                        result.terms.push_back({1u, a});
+                    }
+                } else {
+                    continue;
+                }
+                result.ops++;
+                affine[v] = result;
+            }
+        }
+
+        // Reduce the largest affine expressions worth it. Each operation
+        // costs about two instructions (operand and opcode); the new
+        // variable costs a LOADLOCAL where it is used and four to advance
+        // it, so it pays from three operations on
+        for (IRBlock* block : loop.blocks) {
+            for (size_t i = 0; i < block->instrs.size(); i++) {
+                IRValue* v = block->instrs[i].get();
+                auto found = affine.find(v);
+                if (found == affine.end() || found->second.ops < MIN_OPERATIONS) continue;
+
+                bool extended = !users[v].empty();
+                for (IRValue* user : users[v]) {
+                    auto parent = affine.find(user);
+                    if (parent == affine.end() || parent->second.ops < MIN_OPERATIONS) extended = false;
+                }
+                if (extended) continue;  // A larger expression gets reduced instead
+
+                const Affine& form = found->second;
+                const Induction& iv = ivs[form.iv];
+
+                // Value on entry, computed in the preheader
+                IRValue* start = iv.start;
+                if (!start) {
+                    start = insertBeforeTerminator(function, pre, IROp::LOAD, ValueType::INT);
+                    start->name = forLoop->name;
+                }
+                IRValue* init = start;
+                auto binary = [&](const char* opcode, IRValue* left, IRValue* right) {
+                    IRValue* op = insertBeforeTerminator(function, pre, IROp::BINARY, ValueType::INT);
+                    op->name = opcode;
+                    op->operands = {left, right};
+                    return op;
+                };
+                if (form.scale != 1) init = binary("MUL", init, constantBeforeTerminator(function, pre, (int)form.scale));
+                if (form.offset != 0) init = binary("ADD", init, constantBeforeTerminator(function, pre, (int)form.offset));
+                for (const auto& term : form.terms) {
+                    if (term.first == 0u - 1u) {
+                        init = binary("SUB", init, term.second);
+                    } else if (term.first == 1) {
+                        init = binary("ADD", init, term.second);
+                    } else {
+                        IRValue* factor = constantBeforeTerminator(function, pre, (int)term.first);
+                        init = binary("ADD", init, binary("MUL", term.second, factor));
+                    }
+                }
+
+                // New induction variable, advanced where the old one is
+                IRValue* phi = function.insert(header, 0, IROp::PHI, ValueType::INT);
+                IRBlock* updateBlock = iv.update ? iv.update->block : latch;
+                size_t at = updateBlock->instrs.size() - 1;
+                if (iv.update) {
+                    at = std::find_if(updateBlock->instrs.begin(), updateBlock->instrs.end(),
+                                      [&](const std::unique_ptr<IRValue>& x) { return x.get() == iv.update; }) -
+                         updateBlock->instrs.begin() + 1;
+                }
+                IRValue* stride = function.insert(updateBlock, at, IROp::CONST, ValueType::INT);
+                stride->imm = (int)(form.scale * iv.step);
+                IRValue* next = function.insert(updateBlock, at + 1, IROp::BINARY, ValueType::INT);
+                next->name = "ADD";
+                next->operands = {phi, stride};
+
+                phi->operands.resize(2);
+                phi->operands[entryEdge] = init;
+                phi->operands[1 - entryEdge] = next;
+
+                function.replaceAllUses(v, phi);
+                next->operands[0] = phi;
+                reduced++;
+
+                // Instructions were inserted before this one
+                if (block == header || block == updateBlock) {
+                    i = std::find_if(block->instrs.begin(), block->instrs.end(),
+                                     [&](const std::unique_ptr<IRValue>& x) { return x.get() == v; }) -
+                        block->instrs.begin();
+                }
+            }
+        }
+    }
+    return reduced;
+}
@@ -0,0 +1,124 @@
+/**
+ * CINEBREW Loop Optimizer
+ *
+ * ============================================================================
+ * WHAT DOES IT DO?
+ * ============================================================================
+ *
+ * IR passes for the code that runs most often: loop bodies. Loops are the
+ * natural loops of the CFG (a back edge to a block that dominates its
+ * source), so LOOP, FOR and loops built from inlined SCENEs are all found
+ * the same way. Each loop needs a preheader, the single block outside the
+ * loop that enters it; code hoisted out of the loop goes at its end.
+ *
+ * The passes, in pipeline order:
+ *
+ *   LoopUnroll         FOR loops with a constant trip count of at most 8
+ *                      and a one-block body are replaced by copies of the
+ *                      body (no FORPREP / FORLOOP at all).
+ *   PromoteGlobals     A global only touched by LOAD / STORE inside a loop
+ *                      that calls no SCENE lives in an SSA value (a phi at
+ *                      the loop header) while the loop runs; it is loaded
+ *                      once before and stored back on the way out. Only
+ *                      globals already assigned before the loop (a STORE
+ *                      dominates the preheader) are promoted.
+ *   LoopInvariantCodeMotion
+ *                      Arithmetic and pure / frame-stable built-in calls
+ *                      whose operands are all defined outside the loop
+ *                      are computed once, in the preheader.
+ *   StrengthReduction  An affine expression of an induction variable
+ *                      (i * 8 + base + 4) gets its own induction variable
+ *                      that is advanced by a constant each iteration.
+ *
+ *   TAKE i = 0;                         TAKE i = 0;
+ *   LOOP i < n {                        i' = i; t = base + 4; lim = n   (once)
+ *       POUR i * 8 + base + 4;  →       LOOP i' < lim {
+ *       i = i + 1;                          POUR t;
+ *   }                                       i' = i' + 1; t = t + 8;
+ *                                       }
+ *                                       i = i'
+ *
+ * ============================================================================
+ */
+
+#ifndef LOOP_OPT_H
+#define LOOP_OPT_H
+
+#include "ir_pass.h"
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+/**
+ * A natural loop: the header, every block that can reach a back edge
+ * without leaving through the header, and the preheader (nullptr if the
+ * header has several predecessors outside the loop).
+ */
+struct IRLoop {
+    IRBlock* header = nullptr;
+    IRBlock* preheader = nullptr;
+    std::vector<IRBlock*> blocks;               // Reverse postorder, header first
+    std::unordered_set<const IRBlock*> contains;
+    std::vector<IRBlock*> latches;              // Sources of the back edges
+    int depth = 1;                              // 1: outermost
+
+    bool has(const IRValue* value) const { return contains.count(value->block) > 0; }
+};
+
+// All loops of the function, outermost first
+std::vector<IRLoop> findLoops(const IRFunction& function);
+
+/**
+ * Base for the loop passes: knows which CALLs are SCENEs (a SCENE may
+ * read or write any global, a built-in never does).
+ */
+class LoopPass : public IRPass {
+public:
+    int runOnModule(IRModule& module) override;
+
+protected:
+    std::unordered_set<std::string> scenes_;
+
+    bool callsScene(const IRLoop& loop) const;
+
+    // New instruction at the end of `block`, before its terminator
+    static IRValue* insertBeforeTerminator(IRFunction& function, IRBlock* block, IROp op, ValueType type);
+    static IRValue* constantBeforeTerminator(IRFunction& function, IRBlock* block, int value);
+};
+
+class LoopUnroll : public LoopPass {
+public:
+    static const int MAX_TRIPS = 8;
+    static const int MAX_INSTRUCTIONS = 64;  // Unrolled body size
+
+    std::string name() const override { return "loop-unroll"; }
+    int run(IRFunction& function) override;
+
+private:
+    bool unroll(IRFunction& function, const IRLoop& loop);
+};
+
+class PromoteGlobals : public LoopPass {
+public:
+    std::string name() const override { return "promote-globals"; }
+    int run(IRFunction& function) override;
+
+private:
+    void promote(IRFunction& function, const IRLoop& loop, const std::string& global);
+};
+
+class LoopInvariantCodeMotion : public LoopPass {
+public:
+    std::string name() const override { return "licm"; }
+    int run(IRFunction& function) override;
+};
+
+class StrengthReduction : public LoopPass {
+public:
+    static const int MIN_OPERATIONS = 3;  // Affine expression size worth a new variable
+
+    std::string name() const override { return "strength-reduction"; }
+    int run(IRFunction& function) override;
+};
+
+#endif // LOOP_OPT_H
@@ -12,7 +12,7 @@
 // ============================================================================
 
 Parser::Parser(const std::vector<Token>& tokens)
-    : tokens_(tokens), current_(0), hadError_(false) {
+    : tokens_(tokens), current_(0), hadError_(false), lazy_(false), blockDepth_(0) {
 }
 
 // ============================================================================
@@ -77,10 +77,16 @@ void Parser::synchronize() {
         
         switch (peek().type) {
             case TokenType::TAKE:
+            case TokenType::CONST:
             case TokenType::POUR:
             case TokenType::SCENE:
+            case TokenType::INLINE:
+            case TokenType::NOINLINE:
+            case TokenType::MEMO:
             case TokenType::IF:
             case TokenType::LOOP:
+            case TokenType::FOR:
+            case TokenType::MATCH:
             case TokenType::BREAK:
             case TokenType::CONTINUE:
             case TokenType::SHOT:
@@ -108,10 +114,15 @@ std::unique_ptr<Program> Parser::parse() {
 }
 
 std::unique_ptr<Stmt> Parser::declaration() {
+    if (match(TokenType::INLINE) || match(TokenType::NOINLINE) || match(TokenType::MEMO)) {
+        Token hint = previous();
+        consume(TokenType::SCENE, "Expected SCENE after " + hint.lexeme);
+        return functionStmt(hint.type);
+    }
     if (match(TokenType::SCENE)) {
         return functionStmt();
     }
-    if (match(TokenType::TAKE)) {
+    if (match(TokenType::TAKE) || match(TokenType::CONST)) {
         return declarationStmt();
     }
     return statement();
@@ -121,6 +132,8 @@ std::unique_ptr<Stmt> Parser::statement() {
     if (match(TokenType::POUR)) return printStmt();
     if (match(TokenType::IF)) return ifStmt();
     if (match(TokenType::LOOP)) return loopStmt();
+    if (match(TokenType::FOR)) return forStmt();
+    if (match(TokenType::MATCH)) return matchStmt();
     if (match(TokenType::BREAK)) return breakStmt();
     if (match(TokenType::CONTINUE)) return continueStmt();
     if (match(TokenType::SHOT)) return returnStmt();
@@ -135,13 +148,14 @@ std::unique_ptr<Stmt> Parser::statement() {
 // ============================================================================
 
 std::unique_ptr<Stmt> Parser::declarationStmt() {
+    Token keyword = previous();  // TAKE or CONST
     Token name = consume(TokenType::IDENTIFIER, "Expected variable name");
     consume(TokenType::EQUAL, "Expected '=' after variable name");
     std::unique_ptr<Expr> initializer = expression();
     consume(TokenType::SEMICOLON, "Expected ';' after variable declaration");
     
     return std::make_unique<DeclarationStmt>(
-        previous(), name, std::move(initializer)
+        keyword, name, std::move(initializer)
     );
 }
 
@@ -158,8 +172,23 @@ std::unique_ptr<Stmt> Parser::assignmentStmt() {
         return std::make_unique<AssignmentStmt>(name, std::move(value));
     }
     
-    // Otherwise, it's an expression statement
+    // Otherwise, it's an expression statement (or a property assignment)
     std::unique_ptr<Expr> expr = expression();
+    
+    if (match(TokenType::EQUAL)) {
+        PropertyExpr* target = dynamic_cast<PropertyExpr*>(expr.get());
+        if (!target) {
+            error(previous(), "Invalid assignment target");
+            return std::make_unique<ExpressionStmt>(std::move(expr));
+        }
+        std::unique_ptr<Expr> value = expression();
+        consume(TokenType::SEMICOLON, "Expected ';' after assignment");
+        
+        return std::make_unique<PropertyAssignmentStmt>(
+            std::move(target->object), target->name, std::move(value)
+        );
+    }
+    
     consume(TokenType::SEMICOLON, "Expected ';' after expression");
     return std::make_unique<ExpressionStmt>(std::move(expr));
 }
@@ -205,6 +234,58 @@ std::unique_ptr<Stmt> Parser::loopStmt() {
     return std::make_unique<LoopStmt>(keyword, std::move(condition), std::move(body));
 }
 
+std::unique_ptr<Stmt> Parser::forStmt() {
+    Token keyword = previous();
+    Token variable = consume(TokenType::IDENTIFIER, "Expected loop variable after FOR");
+    consume(TokenType::EQUAL, "Expected '=' after FOR variable");
+    std::unique_ptr<Expr> start = expression();
+    consume(TokenType::TO, "Expected TO after FOR start value");
+    std::unique_ptr<Expr> limit = expression();
+    
+    std::unique_ptr<Expr> step;
+    if (match(TokenType::STEP)) {
+        step = expression();
+    }
+    
+    consume(TokenType::LBRACE, "Expected '{' after FOR header");
+    std::unique_ptr<BlockStmt> body = block();
+    
+    return std::make_unique<ForStmt>(keyword, variable, std::move(start), std::move(limit),
+                                     std::move(step), std::move(body));
+}
+
+std::unique_ptr<Stmt> Parser::matchStmt() {
+    Token keyword = previous();
+    std::unique_ptr<Expr> subject = expression();
+    consume(TokenType::LBRACE, "Expected '{' after MATCH value");
+    
+    std::vector<MatchStmt::Case> cases;
+    while (match(TokenType::CASE)) {
+        MatchStmt::Case c;
+        do {
+            if (check(TokenType::STRING)) {
+                error(peek(), "String CASE values are not supported (no runtime strings yet)");
+            }
+            c.values.push_back(consume(TokenType::NUMBER, "Expected integer CASE value"));
+        } while (match(TokenType::COMMA));
+        
+        consume(TokenType::LBRACE, "Expected '{' after CASE values");
+        c.body = block();
+        cases.push_back(std::move(c));
+    }
+    
+    std::unique_ptr<BlockStmt> elseBranch = nullptr;
+    if (match(TokenType::ELSE)) {
+        consume(TokenType::LBRACE, "Expected '{' after ELSE");
+        elseBranch = block();
+    }
+    
+    consume(TokenType::RBRACE, "Expected '}' after MATCH cases");
+    
+    return std::make_unique<MatchStmt>(keyword, std::move(subject), std::move(cases),
+                                       std::move(elseBranch));
+}
+
 std::unique_ptr<Stmt> Parser::breakStmt() {
     Token keyword = previous();
     consume(TokenType::SEMICOLON, "Expected ';' after BREAK");
@@ -229,7 +310,7 @@ std::unique_ptr<Stmt> Parser::returnStmt() {
     return std::make_unique<ReturnStmt>(keyword, std::move(value));
 }
 
-std::unique_ptr<Stmt> Parser::functionStmt() {
+std::unique_ptr<Stmt> Parser::functionStmt(TokenType hint) {
     Token keyword = previous();
     Token name = consume(TokenType::IDENTIFIER, "Expected function name");
     consume(TokenType::LPAREN, "Expected '(' after function name");
@@ -246,19 +327,61 @@ std::unique_ptr<Stmt> Parser::functionStmt() {
     
     consume(TokenType::RPAREN, "Expected ')' after parameters");
     consume(TokenType::LBRACE, "Expected '{' before function body");
-    std::unique_ptr<BlockStmt> body = block();
-    
-    return std::make_unique<FunctionStmt>(
-        keyword, name, std::move(parameters), std::move(body)
-    );
+    auto function = std::make_unique<FunctionStmt>(keyword, name, std::move(parameters), nullptr);
+    function->hint = hint;
+    if (lazy_ && blockDepth_ == 0 && hint != TokenType::MEMO && !hadError_ && skipBody(function.get())) {
+        return function;
+    }
+    function->body = block();
+    return function;
+}
+
+/**
+ * Lazy mode: finds the '}' that closes the body and steps past it,
+ * noting the FOR variables on the way. Gives up (false, nothing consumed)
+ * if the body declares a global, which the rest of the program may use
+ * before the SCENE is ever called, or is not closed.
+ */
+bool Parser::skipBody(FunctionStmt* function) {
+    int depth = 1;
+    for (int at = current_; tokens_[at].type != TokenType::END_OF_FILE; at++) {
+        switch (tokens_[at].type) {
+            case TokenType::LBRACE:
+                depth++;
+                break;
+            case TokenType::RBRACE:
+                if (--depth == 0) {
+                    function->bodyStart = current_;
+                    function->bodyEnd = at;
+                    current_ = at + 1;
+                    return true;
+                }
+                break;
+            case TokenType::TAKE:
+            case TokenType::CONST:
+                function->forVariables.clear();
+                return false;
+            case TokenType::FOR:
+                if (tokens_[at + 1].type == TokenType::IDENTIFIER) {
+                    function->forVariables.push_back(tokens_[at + 1]);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    function->forVariables.clear();
+    return false;
 }
 
 std::unique_ptr<BlockStmt> Parser::block() {
     std::vector<std::unique_ptr<Stmt>> statements;
     
+    blockDepth_++;
     while (!check(TokenType::RBRACE) && !isAtEnd()) {
         statements.push_back(declaration());
     }
+    blockDepth_--;
     
     consume(TokenType::RBRACE, "Expected '}' after block");
     return std::make_unique<BlockStmt>(std::move(statements));
@@ -275,16 +398,90 @@ std::unique_ptr<Expr> Parser::expression() {
 std::unique_ptr<Expr> Parser::assignment() {
     // For now, we don't support assignment as expression
     // (like: x = y = 5)
-    return comparison();
+    return logicOr();
+}
+
+std::unique_ptr<Expr> Parser::logicOr() {
+    std::unique_ptr<Expr> expr = logicAnd();
+    
+    while (match(TokenType::OR)) {
+        Token op = previous();
+        std::unique_ptr<Expr> right = logicAnd();
+        expr = std::make_unique<LogicalExpr>(std::move(expr), op, std::move(right));
+    }
+    
+    return expr;
+}
+
+std::unique_ptr<Expr> Parser::logicAnd() {
+    std::unique_ptr<Expr> expr = comparison();
+    
+    while (match(TokenType::AND)) {
+        Token op = previous();
+        std::unique_ptr<Expr> right = comparison();
+        expr = std::make_unique<LogicalExpr>(std::move(expr), op, std::move(right));
+    }
+    
+    return expr;
 }
 
 std::unique_ptr<Expr> Parser::comparison() {
-    std::unique_ptr<Expr> expr = addition();
+    std::unique_ptr<Expr> expr = bitOr();
     
     while (match(TokenType::GREATER) || match(TokenType::GREATER_EQUAL) ||
            match(TokenType::LESS) || match(TokenType::LESS_EQUAL) ||
            match(TokenType::EQUAL_EQUAL) || match(TokenType::BANG_EQUAL)) {
         Token op = previous();
+        std::unique_ptr<Expr> right = bitOr();
+        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
+    }
+    
+    return expr;
+}
+
+// Bitwise operators bind tighter than comparisons (unlike C), so
+// `flags & MASK == 0` means `(flags & MASK) == 0`.
+std::unique_ptr<Expr> Parser::bitOr() {
+    std::unique_ptr<Expr> expr = bitXor();
+    
+    while (match(TokenType::PIPE)) {
+        Token op = previous();
+        std::unique_ptr<Expr> right = bitXor();
+        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
+    }
+    
+    return expr;
+}
+
+std::unique_ptr<Expr> Parser::bitXor() {
+    std::unique_ptr<Expr> expr = bitAnd();
+    
+    while (match(TokenType::CARET)) {
+        Token op = previous();
+        std::unique_ptr<Expr> right = bitAnd();
+        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
+    }
+    
+    return expr;
+}
+
+std::unique_ptr<Expr> Parser::bitAnd() {
+    std::unique_ptr<Expr> expr = shift();
+    
+    while (match(TokenType::AMPERSAND)) {
+        Token op = previous();
+        std::unique_ptr<Expr> right = shift();
+        expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
+    }
+    
+    return expr;
+}
+
+std::unique_ptr<Expr> Parser::shift() {
+    std::unique_ptr<Expr> expr = addition();
+    
+    while (match(TokenType::LESS_LESS) || match(TokenType::GREATER_GREATER)) {
+        Token op = previous();
         std::unique_ptr<Expr> right = addition();
         expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
     }
@@ -307,7 +504,7 @@ std::unique_ptr<Expr> Parser::addition() {
 std::unique_ptr<Expr> Parser::multiplication() {
     std::unique_ptr<Expr> expr = unary();
     
-    while (match(TokenType::STAR) || match(TokenType::SLASH)) {
+    while (match(TokenType::STAR) || match(TokenType::SLASH) || match(TokenType::PERCENT)) {
         Token op = previous();
         std::unique_ptr<Expr> right = unary();
         expr = std::make_unique<BinaryExpr>(std::move(expr), op, std::move(right));
@@ -317,18 +514,31 @@ std::unique_ptr<Expr> Parser::multiplication() {
 }
 
 std::unique_ptr<Expr> Parser::unary() {
-    if (match(TokenType::MINUS)) {
+    if (match(TokenType::MINUS) || match(TokenType::BANG)) {
         Token op = previous();
         std::unique_ptr<Expr> right = unary();
         return std::make_unique<UnaryExpr>(op, std::move(right));
     }
     
-    return primary();
+    return postfix();
+}
+
+std::unique_ptr<Expr> Parser::postfix() {
+    std::unique_ptr<Expr> expr = primary();
+    
+    // Property access: obj.a.b
+    while (match(TokenType::DOT)) {
+        Token name = consume(TokenType::IDENTIFIER, "Expected property name after '.'");
+        expr = std::make_unique<PropertyExpr>(std::move(expr), name);
+    }
+    
+    return expr;
 }
 
 std::unique_ptr<Expr> Parser::primary() {
     // Literals
-    if (match(TokenType::NUMBER)) {
+    if (match(TokenType::NUMBER) || match(TokenType::FLOAT_NUMBER) ||
+        match(TokenType::FIXED_NUMBER)) {
         return std::make_unique<LiteralExpr>(previous(), previous().literal);
     }
     
@@ -356,6 +566,11 @@ std::unique_ptr<Expr> Parser::primary() {
         return std::make_unique<VariableExpr>(name);
     }
     
+    // Object literal
+    if (match(TokenType::LBRACE)) {
+        return objectLiteral();
+    }
+    
     // Grouping
     if (match(TokenType::LPAREN)) {
         std::unique_ptr<Expr> expr = expression();
@@ -383,3 +598,19 @@ std::unique_ptr<Expr> Parser::finishCall(const Token& callee) {
     return std::make_unique<CallExpr>(callee, std::move(arguments));
 }
 
+std::unique_ptr<Expr> Parser::objectLiteral() {
+    Token brace = previous();
+    std::vector<Token> names;
+    std::vector<std::unique_ptr<Expr>> values;
+    
+    if (!check(TokenType::RBRACE)) {
+        do {
+            names.push_back(consume(TokenType::IDENTIFIER, "Expected field name in object literal"));
+            consume(TokenType::COLON, "Expected ':' after field name");
+            values.push_back(expression());
+        } while (match(TokenType::COMMA));
+    }
+    
+    consume(TokenType::RBRACE, "Expected '}' after object literal");
+    return std::make_unique<ObjectExpr>(brace, std::move(names), std::move(values));
+}
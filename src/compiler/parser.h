@@ -42,6 +42,11 @@ public:
     // Main function: parse entire program
     std::unique_ptr<Program> parse();
     
+    // Lazy mode: the body of a top-level SCENE is skipped and only its
+    // token range is kept (see FunctionStmt), unless it declares globals
+    // (TAKE / CONST) or is MEMO
+    void setLazy(bool lazy) { lazy_ = lazy; }
+    
     // Check if there were any errors
     bool hadError() const { return hadError_; }
     
@@ -55,6 +60,8 @@ private:
     std::vector<Token> tokens_;
     int current_;
     bool hadError_;
+    bool lazy_;
+    int blockDepth_;  // Blocks being parsed (SCENEs are lazy at 0)
     std::string errorMessage_;
     
     // ========================================================================
@@ -90,21 +97,32 @@ private:
     std::unique_ptr<Stmt> printStmt();
     std::unique_ptr<Stmt> ifStmt();
     std::unique_ptr<Stmt> loopStmt();
+    std::unique_ptr<Stmt> forStmt();
+    std::unique_ptr<Stmt> matchStmt();
     std::unique_ptr<Stmt> breakStmt();
     std::unique_ptr<Stmt> continueStmt();
     std::unique_ptr<Stmt> returnStmt();
-    std::unique_ptr<Stmt> functionStmt();
+    std::unique_ptr<Stmt> functionStmt(TokenType hint = TokenType::SCENE);
+    bool skipBody(FunctionStmt* function);
     std::unique_ptr<BlockStmt> block();
     
     // Expressions
     std::unique_ptr<Expr> expression();
     std::unique_ptr<Expr> assignment();
+    std::unique_ptr<Expr> logicOr();
+    std::unique_ptr<Expr> logicAnd();
     std::unique_ptr<Expr> comparison();
+    std::unique_ptr<Expr> bitOr();
+    std::unique_ptr<Expr> bitXor();
+    std::unique_ptr<Expr> bitAnd();
+    std::unique_ptr<Expr> shift();
     std::unique_ptr<Expr> addition();
     std::unique_ptr<Expr> multiplication();
     std::unique_ptr<Expr> unary();
+    std::unique_ptr<Expr> postfix();
     std::unique_ptr<Expr> primary();
     std::unique_ptr<Expr> finishCall(const Token& callee);
+    std::unique_ptr<Expr> objectLiteral();
 };
 
 #endif // PARSER_H
@@ -0,0 +1,332 @@
+/**
+ * Peephole Optimizer Implementation
+ *
+ * The rewrite table and the pattern matcher.
+ */
+
+#include "peephole.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+// ============================================================================
+// RULES
+// ============================================================================
+//
+// Every rewrite must leave the stack and variables exactly as the pattern
+// would. Integer identities only use PUSH/ADD/... (never FPUSH/FADD), so
+// they hold for INT and FIXED values alike.
+
+static const PeepholeRule RULES[] = {
+    // Reuse a value instead of reading it back
+    {"store-load",        {"STORE $x", "LOAD $x"},         {"DUP", "STORE $x"}},
+    {"storearg-loadarg",  {"STOREARG $i", "LOADARG $i"},   {"DUP", "STOREARG $i"}},
+    {"load-load",         {"LOAD $x", "LOAD $x"},          {"LOAD $x", "DUP"}},
+    {"loadarg-loadarg",   {"LOADARG $i", "LOADARG $i"},    {"LOADARG $i", "DUP"}},
+    {"loadargu-loadargu", {"LOADARGU $i", "LOADARGU $i"},  {"LOADARGU $i", "DUP"}},
+    {"storelocal-loadlocal", {"STORELOCAL $k", "LOADLOCAL $k"}, {"DUP", "STORELOCAL $k"}},
+    {"loadlocal-loadlocal",  {"LOADLOCAL $k", "LOADLOCAL $k"},  {"LOADLOCAL $k", "DUP"}},
+
+    // Negation: -x is generated as 0 - x
+    {"negate-var",        {"PUSH 0", "LOAD $x", "SUB"},    {"LOAD $x", "NEG"}},
+    {"negate-arg",        {"PUSH 0", "LOADARG $i", "SUB"}, {"LOADARG $i", "NEG"}},
+    {"double-negate",     {"NEG", "NEG"},                  {}},
+
+    // Arithmetic identities
+    {"add-zero",          {"PUSH 0", "ADD"},               {}},
+    {"sub-zero",          {"PUSH 0", "SUB"},               {}},
+    {"mul-one",           {"PUSH 1", "MUL"},               {}},
+    {"div-one",           {"PUSH 1", "DIV"},               {}},
+    {"divnz-one",         {"PUSH 1", "DIVNZ"},             {}},
+    {"or-zero",           {"PUSH 0", "BOR"},               {}},
+    {"xor-zero",          {"PUSH 0", "BXOR"},              {}},
+    {"shl-zero",          {"PUSH 0", "SHL"},               {}},
+    {"shr-zero",          {"PUSH 0", "SHR"},               {}},
+
+    // Tests against zero: the jump already compares with 0
+    {"eq-zero-jz",        {"PUSH 0", "EQ", "JZ $l"},       {"JNZ $l"}},
+    {"eq-zero-jnz",       {"PUSH 0", "EQ", "JNZ $l"},      {"JZ $l"}},
+    {"ne-zero-jz",        {"PUSH 0", "NE", "JZ $l"},       {"JZ $l"}},
+    {"ne-zero-jnz",       {"PUSH 0", "NE", "JNZ $l"},      {"JNZ $l"}},
+
+    // Conditional jump over an unconditional one (IF c { BREAK; })
+    {"jz-over-jmp",       {"JZ $a", "JMP $b", "$a:"},      {"JNZ $b", "$a:"}},
+    {"jnz-over-jmp",      {"JNZ $a", "JMP $b", "$a:"},     {"JZ $b", "$a:"}},
+
+    // Values pushed only to be discarded
+    {"push-pop",          {"PUSH $v", "POP"},              {}},
+    {"fpush-pop",         {"FPUSH $v", "POP"},             {}},
+    {"load-pop",          {"LOAD $x", "POP"},              {}},
+    {"loadarg-pop",       {"LOADARG $i", "POP"},           {}},
+    {"loadargu-pop",      {"LOADARGU $i", "POP"},          {}},
+    {"loadlocal-pop",     {"LOADLOCAL $k", "POP"},         {}},
+    {"dup-pop",           {"DUP", "POP"},                  {}},
+    {"dup-store-pop",     {"DUP", "STORE $x", "POP"},      {"STORE $x"}},
+    {"dup-storelocal-pop", {"DUP", "STORELOCAL $k", "POP"}, {"STORELOCAL $k"}},
+
+    // Nothing reads the stack once the main program stops
+    {"pop-halt",          {"POP", "HALT:"},                {"HALT:"}},
+    {"pop-jmp-halt",      {"POP", "JMP HALT"},             {"JMP HALT"}},
+
+    // Operand order does not matter (or flips the comparison)
+    {"swap-swap",         {"SWAP", "SWAP"},                {}},
+    {"swap-add",          {"SWAP", "ADD"},                 {"ADD"}},
+    {"swap-mul",          {"SWAP", "MUL"},                 {"MUL"}},
+    {"swap-band",         {"SWAP", "BAND"},                {"BAND"}},
+    {"swap-bor",          {"SWAP", "BOR"},                 {"BOR"}},
+    {"swap-bxor",         {"SWAP", "BXOR"},                {"BXOR"}},
+    {"swap-eq",           {"SWAP", "EQ"},                  {"EQ"}},
+    {"swap-ne",           {"SWAP", "NE"},                  {"NE"}},
+    {"swap-gt",           {"SWAP", "GT"},                  {"LT"}},
+    {"swap-lt",           {"SWAP", "LT"},                  {"GT"}},
+    {"swap-ge",           {"SWAP", "GE"},                  {"LE"}},
+    {"swap-le",           {"SWAP", "LE"},                  {"GE"}},
+    {"swap-fadd",         {"SWAP", "FADD"},                {"FADD"}},
+    {"swap-fmul",         {"SWAP", "FMUL"},                {"FMUL"}},
+};
+
+// Superinstructions: applied only when enabled (see peephole.h). A
+// comparison followed by JNZ jumps on the comparison, followed by JZ on
+// its opposite. INT / FIXED comparisons only: FLOAT ones fail on NaN both
+// ways round.
+static const PeepholeRule SUPERINSTRUCTIONS[] = {
+    {"super-inc",         {"LOAD $x", "PUSH $n", "ADD", "STORE $x"},                 {"INC $x $n"}},
+    {"super-inclocal",    {"LOADLOCAL $k", "PUSH $n", "ADD", "STORELOCAL $k"},       {"INCLOCAL $k $n"}},
+    {"super-cmp-jump",    {"EQ", "JNZ $l"},                {"JEQ $l"}},
+    {"super-cmp-jump",    {"NE", "JNZ $l"},                {"JNE $l"}},
+    {"super-cmp-jump",    {"LT", "JNZ $l"},                {"JLT $l"}},
+    {"super-cmp-jump",    {"GT", "JNZ $l"},                {"JGT $l"}},
+    {"super-cmp-jump",    {"LE", "JNZ $l"},                {"JLE $l"}},
+    {"super-cmp-jump",    {"GE", "JNZ $l"},                {"JGE $l"}},
+    {"super-cmp-jump",    {"EQ", "JZ $l"},                 {"JNE $l"}},
+    {"super-cmp-jump",    {"NE", "JZ $l"},                 {"JEQ $l"}},
+    {"super-cmp-jump",    {"LT", "JZ $l"},                 {"JGE $l"}},
+    {"super-cmp-jump",    {"GT", "JZ $l"},                 {"JLE $l"}},
+    {"super-cmp-jump",    {"LE", "JZ $l"},                 {"JGT $l"}},
+    {"super-cmp-jump",    {"GE", "JZ $l"},                 {"JLT $l"}},
+};
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+PeepholeOptimizer::PeepholeOptimizer(const std::set<std::string>& superinstructions)
+    : rules_(compile(RULES, sizeof(RULES) / sizeof(RULES[0]), nullptr)),
+      superinstructions_(compile(SUPERINSTRUCTIONS, sizeof(SUPERINSTRUCTIONS) / sizeof(SUPERINSTRUCTIONS[0]),
+                                 &superinstructions)) {
+}
+
+void PeepholeOptimizer::run(Bytecode& bytecode) {
+    counts_.clear();
+    apply(rules_, bytecode);
+    if (!superinstructions_.empty()) apply(superinstructions_, bytecode);
+}
+
+/**
+ * Compiles the rows once (only the `enabled` ones, if given).
+ */
+std::vector<PeepholeOptimizer::CompiledRule> PeepholeOptimizer::compile(
+    const PeepholeRule* rules, size_t count, const std::set<std::string>* enabled) {
+    std::vector<CompiledRule> compiled;
+    for (size_t r = 0; r < count; r++) {
+        if (enabled && !enabled->count(rules[r].name)) continue;
+        CompiledRule rule = {rules[r].name, {}, {}};
+        std::vector<std::string> captures;
+        for (const std::string& line : rules[r].pattern) rule.pattern.push_back(compileLine(line, captures, true));
+        for (const std::string& line : rules[r].rewrite) rule.rewrite.push_back(compileLine(line, captures, false));
+        compiled.push_back(std::move(rule));
+    }
+    return compiled;
+}
+
+/**
+ * "JZ $l" or "$a:" to its opcode and operands; `captures` collects the
+ * '$' names of the row in order. An opcode the VM does not know compiles
+ * to INVALID, which IRLowering never emits: the row never matches.
+ */
+PeepholeOptimizer::Line PeepholeOptimizer::compileLine(const std::string& text, std::vector<std::string>& captures,
+                                                       bool pattern) {
+    std::vector<std::string> parts = split(text);
+    Line line = {Op::LABEL, {}};
+    if (text.back() == ':') {
+        parts[0].pop_back();  // The label is the operand
+    } else {
+        if (!Bytecode::lookupOp(parts[0], line.op)) line.op = Op::INVALID;
+        parts.erase(parts.begin());
+    }
+
+    for (const std::string& part : parts) {
+        Operand operand = {-1, false, 0, ""};
+        if (part[0] == '$') {
+            auto known = std::find(captures.begin(), captures.end(), part);
+            operand.capture = (int)(known - captures.begin());
+            operand.binds = pattern && known == captures.end();
+            if (operand.binds) captures.push_back(part);
+        } else if (std::isdigit(static_cast<unsigned char>(part.back()))) {
+            operand.value = std::atoi(part.c_str());
+        } else {
+            operand.name = part;
+        }
+        line.operands.push_back(operand);
+    }
+    return line;
+}
+
+/**
+ * One table to a fixed point, in a single pass. Each instruction read is
+ * appended to the output, and the rules whose pattern ends with its
+ * opcode are tried on the window ending there (in table order). A match
+ * is cut from the output and its rewrite is read next: windows that end
+ * before it have already been tried and did not change.
+ */
+void PeepholeOptimizer::apply(const std::vector<CompiledRule>& rules, Bytecode& bytecode) {
+    // Rules by the opcode of their last instruction
+    std::vector<std::vector<const CompiledRule*>> byLast((size_t)Op::COUNT);
+    for (const CompiledRule& rule : rules) {
+        byLast[(size_t)rule.pattern.back().op].push_back(&rule);
+    }
+
+    std::vector<Instruction> out;
+    out.reserve(bytecode.code.size());
+    std::vector<Instruction> pending;  // Rewritten instructions to read again, next one last
+    int captures[MAX_CAPTURES];
+    size_t next = 0;
+    while (next < bytecode.code.size() || !pending.empty()) {
+        if (!pending.empty()) {
+            out.push_back(pending.back());
+            pending.pop_back();
+        } else {
+            out.push_back(bytecode.code[next++]);
+        }
+
+        for (const CompiledRule* rule : byLast[(size_t)out.back().op]) {
+            if (rule->pattern.size() > out.size()) continue;
+            size_t at = out.size() - rule->pattern.size();
+            if (!match(*rule, bytecode, out, at, captures)) continue;
+
+            out.resize(at);
+            for (auto line = rule->rewrite.rbegin(); line != rule->rewrite.rend(); ++line) {
+                pending.push_back(instantiate(*line, captures, bytecode));
+            }
+            counts_[rule->name]++;
+            break;
+        }
+    }
+    bytecode.code.swap(out);
+}
+
+std::vector<std::string> PeepholeOptimizer::superinstructionNames() {
+    std::vector<std::string> names;
+    for (const PeepholeRule& rule : SUPERINSTRUCTIONS) {
+        if (names.empty() || names.back() != rule.name) names.push_back(rule.name);
+    }
+    return names;
+}
+
+/**
+ * Matches every superinstruction against the bytecode a profile was
+ * recorded with; a match counts as often as its first instruction ran.
+ * The profiling instructions are left out, as the optimized build has
+ * none.
+ */
+std::map<std::string, long long> PeepholeOptimizer::superinstructionHits(
+    const Bytecode& program, const std::vector<long long>& executed) {
+    std::vector<Instruction> code;
+    std::vector<long long> counts;
+    for (size_t pc = 0; pc < program.code.size(); pc++) {
+        Op op = program.code[pc].op;
+        if (op == Op::PROFBR || op == Op::PROFLOOP) continue;
+        code.push_back(program.code[pc]);
+        counts.push_back(pc < executed.size() ? executed[pc] : 0);
+    }
+
+    std::map<std::string, long long> hits;
+    for (const std::string& name : superinstructionNames()) {
+        hits[name] = 0;
+    }
+    std::vector<CompiledRule> rules =
+        compile(SUPERINSTRUCTIONS, sizeof(SUPERINSTRUCTIONS) / sizeof(SUPERINSTRUCTIONS[0]), nullptr);
+    int captures[MAX_CAPTURES];
+    for (size_t i = 0; i < code.size(); i++) {
+        for (const CompiledRule& rule : rules) {
+            if (match(rule, program, code, i, captures)) {
+                hits[rule.name] += counts[i];
+                break;
+            }
+        }
+    }
+    return hits;
+}
+
+int PeepholeOptimizer::rewriteCount() const {
+    int total = 0;
+    for (const auto& entry : counts_) {
+        total += entry.second;
+    }
+    return total;
+}
+
+// ============================================================================
+// MATCHING
+// ============================================================================
+
+bool PeepholeOptimizer::match(const CompiledRule& rule, const Bytecode& program, const std::vector<Instruction>& code,
+                              size_t at, int* captures) {
+    if (at + rule.pattern.size() > code.size()) return false;
+
+    for (size_t k = 0; k < rule.pattern.size(); k++) {
+        const Line& want = rule.pattern[k];
+        const Instruction& have = code[at + k];
+        if (want.op != have.op) return false;
+
+        for (size_t i = 0; i < want.operands.size(); i++) {
+            const Operand& operand = want.operands[i];
+            bool label = i == 0 && usesLabel(want.op);
+            int value = label ? have.label : i == 0 ? have.a : have.b;
+            if (operand.capture >= 0) {
+                if (operand.binds) captures[operand.capture] = value;
+                else if (captures[operand.capture] != value) return false;
+            } else if (operand.name.empty()) {
+                if (value != operand.value) return false;
+            } else {
+                int symbol = label ? program.labels[value].name : value;
+                if (symbol < 0 || program.symbols[symbol] != operand.name) return false;
+            }
+        }
+    }
+    return true;
+}
+
+Instruction PeepholeOptimizer::instantiate(const Line& line, const int* captures, Bytecode& program) {
+    Instruction result = {line.op, 0, false, 0, 0, 0, -1, -1};
+    for (size_t i = 0; i < line.operands.size(); i++) {
+        const Operand& operand = line.operands[i];
+        bool label = i == 0 && usesLabel(line.op);
+        int value = operand.capture >= 0 ? captures[operand.capture]
+                    : operand.name.empty() ? operand.value
+                    : label ? program.namedLabel(operand.name) : program.symbol(operand.name);
+        (label ? result.label : i == 0 ? result.a : result.b) = value;
+    }
+    return result;
+}
+
+bool PeepholeOptimizer::usesLabel(Op op) {
+    switch (op) {
+        case Op::LABEL: case Op::JMP: case Op::JZ: case Op::JNZ:
+        case Op::JEQ: case Op::JNE: case Op::JLT: case Op::JGT: case Op::JLE: case Op::JGE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::vector<std::string> PeepholeOptimizer::split(const std::string& instruction) {
+    std::vector<std::string> parts;
+    size_t start = instruction.find_first_not_of(' ');
+    while (start != std::string::npos) {
+        size_t end = instruction.find(' ', start);
+        parts.push_back(instruction.substr(start, end - start));
+        start = instruction.find_first_not_of(' ', end);
+    }
+    return parts;
+}
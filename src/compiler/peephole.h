@@ -0,0 +1,119 @@
+/**
+ * CINEBREW Peephole Optimizer
+ *
+ * ============================================================================
+ * WHAT DOES IT DO?
+ * ============================================================================
+ *
+ * Looks at short windows of consecutive bytecode instructions and
+ * replaces known wasteful sequences with cheaper ones:
+ *
+ *   STORE x            DUP
+ *   LOAD x       →     STORE x        (no variable lookup)
+ *
+ *   PUSH 0
+ *   LOAD x       →     LOAD x
+ *   SUB                NEG
+ *
+ * The rules are data: a table of (pattern, rewrite) pairs in peephole.cpp,
+ * written in the text form of instructions.h. A pattern operand starting
+ * with '$' captures whatever is there, and the same name must match the
+ * same operand everywhere in the pattern. "$a:" matches a label. Adding
+ * an optimization means adding a table row. The rows are compiled once
+ * into typed lines (opcode, operands), and matched against the typed
+ * instructions field by field: no instruction is ever printed.
+ *
+ * Rewrites can expose new matches. The output is built in one forward
+ * pass: after a rewrite the new instructions are read again, so every
+ * window ending in one of them is tried again, and the result is a fixed
+ * point of the table. A window never spans a label unless the pattern
+ * names it, so jump targets are never merged away.
+ *
+ * A second table holds superinstructions (INC, INCLOCAL, JLT, ...): one
+ * VM dispatch for a sequence the compiler emits often. They only pay off
+ * where they run a lot, so none is applied by default; the compiler turns
+ * on the ones a profile shows are hot (see profile.h), after the
+ * ordinary rules have reached their fixed point.
+ *
+ * ============================================================================
+ */
+
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include "../vm/bytecode.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+/**
+ * One table row: `pattern` instructions are replaced by `rewrite`
+ */
+struct PeepholeRule {
+    const char* name;
+    std::vector<std::string> pattern;
+    std::vector<std::string> rewrite;
+};
+
+class PeepholeOptimizer {
+public:
+    // superinstructions: names of the superinstruction rules to apply too
+    explicit PeepholeOptimizer(const std::set<std::string>& superinstructions = {});
+
+    // Main function: rewrite the bytecode in place, to a fixed point
+    // (before link(), see Bytecode::compact)
+    void run(Bytecode& bytecode);
+
+    // Statistics
+    int rewriteCount() const;                                           // All rules
+    const std::map<std::string, int>& ruleCounts() const { return counts_; }  // Per rule name
+
+    // Every superinstruction rule name, and how often each would have run
+    // in a program whose instruction at pc ran executed[pc] times
+    static std::vector<std::string> superinstructionNames();
+    static std::map<std::string, long long> superinstructionHits(const Bytecode& program,
+                                                                 const std::vector<long long>& executed);
+
+private:
+    static const int MAX_CAPTURES = 4;  // Distinct '$' names in one row
+
+    // One operand of a compiled line: a capture or a literal
+    struct Operand {
+        int capture;       // Index of the '$' name, -1 for a literal
+        bool binds;        // First use in the pattern: takes the value instead of comparing
+        int value;         // A number literal
+        std::string name;  // A name literal (a symbol, or a label such as HALT), "" for a number
+    };
+
+    // One instruction of a row. The first operand is `label` for jumps
+    // and labels, `a` otherwise; the second is `b`.
+    struct Line {
+        Op op;
+        std::vector<Operand> operands;
+    };
+
+    // A table row compiled once
+    struct CompiledRule {
+        const char* name;
+        std::vector<Line> pattern;
+        std::vector<Line> rewrite;
+    };
+
+    std::vector<CompiledRule> rules_;
+    std::vector<CompiledRule> superinstructions_;  // Only the enabled ones
+    std::map<std::string, int> counts_;
+
+    void apply(const std::vector<CompiledRule>& rules, Bytecode& bytecode);
+
+    static std::vector<CompiledRule> compile(const PeepholeRule* rules, size_t count,
+                                             const std::set<std::string>* enabled);
+    static Line compileLine(const std::string& text, std::vector<std::string>& captures, bool pattern);
+    static bool match(const CompiledRule& rule, const Bytecode& program, const std::vector<Instruction>& code,
+                      size_t at, int* captures);
+    static Instruction instantiate(const Line& line, const int* captures, Bytecode& program);
+    static bool usesLabel(Op op);
+    static std::vector<std::string> split(const std::string& instruction);
+};
+
+#endif // PEEPHOLE_H
@@ -0,0 +1,123 @@
+/**
+ * Execution Profile Implementation
+ *
+ * Building a profile from a run, and the text file format.
+ */
+
+#include "profile.h"
+#include "peephole.h"
+#include <fstream>
+#include <sstream>
+
+Profile::Profile() : instructions_(0) {
+}
+
+Profile Profile::fromRun(const VMProfile& run, const Bytecode& program) {
+    Profile profile;
+    for (const auto& call : run.calls) {
+        profile.calls_[call.first] = call.second;
+    }
+    for (const auto& branch : run.branches) {
+        profile.branches_[branch.first] = branch.second;
+    }
+    for (const auto& loop : run.loops) {
+        profile.loops_[loop.first] = loop.second;
+    }
+
+    // The instrumentation itself does not count
+    for (size_t pc = 0; pc < run.executed.size() && pc < program.size(); pc++) {
+        Op op = program.code[pc].op;
+        if (op != Op::PROFBR && op != Op::PROFLOOP) profile.instructions_ += run.executed[pc];
+    }
+    for (const auto& hits : PeepholeOptimizer::superinstructionHits(program, run.executed)) {
+        if (hits.second > 0) profile.superinstructions_[hits.first] = hits.second;
+    }
+    return profile;
+}
+
+bool Profile::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error_ = "could not open profile: " + path;
+        return false;
+    }
+
+    *this = Profile();
+    std::string line;
+    int number = 0;
+    while (std::getline(file, line)) {
+        number++;
+        std::istringstream in(line);
+        std::string kind, key;
+        if (!(in >> kind) || kind[0] == '#') continue;
+
+        bool ok;
+        if (kind == "instructions") {
+            ok = (bool)(in >> instructions_);
+        } else if (kind == "branch") {
+            std::pair<long long, long long> counts;
+            ok = (bool)(in >> key >> counts.first >> counts.second);
+            if (ok) branches_[key] = counts;
+        } else if (kind == "call" || kind == "loop" || kind == "super") {
+            long long count = 0;
+            ok = (bool)(in >> key >> count);
+            if (ok) (kind == "call" ? calls_ : kind == "loop" ? loops_ : superinstructions_)[key] = count;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            error_ = path + ":" + std::to_string(number) + ": malformed profile line: " + line;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Profile::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) return false;
+
+    file << "# CineBrew execution profile" << std::endl;
+    file << "instructions " << instructions_ << std::endl;
+    for (const auto& call : calls_) {
+        file << "call " << call.first << " " << call.second << std::endl;
+    }
+    for (const auto& branch : branches_) {
+        file << "branch " << branch.first << " " << branch.second.first << " "
+             << branch.second.second << std::endl;
+    }
+    for (const auto& loop : loops_) {
+        file << "loop " << loop.first << " " << loop.second << std::endl;
+    }
+    for (const auto& rule : superinstructions_) {
+        file << "super " << rule.first << " " << rule.second << std::endl;
+    }
+    return (bool)file;
+}
+
+long long Profile::callCount(const std::string& scene) const {
+    auto it = calls_.find(scene);
+    return it == calls_.end() ? 0 : it->second;
+}
+
+bool Profile::branchCounts(const std::string& site, long long& taken, long long& notTaken) const {
+    auto it = branches_.find(site);
+    if (it == branches_.end()) return false;
+    taken = it->second.first;
+    notTaken = it->second.second;
+    return true;
+}
+
+long long Profile::loopCount(const std::string& site) const {
+    auto it = loops_.find(site);
+    return it == loops_.end() ? 0 : it->second;
+}
+
+long long Profile::superinstructionCount(const std::string& rule) const {
+    auto it = superinstructions_.find(rule);
+    return it == superinstructions_.end() ? 0 : it->second;
+}
+
+bool Profile::isHot(long long count) const {
+    return count > 0 && count * HOT_SHARE >= instructions_;
+}
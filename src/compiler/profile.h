@@ -0,0 +1,80 @@
+/**
+ * CINEBREW Execution Profile
+ *
+ * ============================================================================
+ * WHAT IS IT?
+ * ============================================================================
+ *
+ * What one run of a script did, saved so the next compile can optimize
+ * for it (profile-guided optimization):
+ *
+ *   cinebrew run game.cb --write-profile game.prof   (instrumented build)
+ *   cinebrew run game.cb --profile game.prof         (optimized for it)
+ *
+ * The instrumented build keeps every SCENE call and FOR loop (no inlining,
+ * no unrolling) and counts each branch outcome (PROFBR) and loop test
+ * (PROFLOOP); the VM counts SCENE calls and how often every instruction
+ * ran. The compiler then uses the profile to:
+ *
+ *   - inline hot SCENEs up to a larger size, and keep calls of SCENEs
+ *     that never ran (Inliner)
+ *   - lay out blocks so the likely successor of a branch falls through
+ *     and code that never ran goes last, and place hot SCENEs right
+ *     after the main program (IRLowering)
+ *   - turn on the superinstructions that cover hot sequences
+ *     (PeepholeOptimizer)
+ *
+ * Branches and loops are identified by source position, "line.n" (the
+ * n-th branch or loop the IR builder made for that line), so a profile
+ * stays valid across builds of the same source and mostly so across
+ * small edits. The file is plain text, one fact per line:
+ *
+ *   instructions 1843205
+ *   call fib 21891
+ *   branch 12.0 10946 10945        (taken, not taken)
+ *   loop 20.0 5001                 (FORLOOP tests)
+ *   super super-cmp-jump 240117    (instructions the rule would cover)
+ *
+ * ============================================================================
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "../vm/vm.h"
+#include <string>
+#include <vector>
+#include <map>
+
+class Profile {
+public:
+    static const int HOT_SHARE = 100;  // Hot: at least 1/HOT_SHARE of the instructions executed
+
+    Profile();
+
+    // From a profiling run (VM::profiling) of an instrumented build
+    static Profile fromRun(const VMProfile& run, const Bytecode& program);
+
+    bool load(const std::string& path);  // false (see getError) if unreadable or malformed
+    bool save(const std::string& path) const;
+    const std::string& getError() const { return error_; }
+
+    long long instructionCount() const { return instructions_; }
+    long long callCount(const std::string& scene) const;       // 0: never called
+    bool branchCounts(const std::string& site, long long& taken, long long& notTaken) const;
+    long long loopCount(const std::string& site) const;
+    long long superinstructionCount(const std::string& rule) const;
+
+    // Worth optimizing for: count is a noticeable share of the whole run
+    bool isHot(long long count) const;
+
+private:
+    long long instructions_;
+    std::map<std::string, long long> calls_;
+    std::map<std::string, std::pair<long long, long long>> branches_;
+    std::map<std::string, long long> loops_;
+    std::map<std::string, long long> superinstructions_;
+    std::string error_;
+};
+
+#endif // PROFILE_H
@@ -0,0 +1,573 @@
+/**
+ * Range Analysis Implementation
+ */
+
+#include "range_analysis.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+// Widening and narrowing always finish well before this
+static const int MAX_PASSES = 64;
+
+// A phi that grew this often is widened
+static const int WIDEN_AFTER = 2;
+
+// ============================================================================
+// INTERVALS
+// ============================================================================
+
+ValueRange ValueRange::full() {
+    return {INT_MIN, INT_MAX, false};
+}
+
+ValueRange ValueRange::constant(long long value) {
+    return {value, value, false};
+}
+
+ValueRange ValueRange::of(long long lo, long long hi) {
+    if (lo < INT_MIN || hi > INT_MAX || lo > hi) return full();
+    return {lo, hi, false};
+}
+
+static ValueRange join(const ValueRange& a, const ValueRange& b) {
+    return {std::min(a.lo, b.lo), std::max(a.hi, b.hi), a.excludesZero() && b.excludesZero()};
+}
+
+// Both hold; a contradiction (a branch that cannot be taken) keeps `a`
+static ValueRange meet(const ValueRange& a, const ValueRange& b) {
+    ValueRange result = {std::max(a.lo, b.lo), std::min(a.hi, b.hi), a.nonzero || b.nonzero};
+    if (result.nonzero && result.lo == 0) result.lo = 1;
+    if (result.nonzero && result.hi == 0) result.hi = -1;
+    if (result.lo > result.hi) return a;
+    return result;
+}
+
+static bool isComparison(const std::string& opcode) {
+    return opcode == "EQ" || opcode == "NE" || opcode == "LT" || opcode == "GT" ||
+           opcode == "LE" || opcode == "GE";
+}
+
+// DIVNZ / MODNZ divide without any check: no 0, and no INT_MIN / -1
+// (XDIV divides in 64 bits, -1 is harmless there)
+static bool safeDivision(const std::string& opcode, const ValueRange& a, const ValueRange& b) {
+    if (!b.excludesZero()) return false;
+    return opcode == "XDIV" || b.lo > -1 || b.hi < -1 || a.lo > INT_MIN;
+}
+
+static std::string invert(const std::string& comparison) {
+    if (comparison == "EQ") return "NE";
+    if (comparison == "NE") return "EQ";
+    if (comparison == "LT") return "GE";
+    if (comparison == "GE") return "LT";
+    if (comparison == "GT") return "LE";
+    return "GT";
+}
+
+// ============================================================================
+// DRIVER
+// ============================================================================
+
+int RangeAnalysis::run(IRFunction& function) {
+    ranges_.clear();
+    growth_.clear();
+    exits_.clear();
+    position_.clear();
+    liveValues_.clear();
+    liveGlobals_.clear();
+
+    std::vector<IRBlock*> order = function.reversePostorder();
+    for (size_t i = 0; i < order.size(); i++) {
+        position_[order[i]] = (int)i;
+    }
+    computeLiveness(function);
+
+    // Grow (widening loop phis) until nothing changes, then tighten the
+    // widened phis again from their inputs
+    int passes = 0;
+    while (analyze(order, false)) {
+        if (++passes > MAX_PASSES) return 0;  // Keep every check
+    }
+    analyze(order, true);
+    analyze(order, true);
+
+    return markChecks(function, order);
+}
+
+/**
+ * One pass over the blocks in reverse postorder; true if any range (or
+ * what a block passes on) changed.
+ */
+bool RangeAnalysis::analyze(const std::vector<IRBlock*>& order, bool narrow) {
+    bool changed = false;
+    for (IRBlock* block : order) {
+        State state = entryState(block);
+        for (auto& instr : block->instrs) {
+            const IRValue* value = instr.get();
+            if (value->hasResult()) {
+                ValueRange range = value->op == IROp::PHI ? phiRange(value) : evaluate(value, state);
+                auto old = ranges_.find(value);
+                if (value->op == IROp::PHI && !narrow && old != ranges_.end()) {
+                    ValueRange joined = join(old->second, range);
+                    if (joined != old->second && ++growth_[value] > WIDEN_AFTER) {
+                        if (joined.lo < old->second.lo) joined.lo = INT_MIN;
+                        if (joined.hi > old->second.hi) joined.hi = INT_MAX;
+                    }
+                    range = joined;
+                }
+                if (old == ranges_.end() || old->second != range) {
+                    ranges_[value] = range;
+                    changed = true;
+                }
+            }
+            step(value, state);
+        }
+        trim(block, state);
+
+        auto old = exits_.find(block);
+        if (old == exits_.end() || old->second.values != state.values ||
+            old->second.globals != state.globals) {
+            changed = true;
+        }
+        exits_[block] = std::move(state);
+    }
+    return changed;
+}
+
+/**
+ * The proven checks become their unchecked opcodes.
+ */
+int RangeAnalysis::markChecks(const IRFunction& function, const std::vector<IRBlock*>& order) {
+    int changes = 0;
+    for (IRBlock* block : order) {
+        State state = entryState(block);
+        for (auto& instr : block->instrs) {
+            IRValue* value = instr.get();
+            if (value->op == IROp::BINARY &&
+                (value->name == "DIV" || value->name == "MOD" || value->name == "XDIV")) {
+                checks_++;
+                if (safeDivision(value->name, rangeOf(value->operands[0], state),
+                                 rangeOf(value->operands[1], state))) {
+                    value->name += "NZ";
+                    removed_++;
+                    changes++;
+                }
+            } else if (value->op == IROp::BINARY &&
+                       (value->name == "DIVNZ" || value->name == "MODNZ" || value->name == "XDIVNZ")) {
+                checks_++;
+                removed_++;
+            } else if (value->op == IROp::PARAM) {
+                // Semantic analysis checks every call's argument count, and
+                // VM::call the host's (against the SCENE label's arity)
+                checks_++;
+                if (!function.isMain && value->imm < function.paramCount) {
+                    if (value->name != "LOADARGU") changes++;
+                    value->name = "LOADARGU";
+                    removed_++;
+                }
+            }
+            step(value, state);
+        }
+    }
+    return changes;
+}
+
+// ============================================================================
+// STATES
+// ============================================================================
+
+/**
+ * Which facts a block has to pass on. A narrowed value (or a LOAD whose
+ * global a branch may still narrow) only matters while the value is live;
+ * what is known about a global only until every path has stored it again
+ * or stopped loading it. Without this every fact would travel to the end
+ * of the function and each block would copy all of them.
+ *
+ * Only values a branch can narrow are followed: BRANCH conditions and the
+ * operands of the comparison they test, live out of the branching block.
+ */
+void RangeAnalysis::computeLiveness(const IRFunction& function) {
+    std::unordered_map<const IRValue*, std::vector<const IRBlock*>> liveOut;  // Seeds
+    for (auto& block : function.blocks) {
+        IRValue* terminator = block->terminator();
+        if (!terminator || terminator->op != IROp::BRANCH) continue;
+        const IRValue* condition = terminator->operands[0];
+        liveOut[condition].push_back(block.get());
+        if (condition->op == IROp::BINARY && isComparison(condition->name)) {
+            liveOut[condition->operands[0]].push_back(block.get());
+            liveOut[condition->operands[1]].push_back(block.get());
+        }
+    }
+
+    std::unordered_map<const IRValue*, std::unordered_set<const IRBlock*>> liveIn;
+    std::unordered_map<std::string, std::unordered_set<const IRBlock*>> globalIn;
+    std::vector<std::pair<const IRBlock*, std::string>> globalOut;
+    std::unordered_map<const IRBlock*, std::unordered_set<std::string>> stores;
+    for (auto& block : function.blocks) {
+        std::unordered_set<std::string>& stored = stores[block.get()];
+        for (auto& instr : block->instrs) {
+            for (size_t i = 0; i < instr->operands.size(); i++) {
+                const IRValue* operand = instr->operands[i];
+                auto seeds = liveOut.find(operand);
+                if (seeds == liveOut.end()) continue;
+                if (instr->op == IROp::PHI) {
+                    seeds->second.push_back(block->preds[i]);
+                } else if (block.get() != operand->block && liveIn[operand].insert(block.get()).second) {
+                    seeds->second.insert(seeds->second.end(), block->preds.begin(), block->preds.end());
+                }
+            }
+            if (instr->op == IROp::LOAD && !stored.count(instr->name) &&
+                globalIn[instr->name].insert(block.get()).second) {
+                for (IRBlock* pred : block->preds) globalOut.push_back({pred, instr->name});
+            } else if (instr->op == IROp::STORE || instr->op == IROp::FORPREP || instr->op == IROp::FORLOOP) {
+                stored.insert(instr->name);
+            }
+        }
+    }
+
+    // Backwards from the uses to the definition
+    for (auto& entry : liveOut) {
+        const IRValue* value = entry.first;
+        std::vector<const IRBlock*>& work = entry.second;
+        std::unordered_set<const IRBlock*>& in = liveIn[value];
+        while (!work.empty()) {
+            const IRBlock* block = work.back();
+            work.pop_back();
+            if (!liveValues_[block].insert(value).second) continue;
+            if (block != value->block && in.insert(block).second) {
+                work.insert(work.end(), block->preds.begin(), block->preds.end());
+            }
+        }
+    }
+    while (!globalOut.empty()) {
+        const IRBlock* block = globalOut.back().first;
+        std::string global = std::move(globalOut.back().second);
+        globalOut.pop_back();
+        if (!liveGlobals_[block].insert(global).second || stores[block].count(global)) continue;
+        if (globalIn[global].insert(block).second) {
+            for (IRBlock* pred : block->preds) globalOut.push_back({pred, global});
+        }
+    }
+}
+
+void RangeAnalysis::trim(const IRBlock* block, State& state) const {
+    static const std::unordered_set<const IRValue*> noValues;
+    static const std::unordered_set<std::string> noGlobals;
+    auto values = liveValues_.find(block);
+    auto globals = liveGlobals_.find(block);
+    const std::unordered_set<const IRValue*>& live = values != liveValues_.end() ? values->second : noValues;
+    const std::unordered_set<std::string>& read = globals != liveGlobals_.end() ? globals->second : noGlobals;
+
+    for (auto it = state.values.begin(); it != state.values.end();) {
+        it = live.count(it->first) ? std::next(it) : state.values.erase(it);
+    }
+    for (auto it = state.loads.begin(); it != state.loads.end();) {
+        std::vector<const IRValue*>& loads = it->second;
+        loads.erase(std::remove_if(loads.begin(), loads.end(),
+                                   [&](const IRValue* load) { return !live.count(load); }),
+                    loads.end());
+        it = loads.empty() ? state.loads.erase(it) : std::next(it);
+    }
+    for (auto it = state.globals.begin(); it != state.globals.end();) {
+        it = read.count(it->first) ? std::next(it) : state.globals.erase(it);
+    }
+}
+
+/**
+ * What holds on entry: the predecessor's exit (through the branch that
+ * leads here), or what all forward predecessors agree on. A loop header
+ * starts over: its back edges are not known yet.
+ */
+RangeAnalysis::State RangeAnalysis::entryState(const IRBlock* block) const {
+    State state;
+    bool first = true;
+    int here = position_.at(block);
+    for (const IRBlock* pred : block->preds) {
+        auto found = position_.find(pred);
+        if (found == position_.end()) continue;  // Unreachable
+        if (found->second >= here) return State();
+
+        State incoming = edgeState(pred, block);
+        if (first) {
+            state = std::move(incoming);
+            first = false;
+            continue;
+        }
+        for (auto it = state.globals.begin(); it != state.globals.end();) {
+            auto other = incoming.globals.find(it->first);
+            if (other == incoming.globals.end()) {
+                it = state.globals.erase(it);
+            } else {
+                it->second = join(it->second, other->second);
+                ++it;
+            }
+        }
+        for (auto it = state.values.begin(); it != state.values.end();) {
+            auto other = incoming.values.find(it->first);
+            if (other == incoming.values.end()) {
+                it = state.values.erase(it);
+            } else {
+                it->second = join(it->second, other->second);
+                ++it;
+            }
+        }
+        for (auto& loads : state.loads) {
+            const std::vector<const IRValue*>& others = incoming.loads[loads.first];
+            loads.second.erase(std::remove_if(loads.second.begin(), loads.second.end(),
+                                              [&](const IRValue* load) {
+                                                  return std::find(others.begin(), others.end(), load) == others.end();
+                                              }),
+                               loads.second.end());
+        }
+    }
+    return state;
+}
+
+RangeAnalysis::State RangeAnalysis::edgeState(const IRBlock* from, const IRBlock* to) const {
+    auto found = exits_.find(from);
+    if (found == exits_.end()) return State();
+
+    State state = found->second;
+    IRValue* terminator = from->terminator();
+    if (terminator && terminator->op == IROp::BRANCH && from->succs[0] != from->succs[1]) {
+        refine(state, terminator->operands[0], to == from->succs[0]);
+    }
+    return state;
+}
+
+/**
+ * What an instruction does to the globals.
+ */
+void RangeAnalysis::step(const IRValue* instr, State& state) const {
+    switch (instr->op) {
+        case IROp::LOAD:
+            state.loads[instr->name].push_back(instr);
+            break;
+        case IROp::STORE:
+            state.globals[instr->name] = rangeOf(instr->operands[0], state);
+            state.loads.erase(instr->name);
+            break;
+        case IROp::FORPREP:
+        case IROp::FORLOOP:
+            state.globals.erase(instr->name);
+            state.loads.erase(instr->name);
+            break;
+        case IROp::CALL:
+            // A SCENE can assign any global
+            if (instr->purity == Purity::EFFECTFUL) {
+                state.globals.clear();
+                state.loads.clear();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * The branch on `condition` went the `taken` (non-zero) way or not.
+ */
+void RangeAnalysis::refine(State& state, const IRValue* condition, bool taken) const {
+    if (condition->op != IROp::BINARY || !isComparison(condition->name)) {
+        narrowTo(state, condition, taken ? ValueRange{INT_MIN, INT_MAX, true} : ValueRange::constant(0));
+        return;
+    }
+
+    const IRValue* left = condition->operands[0];
+    const IRValue* right = condition->operands[1];
+    ValueRange l = rangeOf(left, state);
+    ValueRange r = rangeOf(right, state);
+    std::string comparison = taken ? condition->name : invert(condition->name);
+
+    if (comparison == "LT") {
+        narrowTo(state, left, ValueRange::of(INT_MIN, r.hi - 1));
+        narrowTo(state, right, ValueRange::of(l.lo + 1, INT_MAX));
+    } else if (comparison == "LE") {
+        narrowTo(state, left, ValueRange::of(INT_MIN, r.hi));
+        narrowTo(state, right, ValueRange::of(l.lo, INT_MAX));
+    } else if (comparison == "GT") {
+        narrowTo(state, left, ValueRange::of(r.lo + 1, INT_MAX));
+        narrowTo(state, right, ValueRange::of(INT_MIN, l.hi - 1));
+    } else if (comparison == "GE") {
+        narrowTo(state, left, ValueRange::of(r.lo, INT_MAX));
+        narrowTo(state, right, ValueRange::of(INT_MIN, l.hi));
+    } else if (comparison == "EQ") {
+        narrowTo(state, left, r);
+        narrowTo(state, right, l);
+    } else {
+        // NE: only a constant on the other side says something
+        const IRValue* sides[2][2] = {{left, right}, {right, left}};
+        for (auto& side : sides) {
+            ValueRange known = rangeOf(side[0], state);
+            ValueRange other = rangeOf(side[1], state);
+            if (other.lo != other.hi) continue;
+            if (other.lo == 0) known.nonzero = true;
+            else if (known.lo == other.lo) known.lo++;
+            else if (known.hi == other.lo) known.hi--;
+            narrowTo(state, side[0], known);
+        }
+    }
+}
+
+void RangeAnalysis::narrowTo(State& state, const IRValue* value, const ValueRange& range) const {
+    if (value->op == IROp::CONST) return;
+    state.values[value] = meet(rangeOf(value, state), range);
+
+    // The global still holds what this LOAD read
+    if (value->op == IROp::LOAD) {
+        const std::vector<const IRValue*>& loads = state.loads[value->name];
+        if (std::find(loads.begin(), loads.end(), value) != loads.end()) {
+            auto global = state.globals.find(value->name);
+            ValueRange known = global != state.globals.end() ? global->second : ValueRange::full();
+            state.globals[value->name] = meet(known, range);
+        }
+    }
+}
+
+// ============================================================================
+// TRANSFER FUNCTIONS
+// ============================================================================
+
+ValueRange RangeAnalysis::rangeOf(const IRValue* value, const State& state) const {
+    auto narrowed = state.values.find(value);
+    if (narrowed != state.values.end()) return narrowed->second;
+    auto found = ranges_.find(value);
+    return found != ranges_.end() ? found->second : ValueRange::full();
+}
+
+/**
+ * Join of the incoming values as they leave their predecessors (inputs
+ * not computed yet, on back edges, are left out until they are).
+ */
+ValueRange RangeAnalysis::phiRange(const IRValue* phi) const {
+    bool any = false;
+    ValueRange result = ValueRange::full();
+    for (size_t i = 0; i < phi->operands.size(); i++) {
+        const IRValue* operand = phi->operands[i];
+        ValueRange range;
+        auto exit = exits_.find(phi->block->preds[i]);
+        if (operand->op == IROp::CONST) {
+            range = ValueRange::constant(operand->imm);
+        } else if (exit != exits_.end() && exit->second.values.count(operand)) {
+            range = exit->second.values.at(operand);
+        } else if (ranges_.count(operand)) {
+            range = ranges_.at(operand);
+        } else {
+            continue;
+        }
+        result = any ? join(result, range) : range;
+        any = true;
+    }
+    return result;
+}
+
+ValueRange RangeAnalysis::evaluate(const IRValue* value, const State& state) const {
+    switch (value->op) {
+        case IROp::CONST:
+            return ValueRange::constant(value->imm);
+
+        case IROp::LOAD: {
+            auto global = state.globals.find(value->name);
+            return global != state.globals.end() ? global->second : ValueRange::full();
+        }
+
+        case IROp::UNARY: {
+            ValueRange a = rangeOf(value->operands[0], state);
+            if (value->name == "NEG") {
+                if (a.lo == INT_MIN) return ValueRange::full();
+                return {-a.hi, -a.lo, a.nonzero};
+            }
+            if (value->name == "I2X") {
+                ValueRange result = ValueRange::of(a.lo * 65536, a.hi * 65536);
+                if (result.lo != INT_MIN || result.hi != INT_MAX) result.nonzero = a.nonzero;
+                return result;
+            }
+            if (value->name == "X2I") return ValueRange::of(a.lo / 65536, a.hi / 65536);
+            return ValueRange::full();
+        }
+
+        case IROp::BINARY: {
+            ValueRange a = rangeOf(value->operands[0], state);
+            ValueRange b = rangeOf(value->operands[1], state);
+            const std::string& opcode = value->name;
+
+            if (isComparison(opcode) || opcode == "FEQ" || opcode == "FNE" || opcode == "FLT" ||
+                opcode == "FGT" || opcode == "FLE" || opcode == "FGE") {
+                return ValueRange::of(0, 1);
+            }
+            if (opcode == "ADD") return ValueRange::of(a.lo + b.lo, a.hi + b.hi);
+            if (opcode == "SUB") return ValueRange::of(a.lo - b.hi, a.hi - b.lo);
+            if (opcode == "MUL") {
+                long long corners[] = {a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi};
+                ValueRange result = ValueRange::of(*std::min_element(corners, corners + 4),
+                                                   *std::max_element(corners, corners + 4));
+                // No wrap-around, so nonzero times nonzero stays nonzero
+                if (result.lo != INT_MIN || result.hi != INT_MAX) {
+                    result.nonzero = a.excludesZero() && b.excludesZero();
+                }
+                return result;
+            }
+            if (opcode == "DIV" || opcode == "DIVNZ") {
+                // Same sign divisor, and no INT_MIN / -1
+                if (b.lo > 0 || (b.hi < 0 && a.lo > INT_MIN)) {
+                    long long corners[] = {a.lo / b.lo, a.lo / b.hi, a.hi / b.lo, a.hi / b.hi};
+                    return ValueRange::of(*std::min_element(corners, corners + 4),
+                                          *std::max_element(corners, corners + 4));
+                }
+                return ValueRange::full();
+            }
+            if (opcode == "MOD" || opcode == "MODNZ") {
+                // |a % b| < |b|, sign follows a (and % 0 gives 0)
+                long long bound = std::max(std::llabs(b.lo), std::llabs(b.hi)) - 1;
+                if (bound < 0) return ValueRange::constant(0);
+                return ValueRange::of(a.lo >= 0 ? 0 : std::max(a.lo, -bound),
+                                      a.hi <= 0 ? 0 : std::min(a.hi, bound));
+            }
+            if (opcode == "BAND") {
+                if (a.lo >= 0 && b.lo >= 0) return ValueRange::of(0, std::min(a.hi, b.hi));
+                if (a.lo >= 0) return ValueRange::of(0, a.hi);
+                if (b.lo >= 0) return ValueRange::of(0, b.hi);
+                return ValueRange::full();
+            }
+            if ((opcode == "BOR" || opcode == "BXOR") && a.lo >= 0 && b.lo >= 0) {
+                long long mask = 1;
+                while (mask <= std::max(a.hi, b.hi)) mask <<= 1;
+                if (opcode == "BXOR") return ValueRange::of(0, mask - 1);
+                ValueRange result = ValueRange::of(std::max(a.lo, b.lo), mask - 1);
+                result.nonzero = a.excludesZero() || b.excludesZero();
+                return result;
+            }
+            if (opcode == "SHR" && b.lo == b.hi) {
+                int shift = (int)(b.lo & 31);
+                return ValueRange::of(a.lo >> shift, a.hi >> shift);
+            }
+            return ValueRange::full();
+        }
+
+        case IROp::CALL: {
+            if (value->purity == Purity::EFFECTFUL) return ValueRange::full();
+            if (value->name == "keyPressed") return ValueRange::of(0, 1);
+            if (value->operands.size() == 1 && value->name == "abs") {
+                ValueRange a = rangeOf(value->operands[0], state);
+                if (a.lo == INT_MIN) return ValueRange::full();  // abs(INT_MIN) wraps
+                ValueRange result = ValueRange::of(a.lo >= 0 ? a.lo : (a.hi <= 0 ? -a.hi : 0),
+                                                   std::max(std::llabs(a.lo), std::llabs(a.hi)));
+                result.nonzero = a.excludesZero();
+                return result;
+            }
+            if (value->operands.size() == 2 && (value->name == "min" || value->name == "max")) {
+                ValueRange a = rangeOf(value->operands[0], state);
+                ValueRange b = rangeOf(value->operands[1], state);
+                ValueRange result = value->name == "min" ? ValueRange::of(std::min(a.lo, b.lo), std::min(a.hi, b.hi))
+                                                         : ValueRange::of(std::max(a.lo, b.lo), std::max(a.hi, b.hi));
+                result.nonzero = a.excludesZero() && b.excludesZero();
+                return result;
+            }
+            return ValueRange::full();
+        }
+
+        default:
+            // PARAM, STRING, object values
+            return ValueRange::full();
+    }
+}
@@ -0,0 +1,110 @@
+/**
+ * CINEBREW Range Analysis
+ *
+ * ============================================================================
+ * WHAT DOES IT DO?
+ * ============================================================================
+ *
+ * Works out an interval [lo, hi] for every integer value of a function,
+ * then drops the VM's safety checks where the interval proves them
+ * unnecessary:
+ *
+ *   DIV, MOD, XDIV  →  DIVNZ, MODNZ, XDIVNZ   divisor can never be 0
+ *   LOADARG n       →  LOADARGU n             SCENE is always called with
+ *                                             its declared parameters
+ *
+ * Where intervals come from:
+ *
+ *   - constants, comparisons (0 or 1), arithmetic on known intervals
+ *     (a result that may overflow knows nothing)
+ *   - x % 8 is within -7..7, x & 255 within 0..255, abs(x) >= 0, ...
+ *   - branches: inside IF d != 0 { ... } d is nonzero, inside
+ *     LOOP i < 10 { ... } i is at most 9. A global keeps what a branch
+ *     or STORE taught about it until the next STORE, FOR step, SCENE or
+ *     effectful call.
+ *   - phis join their inputs; a loop-carried one that keeps growing is
+ *     widened to the whole INT range, then narrowed again
+ *
+ *   TAKE d = getScreenWidth() % 7 + 1;    d: -5..7 (0 is possible)
+ *   IF d > 0 {
+ *       POUR 100 / d;                     d: 1..7  → DIVNZ
+ *   }
+ *
+ * DIVNZ / MODNZ check nothing at all, so the divisor must not be -1
+ * either unless the dividend cannot be INT_MIN (INT_MIN / -1 overflows).
+ * Calls from the host (VM::call, the game loop) are checked against the
+ * SCENE's arity, so LOADARGU holds for them too.
+ *
+ * ============================================================================
+ */
+
+#ifndef RANGE_ANALYSIS_H
+#define RANGE_ANALYSIS_H
+
+#include "ir_pass.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+/**
+ * Interval of a 32-bit value; nonzero also excludes 0 from the middle.
+ */
+struct ValueRange {
+    long long lo;
+    long long hi;
+    bool nonzero;
+
+    static ValueRange full();
+    static ValueRange constant(long long value);
+    static ValueRange of(long long lo, long long hi);  // full() if outside INT
+
+    bool excludesZero() const { return nonzero || lo > 0 || hi < 0; }
+    bool operator==(const ValueRange& other) const {
+        return lo == other.lo && hi == other.hi && excludesZero() == other.excludesZero();
+    }
+    bool operator!=(const ValueRange& other) const { return !(*this == other); }
+};
+
+class RangeAnalysis : public IRPass {
+public:
+    std::string name() const override { return "ranges"; }
+    int run(IRFunction& function) override;
+
+    // Over every function run so far
+    int checkCount() const { return checks_; }    // DIV / MOD / XDIV / LOADARG
+    int removedCount() const { return removed_; }  // Turned into unchecked variants
+
+private:
+    // What is known on entry to / exit from a block. Only what a later
+    // instruction can still read leaves a block (see computeLiveness).
+    struct State {
+        std::unordered_map<std::string, ValueRange> globals;
+        std::unordered_map<std::string, std::vector<const IRValue*>> loads;  // LOADs still holding it
+        std::unordered_map<const IRValue*, ValueRange> values;               // Narrowed by a branch
+    };
+
+    std::unordered_map<const IRValue*, ValueRange> ranges_;
+    std::unordered_map<const IRValue*, int> growth_;  // Phi -> times it grew
+    std::unordered_map<const IRBlock*, State> exits_;
+    std::unordered_map<const IRBlock*, int> position_;  // Index in reverse postorder
+    std::unordered_map<const IRBlock*, std::unordered_set<const IRValue*>> liveValues_;  // At the exit
+    std::unordered_map<const IRBlock*, std::unordered_set<std::string>> liveGlobals_;
+    int checks_ = 0;
+    int removed_ = 0;
+
+    void computeLiveness(const IRFunction& function);
+    void trim(const IRBlock* block, State& state) const;
+    bool analyze(const std::vector<IRBlock*>& order, bool narrow);
+    State entryState(const IRBlock* block) const;
+    State edgeState(const IRBlock* from, const IRBlock* to) const;
+    void step(const IRValue* instr, State& state) const;
+    ValueRange evaluate(const IRValue* value, const State& state) const;
+    ValueRange rangeOf(const IRValue* value, const State& state) const;
+    ValueRange phiRange(const IRValue* phi) const;
+    void refine(State& state, const IRValue* condition, bool taken) const;
+    void narrowTo(State& state, const IRValue* value, const ValueRange& range) const;
+    int markChecks(const IRFunction& function, const std::vector<IRBlock*>& order);
+};
+
+#endif // RANGE_ANALYSIS_H
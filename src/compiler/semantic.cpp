@@ -6,13 +6,15 @@
 
 #include "semantic.h"
 #include "../runtime/runtime.h"
+#include "../vm/memo_cache.h"
 #include <iostream>
+#include <unordered_set>
 
 // ============================================================================
 // CONSTRUCTOR
 // ============================================================================
 
-SemanticAnalyzer::SemanticAnalyzer() : hadError_(false) {
+SemanticAnalyzer::SemanticAnalyzer() : declarations_(0), visible_(-1), loopDepth_(0), hadError_(false) {
     // Initialize runtime to check for built-in functions
     runtime_ = std::make_unique<Runtime>();
 }
@@ -32,25 +34,95 @@ void SemanticAnalyzer::error(const Token& token, const std::string& message) {
 // SYMBOL TABLE MANAGEMENT
 // ============================================================================
 
-void SemanticAnalyzer::declare(const Token& name, SymbolType type, int paramCount) {
+bool SemanticAnalyzer::declare(const Token& name, SymbolType type, int paramCount,
+                               ValueType valueType) {
     std::string nameStr = name.lexeme;
     
+    ValueType ignored;
+    if (conversionTarget(nameStr, ignored)) {
+        error(name, "'" + nameStr + "' is a reserved conversion name");
+        return false;
+    }
+    
     // Check for redeclaration
     if (symbols_.find(nameStr) != symbols_.end()) {
         Symbol& existing = symbols_[nameStr];
         error(name, "Redeclaration of '" + nameStr + "' (first declared at line " + 
               std::to_string(existing.line) + ")");
-        return;
+        return false;
     }
     
-    symbols_[nameStr] = Symbol(type, nameStr, name.line, paramCount);
+    symbols_[nameStr] = Symbol(type, nameStr, name.line, paramCount, valueType);
+    symbols_[nameStr].order = declarations_++;
+    return true;
+}
+
+bool SemanticAnalyzer::isParameter(const Token& name) const {
+    return params_.find(name.lexeme) != params_.end();
+}
+
+bool SemanticAnalyzer::conversionTarget(const std::string& name, ValueType& target) {
+    if (name == "int") { target = ValueType::INT; return true; }
+    if (name == "float") { target = ValueType::FLOAT; return true; }
+    if (name == "fixed") { target = ValueType::FIXED; return true; }
+    return false;
+}
+
+// ============================================================================
+// TYPE INFERENCE
+// ============================================================================
+
+/**
+ * Pick the type a binary operation is performed in.
+ * 
+ * INT is promoted to FLOAT or FIXED. FLOAT and FIXED are never mixed
+ * implicitly: fixed point exists for deterministic simulation, and a silent
+ * float conversion would defeat that.
+ */
+ValueType SemanticAnalyzer::unify(const Token& op, ValueType left, ValueType right) {
+    if (left == right) return left;
+    if (left == ValueType::INT) return right;
+    if (right == ValueType::INT) return left;
+    
+    error(op, "Cannot mix " + valueTypeToString(left) + " and " + valueTypeToString(right) +
+          " in '" + op.lexeme + "' (use float() or fixed())");
+    return left;
+}
+
+/**
+ * A constant expression is built only from literals, CONSTs, operators and
+ * the int()/float()/fixed() conversions, so the optimizer can always fold it.
+ */
+bool SemanticAnalyzer::isConstantExpr(Expr* expr) {
+    if (LiteralExpr* lit = dynamic_cast<LiteralExpr*>(expr)) {
+        return lit->token.type != TokenType::STRING;
+    }
+    if (VariableExpr* var = dynamic_cast<VariableExpr*>(expr)) {
+        auto it = symbols_.find(var->name.lexeme);
+        return !isParameter(var->name) && it != symbols_.end() && it->second.isConst;
+    }
+    if (BinaryExpr* bin = dynamic_cast<BinaryExpr*>(expr)) {
+        return isConstantExpr(bin->left.get()) && isConstantExpr(bin->right.get());
+    }
+    if (LogicalExpr* logical = dynamic_cast<LogicalExpr*>(expr)) {
+        return isConstantExpr(logical->left.get()) && isConstantExpr(logical->right.get());
+    }
+    if (UnaryExpr* unary = dynamic_cast<UnaryExpr*>(expr)) {
+        return isConstantExpr(unary->right.get());
+    }
+    if (CallExpr* call = dynamic_cast<CallExpr*>(expr)) {
+        ValueType ignored;
+        return conversionTarget(call->callee.lexeme, ignored) && call->arguments.size() == 1 &&
+               isConstantExpr(call->arguments[0].get());
+    }
+    return false;
 }
 
 Symbol* SemanticAnalyzer::resolve(const Token& name, SymbolType expectedType) {
     std::string nameStr = name.lexeme;
     
     auto it = symbols_.find(nameStr);
-    if (it == symbols_.end()) {
+    if (it == symbols_.end() || (visible_ >= 0 && it->second.order >= visible_)) {
         std::string typeStr = (expectedType == SymbolType::VARIABLE ? "variable" : "function");
         error(name, "Undefined " + typeStr + ": '" + nameStr + "'");
         return nullptr;
@@ -68,16 +140,97 @@ Symbol* SemanticAnalyzer::resolve(const Token& name, SymbolType expectedType) {
     return &symbol;
 }
 
+// ============================================================================
+// PURITY INFERENCE
+// ============================================================================
+
+void SemanticAnalyzer::impure(const std::string& reason) {
+    if (scene_.empty()) return;
+    std::string& impurity = scenes_[scene_].impurity;
+    if (impurity.empty()) impurity = reason;
+}
+
+/**
+ * A SCENE is pure when its result depends only on its arguments and
+ * calling it changes nothing: it touches no global (CONSTs are fine),
+ * prints nothing, uses no object, and only calls PURE built-ins and pure
+ * SCENEs. Starts from the SCENEs' own bodies and spreads impurity to
+ * their callers until nothing changes.
+ *
+ * Pure SCENEs that are recursive, or marked MEMO, are memoized: the VM
+ * remembers their results by arguments (MEMOGET / MEMOPUT).
+ */
+void SemanticAnalyzer::inferPurity() {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& entry : scenes_) {
+            SceneFacts& facts = entry.second;
+            if (!facts.impurity.empty()) continue;
+            for (const std::string& callee : facts.callees) {
+                auto found = scenes_.find(callee);
+                if (found == scenes_.end() || !found->second.impurity.empty()) {
+                    facts.impurity = "calls impure SCENE '" + callee + "'";
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (auto& entry : scenes_) {
+        FunctionStmt* stmt = entry.second.stmt;
+        if (!stmt) continue;
+        stmt->pure = entry.second.impurity.empty();
+        bool recursive = reaches(entry.first, entry.first);
+        bool fits = stmt->parameters.size() <= (size_t)MemoCache::MAX_ARGS;
+
+        if (stmt->hint == TokenType::MEMO) {
+            if (!stmt->pure) {
+                error(stmt->name, "MEMO SCENE '" + entry.first + "' is not pure (it " +
+                      entry.second.impurity + ")");
+            } else if (!fits) {
+                error(stmt->name, "MEMO SCENE '" + entry.first + "' has more than " +
+                      std::to_string(MemoCache::MAX_ARGS) + " parameters");
+            }
+        }
+        stmt->memoize = stmt->pure && fits && (recursive || stmt->hint == TokenType::MEMO);
+    }
+}
+
+// Whether `from` can end up calling `to`
+bool SemanticAnalyzer::reaches(const std::string& from, const std::string& to) const {
+    std::unordered_set<std::string> seen;
+    std::vector<std::string> work = {from};
+    while (!work.empty()) {
+        std::string name = work.back();
+        work.pop_back();
+        auto found = scenes_.find(name);
+        if (found == scenes_.end()) continue;
+        for (const std::string& callee : found->second.callees) {
+            if (callee == to) return true;
+            if (seen.insert(callee).second) work.push_back(callee);
+        }
+    }
+    return false;
+}
+
 // ============================================================================
 // MAIN ANALYSIS FUNCTION
 // ============================================================================
 
 void SemanticAnalyzer::analyze(std::unique_ptr<Program>& program) {
     symbols_.clear();
+    params_.clear();
+    loopDepth_ = 0;
+    forVariables_.clear();
     errors_.clear();
     hadError_ = false;
+    scenes_.clear();
+    scene_.clear();
     
     visitProgram(program.get());
+    inferPurity();
 }
 
 // ============================================================================
@@ -103,12 +256,18 @@ void SemanticAnalyzer::visitStmt(Stmt* stmt) {
         visitDeclaration(decl);
     } else if (AssignmentStmt* assign = dynamic_cast<AssignmentStmt*>(stmt)) {
         visitAssignment(assign);
+    } else if (PropertyAssignmentStmt* propAssign = dynamic_cast<PropertyAssignmentStmt*>(stmt)) {
+        visitPropertyAssignment(propAssign);
     } else if (PrintStmt* print = dynamic_cast<PrintStmt*>(stmt)) {
         visitPrint(print);
     } else if (IfStmt* ifStmt = dynamic_cast<IfStmt*>(stmt)) {
         visitIf(ifStmt);
     } else if (LoopStmt* loop = dynamic_cast<LoopStmt*>(stmt)) {
         visitLoop(loop);
+    } else if (ForStmt* forStmt = dynamic_cast<ForStmt*>(stmt)) {
+        visitFor(forStmt);
+    } else if (MatchStmt* matchStmt = dynamic_cast<MatchStmt*>(stmt)) {
+        visitMatch(matchStmt);
     } else if (BreakStmt* brk = dynamic_cast<BreakStmt*>(stmt)) {
         visitBreak(brk);
     } else if (ContinueStmt* cont = dynamic_cast<ContinueStmt*>(stmt)) {
@@ -131,21 +290,61 @@ void SemanticAnalyzer::visitStmt(Stmt* stmt) {
 void SemanticAnalyzer::visitDeclaration(DeclarationStmt* stmt) {
     // Check initializer expression
     visitExpr(stmt->initializer.get());
+    impure("declares global '" + stmt->name.lexeme + "'");
     
-    // Declare variable
-    declare(stmt->name, SymbolType::VARIABLE);
+    if (isParameter(stmt->name)) {
+        error(stmt->name, "Declaration of '" + stmt->name.lexeme + "' shadows a parameter");
+        return;
+    }
+    
+    if (stmt->isConst() && !isConstantExpr(stmt->initializer.get())) {
+        error(stmt->name, "CONST '" + stmt->name.lexeme +
+              "' must be initialized with a constant expression");
+    }
+    
+    // Declare variable with the initializer's type
+    if (declare(stmt->name, SymbolType::VARIABLE, 0, stmt->initializer->type)) {
+        symbols_[stmt->name.lexeme].isConst = stmt->isConst();
+    }
 }
 
 void SemanticAnalyzer::visitAssignment(AssignmentStmt* stmt) {
-    // Check that variable exists
-    resolve(stmt->name, SymbolType::VARIABLE);
-    
     // Check value expression
     visitExpr(stmt->value.get());
+    
+    for (const std::string& var : forVariables_) {
+        if (var == stmt->name.lexeme) {
+            error(stmt->name, "Cannot assign to FOR variable '" + var + "' inside its loop");
+        }
+    }
+    
+    // Parameters are always INT
+    if (isParameter(stmt->name)) {
+        stmt->targetType = ValueType::INT;
+        return;
+    }
+    
+    // Check that variable exists; the value is converted to its type
+    impure("writes global '" + stmt->name.lexeme + "'");
+    Symbol* symbol = resolve(stmt->name, SymbolType::VARIABLE);
+    if (symbol) {
+        if (symbol->isConst) {
+            error(stmt->name, "Cannot assign to CONST '" + stmt->name.lexeme + "'");
+        }
+        stmt->targetType = symbol->valueType;
+    }
+}
+
+void SemanticAnalyzer::visitPropertyAssignment(PropertyAssignmentStmt* stmt) {
+    // Properties are dynamic: any name may be added at runtime
+    visitExpr(stmt->object.get());
+    visitExpr(stmt->value.get());
+    impure("writes a property");
 }
 
 void SemanticAnalyzer::visitPrint(PrintStmt* stmt) {
     visitExpr(stmt->expression.get());
+    impure("prints");
 }
 
 void SemanticAnalyzer::visitIf(IfStmt* stmt) {
@@ -158,15 +357,103 @@ void SemanticAnalyzer::visitIf(IfStmt* stmt) {
 
 void SemanticAnalyzer::visitLoop(LoopStmt* stmt) {
     visitExpr(stmt->condition.get());
+    loopDepth_++;
     visitBlock(stmt->body.get());
+    loopDepth_--;
+}
+
+void SemanticAnalyzer::visitFor(ForStmt* stmt) {
+    visitExpr(stmt->start.get());
+    visitExpr(stmt->limit.get());
+    if (stmt->step) {
+        visitExpr(stmt->step.get());
+    }
+    
+    if (stmt->start->type != ValueType::INT || stmt->limit->type != ValueType::INT ||
+        (stmt->step && stmt->step->type != ValueType::INT)) {
+        error(stmt->keyword, "FOR bounds and STEP must be INT");
+    }
+    
+    declareForVariable(stmt->variable);
+    
+    // Record the step for the optimizer when it is a literal
+    stmt->constantStep = true;
+    stmt->stepValue = 1;
+    if (stmt->step) {
+        LiteralExpr* lit = dynamic_cast<LiteralExpr*>(stmt->step.get());
+        if (lit && lit->token.type == TokenType::NUMBER) {
+            stmt->stepValue = std::stoi(lit->value);
+            if (stmt->stepValue == 0) {
+                error(stmt->keyword, "FOR STEP cannot be 0");
+            }
+        } else {
+            stmt->constantStep = false;
+        }
+    }
+    
+    loopDepth_++;
+    forVariables_.push_back(stmt->variable.lexeme);
+    visitBlock(stmt->body.get());
+    forVariables_.pop_back();
+    loopDepth_--;
+}
+
+// The loop variable is an INT global, declared by the FOR if needed
+void SemanticAnalyzer::declareForVariable(const Token& variable) {
+    impure("uses global '" + variable.lexeme + "' as FOR variable");
+    if (isParameter(variable)) {
+        error(variable, "FOR variable '" + variable.lexeme + "' shadows a parameter");
+        return;
+    }
+    auto it = symbols_.find(variable.lexeme);
+    if (it == symbols_.end()) {
+        declare(variable, SymbolType::VARIABLE, 0, ValueType::INT);
+    } else if (it->second.type != SymbolType::VARIABLE || it->second.valueType != ValueType::INT ||
+               it->second.isConst) {
+        error(variable, "FOR variable '" + variable.lexeme + "' must be an INT variable");
+    }
+}
+
+void SemanticAnalyzer::visitMatch(MatchStmt* stmt) {
+    visitExpr(stmt->subject.get());
+    if (stmt->subject->type != ValueType::INT) {
+        error(stmt->keyword, "MATCH value must be INT");
+    }
+    
+    // Case values must be distinct: at most one arm may claim a value
+    std::unordered_set<int> seen;
+    for (auto& c : stmt->cases) {
+        c.constants.clear();
+        for (const Token& value : c.values) {
+            int constant = 0;
+            try {
+                constant = std::stoi(value.lexeme);
+            } catch (const std::out_of_range&) {
+                error(value, "CASE value " + value.lexeme + " is out of INT range");
+            }
+            if (!seen.insert(constant).second) {
+                error(value, "Duplicate CASE value " + value.lexeme);
+            }
+            c.constants.push_back(constant);
+        }
+        visitBlock(c.body.get());
+    }
+    
+    if (stmt->elseBranch) {
+        visitBlock(stmt->elseBranch.get());
+    }
 }
 
 void SemanticAnalyzer::visitBreak(BreakStmt* stmt) {
-    // Break is valid (we don't check if it's inside a loop for simplicity)
+    if (loopDepth_ == 0) {
+        error(stmt->keyword, "BREAK outside of a loop");
+    }
 }
 
 void SemanticAnalyzer::visitContinue(ContinueStmt* stmt) {
-    // Continue is valid (we don't check if it's inside a loop for simplicity)
+    if (loopDepth_ == 0) {
+        error(stmt->keyword, "CONTINUE outside of a loop");
+    }
 }
 
 void SemanticAnalyzer::visitReturn(ReturnStmt* stmt) {
@@ -178,8 +465,67 @@ void SemanticAnalyzer::visitReturn(ReturnStmt* stmt) {
 
 void SemanticAnalyzer::visitFunction(FunctionStmt* stmt) {
     // Function already declared in first pass
-    // Analyze function body
+    // Parameters are visible (as INT) inside the body only
+    std::unordered_map<std::string, int> outerParams = params_;
+    params_.clear();
+    for (size_t i = 0; i < stmt->parameters.size(); i++) {
+        const Token& param = stmt->parameters[i];
+        if (params_.find(param.lexeme) != params_.end()) {
+            error(param, "Duplicate parameter '" + param.lexeme + "'");
+        }
+        params_[param.lexeme] = (int)i;
+    }
+    
+    stmt->pure = false;
+    stmt->memoize = false;
+    scene_ = stmt->name.lexeme;
+    
+    if (!stmt->body) {
+        // Not parsed yet (lazy): only the globals its FORs declare are
+        // known; the body is analyzed by analyzeScene() when first called,
+        // against the globals declared up to here.
+        // Unknown to purity inference, so its callers are impure too.
+        for (const Token& variable : stmt->forVariables) {
+            declareForVariable(variable);
+        }
+        visibleAt_[scene_] = declarations_;
+        scene_.clear();
+        params_ = outerParams;
+        return;
+    }
+    scenes_[scene_].stmt = stmt;
+    
+    // Analyze function body (loops outside the SCENE are not visible)
+    int outerLoopDepth = loopDepth_;
+    std::vector<std::string> outerForVariables = forVariables_;
+    loopDepth_ = 0;
+    forVariables_.clear();
+    
     visitBlock(stmt->body.get());
+    
+    scene_.clear();
+    params_ = outerParams;
+    loopDepth_ = outerLoopDepth;
+    forVariables_ = outerForVariables;
+}
+
+/**
+ * Analyzes the body of a lazily parsed SCENE, once it has been parsed:
+ * against the globals declared before the SCENE, as the whole program's
+ * analysis would have (the globals declared after it are known by now,
+ * but not visible). The SCENE stays impure (it is not memoized).
+ */
+bool SemanticAnalyzer::analyzeScene(FunctionStmt* stmt) {
+    errors_.clear();
+    hadError_ = false;
+    auto visible = visibleAt_.find(stmt->name.lexeme);
+    visible_ = visible == visibleAt_.end() ? -1 : visible->second;
+    visitFunction(stmt);
+    visible_ = -1;
+    scenes_.erase(stmt->name.lexeme);
+    stmt->pure = false;
+    stmt->memoize = false;
+    return !hadError_;
 }
 
 void SemanticAnalyzer::visitBlock(BlockStmt* stmt) {
@@ -199,36 +545,127 @@ void SemanticAnalyzer::visitExpr(Expr* expr) {
         visitVariable(var);
     } else if (BinaryExpr* bin = dynamic_cast<BinaryExpr*>(expr)) {
         visitBinary(bin);
+    } else if (LogicalExpr* logical = dynamic_cast<LogicalExpr*>(expr)) {
+        visitLogical(logical);
     } else if (UnaryExpr* un = dynamic_cast<UnaryExpr*>(expr)) {
         visitUnary(un);
     } else if (CallExpr* call = dynamic_cast<CallExpr*>(expr)) {
         visitCall(call);
+    } else if (ObjectExpr* obj = dynamic_cast<ObjectExpr*>(expr)) {
+        visitObject(obj);
+    } else if (PropertyExpr* prop = dynamic_cast<PropertyExpr*>(expr)) {
+        visitProperty(prop);
     }
 }
 
 void SemanticAnalyzer::visitLiteral(LiteralExpr* expr) {
-    // Literals are always valid
+    // Literals are always valid; their token decides the type
+    if (expr->token.type == TokenType::FLOAT_NUMBER) {
+        expr->type = ValueType::FLOAT;
+    } else if (expr->token.type == TokenType::FIXED_NUMBER) {
+        expr->type = ValueType::FIXED;
+    } else {
+        expr->type = ValueType::INT;
+    }
 }
 
 void SemanticAnalyzer::visitVariable(VariableExpr* expr) {
+    if (isParameter(expr->name)) {
+        expr->type = ValueType::INT;
+        return;
+    }
+    
     // Check that variable exists
-    resolve(expr->name, SymbolType::VARIABLE);
+    Symbol* symbol = resolve(expr->name, SymbolType::VARIABLE);
+    expr->type = symbol ? symbol->valueType : ValueType::INT;
+    if (!symbol || !symbol->isConst) {
+        impure("reads global '" + expr->name.lexeme + "'");
+    }
 }
 
 void SemanticAnalyzer::visitBinary(BinaryExpr* expr) {
     visitExpr(expr->left.get());
     visitExpr(expr->right.get());
+    
+    expr->operandType = unify(expr->op, expr->left->type, expr->right->type);
+    
+    switch (expr->op.type) {
+        case TokenType::EQUAL_EQUAL:
+        case TokenType::BANG_EQUAL:
+        case TokenType::GREATER:
+        case TokenType::GREATER_EQUAL:
+        case TokenType::LESS:
+        case TokenType::LESS_EQUAL:
+            expr->type = ValueType::INT;  // Comparisons produce 0 or 1
+            break;
+        case TokenType::PERCENT:
+        case TokenType::AMPERSAND:
+        case TokenType::PIPE:
+        case TokenType::CARET:
+        case TokenType::LESS_LESS:
+        case TokenType::GREATER_GREATER:
+            // Integer-only operators: no float/fixed variants
+            if (expr->operandType != ValueType::INT) {
+                error(expr->op, "Operator '" + expr->op.lexeme + "' requires INT operands, got " +
+                      valueTypeToString(expr->operandType) + " (use int())");
+            }
+            expr->operandType = ValueType::INT;
+            expr->type = ValueType::INT;
+            break;
+        default:
+            expr->type = expr->operandType;
+            break;
+    }
+}
+
+void SemanticAnalyzer::visitLogical(LogicalExpr* expr) {
+    visitExpr(expr->left.get());
+    visitExpr(expr->right.get());
+    
+    // Truth values are INT (0 is false); test FLOAT/FIXED with a comparison
+    if (expr->left->type != ValueType::INT || expr->right->type != ValueType::INT) {
+        error(expr->op, "Operator '" + expr->op.lexeme + "' requires INT operands (compare with 0 first)");
+    }
+    expr->type = ValueType::INT;
 }
 
 void SemanticAnalyzer::visitUnary(UnaryExpr* expr) {
     visitExpr(expr->right.get());
+    expr->type = expr->right->type;
+    
+    if (expr->op.type == TokenType::BANG) {
+        if (expr->right->type != ValueType::INT) {
+            error(expr->op, "Operator '!' requires an INT operand (compare with 0 first)");
+        }
+        expr->type = ValueType::INT;
+    }
 }
 
 void SemanticAnalyzer::visitCall(CallExpr* expr) {
     std::string funcName = expr->callee.lexeme;
     
+    // Builtins and SCENEs take and return INT; arguments are converted
+    expr->type = ValueType::INT;
+    
+    // Type conversions: int(x), float(x), fixed(x)
+    ValueType target;
+    if (conversionTarget(funcName, target)) {
+        if (expr->arguments.size() != 1) {
+            error(expr->callee, "Conversion '" + funcName + "' expects 1 argument, but got " +
+                  std::to_string(expr->arguments.size()));
+        }
+        for (auto& arg : expr->arguments) {
+            visitExpr(arg.get());
+        }
+        expr->type = target;
+        return;
+    }
+    
     // Check if it's a built-in function
     if (runtime_->isBuiltin(funcName)) {
+        if (runtime_->getPurity(funcName) != Purity::PURE) {
+            impure("calls " + funcName + "()");
+        }
         int expectedArgs = runtime_->getParamCount(funcName);
         int actualArgs = expr->arguments.size();
         
@@ -240,6 +677,9 @@ void SemanticAnalyzer::visitCall(CallExpr* expr) {
     } else {
         // Check that user-defined function exists
         Symbol* symbol = resolve(expr->callee, SymbolType::FUNCTION);
+        if (!scene_.empty()) {
+            scenes_[scene_].callees.insert(funcName);
+        }
         
         if (symbol) {
             // Check argument count
@@ -260,3 +700,22 @@ void SemanticAnalyzer::visitCall(CallExpr* expr) {
     }
 }
 
+void SemanticAnalyzer::visitObject(ObjectExpr* expr) {
+    impure("creates an object");
+    // Field names must be unique within a literal
+    for (size_t i = 0; i < expr->fieldNames.size(); i++) {
+        for (size_t j = 0; j < i; j++) {
+            if (expr->fieldNames[i].lexeme == expr->fieldNames[j].lexeme) {
+                error(expr->fieldNames[i], "Duplicate field '" + expr->fieldNames[i].lexeme +
+                      "' in object literal");
+                break;
+            }
+        }
+        visitExpr(expr->fieldValues[i].get());
+    }
+}
+
+void SemanticAnalyzer::visitProperty(PropertyExpr* expr) {
+    visitExpr(expr->object.get());
+    impure("reads a property");
+}
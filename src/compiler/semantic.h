@@ -17,6 +17,9 @@
  *   - Calling undefined function: result = add(3, 5); (add not defined)
  *   - Wrong argument count: add(3); (add expects 2 args)
  * 
+ * It also infers which SCENEs are pure (see inferPurity) and marks the
+ * ones the VM memoizes.
+ * 
  * ============================================================================
  */
 
@@ -29,6 +32,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 
 /**
@@ -46,12 +50,17 @@ struct Symbol {
     std::string name;
     int line;  // Where it was declared
     int paramCount;  // For functions: number of parameters
+    ValueType valueType;  // For variables: type of the initializer
+    bool isConst;         // Declared with CONST
+    int order;            // Declarations before this one (what a lazy SCENE may see)
     
     // Default constructor (required for unordered_map::operator[])
-    Symbol() : type(SymbolType::VARIABLE), name(""), line(0), paramCount(0) {}
+    Symbol() : type(SymbolType::VARIABLE), name(""), line(0), paramCount(0),
+               valueType(ValueType::INT), isConst(false), order(0) {}
     
-    Symbol(SymbolType t, const std::string& n, int l, int params = 0)
-        : type(t), name(n), line(l), paramCount(params) {}
+    Symbol(SymbolType t, const std::string& n, int l, int params = 0,
+           ValueType vt = ValueType::INT)
+        : type(t), name(n), line(l), paramCount(params), valueType(vt), isConst(false), order(0) {}
 };
 
 /**
@@ -66,21 +75,42 @@ public:
     // Main function: analyze program
     void analyze(std::unique_ptr<Program>& program);
     
+    // Lazy compilation: the body of a SCENE parsed after analyze() (false on error)
+    bool analyzeScene(FunctionStmt* stmt);
+    
     // Check if there were any errors
     bool hadError() const { return hadError_; }
     
     // Get error messages
     std::vector<std::string> getErrors() const { return errors_; }
+    
+    // Type conversion intrinsics: int(x), float(x), fixed(x)
+    static bool conversionTarget(const std::string& name, ValueType& target);
 
 private:
     // ========================================================================
     // STATE
     // ========================================================================
     std::unordered_map<std::string, Symbol> symbols_;  // Global symbol table
+    int declarations_;                                 // Symbols declared so far
+    std::unordered_map<std::string, int> visibleAt_;   // Lazy SCENE -> declarations_ at its position
+    int visible_;                                      // Only symbols with a lower order resolve, -1: all
+    std::unordered_map<std::string, int> params_;      // Current SCENE's parameters (name -> index)
+    int loopDepth_;                                    // Enclosing LOOP/FOR count (for BREAK/CONTINUE)
+    std::vector<std::string> forVariables_;            // Induction variables of enclosing FORs
     std::vector<std::string> errors_;
     bool hadError_;
     std::unique_ptr<Runtime> runtime_;  // Runtime library for built-in functions
     
+    // Purity facts gathered while walking a SCENE body
+    struct SceneFacts {
+        FunctionStmt* stmt = nullptr;
+        std::string impurity;                     // First reason it is not pure, "" if none
+        std::unordered_set<std::string> callees;  // SCENEs it calls
+    };
+    std::unordered_map<std::string, SceneFacts> scenes_;
+    std::string scene_;  // SCENE being analyzed, "" in the main program
+    
     // ========================================================================
     // ERROR REPORTING
     // ========================================================================
@@ -89,8 +119,23 @@ private:
     // ========================================================================
     // SYMBOL TABLE MANAGEMENT
     // ========================================================================
-    void declare(const Token& name, SymbolType type, int paramCount = 0);
+    bool declare(const Token& name, SymbolType type, int paramCount = 0,
+                 ValueType valueType = ValueType::INT);  // False on error
     Symbol* resolve(const Token& name, SymbolType expectedType);
+    bool isParameter(const Token& name) const;
+    
+    // ========================================================================
+    // TYPE INFERENCE
+    // ========================================================================
+    ValueType unify(const Token& op, ValueType left, ValueType right);
+    bool isConstantExpr(Expr* expr);
+    
+    // ========================================================================
+    // PURITY INFERENCE
+    // ========================================================================
+    void impure(const std::string& reason);  // The current SCENE is not pure
+    void inferPurity();
+    bool reaches(const std::string& from, const std::string& to) const;
     
     // ========================================================================
     // AST WALKING
@@ -102,9 +147,13 @@ private:
     // Statements
     void visitDeclaration(DeclarationStmt* stmt);
     void visitAssignment(AssignmentStmt* stmt);
+    void visitPropertyAssignment(PropertyAssignmentStmt* stmt);
     void visitPrint(PrintStmt* stmt);
     void visitIf(IfStmt* stmt);
     void visitLoop(LoopStmt* stmt);
+    void visitFor(ForStmt* stmt);
+    void declareForVariable(const Token& variable);
+    void visitMatch(MatchStmt* stmt);
     void visitBreak(BreakStmt* stmt);
     void visitContinue(ContinueStmt* stmt);
     void visitReturn(ReturnStmt* stmt);
@@ -115,8 +164,11 @@ private:
     void visitLiteral(LiteralExpr* expr);
     void visitVariable(VariableExpr* expr);
     void visitBinary(BinaryExpr* expr);
+    void visitLogical(LogicalExpr* expr);
     void visitUnary(UnaryExpr* expr);
     void visitCall(CallExpr* expr);
+    void visitObject(ObjectExpr* expr);
+    void visitProperty(PropertyExpr* expr);
 };
 
 #endif // SEMANTIC_H
@@ -9,24 +9,44 @@
 std::string tokenTypeToString(TokenType type) {
     static std::unordered_map<TokenType, std::string> typeNames = {
         {TokenType::TAKE, "TAKE"},
+        {TokenType::CONST, "CONST"},
         {TokenType::POUR, "POUR"},
         {TokenType::SCENE, "SCENE"},
+        {TokenType::INLINE, "INLINE"},
+        {TokenType::NOINLINE, "NOINLINE"},
+        {TokenType::MEMO, "MEMO"},
         {TokenType::SHOT, "SHOT"},
         {TokenType::IF, "IF"},
         {TokenType::ELSE, "ELSE"},
         {TokenType::LOOP, "LOOP"},
+        {TokenType::FOR, "FOR"},
+        {TokenType::TO, "TO"},
+        {TokenType::STEP, "STEP"},
+        {TokenType::MATCH, "MATCH"},
+        {TokenType::CASE, "CASE"},
         {TokenType::BREAK, "BREAK"},
         {TokenType::CONTINUE, "CONTINUE"},
         {TokenType::TRUE_KW, "TRUE"},
         {TokenType::FALSE_KW, "FALSE"},
         {TokenType::IDENTIFIER, "IDENTIFIER"},
         {TokenType::NUMBER, "NUMBER"},
+        {TokenType::FLOAT_NUMBER, "FLOAT_NUMBER"},
+        {TokenType::FIXED_NUMBER, "FIXED_NUMBER"},
         {TokenType::STRING, "STRING"},
         {TokenType::EQUAL, "EQUAL"},
         {TokenType::PLUS, "PLUS"},
         {TokenType::MINUS, "MINUS"},
         {TokenType::STAR, "STAR"},
         {TokenType::SLASH, "SLASH"},
+        {TokenType::PERCENT, "PERCENT"},
+        {TokenType::AMPERSAND, "AMPERSAND"},
+        {TokenType::PIPE, "PIPE"},
+        {TokenType::CARET, "CARET"},
+        {TokenType::LESS_LESS, "LESS_LESS"},
+        {TokenType::GREATER_GREATER, "GREATER_GREATER"},
+        {TokenType::AND, "AND"},
+        {TokenType::OR, "OR"},
+        {TokenType::BANG, "BANG"},
         {TokenType::EQUAL_EQUAL, "EQUAL_EQUAL"},
         {TokenType::BANG_EQUAL, "BANG_EQUAL"},
         {TokenType::GREATER, "GREATER"},
@@ -39,6 +59,8 @@ std::string tokenTypeToString(TokenType type) {
         {TokenType::LPAREN, "LPAREN"},
         {TokenType::RPAREN, "RPAREN"},
         {TokenType::COMMA, "COMMA"},
+        {TokenType::DOT, "DOT"},
+        {TokenType::COLON, "COLON"},
         {TokenType::END_OF_FILE, "END_OF_FILE"},
         {TokenType::ERROR, "ERROR"}
     };
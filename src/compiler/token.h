@@ -20,12 +20,21 @@ enum class TokenType {
     // KEYWORDS (Cinema + Coffee Theme)
     // ========================================================================
     TAKE,       // Variable declaration: TAKE x = 5;
+    CONST,      // Constant declaration: CONST SPEED = 5;
     POUR,       // Print statement: POUR x;
     SCENE,      // Function definition: SCENE add(a, b) { ... }
+    INLINE,     // Inlining hint: INLINE SCENE f(x) { ... }
+    NOINLINE,   // Inlining hint: NOINLINE SCENE f(x) { ... }
+    MEMO,       // Memoization hint: MEMO SCENE f(x) { ... }
     SHOT,       // Return statement: SHOT result;
     IF,         // Conditional: IF x > 0 { ... }
     ELSE,       // Else clause: ELSE { ... }
     LOOP,       // While loop: LOOP i < 10 { ... }
+    FOR,        // Counted loop: FOR i = 1 TO 10 STEP 2 { ... }
+    TO,         // FOR upper/lower bound
+    STEP,       // FOR increment (optional, default 1)
+    MATCH,      // Multi-way branch: MATCH state { CASE 1 { ... } ELSE { ... } }
+    CASE,       // MATCH arm: CASE 1, 2 { ... }
     BREAK,      // Exit loop: BREAK;
     CONTINUE,   // Skip iteration: CONTINUE;
     TRUE_KW,    // Boolean true: true
@@ -36,6 +45,8 @@ enum class TokenType {
     // ========================================================================
     IDENTIFIER, // Variable/function name: x, myVar, add
     NUMBER,     // Integer literal: 42, -10, 0
+    FLOAT_NUMBER,  // Float literal: 3.5, -0.25
+    FIXED_NUMBER,  // 16.16 fixed-point literal: 1.5q, 2q
     STRING,     // String literal: "hello" (for future use)
     
     // ========================================================================
@@ -46,6 +57,23 @@ enum class TokenType {
     MINUS,      // Subtraction: -
     STAR,       // Multiplication: *
     SLASH,      // Division: /
+    PERCENT,    // Modulo: %
+    
+    // ========================================================================
+    // BITWISE OPERATORS (INT only)
+    // ========================================================================
+    AMPERSAND,       // Bitwise and: &
+    PIPE,            // Bitwise or: |
+    CARET,           // Bitwise xor: ^
+    LESS_LESS,       // Shift left: <<
+    GREATER_GREATER, // Arithmetic shift right: >>
+    
+    // ========================================================================
+    // LOGICAL OPERATORS (short-circuit)
+    // ========================================================================
+    AND,        // Logical and: && or AND
+    OR,         // Logical or: || or OR
+    BANG,       // Logical not: !
     
     // ========================================================================
     // COMPARISON OPERATORS
@@ -66,6 +94,8 @@ enum class TokenType {
     LPAREN,     // Left parenthesis: (
     RPAREN,     // Right parenthesis: )
     COMMA,      // Comma: ,
+    DOT,        // Property access: player.x
+    COLON,      // Object field initializer: { x: 1 }
     
     // ========================================================================
     // SPECIAL
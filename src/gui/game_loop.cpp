@@ -6,6 +6,7 @@
 
 #include "game_loop.h"
 #include "../runtime/runtime.h"
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <chrono>
@@ -21,9 +22,8 @@
 // CONSTRUCTOR
 // ============================================================================
 
-GameLoop::GameLoop(VM& vm, const std::vector<std::string>& program,
-                   int width, int height, const std::string& title) 
-    : vm_(vm), program_(program), running_(true), targetFPS_(60) {
+GameLoop::GameLoop(VM& vm, int width, int height, const std::string& title) 
+    : vm_(vm), running_(true), targetFPS_(60) {
     
     // Initialize window
     if (Window::initialize()) {
@@ -113,8 +113,9 @@ void GameLoop::render() {
 // ============================================================================
 
 bool GameLoop::callCineBrewFunction(const std::string& functionName) {
-    // Check if function exists in VM labels
-    if (vm_.labels.find(functionName) == vm_.labels.end()) {
+    // Check if function exists in the loaded program
+    int entry = vm_.findLabel(functionName);
+    if (entry < 0) {
         // Function doesn't exist - that's okay, just skip
         return false;
     }
@@ -123,23 +124,23 @@ bool GameLoop::callCineBrewFunction(const std::string& functionName) {
     int savedPC = vm_.pc;
     int savedStackSize = vm_.stack.size();
     
-    // Create a CALL instruction to call the function
-    std::string callInstr = "CALL " + functionName + " 0";
-    
-    // Execute the CALL instruction
-    vm_.execute(callInstr, program_);
+    // Call the function as if a "CALL <name> <n>" had been executed; its
+    // parameters, if it has any, are 0 (VM::call checks the count)
+    int argc = std::max(vm_.program().arity(functionName), 0);
+    for (int i = 0; i < argc; i++) vm_.push(0);
+    vm_.call(functionName, argc);
     
     // Execute the function until it returns
     int maxInstructions = 1000;  // Safety limit
     int instructionCount = 0;
     
-    while (instructionCount < maxInstructions && vm_.pc < (int)program_.size()) {
+    while (instructionCount < maxInstructions && vm_.pc < vm_.programSize()) {
         // Check if we've returned (callstack is empty and we're past the function)
-        if (vm_.callstack.empty() && vm_.pc > vm_.labels[functionName]) {
+        if (vm_.callstack.empty() && vm_.pc > entry) {
             break;
         }
         
-        vm_.execute(program_[vm_.pc], program_);
+        vm_.step();
         instructionCount++;
     }
     
@@ -17,15 +17,14 @@
 
 class GameLoop {
 public:
-    GameLoop(VM& vm, const std::vector<std::string>& program, int width = 800, int height = 600, const std::string& title = "CineBrew Game");
+    GameLoop(VM& vm, int width = 800, int height = 600, const std::string& title = "CineBrew Game");
     void run();
     void stop();
     bool isRunning() const { return running_; }
     void setTargetFPS(int fps) { targetFPS_ = fps; }
 
 private:
-    VM& vm_;
-    std::vector<std::string> program_;
+    VM& vm_;  // Holds the loaded program
     std::unique_ptr<Window> window_;
     bool running_;
     int targetFPS_;
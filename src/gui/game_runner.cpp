@@ -39,9 +39,9 @@ int main(int argc, char* argv[]) {
 
     // Compile
     Compiler compiler;
-    std::vector<std::string> bytecode;
+    const Bytecode* program = nullptr;
     try {
-        bytecode = compiler.compile(source);
+        program = &compiler.compileProgram(source);
     } catch (const std::exception& ex) {
         std::cerr << "Compilation failed with exception: " << ex.what() << std::endl;
         return 1;
@@ -55,7 +55,7 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    if (bytecode.empty()) {
+    if (program->empty()) {
         std::cerr << "Compilation produced no bytecode." << std::endl;
         return 1;
     }
@@ -66,16 +66,14 @@ int main(int argc, char* argv[]) {
     // Create VM and load bytecode
     VM vm;
     try {
-        // Preprocess labels and initialize VM state if available
-        vm.preprocess(bytecode);
-        vm.run(bytecode); // run top-level initialization if needed
+        vm.run(*program); // run top-level initialization if needed
     } catch (const std::exception& ex) {
         std::cerr << "Runtime error during VM initialization: " << ex.what() << std::endl;
         return 1;
     }
 
     // Create and run game loop
-    GameLoop gameLoop(vm, bytecode, width, height, "CineBrew Game");
+    GameLoop gameLoop(vm, width, height, "CineBrew Game");
     gameLoop.setTargetFPS(60);
 
     if (!gameLoop.isRunning()) {
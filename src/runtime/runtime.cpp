@@ -171,14 +171,14 @@ void Runtime::initializeBuiltins() {
     builtins_["input"] = RuntimeFunction("input", 0, inputImpl);
     builtins_["random"] = RuntimeFunction("random", 1, randomImpl);
     builtins_["time"] = RuntimeFunction("time", 0, timeImpl);
-    builtins_["abs"] = RuntimeFunction("abs", 1, absImpl);
-    builtins_["min"] = RuntimeFunction("min", 2, minImpl);
-    builtins_["max"] = RuntimeFunction("max", 2, maxImpl);
+    builtins_["abs"] = RuntimeFunction("abs", 1, absImpl, Purity::PURE);
+    builtins_["min"] = RuntimeFunction("min", 2, minImpl, Purity::PURE);
+    builtins_["max"] = RuntimeFunction("max", 2, maxImpl, Purity::PURE);
     
-    // Game-related functions
-    builtins_["keyPressed"] = RuntimeFunction("keyPressed", 1, keyPressedImpl);
-    builtins_["getScreenWidth"] = RuntimeFunction("getScreenWidth", 0, getScreenWidthImpl);
-    builtins_["getScreenHeight"] = RuntimeFunction("getScreenHeight", 0, getScreenHeightImpl);
+    // Game-related functions (window events are only processed between frames)
+    builtins_["keyPressed"] = RuntimeFunction("keyPressed", 1, keyPressedImpl, Purity::FRAME_STABLE);
+    builtins_["getScreenWidth"] = RuntimeFunction("getScreenWidth", 0, getScreenWidthImpl, Purity::FRAME_STABLE);
+    builtins_["getScreenHeight"] = RuntimeFunction("getScreenHeight", 0, getScreenHeightImpl, Purity::FRAME_STABLE);
     
     // Rendering functions
     builtins_["clearScreen"] = RuntimeFunction("clearScreen", 0, clearScreenImpl);
@@ -212,6 +212,14 @@ int Runtime::getParamCount(const std::string& name) const {
     return -1;
 }
 
+Purity Runtime::getPurity(const std::string& name) const {
+    auto it = builtins_.find(name);
+    if (it != builtins_.end()) {
+        return it->second.purity;
+    }
+    return Purity::EFFECTFUL;
+}
+
 int Runtime::call(const std::string& name, std::vector<int>& args) {
     RuntimeFunction* func = getBuiltin(name);
     if (!func) {
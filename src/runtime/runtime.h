@@ -14,15 +14,25 @@
 // Forward declaration of Window (defined in gui)
 class Window;
 
+// What a built-in may do, as far as the optimizer is concerned
+enum class Purity {
+    PURE,           // Result depends only on the arguments: abs, min, max
+    FRAME_STABLE,   // No effects; same result until the game loop starts the
+                    // next frame (screen size, key state)
+    EFFECTFUL       // Anything else: I/O, drawing, random(), time()
+};
+
 // Represents a built-in runtime function
 struct RuntimeFunction {
     std::string name;
     int paramCount;
     std::function<int(std::vector<int>&)> func;
+    Purity purity;
 
-    RuntimeFunction() : name(""), paramCount(0), func(nullptr) {}
-    RuntimeFunction(const std::string& n, int params, std::function<int(std::vector<int>&)> f)
-        : name(n), paramCount(params), func(f) {}
+    RuntimeFunction() : name(""), paramCount(0), func(nullptr), purity(Purity::EFFECTFUL) {}
+    RuntimeFunction(const std::string& n, int params, std::function<int(std::vector<int>&)> f,
+                    Purity p = Purity::EFFECTFUL)
+        : name(n), paramCount(params), func(f), purity(p) {}
 };
 
 class Runtime {
@@ -32,17 +42,13 @@ public:
     bool isBuiltin(const std::string& name) const;
     RuntimeFunction* getBuiltin(const std::string& name);
     int getParamCount(const std::string& name) const;
+    Purity getPurity(const std::string& name) const;  // EFFECTFUL if unknown
     int call(const std::string& name, std::vector<int>& args);
 
     // Set a Window reference for graphics-related builtins
     static void setWindow(Window* window);
 
-private:
-    std::unordered_map<std::string, RuntimeFunction> builtins_;
-
-    void initializeBuiltins();
-
-    // Built-in implementations
+    // Built-in implementations (called directly by `cinebrew aot` output)
     static int printImpl(std::vector<int>& args);
     static int inputImpl(std::vector<int>& args);
     static int randomImpl(std::vector<int>& args);
@@ -61,6 +67,11 @@ private:
     static int drawCircleImpl(std::vector<int>& args);
     static int drawLineImpl(std::vector<int>& args);
 
+private:
+    std::unordered_map<std::string, RuntimeFunction> builtins_;
+
+    void initializeBuiltins();
+
     static Window* window_;
 };
 
@@ -0,0 +1,615 @@
+/**
+ * CINEBREW Bytecode - Implementation
+ *
+ * Building, backpatching, the text form (assembler / disassembler) and the
+ * embedded form (C++ headers).
+ */
+
+#include "bytecode.h"
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+// ============================================================================
+// OPCODE TABLE
+// ============================================================================
+//
+// In the order of Op. Operand kinds of a and b: 'i' integer, 'I' integer
+// that defaults to 0, 'n' symbol, 'l' label (jumps), 0 none. PUSHSTR, FPUSH,
+// FORPREP, FORLOOP and JMPTABLE have their own cases.
+
+struct OpInfo {
+    const char* name;
+    char a;
+    char b;
+};
+
+static const OpInfo OPS[] = {
+    {"", 0, 0}, {"", 0, 0}, {"", 0, 0},  // NOP, LABEL, INVALID
+    {"PUSH", 'i', 0}, {"PUSH", 'n', 0}, {"FPUSH", 0, 0},
+    {"DUP", 0, 0}, {"POP", 0, 0}, {"SWAP", 0, 0},
+    {"ADD", 0, 0}, {"SUB", 0, 0}, {"MUL", 0, 0}, {"NEG", 0, 0},
+    {"DIV", 0, 0}, {"MOD", 0, 0}, {"DIVNZ", 0, 0}, {"MODNZ", 0, 0},
+    {"BAND", 0, 0}, {"BOR", 0, 0}, {"BXOR", 0, 0}, {"SHL", 0, 0}, {"SHR", 0, 0},
+    {"FADD", 0, 0}, {"FSUB", 0, 0}, {"FMUL", 0, 0}, {"FDIV", 0, 0},
+    {"FEQ", 0, 0}, {"FNE", 0, 0}, {"FGT", 0, 0}, {"FLT", 0, 0}, {"FGE", 0, 0}, {"FLE", 0, 0},
+    {"XMUL", 0, 0}, {"XDIV", 0, 0}, {"XDIVNZ", 0, 0},
+    {"I2F", 0, 0}, {"F2I", 0, 0}, {"I2X", 0, 0}, {"X2I", 0, 0}, {"F2X", 0, 0}, {"X2F", 0, 0},
+    {"LOAD", 'n', 0}, {"STORE", 'n', 0}, {"LOADLOCAL", 'i', 0}, {"STORELOCAL", 'i', 0},
+    {"EQ", 0, 0}, {"NE", 0, 0}, {"GT", 0, 0}, {"LT", 0, 0}, {"GE", 0, 0}, {"LE", 0, 0},
+    {"JMP", 'l', 0}, {"JZ", 'l', 0}, {"JNZ", 'l', 0},
+    {"JMPTABLE", 0, 0}, {"FORPREP", 0, 0}, {"FORLOOP", 0, 0},
+    {"INC", 'n', 'i'}, {"INCLOCAL", 'i', 'i'},
+    {"JEQ", 'l', 0}, {"JNE", 'l', 0}, {"JLT", 'l', 0}, {"JGT", 'l', 0}, {"JLE", 'l', 0}, {"JGE", 'l', 0},
+    {"PROFBR", 'n', 0}, {"PROFLOOP", 'n', 0},
+    {"CALL", 'n', 'I'}, {"LOADARG", 'i', 0}, {"LOADARGU", 'i', 0}, {"STOREARG", 'i', 0},
+    {"ENTER", 'I', 0}, {"RET", 0, 0}, {"MEMOGET", 'n', 0}, {"MEMOPUT", 'n', 0},
+    {"COMPILE", 'n', 0},
+    {"NEWOBJ", 0, 0}, {"GETPROP", 'n', 'i'}, {"SETPROP", 'n', 'i'}, {"INITPROP", 'n', 'i'},
+    {"PRINT", 0, 0}, {"FPRINT", 0, 0}, {"XPRINT", 0, 0},
+};
+
+static_assert(sizeof(OPS) / sizeof(OPS[0]) == (size_t)Op::COUNT, "OPS must list every Op");
+
+const unsigned char Instruction::LIMIT_NAME;
+const unsigned char Instruction::STEP_NAME;
+const int Instruction::BUILTIN;
+
+const char* Bytecode::opName(Op op) {
+    return OPS[(int)op].name;
+}
+
+bool Bytecode::lookupOp(const std::string& name, Op& op) {
+    static std::unordered_map<std::string, Op> byName;
+    if (byName.empty()) {
+        for (int i = (int)Op::PUSH; i < (int)Op::COUNT; i++) {
+            if ((Op)i != Op::PUSHSTR) byName[OPS[i].name] = (Op)i;
+        }
+    }
+    auto it = byName.find(name);
+    if (it == byName.end()) return false;
+    op = it->second;
+    return true;
+}
+
+// ============================================================================
+// SYMBOLS AND LABELS
+// ============================================================================
+
+int Bytecode::symbol(const std::string& text) {
+    auto it = symbolIds_.find(text);
+    if (it != symbolIds_.end()) return it->second;
+    int id = (int)symbols.size();
+    symbols.push_back(text);
+    symbolIds_[text] = id;
+    return id;
+}
+
+int Bytecode::namedLabel(const std::string& name) {
+    int sym = symbol(name);
+    auto it = namedLabels_.find(sym);
+    if (it != namedLabels_.end()) return it->second;
+    int id = (int)labels.size();
+    labels.push_back({sym, nullptr, -1, -1});
+    namedLabels_[sym] = id;
+    return id;
+}
+
+int Bytecode::newLabel(const char* prefix) {
+    labels.push_back({-1, prefix, -1, -1});
+    return (int)labels.size() - 1;
+}
+
+// The prefixes of a compiled Bytecode are string literals; others (IR
+// block hints, a file's prefixes) are kept here, a handful of distinct
+// words that must outlive every Bytecode naming them
+const char* Bytecode::internPrefix(const std::string& prefix) {
+    static std::unordered_set<std::string> prefixes;
+    return prefixes.insert(prefix).first->c_str();
+}
+
+std::string Bytecode::labelName(int label) const {
+    const Label& l = labels[label];
+    if (l.name >= 0) return symbols[l.name];
+    return std::string(l.prefix) + "_" + std::to_string(label);
+}
+
+int Bytecode::findLabel(const std::string& name) const {
+    auto sym = symbolIds_.find(name);
+    if (sym == symbolIds_.end()) return -1;
+    auto label = namedLabels_.find(sym->second);
+    return label == namedLabels_.end() ? -1 : labels[label->second].pc;
+}
+
+void Bytecode::setArity(const std::string& scene, int argc) {
+    auto sym = symbolIds_.find(scene);
+    if (sym == symbolIds_.end()) return;
+    auto label = namedLabels_.find(sym->second);
+    if (label != namedLabels_.end()) labels[label->second].arity = argc;
+}
+
+int Bytecode::arity(const std::string& scene) const {
+    auto sym = symbolIds_.find(scene);
+    if (sym == symbolIds_.end()) return -1;
+    auto label = namedLabels_.find(sym->second);
+    return label == namedLabels_.end() ? -1 : labels[label->second].arity;
+}
+
+// ============================================================================
+// BUILDING
+// ============================================================================
+
+void Bytecode::emit(Op op, int a, int b, int c) {
+    code.push_back({op, 0, false, a, b, c, -1, -1});
+    if (op == Op::CALL) patches_.push_back((int)code.size() - 1);
+}
+
+void Bytecode::emitJump(Op op, int label) {
+    code.push_back({op, 0, false, 0, 0, 0, label, -1});
+    patches_.push_back((int)code.size() - 1);
+}
+
+void Bytecode::emitFor(Op op, int var, int limit, bool limitIsName, int step, bool stepIsName,
+                       int label) {
+    unsigned char names = (limitIsName ? Instruction::LIMIT_NAME : 0) |
+                          (stepIsName ? Instruction::STEP_NAME : 0);
+    code.push_back({op, names, false, var, limit, step, label, -1});
+    patches_.push_back((int)code.size() - 1);
+}
+
+void Bytecode::emitTable(int min, int defaultLabel, const std::vector<int>& entries) {
+    code.push_back({Op::JMPTABLE, 0, false, min, (int)tables.size(), (int)entries.size(), defaultLabel, -1});
+    tables.insert(tables.end(), entries.begin(), entries.end());
+    patches_.push_back((int)code.size() - 1);
+}
+
+void Bytecode::place(int label) {
+    labels[label].pc = (int)code.size();
+    code.push_back({Op::LABEL, 0, false, 0, 0, 0, label, -1});
+}
+
+/**
+ * Backpatch: every jump gets the pc of its label, every CALL the pc of the
+ * SCENE's label (built-ins have none and keep -1).
+ */
+void Bytecode::link() {
+    for (int pc : patches_) {
+        Instruction& instruction = code[pc];
+        if (instruction.op == Op::CALL) {
+            auto label = namedLabels_.find(instruction.a);
+            instruction.target = label == namedLabels_.end() ? -1 : labels[label->second].pc;
+        } else {
+            instruction.target = labels[instruction.label].pc;
+        }
+    }
+    patches_.clear();
+}
+
+// The operands of `instruction` that are symbols
+static int symbolOperands(Instruction& instruction, int* operands[3]) {
+    int count = 0;
+    switch (instruction.op) {
+        case Op::INVALID:
+        case Op::PUSHSTR:
+            operands[count++] = &instruction.a;
+            break;
+        case Op::FPUSH:
+            operands[count++] = &instruction.b;
+            break;
+        case Op::FORPREP:
+        case Op::FORLOOP:
+            operands[count++] = &instruction.a;
+            if (instruction.names & Instruction::LIMIT_NAME) operands[count++] = &instruction.b;
+            if (instruction.names & Instruction::STEP_NAME) operands[count++] = &instruction.c;
+            break;
+        case Op::JMPTABLE:
+            break;
+        default:
+            if (OPS[(int)instruction.op].a == 'n') operands[count++] = &instruction.a;
+            if (OPS[(int)instruction.op].b == 'n') operands[count++] = &instruction.b;
+            break;
+    }
+    return count;
+}
+
+/**
+ * Passes that delete instructions leave symbols, labels and JMPTABLE
+ * entries behind that nothing uses any more, and label pcs that no longer
+ * hold. Keep what the code still refers to (in the same order), place
+ * every label again at its LABEL instruction and queue every jump and
+ * CALL for link().
+ */
+void Bytecode::compact() {
+    std::vector<int> symbolIds(symbols.size(), -1);
+    std::vector<int> labelIds(labels.size(), -1);
+    int* operands[3];
+    for (Instruction& instruction : code) {
+        for (int i = 0, n = symbolOperands(instruction, operands); i < n; i++) symbolIds[*operands[i]] = 0;
+        if (instruction.label >= 0) labelIds[instruction.label] = 0;
+        for (int i = 0; instruction.op == Op::JMPTABLE && i < instruction.c; i++) {
+            labelIds[tables[instruction.b + i]] = 0;
+        }
+    }
+    for (size_t l = 0; l < labels.size(); l++) {
+        if (labelIds[l] == 0 && labels[l].name >= 0) symbolIds[labels[l].name] = 0;
+    }
+
+    std::vector<std::string> keptSymbols;
+    symbolIds_.clear();
+    for (size_t s = 0; s < symbols.size(); s++) {
+        if (symbolIds[s] < 0) continue;
+        symbolIds[s] = (int)keptSymbols.size();
+        symbolIds_[symbols[s]] = symbolIds[s];
+        keptSymbols.push_back(std::move(symbols[s]));
+    }
+    std::vector<Label> keptLabels;
+    namedLabels_.clear();
+    for (size_t l = 0; l < labels.size(); l++) {
+        if (labelIds[l] < 0) continue;
+        Label label = labels[l];
+        labelIds[l] = (int)keptLabels.size();
+        label.pc = -1;
+        if (label.name >= 0) {
+            label.name = symbolIds[label.name];
+            namedLabels_[label.name] = labelIds[l];
+        }
+        keptLabels.push_back(label);
+    }
+
+    std::vector<int> keptTables;
+    patches_.clear();
+    for (int pc = 0; pc < (int)code.size(); pc++) {
+        Instruction& instruction = code[pc];
+        for (int i = 0, n = symbolOperands(instruction, operands); i < n; i++) *operands[i] = symbolIds[*operands[i]];
+        if (instruction.label >= 0) instruction.label = labelIds[instruction.label];
+        if (instruction.op == Op::JMPTABLE) {
+            int first = (int)keptTables.size();
+            for (int i = 0; i < instruction.c; i++) keptTables.push_back(labelIds[tables[instruction.b + i]]);
+            instruction.b = first;
+        }
+        if (instruction.op == Op::LABEL) {
+            keptLabels[instruction.label].pc = pc;
+        } else if (instruction.label >= 0 || instruction.op == Op::CALL) {
+            patches_.push_back(pc);
+        }
+    }
+
+    symbols.swap(keptSymbols);
+    labels.swap(keptLabels);
+    tables.swap(keptTables);
+}
+
+// ============================================================================
+// ASSEMBLER
+// ============================================================================
+
+// Words of a line; a quoted part stays one word (with its quotes)
+static std::vector<std::string> split(const std::string& s) {
+    std::vector<std::string> parts;
+    std::string cur;
+    bool inQuote = false;
+    for (char c : s) {
+        if (c == '"') {
+            inQuote = !inQuote;
+            cur.push_back(c);
+        } else if (std::isspace(static_cast<unsigned char>(c)) && !inQuote) {
+            if (!cur.empty()) {
+                parts.push_back(cur);
+                cur.clear();
+            }
+        } else {
+            cur.push_back(c);
+        }
+    }
+    if (!cur.empty()) parts.push_back(cur);
+    return parts;
+}
+
+static bool parseInt(const std::string& text, int& value) {
+    try {
+        value = std::stoi(text);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// The text of PUSH "some words": everything after the opcode, unquoted
+static std::string literalText(const std::string& line) {
+    size_t start = line.find_first_of(" \t");
+    std::string literal = start == std::string::npos ? "" : line.substr(start + 1);
+    while (!literal.empty() && std::isspace(static_cast<unsigned char>(literal.front()))) literal.erase(literal.begin());
+    while (!literal.empty() && std::isspace(static_cast<unsigned char>(literal.back()))) literal.pop_back();
+    if (literal.size() >= 2 && literal.front() == '"' && literal.back() == '"') {
+        literal = literal.substr(1, literal.size() - 2);
+    }
+    return literal;
+}
+
+// Quoted when the bare text would read back as a label or a number
+std::string Bytecode::quoteLiteral(const std::string& literal) {
+    std::string text = literalText("PUSH " + literal);
+    int number;
+    bool bare = !text.empty() && text.back() != ':' && !parseInt(text, number);
+    return bare ? text : "\"" + text + "\"";
+}
+
+Bytecode Bytecode::assemble(const std::vector<std::string>& text) {
+    Bytecode program;
+    program.code.reserve(text.size());
+
+    for (const std::string& line : text) {
+        if (line.empty()) {
+            program.emit(Op::NOP);
+            continue;
+        }
+        if (line.back() == ':') {
+            program.place(program.namedLabel(line.substr(0, line.size() - 1)));
+            continue;
+        }
+
+        std::vector<std::string> parts = split(line);
+        Op op;
+        if (parts.empty() || !lookupOp(parts[0], op)) {
+            program.emit(parts.empty() ? Op::NOP : Op::INVALID, program.symbol(line));
+            continue;
+        }
+
+        // Operands present and readable?
+        bool ok = true;
+        Instruction instruction = {op, 0, false, 0, 0, 0, -1, -1};
+        if (op == Op::PUSH) {
+            ok = parts.size() >= 2;
+            if (ok && !parseInt(parts[1], instruction.a)) {
+                instruction.op = Op::PUSHSTR;
+                instruction.a = program.symbol(literalText(line));
+            }
+        } else if (op == Op::FPUSH) {
+            ok = parts.size() >= 2;
+            if (ok) {
+                try {
+                    float value = std::stof(parts[1]);
+                    std::memcpy(&instruction.a, &value, sizeof(value));
+                    instruction.b = program.symbol(parts[1]);
+                } catch (const std::exception&) {
+                    ok = false;
+                }
+            }
+        } else if (op == Op::FORPREP || op == Op::FORLOOP) {
+            ok = parts.size() >= 5;
+            if (ok) {
+                instruction.a = program.symbol(parts[1]);
+                for (int i = 0; i < 2 && ok; i++) {
+                    // An immediate ("10", "-1") or a variable name
+                    const std::string& operand = parts[2 + i];
+                    int& field = i == 0 ? instruction.b : instruction.c;
+                    if (std::isdigit(static_cast<unsigned char>(operand[0])) || operand[0] == '-') {
+                        ok = parseInt(operand, field);
+                    } else {
+                        field = program.symbol(operand);
+                        instruction.names |= i == 0 ? Instruction::LIMIT_NAME : Instruction::STEP_NAME;
+                    }
+                }
+                instruction.label = program.namedLabel(parts[4]);
+            }
+        } else if (op == Op::JMPTABLE) {
+            ok = parts.size() >= 3 && parseInt(parts[1], instruction.a);
+            if (ok) {
+                instruction.b = (int)program.tables.size();
+                instruction.c = (int)parts.size() - 3;
+                instruction.label = program.namedLabel(parts[2]);
+                for (size_t i = 3; i < parts.size(); i++) {
+                    program.tables.push_back(program.namedLabel(parts[i]));
+                }
+            }
+        } else {
+            const OpInfo& info = OPS[(int)op];
+            char kinds[2] = {info.a, info.b};
+            int* fields[2] = {&instruction.a, &instruction.b};
+            for (int i = 0; i < 2 && ok && kinds[i]; i++) {
+                if ((int)parts.size() <= 1 + i) {
+                    ok = kinds[i] == 'I';
+                } else if (kinds[i] == 'n') {
+                    *fields[i] = program.symbol(parts[1 + i]);
+                } else if (kinds[i] == 'l') {
+                    instruction.label = program.namedLabel(parts[1 + i]);
+                } else {
+                    ok = parseInt(parts[1 + i], *fields[i]);
+                }
+            }
+        }
+
+        if (!ok) {
+            program.emit(Op::INVALID, program.symbol(line));
+            continue;
+        }
+        program.code.push_back(instruction);
+        if (instruction.label >= 0 || op == Op::CALL) {
+            program.patches_.push_back((int)program.code.size() - 1);
+        }
+    }
+
+    program.link();
+    return program;
+}
+
+// ============================================================================
+// DISASSEMBLER
+// ============================================================================
+
+std::string Bytecode::disassemble(int pc) const {
+    return disassemble(code[pc]);
+}
+
+std::string Bytecode::disassemble(const Instruction& instruction) const {
+    std::string text = opName(instruction.op);
+    switch (instruction.op) {
+        case Op::NOP:
+            return "";
+        case Op::LABEL:
+            return labelName(instruction.label) + ":";
+        case Op::INVALID:
+            return symbols[instruction.a];
+        case Op::PUSHSTR:
+            return text + " " + quoteLiteral(symbols[instruction.a]);
+        case Op::FPUSH:
+            return text + " " + symbols[instruction.b];
+        case Op::FORPREP:
+        case Op::FORLOOP: {
+            bool limitName = instruction.names & Instruction::LIMIT_NAME;
+            bool stepName = instruction.names & Instruction::STEP_NAME;
+            return text + " " + symbols[instruction.a] + " " +
+                   (limitName ? symbols[instruction.b] : std::to_string(instruction.b)) + " " +
+                   (stepName ? symbols[instruction.c] : std::to_string(instruction.c)) + " " +
+                   labelName(instruction.label);
+        }
+        case Op::JMPTABLE:
+            text += " " + std::to_string(instruction.a) + " " + labelName(instruction.label);
+            for (int i = 0; i < instruction.c; i++) {
+                text += " " + labelName(tables[instruction.b + i]);
+            }
+            return text;
+        default:
+            break;
+    }
+
+    const OpInfo& info = OPS[(int)instruction.op];
+    char kinds[2] = {info.a, info.b};
+    int fields[2] = {instruction.a, instruction.b};
+    for (int i = 0; i < 2 && kinds[i]; i++) {
+        if (kinds[i] == 'n') text += " " + symbols[fields[i]];
+        else if (kinds[i] == 'l') text += " " + labelName(instruction.label);
+        else text += " " + std::to_string(fields[i]);
+    }
+    return text;
+}
+
+std::vector<std::string> Bytecode::disassemble() const {
+    std::vector<std::string> text;
+    text.reserve(code.size());
+    for (int pc = 0; pc < (int)code.size(); pc++) {
+        text.push_back(disassemble(pc));
+    }
+    return text;
+}
+
+// ============================================================================
+// EMBEDDED FORM (cinebrew embed)
+// ============================================================================
+
+static std::string cString(const std::string& text) {
+    std::string quoted = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += (char)c;
+        } else if (c < 0x20 || c == 0x7f) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\%03o", c);
+            quoted += escape;
+        } else {
+            quoted += (char)c;
+        }
+    }
+    return quoted + "\"";
+}
+
+static std::string cInt(int value) {
+    return value == INT_MIN ? "-2147483647 - 1" : std::to_string(value);
+}
+
+// The enumerator: OPS has the text names, which PUSHSTR shares with PUSH
+static std::string opEnumerator(Op op) {
+    switch (op) {
+        case Op::NOP: return "Op::NOP";
+        case Op::LABEL: return "Op::LABEL";
+        case Op::INVALID: return "Op::INVALID";
+        case Op::PUSHSTR: return "Op::PUSHSTR";
+        default: return std::string("Op::") + OPS[(int)op].name;
+    }
+}
+
+/**
+ * The linked program as a header for the host's build: `inline constexpr`
+ * arrays (one definition however many files include it), each instruction
+ * commented with its text form.
+ */
+std::string Bytecode::toHeader(const std::string& name, const std::string& sourceName) const {
+    std::string guard = "CINEBREW_EMBED_";
+    for (char c : name) guard += (char)std::toupper(static_cast<unsigned char>(c));
+    guard += "_H";
+
+    std::string out;
+    out += "// Generated by cinebrew embed from " + sourceName + ": do not edit.\n";
+    out += "// Load it with Bytecode::fromEmbedded(" + name + "::program).\n\n";
+    out += "#ifndef " + guard + "\n#define " + guard + "\n\n";
+    out += "#include \"vm/bytecode.h\"\n\n";
+    out += "namespace " + name + " {\n\n";
+
+    out += "inline constexpr Instruction code[] = {\n";
+    for (int pc = 0; pc < (int)code.size(); pc++) {
+        const Instruction& i = code[pc];
+        std::string text = disassemble(pc);
+        for (char& c : text) {
+            if (c == '\n' || c == '\r') c = ' ';
+        }
+        out += "    {" + opEnumerator(i.op) + ", " + std::to_string(i.names) + ", " +
+               (i.statement ? "true" : "false") + ", " + cInt(i.a) + ", " + cInt(i.b) + ", " + cInt(i.c) +
+               ", " + cInt(i.label) + ", " + cInt(i.target) + "},  // " + text + "\n";
+    }
+    if (code.empty()) out += "    {Op::NOP, 0, false, 0, 0, 0, -1, -1},\n";
+    out += "};\n\n";
+
+    out += "inline constexpr const char* symbols[] = {\n";
+    for (const std::string& symbol : symbols) out += "    " + cString(symbol) + ",\n";
+    if (symbols.empty()) out += "    \"\",\n";
+    out += "};\n\n";
+
+    out += "inline constexpr Bytecode::Label labels[] = {\n";
+    for (const Label& label : labels) {
+        out += "    {" + std::to_string(label.name) + ", " + (label.prefix ? cString(label.prefix) : "nullptr") +
+               ", " + std::to_string(label.pc) + ", " + std::to_string(label.arity) + "},\n";
+    }
+    if (labels.empty()) out += "    {-1, nullptr, -1, -1},\n";
+    out += "};\n\n";
+
+    if (!tables.empty()) {
+        out += "inline constexpr int tables[] = {";
+        for (size_t i = 0; i < tables.size(); i++) out += (i > 0 ? ", " : "") + std::to_string(tables[i]);
+        out += "};\n\n";
+    }
+
+    // The arrays of an empty part hold one unused entry (C++ has no empty arrays)
+    out += "inline constexpr EmbeddedBytecode program = {\n";
+    out += "    code, " + std::to_string(code.size()) + ",\n";
+    out += "    symbols, " + std::to_string(symbols.size()) + ",\n";
+    out += "    labels, " + std::to_string(labels.size()) + ",\n";
+    out += std::string("    ") + (tables.empty() ? "nullptr" : "tables") + ", " + std::to_string(tables.size()) + ",\n";
+    out += "};\n\n";
+
+    out += "}  // namespace " + name + "\n\n#endif  // " + guard + "\n";
+    return out;
+}
+
+/**
+ * A program written by toHeader(): copies the arrays, and rebuilds the
+ * symbol and label lookups (the pcs are linked already).
+ */
+Bytecode Bytecode::fromEmbedded(const EmbeddedBytecode& embedded) {
+    Bytecode program;
+    program.code.assign(embedded.code, embedded.code + embedded.codeSize);
+    program.symbols.reserve(embedded.symbolCount);
+    for (int i = 0; i < embedded.symbolCount; i++) {
+        program.symbols.push_back(embedded.symbols[i]);
+        program.symbolIds_.emplace(program.symbols.back(), i);
+    }
+    program.labels.assign(embedded.labels, embedded.labels + embedded.labelCount);
+    for (int i = 0; i < embedded.labelCount; i++) {
+        if (program.labels[i].name >= 0) program.namedLabels_[program.labels[i].name] = i;
+    }
+    if (embedded.tables) program.tables.assign(embedded.tables, embedded.tables + embedded.tableCount);
+    return program;
+}
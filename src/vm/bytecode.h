@@ -0,0 +1,171 @@
+/**
+ * CINEBREW Bytecode - Header
+ * The typed instruction buffer the code generator fills and the VM runs.
+ *
+ * ============================================================================
+ * WHY NOT TEXT?
+ * ============================================================================
+ *
+ * Bytecode used to be a list of strings ("CALL add 2"): the code generator
+ * concatenated them and the VM split every one of them again each time it
+ * ran. A Bytecode is the same program already decoded:
+ *
+ *   "CALL add 2"   →   { op = CALL, a = symbol "add", b = 2, target = pc of add: }
+ *   "JZ else_4"    →   { op = JZ, label = 4, target = pc of else_4: }
+ *
+ * Names (variables, SCENEs, properties, profile sites, string literals)
+ * are interned once in a symbol table; operands refer to them by index.
+ * Jumps refer to labels by id while the code is generated and are
+ * backpatched with the label's pc by link(). Labels stay in the
+ * instruction stream (as LABEL) so that pcs match the text form line for
+ * line.
+ *
+ * Text only exists on request: disassemble() prints the instructions in
+ * the format of instructions.h, and assemble() reads that format back.
+ * The bytecode passes of optimized builds (dead code, peephole) rewrite
+ * `code` directly; compact() then drops the symbols, labels and table
+ * entries nothing refers to any more and places the labels again, so
+ * link() can backpatch the result.
+ *
+ * A host that always runs the same script can compile it while the host
+ * itself is built (`cinebrew embed`): toHeader() writes the arrays below
+ * as `constexpr` data of a C++ header, and fromEmbedded() turns them back
+ * into a Bytecode at startup without lexing, parsing or code generation.
+ *
+ * OPERANDS (a, b, c; `label` and `target` for anything that jumps):
+ *
+ *   PUSH n, LOADLOCAL k, ENTER n, ...   a = n
+ *   PUSHSTR                              a = symbol of the text ("PUSH text")
+ *   FPUSH x                              a = float bits, b = symbol of "x"
+ *   LOAD x, STORE x, MEMOGET s, PROFBR s a = symbol
+ *   INC x n, INCLOCAL k n                a = symbol / slot, b = n
+ *   GETPROP name site, ...               a = symbol of name, b = site
+ *   CALL f argc                          a = symbol of f, b = argc, target = pc of f (-1: none)
+ *   JMP / JZ / JNZ / J<cmp> l            label = l
+ *   FORPREP / FORLOOP v lim step l       a = symbol of v, b = lim, c = step, label = l;
+ *                                        `names` says which of b / c are symbols
+ *   JMPTABLE min default l0 l1 ...       a = min, b = first entry in tables, c = entries,
+ *                                        label = default
+ *   LABEL l:                             label = l
+ *   INVALID                              a = symbol of the line (unknown opcode or operands)
+ *
+ * ============================================================================
+ */
+
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+struct EmbeddedBytecode;
+
+// Every opcode of instructions.h, plus the lines that are not instructions
+enum class Op : unsigned char {
+    NOP,      // Empty line
+    LABEL,    // "name:"
+    INVALID,  // A line the VM cannot run (reported when reached)
+
+    PUSH, PUSHSTR, FPUSH, DUP, POP, SWAP,
+    ADD, SUB, MUL, NEG, DIV, MOD, DIVNZ, MODNZ,
+    BAND, BOR, BXOR, SHL, SHR,
+    FADD, FSUB, FMUL, FDIV, FEQ, FNE, FGT, FLT, FGE, FLE,
+    XMUL, XDIV, XDIVNZ,
+    I2F, F2I, I2X, X2I, F2X, X2F,
+    LOAD, STORE, LOADLOCAL, STORELOCAL,
+    EQ, NE, GT, LT, GE, LE,
+    JMP, JZ, JNZ, JMPTABLE, FORPREP, FORLOOP,
+    INC, INCLOCAL, JEQ, JNE, JLT, JGT, JLE, JGE,
+    PROFBR, PROFLOOP,
+    CALL, LOADARG, LOADARGU, STOREARG, ENTER, RET, MEMOGET, MEMOPUT, COMPILE,
+    NEWOBJ, GETPROP, SETPROP, INITPROP,
+    PRINT, FPRINT, XPRINT,
+
+    COUNT
+};
+
+struct Instruction {
+    static const unsigned char LIMIT_NAME = 1;  // FORPREP / FORLOOP: b is a symbol
+    static const unsigned char STEP_NAME = 2;   // ... c is a symbol
+    static const int BUILTIN = -2;              // CALL target: a runtime built-in (set by the VM)
+
+    Op op;
+    unsigned char names;
+    bool statement;  // First instruction of a source statement (-O0 only; debug VMs check stack balance here)
+    int a, b, c;
+    int label;   // Label id, -1 if none
+    int target;  // Backpatched pc of `label` (or of the CALLed SCENE), -1 if unresolved
+};
+
+class Bytecode {
+public:
+    struct Label {
+        int name;            // Symbol, or -1: called "<prefix>_<id>"
+        const char* prefix;  // String literal
+        int pc;              // -1 until placed
+        int arity;           // SCENE entries: parameter count, -1 if unknown
+    };
+
+    std::vector<Instruction> code;
+    std::vector<std::string> symbols;
+    std::vector<Label> labels;
+    std::vector<int> tables;  // JMPTABLE entries (label ids)
+
+    size_t size() const { return code.size(); }
+    bool empty() const { return code.empty(); }
+
+    // Symbols and labels
+    int symbol(const std::string& text);         // Interned: same text, same id
+    int namedLabel(const std::string& name);     // The label `name:` (SCENE entries)
+    int newLabel(const char* prefix);            // A fresh label
+    static const char* internPrefix(const std::string& prefix);  // A prefix that is not a literal, kept for good
+    std::string labelName(int label) const;
+    int findLabel(const std::string& name) const;  // pc of `name:`, -1 if there is none
+    void setArity(const std::string& scene, int argc);  // Of an existing `scene:` label
+    int arity(const std::string& scene) const;          // -1 if unknown
+
+    // Building (the code generator); jumps are backpatched by link()
+    void emit(Op op, int a = 0, int b = 0, int c = 0);
+    void emitJump(Op op, int label);
+    void emitFor(Op op, int var, int limit, bool limitIsName, int step, bool stepIsName, int label);
+    void emitTable(int min, int defaultLabel, const std::vector<int>& entries);
+    void place(int label);
+    void link();
+    void compact();  // After passes rewrote `code`, before link()
+
+    // Text form (instructions.h)
+    static Bytecode assemble(const std::vector<std::string>& text);
+    std::string disassemble(int pc) const;
+    std::string disassemble(const Instruction& instruction) const;  // One that may live elsewhere (a mapped file)
+    std::vector<std::string> disassemble() const;
+
+    // Built into the host (`cinebrew embed`): a C++ header defining namespace
+    // `name` with the program as constexpr arrays, and the way back
+    std::string toHeader(const std::string& name, const std::string& sourceName) const;
+    static Bytecode fromEmbedded(const EmbeddedBytecode& embedded);
+
+    static std::string quoteLiteral(const std::string& literal);  // Operand of PUSH "text"
+    static const char* opName(Op op);
+    static bool lookupOp(const std::string& name, Op& op);
+
+private:
+    std::unordered_map<std::string, int> symbolIds_;
+    std::unordered_map<int, int> namedLabels_;  // Symbol -> label
+    std::vector<int> patches_;                  // pcs whose target waits for link()
+};
+
+// The arrays of a linked Bytecode, as written by toHeader(): constant data
+// in the host binary
+struct EmbeddedBytecode {
+    const Instruction* code;
+    int codeSize;
+    const char* const* symbols;
+    int symbolCount;
+    const Bytecode::Label* labels;
+    int labelCount;
+    const int* tables;  // nullptr if there are none
+    int tableCount;
+};
+
+#endif // BYTECODE_H
@@ -0,0 +1,304 @@
+/**
+ * CINEBREW Bytecode File - Implementation
+ *
+ * Writing .cbc files, and mapping them back for the VM.
+ */
+
+#include "bytecode_file.h"
+#include "../runtime/runtime.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct BytecodeFile::Header {
+    char magic[4];  // "CBC\0"
+    uint32_t version;
+    uint32_t instructionSize;
+    uint32_t opCount;
+    uint32_t codeCount, codeOffset;
+    uint32_t symbolCount, symbolOffset;
+    uint32_t labelCount, labelOffset;
+    uint32_t tableCount, tableOffset;
+    uint32_t stringSize, stringOffset;
+    uint32_t noteSize, noteOffset;
+};
+
+struct FileLabel {
+    int32_t name;
+    int32_t prefix;
+    int32_t pc;
+    int32_t arity;
+};
+
+static const char MAGIC[4] = {'C', 'B', 'C', '\0'};
+
+static size_t align8(size_t offset) {
+    return (offset + 7) & ~(size_t)7;
+}
+
+BytecodeFile::BytecodeFile()
+    : data_(nullptr), length_(0), header_(nullptr), code_(nullptr), codeSize_(0) {}
+
+BytecodeFile::~BytecodeFile() {
+    close();
+}
+
+// ============================================================================
+// WRITING (cinebrew compile)
+// ============================================================================
+
+// Field by field into zeroed bytes: the padding of an Instruction is not
+// copied, so the same program always gives the same file
+static void writeInstruction(char* out, const Instruction& instruction) {
+    std::memcpy(out + offsetof(Instruction, op), &instruction.op, sizeof(instruction.op));
+    std::memcpy(out + offsetof(Instruction, names), &instruction.names, sizeof(instruction.names));
+    std::memcpy(out + offsetof(Instruction, statement), &instruction.statement, sizeof(instruction.statement));
+    std::memcpy(out + offsetof(Instruction, a), &instruction.a, sizeof(instruction.a));
+    std::memcpy(out + offsetof(Instruction, b), &instruction.b, sizeof(instruction.b));
+    std::memcpy(out + offsetof(Instruction, c), &instruction.c, sizeof(instruction.c));
+    std::memcpy(out + offsetof(Instruction, label), &instruction.label, sizeof(instruction.label));
+    std::memcpy(out + offsetof(Instruction, target), &instruction.target, sizeof(instruction.target));
+}
+
+bool BytecodeFile::write(const Bytecode& program, const std::string& path, std::string& error,
+                         const std::string& note) {
+    std::vector<Instruction> code = program.code;
+    Runtime runtime;
+    for (Instruction& instruction : code) {
+        if (instruction.op == Op::CALL && runtime.isBuiltin(program.symbols[instruction.a])) {
+            instruction.target = Instruction::BUILTIN;
+        }
+    }
+
+    // Texts: the symbols, then every distinct label prefix
+    std::string strings;
+    std::vector<uint32_t> symbols;
+    for (const std::string& symbol : program.symbols) {
+        symbols.push_back((uint32_t)strings.size());
+        strings += symbol;
+        strings += '\0';
+    }
+    std::vector<FileLabel> labels;
+    std::unordered_map<std::string, int32_t> prefixes;
+    for (const Bytecode::Label& label : program.labels) {
+        int32_t prefix = -1;
+        if (label.prefix) {
+            auto it = prefixes.find(label.prefix);
+            if (it == prefixes.end()) {
+                it = prefixes.emplace(label.prefix, (int32_t)strings.size()).first;
+                strings += label.prefix;
+                strings += '\0';
+            }
+            prefix = it->second;
+        }
+        labels.push_back({label.name, prefix, label.pc, label.arity});
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.instructionSize = sizeof(Instruction);
+    header.opCount = (uint32_t)Op::COUNT;
+    size_t offset = align8(sizeof(Header));
+    header.codeCount = (uint32_t)code.size();
+    header.codeOffset = (uint32_t)offset;
+    offset = align8(offset + code.size() * sizeof(Instruction));
+    header.symbolCount = (uint32_t)symbols.size();
+    header.symbolOffset = (uint32_t)offset;
+    offset = align8(offset + symbols.size() * sizeof(uint32_t));
+    header.labelCount = (uint32_t)labels.size();
+    header.labelOffset = (uint32_t)offset;
+    offset = align8(offset + labels.size() * sizeof(FileLabel));
+    header.tableCount = (uint32_t)program.tables.size();
+    header.tableOffset = (uint32_t)offset;
+    offset = align8(offset + program.tables.size() * sizeof(int32_t));
+    header.stringSize = (uint32_t)strings.size();
+    header.stringOffset = (uint32_t)offset;
+    offset = align8(offset + strings.size());
+    header.noteSize = (uint32_t)note.size();
+    header.noteOffset = (uint32_t)offset;
+
+    std::string image(offset + note.size(), '\0');
+    std::memcpy(&image[0], &header, sizeof(Header));
+    for (size_t pc = 0; pc < code.size(); pc++) {
+        writeInstruction(&image[header.codeOffset + pc * sizeof(Instruction)], code[pc]);
+    }
+    if (!symbols.empty()) std::memcpy(&image[header.symbolOffset], symbols.data(), symbols.size() * sizeof(uint32_t));
+    if (!labels.empty()) std::memcpy(&image[header.labelOffset], labels.data(), labels.size() * sizeof(FileLabel));
+    if (!program.tables.empty()) {
+        std::memcpy(&image[header.tableOffset], program.tables.data(), program.tables.size() * sizeof(int32_t));
+    }
+    if (!strings.empty()) std::memcpy(&image[header.stringOffset], strings.data(), strings.size());
+    if (!note.empty()) std::memcpy(&image[header.noteOffset], note.data(), note.size());
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(image.data(), (std::streamsize)image.size());
+    if (!out) {
+        error = "could not write file: " + path;
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// MAPPING (cinebrew run x.cbc)
+// ============================================================================
+
+/**
+ * Maps the file and checks the header and the small sections; the code
+ * pages are not read until the VM runs them.
+ */
+bool BytecodeFile::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error_ = "could not open file: " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || (unsigned long long)size.QuadPart < sizeof(Header)) {
+        CloseHandle(file);
+        error_ = path + ": not a compiled CineBrew program";
+        return false;
+    }
+    // The view keeps the file mapped after both handles are closed
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    if (!data) {
+        error_ = "could not map file: " + path;
+        return false;
+    }
+    data_ = data;
+    length_ = (size_t)size.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = "could not open file: " + path;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(Header)) {
+        ::close(fd);
+        error_ = path + ": not a compiled CineBrew program";
+        return false;
+    }
+    void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        error_ = "could not map file: " + path;
+        return false;
+    }
+    data_ = data;
+    length_ = (size_t)info.st_size;
+#endif
+
+    const Header* header = static_cast<const Header*>(data_);
+    const char* base = static_cast<const char*>(data_);
+    auto fits = [&](uint32_t offset, uint32_t count, size_t size) {
+        return offset % 8 == 0 && offset <= length_ && count <= (length_ - offset) / size;
+    };
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error_ = path + ": not a compiled CineBrew program";
+    } else if (header->version != VERSION || header->instructionSize != sizeof(Instruction) ||
+               header->opCount != (uint32_t)Op::COUNT) {
+        error_ = path + ": compiled by another version of cinebrew (recompile it)";
+    } else if (!fits(header->codeOffset, header->codeCount, sizeof(Instruction)) ||
+               !fits(header->symbolOffset, header->symbolCount, sizeof(uint32_t)) ||
+               !fits(header->labelOffset, header->labelCount, sizeof(FileLabel)) ||
+               !fits(header->tableOffset, header->tableCount, sizeof(int32_t)) ||
+               !fits(header->stringOffset, header->stringSize, 1) ||
+               !fits(header->noteOffset, header->noteSize, 1) ||
+               (header->stringSize > 0 && base[header->stringOffset + header->stringSize - 1] != '\0')) {
+        error_ = path + ": truncated or corrupt";
+    }
+    if (error_.empty()) {
+        const uint32_t* symbols = reinterpret_cast<const uint32_t*>(base + header->symbolOffset);
+        const FileLabel* labels = reinterpret_cast<const FileLabel*>(base + header->labelOffset);
+        for (uint32_t i = 0; i < header->symbolCount && error_.empty(); i++) {
+            if (symbols[i] >= header->stringSize) error_ = path + ": truncated or corrupt";
+        }
+        for (uint32_t i = 0; i < header->labelCount && error_.empty(); i++) {
+            const FileLabel& label = labels[i];
+            if (label.name < -1 || label.name >= (int32_t)header->symbolCount ||
+                (label.prefix != -1 && (label.prefix < 0 || label.prefix >= (int32_t)header->stringSize)) ||
+                label.pc < -1 || label.pc > (int32_t)header->codeCount || label.arity < -1) {
+                error_ = path + ": truncated or corrupt";
+            }
+        }
+    }
+    if (!error_.empty()) {
+        std::string error = error_;
+        close();
+        error_ = error;
+        return false;
+    }
+
+    header_ = header;
+    code_ = reinterpret_cast<const Instruction*>(base + header->codeOffset);
+    codeSize_ = (int)header->codeCount;
+    return true;
+}
+
+void BytecodeFile::close() {
+#ifdef _WIN32
+    if (data_) UnmapViewOfFile(data_);
+#else
+    if (data_) munmap(data_, length_);
+#endif
+    data_ = nullptr;
+    length_ = 0;
+    header_ = nullptr;
+    code_ = nullptr;
+    codeSize_ = 0;
+    error_.clear();
+}
+
+// The symbols, labels and tables of the open file as a Bytecode without code
+
+Bytecode BytecodeFile::names() const {
+    if (!header_) return Bytecode();
+    const char* base = static_cast<const char*>(data_);
+    const char* strings = base + header_->stringOffset;
+
+    const uint32_t* offsets = reinterpret_cast<const uint32_t*>(base + header_->symbolOffset);
+    std::vector<const char*> symbols(header_->symbolCount);
+    for (uint32_t i = 0; i < header_->symbolCount; i++) symbols[i] = strings + offsets[i];
+
+    const FileLabel* fileLabels = reinterpret_cast<const FileLabel*>(base + header_->labelOffset);
+    std::vector<Bytecode::Label> labels(header_->labelCount);
+    for (uint32_t i = 0; i < header_->labelCount; i++) {
+        labels[i] = {fileLabels[i].name, fileLabels[i].prefix < 0 ? nullptr : Bytecode::internPrefix(strings + fileLabels[i].prefix),
+                     fileLabels[i].pc, fileLabels[i].arity};
+    }
+
+    EmbeddedBytecode parts = {nullptr, 0, symbols.data(), (int)symbols.size(), labels.data(), (int)labels.size(),
+                              reinterpret_cast<const int*>(base + header_->tableOffset), (int)header_->tableCount};
+    return Bytecode::fromEmbedded(parts);
+}
+
+std::string BytecodeFile::note() const {
+    if (!header_) return "";
+    return std::string(static_cast<const char*>(data_) + header_->noteOffset, header_->noteSize);
+}
+
+// The whole program, copied out of the mapping
+Bytecode BytecodeFile::program() const {
+    Bytecode program = names();
+    if (code_) program.code.assign(code_, code_ + codeSize_);
+    return program;
+}
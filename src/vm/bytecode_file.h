@@ -0,0 +1,91 @@
+/**
+ * CINEBREW Bytecode File - Header
+ * Compiled programs on disk (.cbc), run in place from a memory mapping.
+ *
+ * ============================================================================
+ * WHY A FILE?
+ * ============================================================================
+ *
+ * Running a .cb script lexes, parses, optimizes and generates it on every
+ * launch. `cinebrew compile` does that once and writes the linked Bytecode
+ * as a .cbc file:
+ *
+ *   cinebrew compile game.cb -o game.cbc
+ *   cinebrew run game.cbc
+ *
+ * open() maps the file read-only and the VM executes the instructions
+ * where they are (VM::load(const BytecodeFile&)): nothing is parsed or
+ * decoded, and the kernel only reads the pages of code that actually run.
+ * What is copied at load time is the symbol table, the labels and the
+ * JMPTABLE entries (the VM looks names up in them), not the code.
+ *
+ * ============================================================================
+ * LAYOUT (docs/BYTECODE_SPEC.md, "Binary Encoding")
+ * ============================================================================
+ *
+ *   Header    magic "CBC", version, sizeof(Instruction), Op::COUNT, and the
+ *             count and offset of each section below
+ *   code      Instruction[codeCount], exactly as in memory
+ *   symbols   uint32 offset into strings, one per symbol
+ *   labels    {int32 name, int32 prefix (offset into strings, -1: none), int32 pc,
+ *             int32 arity (-1: unknown)}
+ *   tables    int32[tableCount]
+ *   strings   NUL-terminated texts of the symbols and label prefixes
+ *   note      free text stored with the program (the compilation cache
+ *             keeps the full key of an entry there)
+ *
+ * Sections start at multiples of 8. The file is in the byte order and
+ * Instruction layout of the machine that wrote it; open() refuses a file
+ * whose header does not match this build. The code itself is trusted like
+ * the text form: operands are not checked when the file is opened (that
+ * would touch every page).
+ *
+ * ============================================================================
+ */
+
+#ifndef BYTECODE_FILE_H
+#define BYTECODE_FILE_H
+
+#include "bytecode.h"
+#include <cstddef>
+#include <string>
+
+class BytecodeFile {
+public:
+    static const unsigned VERSION = 3;
+
+    BytecodeFile();
+    ~BytecodeFile();
+    BytecodeFile(const BytecodeFile&) = delete;
+    BytecodeFile& operator=(const BytecodeFile&) = delete;
+
+    // A linked program; CALLs of runtime built-ins are resolved on the way
+    // (VM::load() does that for a Bytecode, but mapped code is read-only)
+    static bool write(const Bytecode& program, const std::string& path, std::string& error,
+                      const std::string& note = "");
+
+    bool open(const std::string& path);  // false (see getError) if unreadable or not a .cbc of this build
+    void close();
+    const std::string& getError() const { return error_; }
+
+    // The mapped instructions, valid until close()
+    const Instruction* code() const { return code_; }
+    int size() const { return codeSize_; }
+
+    // Everything but the code: symbols, labels and JMPTABLE entries
+    Bytecode names() const;
+    Bytecode program() const;  // Everything, code included (copied)
+    std::string note() const;  // What write() was given
+
+private:
+    struct Header;
+
+    void* data_;
+    size_t length_;
+    const Header* header_;
+    const Instruction* code_;
+    int codeSize_;
+    std::string error_;
+};
+
+#endif // BYTECODE_FILE_H
@@ -5,7 +5,8 @@
  * INSTRUCTION FORMAT
  * ============================================================================
  * 
- * Instructions are text-based for now (readable and debuggable).
+ * The compiler and the VM work on typed instructions (bytecode.h); this is
+ * their text form, printed by the disassembler (readable and debuggable).
  * Format: "OPCODE [OPERAND] [OPERAND]"
  * 
  * Examples:
@@ -28,7 +29,13 @@
  * PUSH <value>    - Push a number onto the stack
  *                  Example: "PUSH 42" → stack: [42]
  * 
- * POP             - Remove top value (not implemented yet, use operations that pop)
+ * POP             - Remove top value
+ * 
+ * DUP             - Push a copy of the top value
+ *                  Stack: [a] → [a, a]
+ * 
+ * SWAP            - Exchange the top two values
+ *                  Stack: [a, b] → [b, a]
  */
 
 /**
@@ -46,6 +53,66 @@
  * DIV             - Pop two values, divide (b / a), push result
  *                  Stack: [a, b] → [b/a]
  *                  WARNING: Division by zero not checked!
+ * 
+ * MOD             - Pop two values, push remainder
+ *                  Stack: [a, b] → [a%b] (division by zero pushes 0)
+ * 
+ * DIVNZ, MODNZ    - DIV / MOD without any check; only emitted where
+ *                  range analysis proved the divisor nonzero and not -1
+ *                  (unless the dividend cannot be INT_MIN)
+ * 
+ * NEG             - Negate the top value (INT or FIXED)
+ *                  Stack: [a] → [-a]
+ * 
+ * ADD, SUB, MUL and NEG wrap around on overflow.
+ */
+
+/**
+ * BITWISE OPERATIONS (INT only)
+ * 
+ * BAND, BOR, BXOR - Stack: [a, b] → [a&b], [a|b], [a^b]
+ * 
+ * SHL             - Stack: [a, b] → [a << (b & 31)]
+ * 
+ * SHR             - Stack: [a, b] → [a >> (b & 31)] (arithmetic, keeps the sign)
+ */
+
+/**
+ * FLOAT OPERATIONS
+ * 
+ * FLOAT values live in ordinary stack slots as the bit pattern of a 32-bit
+ * float. Comparisons push an INT (0 or 1).
+ * 
+ * FPUSH <number>  - Push a float constant
+ *                  Example: "FPUSH 1.5" → push(bits(1.5f))
+ * 
+ * FADD, FSUB, FMUL, FDIV
+ *                 - Float arithmetic, same operand order as ADD/SUB/MUL/DIV
+ * 
+ * FEQ, FNE, FGT, FLT, FGE, FLE
+ *                 - Float comparisons, same operand order as EQ/NE/GT/LT/GE/LE
+ */
+
+/**
+ * FIXED-POINT OPERATIONS
+ * 
+ * FIXED values are 16.16 fixed point (raw = value * 65536). Addition,
+ * subtraction and comparisons use the INT opcodes unchanged.
+ * 
+ * XMUL            - Pop two values, push (a * b) >> 16 (64-bit intermediate)
+ * 
+ * XDIV            - Pop two values, push (a << 16) / b (64-bit intermediate)
+ *                  Division by zero reports an error and pushes 0
+ * 
+ * XDIVNZ          - XDIV without the zero check (divisor proven nonzero)
+ */
+
+/**
+ * CONVERSIONS
+ * 
+ * I2F, F2I        - INT <-> FLOAT (F2I truncates toward zero)
+ * I2X, X2I        - INT <-> FIXED (X2I truncates toward zero)
+ * F2X, X2F        - FLOAT <-> FIXED (F2X rounds to nearest)
  */
 
 /**
@@ -72,6 +139,12 @@
  * 
  * NE              - Pop two values, push 1 if not equal, else 0
  *                  Stack: [a, b] → [b!=a ? 1 : 0]
+ * 
+ * GE              - Pop two values, push 1 if b >= a, else 0
+ *                  Stack: [a, b] → [b>=a ? 1 : 0]
+ * 
+ * LE              - Pop two values, push 1 if b <= a, else 0
+ *                  Stack: [a, b] → [b<=a ? 1 : 0]
  */
 
 /**
@@ -86,10 +159,53 @@
  * JNZ <label>     - Jump if not zero (pop value, jump if != 0)
  *                  Example: "JNZ loop" → if (top != 0) goto loop
  * 
+ * JMPTABLE <min> <default> <label0> <label1> ...
+ *                 - Pop value; jump to label[value - min], or to default
+ *                   when value is outside the table (MATCH dispatch)
+ * 
+ * FORPREP <var> <limit> <step> <label>
+ *                 - Enter a counted loop: jump to label if the range is empty
+ *                   <limit>/<step> are immediates or variable names
+ * 
+ * FORLOOP <var> <limit> <step> <label>
+ *                 - var += step; jump to label while var is within limit
+ *                   (inclusive; var >= limit when step is negative)
+ * 
  * <label>:        - Label definition (ends with colon)
  *                  Example: "loop:" → labels["loop"] = current_pc
  */
 
+/**
+ * SUPERINSTRUCTIONS
+ * 
+ * One dispatch for a sequence the compiler emits often. Only used when a
+ * profile (cinebrew --profile) shows the sequence is hot.
+ * 
+ * INC <var> <n>   - var += n      (LOAD var / PUSH n / ADD / STORE var)
+ * 
+ * INCLOCAL <k> <n> - slot K += n  (LOADLOCAL k / PUSH n / ADD / STORELOCAL k)
+ * 
+ * JEQ <label>     - Pop b and a; jump if a == b  (EQ / JNZ, or NE / JZ)
+ * JNE <label>     - ... if a != b
+ * JLT <label>     - ... if a < b
+ * JGT <label>     - ... if a > b
+ * JLE <label>     - ... if a <= b
+ * JGE <label>     - ... if a >= b
+ */
+
+/**
+ * PROFILING
+ * 
+ * Emitted only in instrumented builds (cinebrew --write-profile); without
+ * VM::profiling they do nothing. <site> is "line.n", the n-th branch or
+ * loop on that source line.
+ * 
+ * PROFBR <site>   - Count the condition on top of the stack (not popped)
+ *                   as taken (non-zero) or not taken
+ * 
+ * PROFLOOP <site> - Count one FORLOOP test of the loop
+ */
+
 /**
  * FUNCTION OPERATIONS
  * 
@@ -100,8 +216,52 @@
  * LOADARG <n>     - Load function argument N (0-indexed)
  *                   Example: "LOADARG 0" → push first argument
  * 
+ * LOADARGU <n>    - LOADARG without the frame / index checks; only emitted
+ *                   in SCENEs whose every caller passes the arguments
+ * 
+ * STOREARG <n>    - Pop value, overwrite function argument N
+ *                   Example: "STOREARG 0" → first argument = top_value
+ * 
+ * ENTER <n>       - Reserve N local slots (pushes N zeros)
+ *                   Emitted at the start of a SCENE / the main program
+ * 
+ * LOADLOCAL <k>   - Push local slot K (slots follow the arguments)
+ * 
+ * STORELOCAL <k>  - Pop value into local slot K
+ * 
  * RET             - Return from function
  *                   Pops return value, restores stack, returns to caller
+ * 
+ * MEMOGET <scene> - First instruction of a memoized (pure) SCENE: if the
+ *                   memo cache holds a result for these arguments, return
+ *                   it like RET; otherwise continue into the body
+ * 
+ * MEMOPUT <scene> - Just before RET: remember the result on top of the
+ *                   stack for the arguments MEMOGET looked up
+ * 
+ * COMPILE <scene> - Entry of a SCENE whose body is not compiled yet (lazy
+ *                   compilation): the VM has the compiler append the body,
+ *                   turns this instruction into a JMP to it and goes there
+ */
+
+/**
+ * OBJECT OPERATIONS
+ * 
+ * Objects are referenced by integer handles. Each GETPROP/SETPROP carries a
+ * <site> id that selects its own inline cache (shape -> slot offset), so
+ * repeated access on same-shaped objects skips the field-name lookup.
+ * 
+ * NEWOBJ               - Allocate an empty object, push its handle
+ *                        Stack: [] → [obj]
+ * 
+ * GETPROP <name> <site>  - Pop object, push property value
+ *                        Stack: [obj] → [obj.name]
+ * 
+ * SETPROP <name> <site>  - Pop value and object, store property (adds it if missing)
+ *                        Stack: [obj, value] → []
+ * 
+ * INITPROP <name> <site> - Like SETPROP but keeps the object (object literals)
+ *                        Stack: [obj, value] → [obj]
  */
 
 /**
@@ -110,6 +270,10 @@
  * PRINT           - Print top stack value to console
  *                   Example: "PRINT" → cout << stack.top()
  * 
+ * FPRINT          - Print top stack value as a FLOAT
+ * 
+ * XPRINT          - Print top stack value as a FIXED
+ * 
  * HALT            - Stop execution (label, not instruction)
  *                   Example: "HALT:" → program ends here
  */
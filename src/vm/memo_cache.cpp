@@ -0,0 +1,69 @@
+/**
+ * CINEBREW Memo Cache - Implementation
+ *
+ * Direct-mapped lookup and store of memoized SCENE results.
+ */
+
+#include "memo_cache.h"
+
+MemoCache::MemoCache() {
+    clear();
+}
+
+void MemoCache::clear() {
+    Entry empty = {};
+    empty.table = -1;
+    entries_.assign(SIZE, empty);
+    nextStamp_ = 0;
+}
+
+/**
+ * Fibonacci hashing: multiply by 2^32 / golden ratio and keep the top
+ * bits. Consecutive arguments (fib(0), fib(1), ...) land in distinct
+ * slots.
+ */
+unsigned MemoCache::hash(int table, const int* args, int argc) {
+    unsigned h = (unsigned)table * 0x85EBCA6Bu;
+    for (int i = 0; i < argc; i++) {
+        h = (h + (unsigned)args[i]) * 0x9E3779B1u;
+    }
+    return h >> (32 - INDEX_BITS);
+}
+
+bool MemoCache::lookup(int table, const int* args, int argc, int& value, Ticket& ticket) {
+    int slot = (int)hash(table, args, argc);
+    Entry& entry = entries_[slot];
+
+    if (entry.table == table && entry.argc == argc) {
+        bool same = true;
+        for (int i = 0; i < argc; i++) {
+            if (entry.args[i] != args[i]) {
+                same = false;
+                break;
+            }
+        }
+        if (same) {
+            value = entry.value;
+            return true;
+        }
+    }
+
+    // Miss: the slot now waits for this call's result
+    entry.table = -1;
+    entry.argc = argc;
+    for (int i = 0; i < argc; i++) {
+        entry.args[i] = args[i];
+    }
+    entry.stamp = ++nextStamp_;
+    ticket.slot = slot;
+    ticket.stamp = entry.stamp;
+    return false;
+}
+
+void MemoCache::store(const Ticket& ticket, int table, int value) {
+    if (ticket.slot < 0) return;
+    Entry& entry = entries_[ticket.slot];
+    if (entry.stamp != ticket.stamp) return;  // Taken by another call since
+    entry.table = table;
+    entry.value = value;
+}
@@ -0,0 +1,76 @@
+/**
+ * CINEBREW Memo Cache - Header
+ * Results of pure SCENEs, remembered by their arguments.
+ *
+ * ============================================================================
+ * HOW IT WORKS
+ * ============================================================================
+ *
+ * The compiler marks pure recursive SCENEs (and MEMO ones) for
+ * memoization and brackets their body:
+ *
+ *   fib:
+ *   MEMOGET fib     ← seen fib(n) before? return the remembered result
+ *   ...             ← no: compute it
+ *   MEMOPUT fib     ← remember the result for n
+ *   RET
+ *
+ * A SCENE's table is the index of its name in the program's symbol table
+ * (the operand of MEMOGET / MEMOPUT), so nothing is looked up by name.
+ *
+ * The cache is direct-mapped: a fixed array of SIZE entries, and every
+ * (SCENE, arguments) key has exactly one slot, picked by a hash. A new
+ * key simply overwrites whatever was in its slot, so the memory used is
+ * bounded and a lookup is one hash and one compare. An entry is 32
+ * bytes: two per cache line.
+ *
+ * A miss claims the slot for the coming MEMOPUT and hands out a ticket
+ * (slot + stamp). If a nested call takes the slot in the meantime, the
+ * stamp no longer matches and the result is simply not stored.
+ *
+ * ============================================================================
+ */
+
+#ifndef MEMO_CACHE_H
+#define MEMO_CACHE_H
+
+#include <vector>
+
+class MemoCache {
+public:
+    static const int MAX_ARGS = 4;  // SCENEs with more parameters are not memoized
+    static const int INDEX_BITS = 12;
+    static const int SIZE = 1 << INDEX_BITS;  // Entries
+
+    // A claimed slot, kept in the call frame between MEMOGET and MEMOPUT
+    struct Ticket {
+        int slot;
+        unsigned stamp;
+    };
+
+    MemoCache();
+
+    // True (and value) if table(args) is cached; otherwise claims its slot
+    bool lookup(int table, const int* args, int argc, int& value, Ticket& ticket);
+
+    // Store the result computed after a missed lookup (if the slot is still ours)
+    void store(const Ticket& ticket, int table, int value);
+
+    void clear();
+
+private:
+    struct alignas(32) Entry {
+        int table;  // -1: empty, or claimed and not stored yet
+        int argc;
+        int args[MAX_ARGS];
+        int value;
+        unsigned stamp;
+    };
+
+    std::vector<Entry> entries_;
+    unsigned nextStamp_;
+
+    static unsigned hash(int table, const int* args, int argc);
+};
+
+#endif // MEMO_CACHE_H
@@ -0,0 +1,145 @@
+/**
+ * CINEBREW Object Model - Implementation
+ *
+ * Shapes, transitions and inline-cache lookups for dynamic objects.
+ */
+
+#include "object.h"
+
+// ============================================================================
+// CONSTRUCTOR
+// ============================================================================
+
+ObjectHeap::ObjectHeap() {
+    clear();
+}
+
+void ObjectHeap::clear() {
+    objects_.clear();
+    shapes_.clear();
+    // Shape 0 is the empty shape every new object starts with
+    shapes_.push_back(std::make_unique<Shape>(0));
+}
+
+// ============================================================================
+// ALLOCATION
+// ============================================================================
+
+int ObjectHeap::allocate() {
+    Object obj;
+    obj.shape = rootShape();
+    objects_.push_back(obj);
+    return (int)objects_.size();  // Handles start at 1 so 0 can mean "no object"
+}
+
+bool ObjectHeap::isValid(int handle) const {
+    return handle >= 1 && handle <= (int)objects_.size();
+}
+
+// ============================================================================
+// SHAPES
+// ============================================================================
+
+/**
+ * Follow (or create) the transition that adds `name` to `from`.
+ *
+ * Reusing existing transitions is what makes objects built the same way
+ * share a shape.
+ */
+Shape* ObjectHeap::transition(Shape* from, const std::string& name) {
+    auto it = from->transitions.find(name);
+    if (it != from->transitions.end()) {
+        return it->second;
+    }
+
+    shapes_.push_back(std::make_unique<Shape>((int)shapes_.size()));
+    Shape* next = shapes_.back().get();
+    next->offsets = from->offsets;
+    next->offsets[name] = (int)from->offsets.size();
+    from->transitions[name] = next;
+    return next;
+}
+
+// ============================================================================
+// INLINE CACHES
+// ============================================================================
+
+void ObjectHeap::remember(InlineCache& cache, Shape* shape, Shape* next, int offset) {
+    if (cache.megamorphic) return;
+
+    if (cache.count == InlineCache::MAX_ENTRIES) {
+        // Too many shapes seen at this site: stop caching, always hash
+        cache.megamorphic = true;
+        return;
+    }
+
+    InlineCache::Entry& entry = cache.entries[cache.count++];
+    entry.shape = shape;
+    entry.next = next;
+    entry.offset = offset;
+}
+
+bool ObjectHeap::getProperty(int handle, const std::string& name, InlineCache& cache,
+                             int& value, bool& cacheHit) {
+    cacheHit = false;
+    if (!isValid(handle)) return false;
+
+    Object& obj = objects_[handle - 1];
+
+    // Fast path: shape seen before at this site
+    for (int i = 0; i < cache.count; i++) {
+        if (cache.entries[i].shape == obj.shape) {
+            cacheHit = true;
+            value = obj.slots[cache.entries[i].offset];
+            return true;
+        }
+    }
+
+    // Slow path: hash lookup in the shape, then remember the result
+    auto it = obj.shape->offsets.find(name);
+    if (it == obj.shape->offsets.end()) {
+        return false;
+    }
+    remember(cache, obj.shape, obj.shape, it->second);
+    value = obj.slots[it->second];
+    return true;
+}
+
+bool ObjectHeap::setProperty(int handle, const std::string& name, int value,
+                             InlineCache& cache, bool& cacheHit) {
+    cacheHit = false;
+    if (!isValid(handle)) return false;
+
+    Object& obj = objects_[handle - 1];
+
+    // Fast path: existing field, or a cached "add field" transition
+    for (int i = 0; i < cache.count; i++) {
+        const InlineCache::Entry& entry = cache.entries[i];
+        if (entry.shape == obj.shape) {
+            cacheHit = true;
+            if (entry.next != entry.shape) {
+                obj.shape = entry.next;
+                obj.slots.push_back(value);
+            } else {
+                obj.slots[entry.offset] = value;
+            }
+            return true;
+        }
+    }
+
+    // Slow path
+    Shape* shape = obj.shape;
+    auto it = shape->offsets.find(name);
+    if (it != shape->offsets.end()) {
+        obj.slots[it->second] = value;
+        remember(cache, shape, shape, it->second);
+        return true;
+    }
+
+    Shape* next = transition(shape, name);
+    int offset = (int)obj.slots.size();
+    obj.shape = next;
+    obj.slots.push_back(value);
+    remember(cache, shape, next, offset);
+    return true;
+}
@@ -0,0 +1,92 @@
+/**
+ * CINEBREW Object Model - Header
+ * Dynamic objects with hidden-class shapes and inline caches.
+ *
+ * ============================================================================
+ * HOW SHAPES WORK
+ * ============================================================================
+ *
+ * An object does not store its own field-name table. Instead it points at a
+ * Shape ("hidden class") that maps field names to slot offsets. Adding a
+ * field moves the object along a transition to the next shape:
+ *
+ *   {}  --x-->  {x}  --y-->  {x, y}
+ *
+ * Objects that receive the same fields in the same order end up sharing a
+ * shape, so a property site only has to remember (shape -> offset) to skip
+ * the hash lookup next time. That memory is the InlineCache.
+ *
+ * ============================================================================
+ */
+
+#ifndef OBJECT_H
+#define OBJECT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+// Hidden class shared by all objects with the same field insertion order
+struct Shape {
+    int id;
+    std::unordered_map<std::string, int> offsets;        // Field name -> slot index
+    std::unordered_map<std::string, Shape*> transitions; // Added field -> next shape
+
+    Shape(int i) : id(i) {}
+};
+
+// Heap object: a shape plus one slot per field
+struct Object {
+    Shape* shape;
+    std::vector<int> slots;
+};
+
+// Per-site cache of shape -> offset (monomorphic with one entry,
+// polymorphic up to MAX_ENTRIES, megamorphic once that overflows)
+struct InlineCache {
+    static const int MAX_ENTRIES = 4;
+
+    struct Entry {
+        Shape* shape;   // Receiver shape this entry applies to
+        Shape* next;    // Shape after the access (differs only when a store adds a field)
+        int offset;     // Slot index of the property
+    };
+
+    Entry entries[MAX_ENTRIES];
+    int count;
+    bool megamorphic;
+
+    InlineCache() : count(0), megamorphic(false) {}
+};
+
+class ObjectHeap {
+public:
+    ObjectHeap();
+
+    // Allocate an empty object; returns its handle (never 0)
+    int allocate();
+    bool isValid(int handle) const;
+
+    // Property access through an inline cache.
+    // Both return false if the handle is invalid (or, for get, the field is missing).
+    bool getProperty(int handle, const std::string& name, InlineCache& cache,
+                     int& value, bool& cacheHit);
+    bool setProperty(int handle, const std::string& name, int value,
+                     InlineCache& cache, bool& cacheHit);
+
+    size_t objectCount() const { return objects_.size(); }
+    size_t shapeCount() const { return shapes_.size(); }
+
+    void clear();
+
+private:
+    std::vector<std::unique_ptr<Shape>> shapes_;
+    std::vector<Object> objects_;  // Handle h lives at objects_[h - 1]
+
+    Shape* rootShape() const { return shapes_[0].get(); }
+    Shape* transition(Shape* from, const std::string& name);
+    void remember(InlineCache& cache, Shape* shape, Shape* next, int offset);
+};
+
+#endif // OBJECT_H
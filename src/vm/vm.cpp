@@ -8,13 +8,39 @@
 #include "vm.h"
 #include <sstream>
 #include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+// ============================================================================
+// NUMERIC REPRESENTATIONS
+// ============================================================================
+//
+// Every stack slot is an int. FLOAT values are stored as the bit pattern of
+// a 32-bit float; FIXED values are 16.16 fixed point (raw = value * 65536).
+
+static const int FIXED_ONE = 1 << 16;
+
+static float asFloat(int bits) {
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static int floatBits(float f) {
+    int bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
 
 // ============================================================================
 // CONSTRUCTOR
 // ============================================================================
 
-VM::VM() {
+VM::VM() : code_(nullptr), codeSize_(0) {
     pc = 0;  // Start at instruction 0
+    trace = true;
+    profiling = false;
     // Stack, vars, labels, callstack are automatically initialized
 }
 
@@ -34,6 +60,7 @@ VM::VM() {
  */
 void VM::push(int value) {
     stack.push_back(value);
+    if ((long long)stack.size() > stats.stackHighWater) stats.stackHighWater = stack.size();
 }
 
 /**
@@ -62,377 +89,715 @@ int VM::pop() {
 // ============================================================================
 
 /**
- * Split a string into words (space-separated).
- * 
- * Example: "PUSH 42" → ["PUSH", "42"]
- *          "ADD"      → ["ADD"]
+ * Get the inline cache for a GETPROP/SETPROP site.
+ *
+ * Site ids are dense (the code generator numbers them 0, 1, 2, ...),
+ * so the caches live in a plain vector indexed by site id.
  */
-std::vector<std::string> VM::split(const std::string& s) {
-    std::vector<std::string> parts;
-    std::string cur;
-    bool in_quote = false;
-    for (size_t i = 0; i < s.size(); ++i) {
-        char c = s[i];
-        if (c == '"') {
-            in_quote = !in_quote;
-            // include quote in token so caller can strip if needed
-            cur.push_back(c);
-        } else if (std::isspace(static_cast<unsigned char>(c)) && !in_quote) {
-            if (!cur.empty()) {
-                parts.push_back(cur);
-                cur.clear();
-            }
-        } else {
-            cur.push_back(c);
-        }
+InlineCache& VM::cacheForSite(int site) {
+    if (site >= (int)inlineCaches.size()) {
+        inlineCaches.resize(site + 1);
+    }
+    return inlineCaches[site];
+}
+
+/**
+ * Read the limit or step of FORPREP / FORLOOP: an integer immediate, or a
+ * variable ("__for_limit_0") when the instruction says it is a name.
+ */
+int VM::operandValue(int operand, bool isName) {
+    if (!isName) return operand;
+    auto it = vars.find(program_.symbols[operand]);
+    return it == vars.end() ? 0 : it->second;
+}
+
+// Jump to a label, or step past the instruction if the label is missing
+void VM::jumpTo(int label) {
+    int target = program_.labels[label].pc;
+    if (target < 0) {
+        std::cerr << "ERROR: Label '" << program_.labelName(label) << "' not found at PC=" << pc << std::endl;
+        pc++;
+    } else {
+        pc = target;
+    }
+}
+
+// Jump to the instruction's (backpatched) target
+void VM::jump(const Instruction& instruction) {
+    if (instruction.target < 0) {
+        jumpTo(instruction.label);
+    } else {
+        pc = instruction.target;
     }
-    if (!cur.empty()) parts.push_back(cur);
-    return parts;
 }
 
 // ============================================================================
-// PREPROCESSING (Label Resolution)
+// LOADING
 // ============================================================================
 
 /**
- * Preprocess the program to build the label map.
- * 
+ * Load a program: keep a copy and decide, once, which CALLs go to the
+ * runtime's built-ins.
+ *
  * WHAT ARE LABELS?
  * Labels are named locations in the code. They allow us to jump
  * to specific places, like "goto" statements.
- * 
+ *
  * Example program:
  *   0: "PUSH 5"
  *   1: "loop:"      ← This is a label
  *   2: "PUSH 1"
  *   3: "ADD"
  *   4: "JMP loop"   ← Jump back to label "loop"
- * 
- * After preprocessing:
- *   labels["loop"] = 1
- * 
- * WHY DO THIS FIRST?
- * We need to know where labels are before we execute, because
- * JMP instructions reference them.
+ *
+ * The code generator already replaced "loop" in the JMP by pc 1 (see
+ * bytecode.h), so nothing is looked up by name while the program runs.
  */
-void VM::preprocess(std::vector<std::string>& program) {
-    labels.clear();
-    
-    for (int i = 0; i < (int)program.size(); i++) {
-        std::string line = program[i];
-        
-        // Labels end with ':'
-        if (!line.empty() && line.back() == ':') {
-            // Extract label name (remove the ':')
-            std::string label_name = line.substr(0, line.size() - 1);
-            labels[label_name] = i;  // Map label name to instruction index
+void VM::load(const Bytecode& program) {
+    program_ = program;
+    for (Instruction& instruction : program_.code) {
+        if (instruction.op == Op::CALL && runtime.isBuiltin(program_.symbols[instruction.a])) {
+            instruction.target = Instruction::BUILTIN;
         }
     }
+    code_ = program_.code.data();
+    codeSize_ = (int)program_.code.size();
+}
+
+// Load a compiled file: its code stays where it is mapped (BytecodeFile::write
+// already resolved the built-ins), only the names are copied
+void VM::load(const BytecodeFile& file) {
+    program_ = file.names();
+    code_ = file.code();
+    codeSize_ = file.size();
+}
+
+// Load a program given as text (assembled once, then run like any other)
+void VM::preprocess(const std::vector<std::string>& program) {
+    load(Bytecode::assemble(program));
 }
 
 // ============================================================================
 // INSTRUCTION EXECUTION
 // ============================================================================
 
+void VM::step() {
+    execute(code_[pc]);
+}
+
+/**
+ * Between two statements the stack holds exactly what the current frame
+ * owns: nothing at top level, the arguments inside a SCENE. Anything more
+ * is a value some statement forgot to pop (debug builds check this at the
+ * first instruction of every statement the code generator marked).
+ */
+void VM::checkStackBalance() const {
+    int expected = callstack.empty() ? 0 : callstack.back().prev_stack_size + callstack.back().arg_count;
+    if ((int)stack.size() != expected) {
+        std::cerr << "ERROR: Unbalanced stack at PC=" << pc << ": " << stack.size()
+                  << " values, expected " << expected << std::endl;
+        throw std::runtime_error("Unbalanced stack");
+    }
+}
+
+/**
+ * CALL <scene> <argc> from outside the program (the game loop calling
+ * update, the compile-time evaluator calling a SCENE): returns to pc + 1.
+ * The argument count must match the SCENE's: its code may read them with
+ * LOADARGU, proven safe for the calls in the program only.
+ */
+void VM::call(const std::string& scene, int argc) {
+    int arity = program_.arity(scene);
+    if (arity >= 0 && argc != arity) {
+        throw std::runtime_error("SCENE '" + scene + "' takes " + std::to_string(arity) + " arguments, called with " +
+                                 std::to_string(argc));
+    }
+    Instruction instruction = {Op::CALL, 0, false, program_.symbol(scene), argc, 0, -1,
+                               runtime.isBuiltin(scene) ? Instruction::BUILTIN : findLabel(scene)};
+    execute(instruction);
+}
+
 /**
  * Execute a single instruction.
- * 
- * This is the core of the VM - it reads an instruction string
+ *
+ * This is the core of the VM - it looks at the instruction's opcode
  * and performs the corresponding operation.
- * 
+ *
  * HOW IT WORKS:
- *   1. Parse the instruction (split into parts)
- *   2. Identify the opcode (first word)
- *   3. Execute the appropriate operation
- *   4. Update the program counter (usually pc++)
+ *   1. Identify the opcode (already decoded, see bytecode.h)
+ *   2. Execute the appropriate operation on the operands
+ *   3. Update the program counter (usually pc++)
  */
-void VM::execute(const std::string& instruction, std::vector<std::string>& program) {
-    // Skip empty lines
-    if (instruction.empty()) {
-        pc++;
-        return;
-    }
-    
-    // Skip label definitions (they're handled in preprocess)
-    if (instruction.back() == ':') {
+void VM::execute(const Instruction& instruction) {
+#ifndef NDEBUG
+    if (instruction.statement) checkStackBalance();
+#endif
+
+    // Skip empty lines and label definitions (their pc is in the jumps)
+    if (instruction.op == Op::NOP || instruction.op == Op::LABEL) {
         pc++;
         return;
     }
-    
+
     // Debug: show executing instruction
-    std::cerr << "[DEBUG] PC=" << pc << " EXEC='" << instruction << "'" << std::endl;
+    if (trace) {
+        std::cerr << "[DEBUG] PC=" << pc << " EXEC='" << disassembleAt(instruction) << "'" << std::endl;
+    }
 
-    // Split instruction into parts: "PUSH 42" → ["PUSH", "42"]
-    auto parts = split(instruction);
-    if (parts.empty()) {
-        pc++;
-        return;
+    stats.instructions++;
+    if (profiling && pc >= 0) {
+        if ((int)profile.executed.size() < codeSize_) profile.executed.resize(codeSize_);
+        if (pc < (int)profile.executed.size()) profile.executed[pc]++;
     }
-    
-    std::string opcode = parts[0];
-    
+
+    switch (instruction.op) {
+
     // ========================================================================
     // STACK OPERATIONS
     // ========================================================================
-    
-    if (opcode == "PUSH") {
+
+    case Op::PUSH:
         // PUSH <value> - Push a number onto the stack
         // Example: "PUSH 42" → push(42)
-        if (parts.size() < 2) {
-            std::cerr << "ERROR: PUSH requires a value at PC=" << pc << std::endl;
-            pc++;
-            return;
-        }
-        // Try to parse as integer, otherwise treat as string literal.
-        try {
-            int value = std::stoi(parts[1]);
-            push(value);
-            pc++;
-        } catch (const std::invalid_argument&) {
-            // Non-numeric push (likely a string). Extract the literal from
-            // the original instruction (take everything after the opcode)
-            std::string literal;
-            size_t sep = instruction.find_first_of(" \t");
-            if (sep != std::string::npos) {
-                literal = instruction.substr(sep + 1);
-                // Trim leading/trailing whitespace
-                while (!literal.empty() && std::isspace(static_cast<unsigned char>(literal.front()))) literal.erase(literal.begin());
-                while (!literal.empty() && std::isspace(static_cast<unsigned char>(literal.back()))) literal.pop_back();
-            } else {
-                literal = parts[1];
-            }
-            // strip surrounding quotes if present
-            if (literal.size() >= 2 && literal.front() == '"' && literal.back() == '"') {
-                literal = literal.substr(1, literal.size() - 2);
-            }
+        push(instruction.a);
+        pc++;
+        break;
 
-            // Find next non-label instruction
-            int next_i = pc + 1;
-            while (next_i < (int)program.size() && !program[next_i].empty() && program[next_i].back() == ':') {
-                next_i++;
-            }
+    case Op::PUSHSTR: {
+        // PUSH <text> - A string literal: only PRINT can use it
+        const std::string& literal = program_.symbols[instruction.a];
 
-            if (next_i < (int)program.size()) {
-                auto next_parts = split(program[next_i]);
-                if (!next_parts.empty() && next_parts[0] == "PRINT") {
-                    // Debug: show literal contents and length
-                    std::cerr << "[DEBUG] Literal=('" << literal << "') len=" << literal.size() << std::endl;
-                    // Print the literal directly
-                    std::cout << literal << std::endl;
-                    // Advance pc to after the PRINT
-                    pc = next_i + 1;
-                    return;
-                }
-            }
+        // Find next non-label instruction
+        int next_i = pc + 1;
+        while (next_i < codeSize_ && code_[next_i].op == Op::LABEL) {
+            next_i++;
+        }
 
-            // Fallback: push 0 and emit a warning
-            std::cerr << "WARNING: PUSH of non-integer '" << parts[1] << "' at PC=" << pc << " - treating as 0" << std::endl;
-            push(0);
-            pc++;
+        if (next_i < codeSize_ && code_[next_i].op == Op::PRINT) {
+            // Debug: show literal contents and length
+            std::cerr << "[DEBUG] Literal=('" << literal << "') len=" << literal.size() << std::endl;
+            // Print the literal directly
+            std::cout << literal << std::endl;
+            // Advance pc to after the PRINT
+            pc = next_i + 1;
+            break;
         }
+
+        // Fallback: push 0 and emit a warning
+        std::cerr << "WARNING: PUSH of non-integer '" << literal << "' at PC=" << pc << " - treating as 0" << std::endl;
+        push(0);
+        pc++;
+        break;
+    }
+
+    case Op::DUP: {
+        // DUP - Push a copy of the top value
+        // Stack: [a] → [a, a]
+        int a = pop();
+        push(a);
+        push(a);
+        pc++;
+        break;
+    }
+
+    case Op::POP:
+        // POP - Discard the top value
+        pop();
+        pc++;
+        break;
+
+    case Op::SWAP: {
+        // SWAP - Exchange the top two values
+        // Stack: [a, b] → [b, a]
+        int b = pop();
+        int a = pop();
+        push(b);
+        push(a);
+        pc++;
+        break;
     }
-    
+
     // ========================================================================
     // ARITHMETIC OPERATIONS
     // ========================================================================
-    
-    else if (opcode == "ADD") {
+
+    case Op::ADD: {
         // ADD - Pop two values, add them, push result
         // Stack: [a, b] → [a+b]
         // Note: We pop in reverse order (b first, then a)
         int b = pop();
         int a = pop();
-        push(a + b);
+        push((int)((unsigned int)a + (unsigned int)b));  // Wraps on overflow
         pc++;
+        break;
     }
-    
-    else if (opcode == "SUB") {
+
+    case Op::SUB: {
         // SUB - Pop two values, subtract (a - b), push result
         // Stack: [a, b] → [a-b]
         int b = pop();
         int a = pop();
-        push(a - b);
+        push((int)((unsigned int)a - (unsigned int)b));  // Wraps on overflow
         pc++;
+        break;
     }
-    
-    else if (opcode == "MUL") {
+
+    case Op::MUL: {
         // MUL - Pop two values, multiply, push result
         // Stack: [a, b] → [a*b]
         int b = pop();
         int a = pop();
-        push(a * b);
+        push((int)((unsigned int)a * (unsigned int)b));  // Wraps on overflow
+        pc++;
+        break;
+    }
+
+    case Op::NEG: {
+        // NEG - Negate the top value (INT or FIXED)
+        // Stack: [a] → [-a]
+        int a = pop();
+        push((int)(0u - (unsigned int)a));  // -INT_MIN wraps like 0 - a
         pc++;
+        break;
     }
-    
-    else if (opcode == "DIV") {
+
+    case Op::DIV: {
         // DIV - Pop two values, divide (a / b), push result
         // Stack: [a, b] → [a/b]
-        // WARNING: No division by zero check!
         int b = pop();
         int a = pop();
         if (b == 0) {
             std::cerr << "ERROR: Division by zero at PC=" << pc << std::endl;
             push(0);  // Return 0 on error
+        } else if (b == -1) {
+            push((int)(0u - (unsigned int)a));  // INT_MIN / -1 wraps instead of trapping
         } else {
             push(a / b);
         }
         pc++;
+        break;
+    }
+
+    case Op::MOD: {
+        // MOD - Pop two values, push remainder (a % b), sign follows a
+        // Stack: [a, b] → [a%b]
+        int b = pop();
+        int a = pop();
+        if (b == 0) {
+            std::cerr << "ERROR: Modulo by zero at PC=" << pc << std::endl;
+            push(0);  // Return 0 on error, like DIV
+        } else if (b == -1) {
+            push(0);  // INT_MIN % -1 traps in C++
+        } else {
+            push(a % b);
+        }
+        pc++;
+        break;
+    }
+
+    case Op::DIVNZ:
+    case Op::MODNZ: {
+        // DIV / MOD whose divisor the compiler proved nonzero, and not -1
+        // where the dividend may be INT_MIN (range analysis): no checks
+        int b = pop();
+        int a = pop();
+        push(instruction.op == Op::DIVNZ ? a / b : a % b);
+        pc++;
+        break;
+    }
+
+    // ========================================================================
+    // BITWISE OPERATIONS
+    // ========================================================================
+
+    case Op::BAND:
+    case Op::BOR:
+    case Op::BXOR: {
+        // Stack: [a, b] → [a & b], [a | b], [a ^ b]
+        int b = pop();
+        int a = pop();
+        if (instruction.op == Op::BAND) push(a & b);
+        else if (instruction.op == Op::BOR) push(a | b);
+        else push(a ^ b);
+        pc++;
+        break;
+    }
+
+    case Op::SHL: {
+        // SHL - Stack: [a, b] → [a << (b & 31)], wraps like 32-bit hardware
+        int b = pop();
+        int a = pop();
+        push((int)((unsigned int)a << (b & 31)));
+        pc++;
+        break;
+    }
+
+    case Op::SHR: {
+        // SHR - Stack: [a, b] → [a >> (b & 31)], arithmetic (sign-extending)
+        int b = pop();
+        int a = pop();
+        push(a >> (b & 31));
+        pc++;
+        break;
+    }
+
+    // ========================================================================
+    // FLOAT OPERATIONS (operands are float bit patterns)
+    // ========================================================================
+
+    case Op::FPUSH:
+        // FPUSH <number> - Push a float constant
+        // Example: "FPUSH 1.5" → push(bits of 1.5f), decoded when loaded
+        push(instruction.a);
+        pc++;
+        break;
+
+    case Op::FADD:
+    case Op::FSUB:
+    case Op::FMUL:
+    case Op::FDIV: {
+        // Stack: [a, b] → [a op b], IEEE semantics (FDIV by zero gives inf/nan)
+        float b = asFloat(pop());
+        float a = asFloat(pop());
+        float result;
+        if (instruction.op == Op::FADD) result = a + b;
+        else if (instruction.op == Op::FSUB) result = a - b;
+        else if (instruction.op == Op::FMUL) result = a * b;
+        else result = a / b;
+        push(floatBits(result));
+        pc++;
+        break;
+    }
+
+    case Op::FEQ:
+    case Op::FNE:
+    case Op::FGT:
+    case Op::FLT:
+    case Op::FGE:
+    case Op::FLE: {
+        // Stack: [a, b] → [a cmp b ? 1 : 0] (result is an INT)
+        float b = asFloat(pop());
+        float a = asFloat(pop());
+        bool result;
+        if (instruction.op == Op::FEQ) result = a == b;
+        else if (instruction.op == Op::FNE) result = a != b;
+        else if (instruction.op == Op::FGT) result = a > b;
+        else if (instruction.op == Op::FLT) result = a < b;
+        else if (instruction.op == Op::FGE) result = a >= b;
+        else result = a <= b;
+        push(result ? 1 : 0);
+        pc++;
+        break;
+    }
+
+    // ========================================================================
+    // FIXED-POINT OPERATIONS (16.16; ADD/SUB/compares reuse the INT opcodes)
+    // ========================================================================
+
+    case Op::XMUL: {
+        // Stack: [a, b] → [(a * b) >> 16], 64-bit intermediate
+        int64_t b = pop();
+        int64_t a = pop();
+        push((int)((a * b) >> 16));
+        pc++;
+        break;
+    }
+
+    case Op::XDIV: {
+        // Stack: [a, b] → [(a << 16) / b], 64-bit intermediate
+        int64_t b = pop();
+        int64_t a = pop();
+        if (b == 0) {
+            std::cerr << "ERROR: Division by zero at PC=" << pc << std::endl;
+            push(0);  // Return 0 on error, like DIV
+        } else {
+            push((int)((a * FIXED_ONE) / b));
+        }
+        pc++;
+        break;
     }
-    
+
+    case Op::XDIVNZ: {
+        // XDIV with a divisor proven nonzero
+        int64_t b = pop();
+        int64_t a = pop();
+        push((int)((a * FIXED_ONE) / b));
+        pc++;
+        break;
+    }
+
+    // ========================================================================
+    // CONVERSIONS
+    // ========================================================================
+
+    case Op::I2F:
+        push(floatBits((float)pop()));
+        pc++;
+        break;
+
+    case Op::F2I:
+        // Truncates toward zero
+        push((int)asFloat(pop()));
+        pc++;
+        break;
+
+    case Op::I2X:
+        push((int)((int64_t)pop() * FIXED_ONE));
+        pc++;
+        break;
+
+    case Op::X2I:
+        // Truncates toward zero, like F2I
+        push(pop() / FIXED_ONE);
+        pc++;
+        break;
+
+    case Op::F2X:
+        push((int)std::lround(asFloat(pop()) * FIXED_ONE));
+        pc++;
+        break;
+
+    case Op::X2F:
+        push(floatBits((float)pop() / FIXED_ONE));
+        pc++;
+        break;
+
     // ========================================================================
     // VARIABLE OPERATIONS
     // ========================================================================
-    
-    else if (opcode == "STORE") {
+
+    case Op::STORE: {
         // STORE <name> - Pop value, store in variable
         // Example: "STORE x" → vars["x"] = pop()
-        if (parts.size() < 2) {
-            std::cerr << "ERROR: STORE requires variable name at PC=" << pc << std::endl;
-            pc++;
-            return;
-        }
-        std::string var_name = parts[1];
         int value = pop();
-        vars[var_name] = value;
+        vars[program_.symbols[instruction.a]] = value;
         pc++;
+        break;
     }
-    
-    else if (opcode == "LOAD") {
+
+    case Op::LOAD: {
         // LOAD <name> - Load variable value onto stack
         // Example: "LOAD x" → push(vars["x"])
-        if (parts.size() < 2) {
-            std::cerr << "ERROR: LOAD requires variable name at PC=" << pc << std::endl;
-            pc++;
-            return;
-        }
-        std::string var_name = parts[1];
-        
+        const std::string& var_name = program_.symbols[instruction.a];
+
         // If variable doesn't exist, default to 0
-        if (vars.find(var_name) == vars.end()) {
+        auto it = vars.find(var_name);
+        if (it == vars.end()) {
             std::cerr << "WARNING: Variable '" << var_name << "' not found, using 0 at PC=" << pc << std::endl;
             push(0);
         } else {
-            push(vars[var_name]);
+            push(it->second);
         }
         pc++;
+        break;
     }
-    
+
+    case Op::LOADLOCAL:
+    case Op::STORELOCAL: {
+        // LOADLOCAL <k>  - Push local slot K
+        // STORELOCAL <k> - Pop value into local slot K
+        //
+        // Slots start right after the frame's arguments (or at the bottom
+        // of the stack in the main program), where ENTER reserved them.
+        // Checked next to LOAD / STORE: optimized loops live in locals.
+        int base = callstack.empty() ? 0 : callstack.back().prev_stack_size + callstack.back().arg_count;
+        int position = base + instruction.a;
+
+        if (instruction.op == Op::LOADLOCAL) {
+            if (position < (int)stack.size()) {
+                push(stack[position]);
+            } else {
+                std::cerr << "WARNING: Local slot out of bounds at PC=" << pc << std::endl;
+                push(0);
+            }
+        } else {
+            int value = pop();
+            if (position < (int)stack.size()) {
+                stack[position] = value;
+            } else {
+                std::cerr << "WARNING: Local slot out of bounds at PC=" << pc << std::endl;
+            }
+        }
+        pc++;
+        break;
+    }
+
     // ========================================================================
     // COMPARISON OPERATIONS
     // ========================================================================
-    
-    else if (opcode == "EQ") {
-        // EQ - Pop two values, push 1 if equal, else 0
-        // Stack: [a, b] → [b==a ? 1 : 0]
-        int b = pop();
-        int a = pop();
-        push(a == b ? 1 : 0);
-        pc++;
-    }
-    
-    else if (opcode == "GT") {
-        // GT - Pop two values, push 1 if a > b, else 0
-        // Stack: [a, b] → [a>b ? 1 : 0]
-        int b = pop();
-        int a = pop();
-        push(a > b ? 1 : 0);
-        pc++;
-    }
-    
-    else if (opcode == "LT") {
-        // LT - Pop two values, push 1 if a < b, else 0
-        // Stack: [a, b] → [a<b ? 1 : 0]
-        int b = pop();
-        int a = pop();
-        push(a < b ? 1 : 0);
-        pc++;
-    }
-    
-    else if (opcode == "NE") {
-        // NE - Pop two values, push 1 if not equal, else 0
-        // Stack: [a, b] → [a!=b ? 1 : 0]
+
+    case Op::EQ:
+    case Op::NE:
+    case Op::GT:
+    case Op::LT:
+    case Op::GE:
+    case Op::LE: {
+        // Pop two values, push 1 if a <cmp> b, else 0
+        // Stack: [a, b] → [a<cmp>b ? 1 : 0]
         int b = pop();
         int a = pop();
-        push(a != b ? 1 : 0);
+        bool result;
+        if (instruction.op == Op::EQ) result = a == b;
+        else if (instruction.op == Op::NE) result = a != b;
+        else if (instruction.op == Op::GT) result = a > b;
+        else if (instruction.op == Op::LT) result = a < b;
+        else if (instruction.op == Op::GE) result = a >= b;
+        else result = a <= b;
+        push(result ? 1 : 0);
         pc++;
+        break;
     }
-    
+
     // ========================================================================
     // CONTROL FLOW
     // ========================================================================
-    
-    else if (opcode == "JMP") {
+
+    case Op::JMP:
         // JMP <label> - Unconditional jump to label
-        // Example: "JMP loop" → pc = labels["loop"]
-        if (parts.size() < 2) {
-            std::cerr << "ERROR: JMP requires label name at PC=" << pc << std::endl;
-            pc++;
-            return;
-        }
-        std::string label = parts[1];
-        
-        if (labels.find(label) == labels.end()) {
-            std::cerr << "ERROR: Label '" << label << "' not found at PC=" << pc << std::endl;
-            pc++;
-            return;
-        }
-        
-        pc = labels[label];  // Jump to label (don't increment pc)
-    }
-    
-    else if (opcode == "JZ") {
+        // Example: "JMP loop" → pc = pc of "loop:"
+        jump(instruction);
+        break;
+
+    case Op::JZ:
         // JZ <label> - Jump if zero
         // Pop value, if it's 0, jump to label; otherwise continue
-        if (parts.size() < 2) {
-            std::cerr << "ERROR: JZ requires label name at PC=" << pc << std::endl;
-            pc++;
-            return;
+        if (pop() == 0) jump(instruction); else pc++;
+        break;
+
+    case Op::JNZ:
+        // JNZ <label> - Jump if not zero
+        // Pop value, if it's NOT 0, jump to label; otherwise continue
+        if (pop() != 0) jump(instruction); else pc++;
+        break;
+
+    case Op::JMPTABLE: {
+        // JMPTABLE <min> <default> <label0> <label1> ... - Indexed jump
+        // Pop value; jump to label[value - min] if in range, else to default.
+        // One dispatch regardless of how many targets the table has.
+        long long index = (long long)pop() - instruction.a;
+        if (index >= 0 && index < instruction.c) {
+            jumpTo(program_.tables[instruction.b + index]);
+        } else {
+            jump(instruction);
         }
-        std::string label = parts[1];
-        int value = pop();
-        
-        if (value == 0) {
-            if (labels.find(label) == labels.end()) {
-                std::cerr << "ERROR: Label '" << label << "' not found at PC=" << pc << std::endl;
-                pc++;
-            } else {
-                pc = labels[label];
-            }
+        break;
+    }
+
+    case Op::FORPREP:
+    case Op::FORLOOP: {
+        // FORPREP <var> <limit> <step> <end>  - Skip the loop if it runs 0 times
+        // FORLOOP <var> <limit> <step> <body> - var += step; loop back while in range
+        //
+        // <limit> and <step> are immediates or variable names. The bound is
+        // inclusive: var <= limit for a positive step, var >= limit otherwise.
+        // FORLOOP replaces the LOAD/PUSH/ADD/STORE/LOAD/LOAD/LT/JZ/JMP of a
+        // hand-written counted LOOP with a single dispatch.
+        int limit = operandValue(instruction.b, instruction.names & Instruction::LIMIT_NAME);
+        int step = operandValue(instruction.c, instruction.names & Instruction::STEP_NAME);
+        if (step == 0) {
+            std::cerr << "ERROR: FOR step is 0 at PC=" << pc << std::endl;
+            if (instruction.op == Op::FORPREP) jump(instruction); else pc++;
+            break;
+        }
+
+        // 64-bit so stepping past INT_MAX ends the loop instead of wrapping
+        int& var = vars[program_.symbols[instruction.a]];
+        long long value = var;
+        if (instruction.op == Op::FORLOOP) {
+            value += step;
+            var = (int)value;
+        }
+        bool inRange = (step > 0) ? value <= limit : value >= limit;
+
+        if (instruction.op == Op::FORPREP) {
+            if (inRange) pc++; else jump(instruction);
         } else {
-            pc++;  // Continue to next instruction
+            if (inRange) jump(instruction); else pc++;
         }
+        break;
     }
-    
-    else if (opcode == "JNZ") {
-        // JNZ <label> - Jump if not zero
-        // Pop value, if it's NOT 0, jump to label; otherwise continue
-        if (parts.size() < 2) {
-            std::cerr << "ERROR: JNZ requires label name at PC=" << pc << std::endl;
-            pc++;
-            return;
+
+    // ========================================================================
+    // SUPERINSTRUCTIONS (picked by the compiler from a profile)
+    // ========================================================================
+
+    case Op::INC: {
+        // INC <var> <n> - var += n, one dispatch for LOAD / PUSH / ADD / STORE
+        const std::string& var_name = program_.symbols[instruction.a];
+        auto it = vars.find(var_name);
+        int value = 0;
+        if (it == vars.end()) {
+            std::cerr << "WARNING: Variable '" << var_name << "' not found, using 0 at PC=" << pc << std::endl;
+        } else {
+            value = it->second;
         }
-        std::string label = parts[1];
-        int value = pop();
-        
-        if (value != 0) {
-            if (labels.find(label) == labels.end()) {
-                std::cerr << "ERROR: Label '" << label << "' not found at PC=" << pc << std::endl;
-                pc++;
-            } else {
-                pc = labels[label];
-            }
+        vars[var_name] = (int)((unsigned int)value + (unsigned int)instruction.b);
+        pc++;
+        break;
+    }
+
+    case Op::INCLOCAL: {
+        // INCLOCAL <k> <n> - Local slot K += n
+        int base = callstack.empty() ? 0 : callstack.back().prev_stack_size + callstack.back().arg_count;
+        int position = base + instruction.a;
+        if (position < (int)stack.size()) {
+            stack[position] = (int)((unsigned int)stack[position] + (unsigned int)instruction.b);
         } else {
-            pc++;  // Continue to next instruction
+            std::cerr << "WARNING: Local slot out of bounds at PC=" << pc << std::endl;
         }
+        pc++;
+        break;
     }
-    
+
+    case Op::JEQ:
+    case Op::JNE:
+    case Op::JLT:
+    case Op::JGT:
+    case Op::JLE:
+    case Op::JGE: {
+        // J<cmp> <label> - Pop b and a, jump if a <cmp> b (a comparison
+        // followed by JNZ, or the opposite comparison followed by JZ)
+        int b = pop();
+        int a = pop();
+        bool taken;
+        if (instruction.op == Op::JEQ) taken = a == b;
+        else if (instruction.op == Op::JNE) taken = a != b;
+        else if (instruction.op == Op::JLT) taken = a < b;
+        else if (instruction.op == Op::JGT) taken = a > b;
+        else if (instruction.op == Op::JLE) taken = a <= b;
+        else taken = a >= b;
+        if (taken) jump(instruction); else pc++;
+        break;
+    }
+
+    // ========================================================================
+    // PROFILING (instrumented builds only)
+    // ========================================================================
+
+    case Op::PROFBR:
+        // PROFBR <site> - Count the condition on top of the stack, keep it
+        if (profiling && !stack.empty()) {
+            auto& counts = profile.branches[program_.symbols[instruction.a]];
+            if (stack.back() != 0) counts.first++; else counts.second++;
+        }
+        pc++;
+        break;
+
+    case Op::PROFLOOP:
+        // PROFLOOP <site> - Count one test of a FOR loop
+        if (profiling) {
+            profile.loops[program_.symbols[instruction.a]]++;
+        }
+        pc++;
+        break;
+
     // ========================================================================
     // FUNCTION OPERATIONS
     // ========================================================================
-    
-    else if (opcode == "CALL") {
+
+    case Op::CALL: {
         // CALL <label> <argc> - Call function with N arguments
-        // 
+        //
         // HOW FUNCTION CALLS WORK:
         //   1. Arguments are already on the stack (pushed before CALL)
         //   2. We create a Frame to remember:
@@ -454,63 +819,59 @@ void VM::execute(const std::string& instruction, std::vector<std::string>& progr
         //   LOADARG 1     ← Get second argument (20)
         //   ADD
         //   RET           ← Return (result is on stack)
-        
-        if (parts.size() < 2) {
-            std::cerr << "ERROR: CALL requires label name at PC=" << pc << std::endl;
-            pc++;
-            return;
-        }
-        
-        std::string label = parts[1];
-        int argc = 0;
-        if (parts.size() >= 3) {
-            argc = std::stoi(parts[2]);
-        }
-        
+
+        const std::string& label = program_.symbols[instruction.a];
+        int argc = instruction.b;
+
         // Calculate where arguments start on the stack
         int total_stack_size = (int)stack.size();
         int arg_start_index = total_stack_size - argc;
-        
+
         // Create frame to remember call context
         Frame frame;
         frame.return_pc = pc + 1;        // Where to return to
         frame.prev_stack_size = arg_start_index;  // Stack size before arguments
         frame.arg_count = argc;          // Number of arguments
-        
-        // Check if this is a built-in function
-        if (runtime.isBuiltin(label)) {
+
+        // Check if this is a built-in function (decided by load())
+        if (instruction.target == Instruction::BUILTIN) {
             // Built-in function: call runtime directly
             // Arguments are already on the stack
-            std::vector<int> args;
-            for (int i = 0; i < argc; i++) {
-                int arg = pop();
-                args.insert(args.begin(), arg);  // Insert at beginning to maintain order
+            std::vector<int> args(argc);
+            for (int i = argc - 1; i >= 0; i--) {
+                args[i] = pop();
             }
-            
-            // Call built-in function
-            int result = runtime.call(label, args);
-            
-            // Push result onto stack
-            push(result);
-            
+
+            // Call built-in function and push its result
+            push(runtime.call(label, args));
+
             pc++;
         } else {
             // User-defined function: use call stack
             callstack.push_back(frame);
-            
+            if (profiling) profile.calls[label]++;
+
             // Jump to function
-            if (labels.find(label) == labels.end()) {
+            if (instruction.target < 0) {
                 std::cerr << "ERROR: Label '" << label << "' not found at PC=" << pc << std::endl;
                 pc++;
             } else {
-                pc = labels[label];
+                pc = instruction.target;
             }
         }
+        break;
     }
-    
-    else if (opcode == "LOADARG") {
+
+    case Op::LOADARGU:
+        // LOADARGU <n> - LOADARG without the checks: the compiler proved
+        // that every caller passes more than N arguments
+        push(stack[callstack.back().prev_stack_size + instruction.a]);
+        pc++;
+        break;
+
+    case Op::LOADARG: {
         // LOADARG <n> - Load function argument N (0-indexed)
-        // 
+        //
         // HOW IT WORKS:
         //   - Arguments are on the stack before the function was called
         //   - We use the Frame to find where they are
@@ -520,37 +881,30 @@ void VM::execute(const std::string& instruction, std::vector<std::string>& progr
         // Example: If add(10, 20) was called:
         //   - LOADARG 0 → pushes 10
         //   - LOADARG 1 → pushes 20
-        
-        if (parts.size() < 2) {
-            std::cerr << "ERROR: LOADARG requires argument index at PC=" << pc << std::endl;
-            push(0);
-            pc++;
-            return;
-        }
-        
-        int arg_index = std::stoi(parts[1]);
-        
+
+        int arg_index = instruction.a;
+
         if (callstack.empty()) {
             // Not in a function call - return 0
             std::cerr << "WARNING: LOADARG called outside function at PC=" << pc << std::endl;
             push(0);
             pc++;
-            return;
+            break;
         }
-        
+
         Frame& frame = callstack.back();
-        
+
         // Check if argument index is valid
         if (arg_index < 0 || arg_index >= frame.arg_count) {
             std::cerr << "WARNING: Invalid argument index " << arg_index << " at PC=" << pc << std::endl;
             push(0);
             pc++;
-            return;
+            break;
         }
-        
+
         // Calculate where this argument is in the stack
         // Arguments are stored at positions: prev_stack_size + arg_index
-        // 
+        //
         // Example: If stack was [10, 20] and we CALL with 2 args:
         //   - prev_stack_size = 0 (arguments start at index 0)
         //   - LOADARG 0 → stack[0 + 0] = stack[0] = 10
@@ -559,9 +913,9 @@ void VM::execute(const std::string& instruction, std::vector<std::string>& progr
         // Even if the stack grows during function execution, the original
         // argument positions remain valid because RET will resize the stack
         // back to prev_stack_size, removing everything added during the function.
-        
+
         int arg_position = frame.prev_stack_size + arg_index;
-        
+
         if (arg_position < (int)stack.size()) {
             push(stack[arg_position]);
         } else {
@@ -569,11 +923,38 @@ void VM::execute(const std::string& instruction, std::vector<std::string>& progr
             push(0);
         }
         pc++;
+        break;
     }
-    
-    else if (opcode == "RET") {
+
+    case Op::STOREARG: {
+        // STOREARG <n> - Pop value, overwrite function argument N
+        // Stack: [..., value] → [...]
+        int arg_index = instruction.a;
+        int value = pop();
+
+        if (callstack.empty() || arg_index < 0 || arg_index >= callstack.back().arg_count) {
+            std::cerr << "WARNING: Invalid argument index " << arg_index << " at PC=" << pc << std::endl;
+            pc++;
+            break;
+        }
+
+        stack[callstack.back().prev_stack_size + arg_index] = value;
+        pc++;
+        break;
+    }
+
+    case Op::ENTER:
+        // ENTER <n> - Reserve N local slots (zeroed) above the arguments
+        // Stack: [args...] → [args..., 0, 0, ...]
+        for (int i = 0; i < instruction.a; i++) {
+            push(0);
+        }
+        pc++;
+        break;
+
+    case Op::RET: {
         // RET - Return from function
-        // 
+        //
         // HOW IT WORKS:
         //   1. Pop the return value (if any) from stack
         //   2. Restore the stack to its size before the function call
@@ -587,39 +968,140 @@ void VM::execute(const std::string& instruction, std::vector<std::string>& progr
         //   LOADARG 1
         //   ADD        ← Result is on stack
         //   RET        ← Return with result
-        
+
         if (callstack.empty()) {
             // No function to return from - stop execution
-            pc = (int)program.size();
-            return;
+            pc = codeSize_;
+            break;
         }
-        
+
         // Get return value (if stack has something)
         int return_value = 0;
         if (!stack.empty()) {
             return_value = pop();
         }
-        
+
         // Get frame and remove it
         Frame frame = callstack.back();
         callstack.pop_back();
-        
+
         // Restore stack to size before function call
         // Remove everything that was added during the function
         stack.resize(frame.prev_stack_size);
-        
+
         // Push return value back
         push(return_value);
-        
+
         // Return to caller
         pc = frame.return_pc;
+        break;
+    }
+
+    case Op::MEMOGET: {
+        // MEMOGET <scene> - First instruction of a memoized SCENE: if it
+        // was called with these arguments before, return that result now
+        Frame& frame = callstack.back();
+        int value;
+        if (frame.arg_count <= MemoCache::MAX_ARGS &&
+            memo.lookup(instruction.a, stack.data() + frame.prev_stack_size, frame.arg_count, value,
+                        frame.memo)) {
+            stats.memoHits++;
+            stack.resize(frame.prev_stack_size);
+            push(value);
+            pc = frame.return_pc;
+            callstack.pop_back();
+            break;
+        }
+        stats.memoMisses++;
+        pc++;
+        break;
     }
-    
+
+    case Op::MEMOPUT:
+        // MEMOPUT <scene> - Before RET: remember the result on top of the stack
+        memo.store(callstack.back().memo, instruction.a, stack.back());
+        pc++;
+        break;
+
+    case Op::COMPILE: {
+        // COMPILE <scene> - First CALL of a SCENE compiled lazily: the
+        // compiler appends its body to the program, and this instruction
+        // becomes a JMP there for the calls that still come here. The
+        // code moves, so `instruction` is not used after this point.
+        std::string scene = program_.symbols[instruction.a];
+        int stub = pc;
+        int size = (int)program_.code.size();
+        if (code_ != program_.code.data() || !compileScene) {
+            throw std::runtime_error("SCENE '" + scene + "' was not compiled");
+        }
+        int entry = compileScene(scene, program_);
+        code_ = program_.code.data();
+        codeSize_ = (int)program_.code.size();
+        if (entry < 0) {
+            throw std::runtime_error("SCENE '" + scene + "' does not compile");
+        }
+        for (int at = size; at < codeSize_; at++) {
+            Instruction& added = program_.code[at];
+            if (added.op == Op::CALL && runtime.isBuiltin(program_.symbols[added.a])) {
+                added.target = Instruction::BUILTIN;
+            }
+        }
+        program_.code[stub] = {Op::JMP, 0, false, 0, 0, 0, program_.namedLabel(scene), entry};
+        pc = entry;
+        break;
+    }
+
+    // ========================================================================
+    // OBJECT OPERATIONS
+    // ========================================================================
+
+    case Op::NEWOBJ:
+        // NEWOBJ - Allocate an empty object and push its handle
+        push(heap.allocate());
+        pc++;
+        break;
+
+    case Op::GETPROP: {
+        // GETPROP <name> <site> - Pop object, push its property
+        // Stack: [obj] -> [obj.name]
+        const std::string& name = program_.symbols[instruction.a];
+        int handle = pop();
+        int value = 0;
+        bool hit = false;
+        if (!heap.getProperty(handle, name, cacheForSite(instruction.b), value, hit)) {
+            std::cerr << "WARNING: Property '" << name << "' not found, using 0 at PC=" << pc << std::endl;
+            value = 0;
+        }
+        if (hit) stats.inlineCacheHits++; else stats.inlineCacheMisses++;
+        push(value);
+        pc++;
+        break;
+    }
+
+    case Op::SETPROP:
+    case Op::INITPROP: {
+        // SETPROP <name> <site>  - Stack: [obj, value] -> []
+        // INITPROP <name> <site> - Stack: [obj, value] -> [obj] (object literals)
+        int value = pop();
+        int handle = pop();
+        bool hit = false;
+        if (!heap.setProperty(handle, program_.symbols[instruction.a], value, cacheForSite(instruction.b), hit)) {
+            std::cerr << "ERROR: " << Bytecode::opName(instruction.op) << " on invalid object " << handle
+                      << " at PC=" << pc << std::endl;
+        }
+        if (hit) stats.inlineCacheHits++; else stats.inlineCacheMisses++;
+        if (instruction.op == Op::INITPROP) {
+            push(handle);
+        }
+        pc++;
+        break;
+    }
+
     // ========================================================================
     // I/O OPERATIONS
     // ========================================================================
-    
-    else if (opcode == "PRINT") {
+
+    case Op::PRINT:
         // PRINT - Print top stack value to console
         if (stack.empty()) {
             std::cout << "[EMPTY_STACK]" << std::endl;
@@ -627,50 +1109,86 @@ void VM::execute(const std::string& instruction, std::vector<std::string>& progr
             std::cout << stack.back() << std::endl;
         }
         pc++;
-    }
-    
+        break;
+
+    case Op::FPRINT:
+    case Op::XPRINT:
+        // FPRINT / XPRINT - Print top stack value as a float / 16.16 fixed
+        if (stack.empty()) {
+            std::cout << "[EMPTY_STACK]" << std::endl;
+        } else if (instruction.op == Op::FPRINT) {
+            std::cout << asFloat(stack.back()) << std::endl;
+        } else {
+            std::cout << (double)stack.back() / FIXED_ONE << std::endl;
+        }
+        pc++;
+        break;
+
     // ========================================================================
     // UNKNOWN INSTRUCTION
     // ========================================================================
-    
-    else {
-        std::cerr << "WARNING: Unknown instruction '" << opcode << "' at PC=" << pc << std::endl;
+
+    default:
+        std::cerr << "WARNING: Unknown instruction '" << disassembleAt(instruction) << "' at PC=" << pc << std::endl;
         pc++;  // Skip unknown instruction
+        break;
     }
 }
 
+// Text of an instruction for trace and error output
+std::string VM::disassembleAt(const Instruction& instruction) const {
+    return program_.disassemble(instruction);
+}
+
 // ============================================================================
 // PROGRAM EXECUTION
 // ============================================================================
 
 /**
  * Run a complete program.
- * 
+ *
  * HOW IT WORKS:
- *   1. Preprocess to build label map
+ *   1. Load the program
  *   2. Reset VM state
  *   3. Execute instructions one by one until program ends
- * 
+ *
  * The program ends when:
- *   - pc >= program.size() (reached end)
+ *   - pc >= program size (reached end)
  *   - RET is called with empty callstack (main function returned)
  */
-void VM::run(std::vector<std::string> program) {
-    // Step 1: Build label map
-    preprocess(program);
-    
+void VM::run(const Bytecode& program) {
+    // Step 1: Load (labels were resolved when the program was built)
+    load(program);
+    start();
+}
+
+void VM::run(const BytecodeFile& file) {
+    load(file);
+    start();
+}
+
+void VM::start() {
     // Step 2: Reset VM state
     pc = 0;
     stack.clear();
     vars.clear();
     callstack.clear();
-    
+    heap.clear();
+    inlineCaches.clear();
+    memo.clear();
+    stats = VMStats();
+    profile = VMProfile();
+
     // Step 3: Execute instructions
-    while (pc < (int)program.size()) {
-        execute(program[pc], program);
+    while (pc < codeSize_) {
+        execute(code_[pc]);
     }
 }
 
+void VM::run(const std::vector<std::string>& program) {
+    run(Bytecode::assemble(program));
+}
+
 // ============================================================================
 // DEBUGGING UTILITIES
 // ============================================================================
@@ -691,11 +1209,36 @@ void VM::printVars() const {
     }
 }
 
+void VM::printStats() const {
+    long long lookups = stats.inlineCacheHits + stats.inlineCacheMisses;
+    std::cout << "VM statistics:" << std::endl;
+    std::cout << "  instructions executed: " << stats.instructions << std::endl;
+    std::cout << "  inline cache hits:     " << stats.inlineCacheHits << std::endl;
+    std::cout << "  inline cache misses:   " << stats.inlineCacheMisses << std::endl;
+    if (lookups > 0) {
+        std::cout << "  inline cache hit rate: "
+                  << (100.0 * stats.inlineCacheHits / lookups) << "%" << std::endl;
+    }
+    if (stats.memoHits + stats.memoMisses > 0) {
+        std::cout << "  memo hits / misses:    " << stats.memoHits << " / " << stats.memoMisses
+                  << std::endl;
+    }
+    std::cout << "  stack high-water mark: " << stats.stackHighWater << std::endl;
+    std::cout << "  objects / shapes:      " << heap.objectCount() << " / "
+              << heap.shapeCount() << std::endl;
+}
+
 void VM::reset() {
     pc = 0;
     stack.clear();
     vars.clear();
-    labels.clear();
+    program_ = Bytecode();
+    code_ = nullptr;
+    codeSize_ = 0;
     callstack.clear();
+    heap.clear();
+    inlineCaches.clear();
+    memo.clear();
+    stats = VMStats();
+    profile = VMProfile();
 }
-
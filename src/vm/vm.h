@@ -10,13 +10,41 @@
 #include <string>
 #include <unordered_map>
 #include <iostream>
+#include <functional>
 #include "../runtime/runtime.h"
+#include "object.h"
+#include "memo_cache.h"
+#include "bytecode.h"
+#include "bytecode_file.h"
 
 // Call frame for function calls
 struct Frame {
     int return_pc;
     int prev_stack_size;
     int arg_count;
+    MemoCache::Ticket memo = {-1, 0};  // Slot claimed by a missed MEMOGET
+};
+
+// Execution counters (reported by `cinebrew --stats`)
+struct VMStats {
+    long long instructions;       // Instructions executed (labels excluded)
+    long long inlineCacheHits;    // GETPROP/SETPROP resolved from the site cache
+    long long inlineCacheMisses;  // GETPROP/SETPROP that fell back to a shape lookup
+    long long memoHits;           // MEMOGET that returned a remembered result
+    long long memoMisses;         // MEMOGET that had to run the SCENE
+    long long stackHighWater;     // Most values the stack ever held at once
+
+    VMStats() : instructions(0), inlineCacheHits(0), inlineCacheMisses(0), memoHits(0),
+                memoMisses(0), stackHighWater(0) {}
+};
+
+// What a profiling run saw (VM::profiling), keyed the way the compiler
+// refers to it: SCENE names and "line.n" sites
+struct VMProfile {
+    std::unordered_map<std::string, long long> calls;  // SCENE -> CALLs
+    std::unordered_map<std::string, std::pair<long long, long long>> branches;  // Site -> taken, not taken
+    std::unordered_map<std::string, long long> loops;  // Site -> FORLOOP tests
+    std::vector<long long> executed;                   // Per pc: times executed
 };
 
 class VM {
@@ -24,25 +52,60 @@ public:
     std::vector<int> stack;
     std::unordered_map<std::string, int> vars;
     int pc;
-    std::unordered_map<std::string, int> labels;
     std::vector<Frame> callstack;
     Runtime runtime;
+    ObjectHeap heap;
+    std::vector<InlineCache> inlineCaches;  // One per GETPROP/SETPROP site
+    MemoCache memo;                         // Results of memoized SCENEs
+    VMStats stats;
+    bool trace;  // Print a [DEBUG] line per executed instruction (on by default)
+    bool profiling;  // Fill `profile` (off by default)
+    VMProfile profile;
+
+    // Lazily compiled programs (COMPILE): appends the SCENE's linked code to
+    // the program and returns the pc of its entry, -1 if it does not compile
+    std::function<int(const std::string& scene, Bytecode& program)> compileScene;
 
     VM();
 
     void push(int value);
     int pop();
 
-    void preprocess(std::vector<std::string>& program);
-    void execute(const std::string& instruction, std::vector<std::string>& program);
-    void run(std::vector<std::string> program);
+    // Loading keeps the program without running it; run() loads and runs.
+    // A BytecodeFile is run in place: it must stay open while the VM uses it
+    void load(const Bytecode& program);
+    void load(const BytecodeFile& file);
+    void preprocess(const std::vector<std::string>& program);  // load() of assembled text
+    void run(const Bytecode& program);
+    void run(const BytecodeFile& file);
+    void run(const std::vector<std::string>& program);
+
+    // Stepping through the loaded program
+    void step();                                    // Execute the instruction at pc
+    void call(const std::string& scene, int argc);  // A CALL from outside the program
+    int findLabel(const std::string& name) const { return program_.findLabel(name); }  // -1: none
+    int programSize() const { return codeSize_; }
+    const Instruction& instructionAt(int at) const { return code_[at]; }
+    const Bytecode& program() const { return program_; }  // No code if loaded from a BytecodeFile
 
     void printStack() const;
     void printVars() const;
+    void printStats() const;
     void reset();
 
 private:
-    std::vector<std::string> split(const std::string& s);
+    Bytecode program_;
+    const Instruction* code_;  // program_.code, or the instructions of a mapped file
+    int codeSize_;
+
+    void start();
+    void execute(const Instruction& instruction);
+    std::string disassembleAt(const Instruction& instruction) const;
+    void checkStackBalance() const;
+    InlineCache& cacheForSite(int site);
+    int operandValue(int operand, bool isName);
+    void jumpTo(int label);
+    void jump(const Instruction& instruction);
 };
 
 #endif // VM_H
@@ -0,0 +1,160 @@
+/**
+ * Bytecode File Test Program
+ *
+ * Writes a compiled program as a .cbc file (what `cinebrew compile`
+ * does), maps it back and checks that it is the same program and runs
+ * the same way.
+ */
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/bytecode_file.h"
+#include "../src/vm/vm.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static const char* SOURCE =
+    "SCENE grade(x) {\n"
+    "    MATCH x {\n"
+    "        CASE 0 { SHOT 10; }\n"
+    "        CASE 1, 2 { SHOT 20; }\n"
+    "        CASE 3 { SHOT 30; }\n"
+    "        ELSE { SHOT -1; }\n"
+    "    }\n"
+    "    SHOT 0;\n"
+    "}\n"
+    "NOINLINE SCENE fact(n) {\n"
+    "    IF n < 2 { SHOT 1; }\n"
+    "    SHOT n * fact(n - 1);\n"
+    "}\n"
+    "TAKE total = 0;\n"
+    "FOR i = 0 TO 4 {\n"
+    "    total = total * 100 + grade(i);\n"
+    "}\n"
+    "TAKE result = fact(6) + 3 + random(1);\n"
+    "POUR \"done\";\n";
+
+static std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream bytes;
+    bytes << in.rdbuf();
+    return bytes.str();
+}
+
+int main() {
+    std::cout << "=== CINEBREW Bytecode File Test ===" << std::endl;
+    const std::string path = "test_bytecode_file.cbc";
+
+    CompilerOptions options;
+    Compiler compiler(options);
+    const Bytecode& compiled = compiler.compileProgram(SOURCE);
+    if (compiler.hadError()) {
+        std::cout << "❌ Compilation failed" << std::endl;
+        return 0;
+    }
+
+    // Test 1: write and map back
+    std::cout << "\n=== Test 1: Write and open ===" << std::endl;
+    std::string error;
+    BytecodeFile file;
+    if (BytecodeFile::write(compiled, path, error) && file.open(path)) {
+        std::cout << "✅ " << file.size() << " instructions mapped" << std::endl;
+    } else {
+        std::cout << "❌ " << (error.empty() ? file.getError() : error) << std::endl;
+        return 0;
+    }
+
+    // Test 1b: the same program always gives the same bytes
+    const std::string again = "test_bytecode_file_again.cbc";
+    Compiler recompiler(options);
+    if (BytecodeFile::write(recompiler.compileProgram(SOURCE), again, error) && readFile(again) == readFile(path)) {
+        std::cout << "✅ Written twice, identical files" << std::endl;
+    } else {
+        std::cout << "❌ Two writes of the same program differ" << std::endl;
+    }
+    std::remove(again.c_str());
+
+    // Test 2: same instructions, names and labels
+    std::cout << "\n=== Test 2: Same program as compileProgram() ===" << std::endl;
+    Bytecode names = file.names();
+    bool same = file.size() == (int)compiled.size();
+    for (int pc = 0; same && pc < file.size(); pc++) {
+        same = names.disassemble(file.code()[pc]) == compiled.disassemble(pc);
+    }
+    if (same && names.findLabel("fact") == compiled.findLabel("fact")) {
+        std::cout << "✅ Disassembly and SCENE labels match" << std::endl;
+    } else {
+        std::cout << "❌ Mapped program differs from compileProgram()" << std::endl;
+    }
+
+    // Test 3: built-in CALLs were resolved when the file was written
+    std::cout << "\n=== Test 3: Built-ins resolved ===" << std::endl;
+    bool resolved = false;
+    for (int pc = 0; pc < file.size(); pc++) {
+        const Instruction& instruction = file.code()[pc];
+        if (instruction.op == Op::CALL && names.symbols[instruction.a] == "random") {
+            resolved = instruction.target == Instruction::BUILTIN;
+        }
+    }
+    std::cout << (resolved ? "✅ CALL random is a built-in" : "❌ CALL random not resolved") << std::endl;
+
+    // Test 4: runs in place like the compiled program
+    std::cout << "\n=== Test 4: Run the mapped program ===" << std::endl;
+    VM direct;
+    direct.trace = false;
+    direct.run(compiled);
+    VM mapped;
+    mapped.trace = false;
+    mapped.run(file);
+    if (mapped.vars["result"] == 723 && mapped.vars["total"] == direct.vars["total"] &&
+        mapped.stats.instructions == direct.stats.instructions) {
+        std::cout << "✅ result = 723, total = " << mapped.vars["total"] << ", "
+                  << mapped.stats.instructions << " instructions" << std::endl;
+    } else {
+        std::cout << "❌ result = " << mapped.vars["result"] << ", total = " << mapped.vars["total"]
+                  << " (expected 723, " << direct.vars["total"] << ")" << std::endl;
+    }
+
+    // Test 5: files that are not (or no longer) valid are refused
+    std::cout << "\n=== Test 5: Reject bad files ===" << std::endl;
+    file.close();
+    {
+        // Header words: magic, version, instruction size, Op::COUNT, then
+        // count / offset pairs for code, symbols and labels (labelOffset is word 9)
+        std::string image = readFile(path);
+        uint32_t labelOffset;
+        std::memcpy(&labelOffset, &image[9 * sizeof(uint32_t)], sizeof(labelOffset));
+        int32_t badName = -5;
+        std::memcpy(&image[labelOffset], &badName, sizeof(badName));
+        std::ofstream out(path, std::ios::binary);
+        out << image;
+    }
+    BytecodeFile corrupt;
+    if (!corrupt.open(path)) {
+        std::cout << "✅ Negative label name refused: " << corrupt.getError() << std::endl;
+    } else {
+        std::cout << "❌ Negative label name accepted" << std::endl;
+    }
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "PUSH 1\nPRINT\n";
+    }
+    BytecodeFile text;
+    if (!text.open(path) && !text.getError().empty()) {
+        std::cout << "✅ Text bytecode refused: " << text.getError() << std::endl;
+    } else {
+        std::cout << "❌ Text bytecode accepted" << std::endl;
+    }
+    std::remove(path.c_str());
+    BytecodeFile missing;
+    if (!missing.open(path)) {
+        std::cout << "✅ Missing file refused: " << missing.getError() << std::endl;
+    } else {
+        std::cout << "❌ Missing file opened" << std::endl;
+    }
+
+    return 0;
+}
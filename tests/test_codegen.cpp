@@ -41,6 +41,63 @@ void testCompileAndRun(const std::string& source, const std::string& description
     std::cout << "----------------------------------------" << std::endl;
 }
 
+// The typed bytecode and its text form must say the same thing: assembling
+// the disassembly gives back the same instructions and jump targets
+void testDisassembly(const std::string& source, const std::string& description) {
+    std::cout << "\n=== " << description << " ===" << std::endl;
+    
+    CompilerOptions options;
+    options.optLevel = 0;
+    Compiler compiler(options);
+    const Bytecode& program = compiler.compileProgram(source);
+    if (compiler.hadError()) {
+        std::cout << "❌ Compilation failed" << std::endl;
+        return;
+    }
+    
+    std::vector<std::string> text = program.disassemble();
+    Bytecode reassembled = Bytecode::assemble(text);
+    bool same = reassembled.size() == program.size() && reassembled.disassemble() == text;
+    for (size_t pc = 0; same && pc < program.size(); pc++) {
+        same = reassembled.code[pc].op == program.code[pc].op &&
+               reassembled.code[pc].target == program.code[pc].target;
+    }
+    std::cout << (same ? "✅" : "❌") << " " << program.size()
+              << " instructions survive disassemble + assemble" << std::endl;
+}
+
+// Discarded values must be popped: ten times the iterations of a loop of
+// expression statements leaves the stack exactly as high, at every level
+void testStackBalance(const std::string& source, const std::string& description) {
+    std::cout << "\n=== " << description << " ===" << std::endl;
+    
+    for (int level = 0; level <= 2; level++) {
+        long long highWater[2];
+        size_t left[2];
+        bool compiled = true;
+        for (int run = 0; run < 2; run++) {
+            std::string program = source;
+            program.replace(program.find("$N"), 2, run == 0 ? "100" : "1000");
+            
+            CompilerOptions options;
+            options.optLevel = level;
+            Compiler compiler(options);
+            const Bytecode& bytecode = compiler.compileProgram(program);
+            compiled = compiled && !compiler.hadError();
+            
+            VM vm;
+            vm.trace = false;
+            vm.run(bytecode);
+            highWater[run] = vm.stats.stackHighWater;
+            left[run] = vm.stack.size();
+        }
+        bool flat = compiled && highWater[0] == highWater[1] && left[0] == left[1];
+        std::cout << (flat ? "✅" : "❌") << " -O" << level << ": high-water mark "
+                  << highWater[0] << " / " << highWater[1] << ", " << left[1]
+                  << " left at HALT" << std::endl;
+    }
+}
+
 int main() {
     std::cout << "========================================" << std::endl;
     std::cout << "   CINEBREW Code Generator Test" << std::endl;
@@ -109,6 +166,124 @@ int main() {
         "Test 7: Comparisons"
     );
     
+    // Test 8: Float arithmetic
+    testCompileAndRun(
+        "TAKE a = 1.5;\n"
+        "TAKE b = a * 2.0 + 1;\n"
+        "POUR b;",
+        "Test 8: Float Arithmetic (should print 4)"
+    );
+    
+    // Test 9: Fixed-point arithmetic and conversions
+    testCompileAndRun(
+        "TAKE pos = 10q;\n"
+        "pos = pos + 2.5q * 3;\n"
+        "POUR pos;\n"
+        "POUR int(pos);\n"
+        "POUR float(pos) / 2.0;",
+        "Test 9: Fixed-Point (should print 17.5, 17, 8.75)"
+    );
+    
+    // Test 10: Parameters and recursion
+    testCompileAndRun(
+        "SCENE fact(n) {\n"
+        "    IF n <= 1 { SHOT 1; }\n"
+        "    SHOT n * fact(n - 1);\n"
+        "}\n"
+        "POUR fact(5);",
+        "Test 10: Recursive Function (should print 120)"
+    );
+    
+    // Test 11: Modulo, bitwise and shift operators
+    testCompileAndRun(
+        "TAKE flags = 1 | 4;\n"
+        "POUR flags;\n"
+        "POUR 300 & 255 ^ 1;\n"
+        "POUR (1 << 4) + (64 >> 2);\n"
+        "POUR 20 % 6;",
+        "Test 11: Bitwise Operators (should print 5, 45, 32, 2)"
+    );
+    
+    // Test 12: Short-circuit logic - the right side must not run when
+    // the left side decides the result
+    testCompileAndRun(
+        "SCENE loud(v) {\n"
+        "    POUR v;\n"
+        "    SHOT v;\n"
+        "}\n"
+        "TAKE x = 5;\n"
+        "IF x > 3 AND x < 10 { POUR 100; }\n"
+        "IF x == 0 && loud(1) { POUR 999; }\n"
+        "IF x == 5 || loud(2) { POUR 200; }\n"
+        "POUR !(x >= 5) OR x != 5;",
+        "Test 12: Logical Operators (should print 100, 200, 0)"
+    );
+    
+    // Test 13: Counted loops with BREAK and CONTINUE
+    testCompileAndRun(
+        "TAKE sum = 0;\n"
+        "FOR i = 0 TO 100 {\n"
+        "    IF i == 2 { CONTINUE; }\n"
+        "    IF i > 4 { BREAK; }\n"
+        "    sum = sum + i;\n"
+        "}\n"
+        "POUR sum;\n"
+        "FOR j = 10 TO 0 STEP -5 { POUR j; }",
+        "Test 13: FOR Loop (should print 8, 10, 5, 0)"
+    );
+    
+    // Test 14: MATCH with dense values (JMPTABLE) and sparse values
+    // (decision tree)
+    testCompileAndRun(
+        "FOR s = 0 TO 3 {\n"
+        "    MATCH s {\n"
+        "        CASE 0 { POUR 10; }\n"
+        "        CASE 1, 2 { POUR 20; }\n"
+        "        ELSE { POUR 99; }\n"
+        "    }\n"
+        "}\n"
+        "MATCH 5000 {\n"
+        "    CASE 1 { POUR 1; }\n"
+        "    CASE 40 { POUR 40; }\n"
+        "    CASE 5000 { POUR 5000; }\n"
+        "    CASE 90000 { POUR 90000; }\n"
+        "}",
+        "Test 14: MATCH (should print 10, 20, 20, 99, 5000)"
+    );
+    
+    // Test 15: Round trip through the text form (string literals that
+    // look like labels or numbers are quoted)
+    testDisassembly(
+        "SCENE add(a, b) { SHOT a + b; }\n"
+        "TAKE f = 1.5;\n"
+        "POUR \"Total:\";\n"
+        "POUR \"42 cups\";\n"
+        "FOR i = 0 TO 3 {\n"
+        "    MATCH i {\n"
+        "        CASE 0 { POUR add(i, 1); }\n"
+        "        CASE 1, 2 { CONTINUE; }\n"
+        "        ELSE { BREAK; }\n"
+        "    }\n"
+        "}",
+        "Test 15: Disassembly Round Trip"
+    );
+    
+    // Test 16: Expression statements inside a loop (should print 1000)
+    testStackBalance(
+        "SCENE tick(n) {\n"
+        "    abs(n);\n"
+        "    SHOT n + 1;\n"
+        "}\n"
+        "TAKE t = 0;\n"
+        "FOR i = 1 TO $N {\n"
+        "    tick(i);\n"
+        "    min(i, 3);\n"
+        "    t = tick(t);\n"
+        "}\n"
+        "POUR t;",
+        "Test 16: Stack Balance (should print 100, 1000 at each level)"
+    );
+    
     std::cout << "\n========================================" << std::endl;
     std::cout << "All tests completed!" << std::endl;
     std::cout << "========================================" << std::endl;
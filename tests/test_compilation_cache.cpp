@@ -0,0 +1,106 @@
+/**
+ * Compilation Cache Test Program
+ *
+ * Compiles through a CompilationCache in a scratch directory: hits,
+ * misses, keys, least-recently-used eviction and stored-key checks.
+ */
+
+#include "../src/compiler/compiler.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+static int entryCount(const fs::path& directory) {
+    int count = 0;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        if (entry.path().extension() == ".cbc") count++;
+    }
+    return count;
+}
+
+int main() {
+    std::cout << "=== CINEBREW Compilation Cache Test ===" << std::endl;
+    fs::path directory = fs::temp_directory_path() / "cinebrew_cache_test";
+    fs::remove_all(directory);
+
+    const std::string source = "SCENE sq(x) { SHOT x * x; }\nTAKE a = sq(7);\nPOUR a;\n";
+    CompilationCache cache(directory.string());
+    CompilerOptions options;
+    options.cache = &cache;
+
+    // Test 1: the first compile misses and stores, the second hits
+    std::cout << "\n=== Test 1: Miss, then hit ===" << std::endl;
+    Compiler first(options);
+    std::vector<std::string> compiled = first.compile(source);
+    Compiler second(options);
+    std::vector<std::string> cached = second.compile(source);
+    if (cache.misses() == 1 && cache.hits() == 1 && second.getStats().fromCache && cached == compiled) {
+        std::cout << "✅ 1 miss, 1 hit, same " << cached.size() << " instructions" << std::endl;
+    } else {
+        std::cout << "❌ " << cache.misses() << " misses, " << cache.hits() << " hits" << std::endl;
+    }
+
+    // Test 2: the options are part of the key
+    std::cout << "\n=== Test 2: Another -O level is another entry ===" << std::endl;
+    CompilerOptions o0 = options;
+    o0.optLevel = 0;
+    Compiler third(o0);
+    third.compile(source);
+    if (cache.misses() == 2 && !third.getStats().fromCache && entryCount(directory) == 2) {
+        std::cout << "✅ -O0 compiled again, 2 entries" << std::endl;
+    } else {
+        std::cout << "❌ -O0 shared the -O2 entry" << std::endl;
+    }
+
+    // Test 3: errors are reported every time, never cached
+    std::cout << "\n=== Test 3: Failed compiles are not stored ===" << std::endl;
+    Compiler broken(options);
+    broken.compile("TAKE = ;");
+    broken.compile("TAKE = ;");
+    if (broken.hadError() && cache.misses() == 4 && entryCount(directory) == 2) {
+        std::cout << "✅ Both compiles reported the error" << std::endl;
+    } else {
+        std::cout << "❌ Failed compile was cached" << std::endl;
+    }
+
+    // Test 4: over the limit, the least recently used entries go first
+    std::cout << "\n=== Test 4: LRU eviction ===" << std::endl;
+    fs::remove_all(directory);
+    CompilationCache unbounded(directory.string());
+    Bytecode program = Compiler().compileProgram("TAKE x = 1;");
+    fs::path a = directory / (CompilationCache::hash("a") + ".cbc");
+    fs::path b = directory / (CompilationCache::hash("b") + ".cbc");
+    fs::path c = directory / (CompilationCache::hash("c") + ".cbc");
+    unbounded.store("a", program);
+    unbounded.store("b", program);
+    auto now = fs::file_time_type::clock::now();
+    fs::last_write_time(a, now - std::chrono::seconds(100));
+    fs::last_write_time(b, now - std::chrono::seconds(50));
+    Bytecode loaded;
+    unbounded.load("a", loaded);  // a is now the most recently used
+
+    CompilationCache bounded(directory.string(), (long long)(fs::file_size(a) + fs::file_size(b)));
+    bounded.store("c", program);
+    if (bounded.evictions() == 1 && fs::exists(a) && !fs::exists(b) && fs::exists(c)) {
+        std::cout << "✅ b evicted, a (just used) and c kept" << std::endl;
+    } else {
+        std::cout << "❌ Wrong entries evicted (" << bounded.evictions() << ")" << std::endl;
+    }
+
+    // Test 5: an entry is only used for the key it was stored with (as if
+    // two keys had the same hash)
+    std::cout << "\n=== Test 5: Stored key is checked ===" << std::endl;
+    fs::path z = directory / (CompilationCache::hash("z") + ".cbc");
+    fs::copy_file(a, z, fs::copy_options::overwrite_existing);
+    CompilationCache checked(directory.string());
+    if (!checked.load("z", loaded) && checked.misses() == 1 && checked.load("a", loaded)) {
+        std::cout << "✅ a's entry under z's name is a miss" << std::endl;
+    } else {
+        std::cout << "❌ Entry loaded for another key" << std::endl;
+    }
+
+    fs::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,61 @@
+/**
+ * Embedded Script Test Program
+ *
+ * examples/factorial.cb is compiled at -O0 while this test is built
+ * (cinebrew_embed_script in CMakeLists.txt, -O0 keeps the SCENE); the
+ * test loads the constant arrays and checks them against compiling the
+ * script at run time.
+ */
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/vm.h"
+#include "factorial.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// The arrays are constant expressions: nothing runs before main()
+static_assert(factorial::program.codeSize > 0, "embedded program is empty");
+static_assert(factorial::code[factorial::program.codeSize - 1].op == Op::LABEL, "program ends in HALT:");
+
+int main() {
+    std::cout << "=== CINEBREW Embedded Script Test ===" << std::endl;
+
+    std::ifstream file(EMBED_SCRIPT);
+    std::stringstream source;
+    source << file.rdbuf();
+
+    // Test 1: the same instructions as compiling the script now
+    std::cout << "\n=== Test 1: Embedded bytecode matches the compiler ===" << std::endl;
+    Bytecode embedded = Bytecode::fromEmbedded(factorial::program);
+    CompilerOptions options;
+    options.optLevel = 0;
+    Compiler compiler(options);
+    const Bytecode& compiled = compiler.compileProgram(source.str());
+    if (!compiler.hadError() && embedded.disassemble() == compiled.disassemble()) {
+        std::cout << "✅ " << embedded.size() << " instructions, same as compileProgram()" << std::endl;
+    } else {
+        std::cout << "❌ Embedded bytecode differs from compileProgram()" << std::endl;
+    }
+
+    // Test 2: symbol and label lookups work without the compiler
+    std::cout << "\n=== Test 2: SCENE labels resolve ===" << std::endl;
+    if (embedded.findLabel("factorial") >= 0 && embedded.findLabel("factorial") == compiled.findLabel("factorial")) {
+        std::cout << "✅ factorial: at pc " << embedded.findLabel("factorial") << std::endl;
+    } else {
+        std::cout << "❌ factorial: not found" << std::endl;
+    }
+
+    // Test 3: it runs
+    std::cout << "\n=== Test 3: Run the embedded program ===" << std::endl;
+    VM vm;
+    vm.trace = false;
+    vm.run(embedded);
+    if (vm.vars["result"] == 120) {
+        std::cout << "✅ result = 120" << std::endl;
+    } else {
+        std::cout << "❌ result = " << vm.vars["result"] << " (expected 120)" << std::endl;
+    }
+
+    return 0;
+}
@@ -81,7 +81,7 @@ SCENE render() {
     std::cout << "----------------------------------------" << std::endl;
     
     // Create and run game loop
-    GameLoop gameLoop(vm, bytecode);
+    GameLoop gameLoop(vm);
     gameLoop.setTargetFPS(10);  // 10 FPS for testing (slower)
     gameLoop.run();
     
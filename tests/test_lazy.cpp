@@ -0,0 +1,148 @@
+/**
+ * Lazy Compilation Test Program
+ *
+ * Runs programs compiled with CompilerOptions::lazy: SCENEs stay COMPILE
+ * stubs until called, and the run matches the one of an eager -O0 build.
+ */
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/vm.h"
+#include <iostream>
+
+static const char* SOURCE =
+    "CONST K = 3;\n"
+    "TAKE total = 0;\n"
+    "SCENE never(x) { SHOT x * K; }\n"
+    "SCENE fact(n) {\n"
+    "    IF n < 2 { SHOT 1; }\n"
+    "    SHOT n * fact(n - 1);\n"
+    "}\n"
+    "SCENE count(n) {\n"
+    "    FOR j = 1 TO n { total = total + j * K; }\n"
+    "    SHOT total;\n"
+    "}\n"
+    "SCENE keep(x) {\n"
+    "    TAKE kept = x;\n"
+    "    SHOT kept;\n"
+    "}\n"
+    "TAKE f = fact(6);\n"
+    "TAKE c = count(4) + count(2);\n"
+    "TAKE r = random(1) + keep(5);\n"
+    "TAKE last = j;\n";
+
+// Runs SOURCE compiled by `compiler`; lazy SCENEs are compiled by it
+static void run(Compiler& compiler, VM& vm) {
+    vm.trace = false;
+    vm.compileScene = [&compiler](const std::string& scene, Bytecode& program) {
+        return compiler.compileScene(scene, program);
+    };
+    vm.run(compiler.compileProgram(SOURCE));
+}
+
+static int stubs(const VM& vm) {
+    int count = 0;
+    for (int pc = 0; pc < vm.programSize(); pc++) {
+        if (vm.instructionAt(pc).op == Op::COMPILE) count++;
+    }
+    return count;
+}
+
+int main() {
+    std::cout << "=== CINEBREW Lazy Compilation Test ===" << std::endl;
+
+    CompilerOptions eagerOptions;
+    eagerOptions.optLevel = 0;
+    CompilerOptions lazyOptions = eagerOptions;
+    lazyOptions.lazy = true;
+
+    // Test 1: only SCENEs whose body declares nothing are deferred
+    std::cout << "\n=== Test 1: Deferred SCENEs ===" << std::endl;
+    Compiler lazy(lazyOptions);
+    const Bytecode& stubbed = lazy.compileProgram(SOURCE);
+    Compiler eager(eagerOptions);
+    const Bytecode& full = eager.compileProgram(SOURCE);
+    if (!lazy.hadError() && lazy.getStats().scenesDeferred == 3 && stubbed.size() < full.size()) {
+        std::cout << "✅ 3 SCENEs deferred (keep declares a global), " << stubbed.size() << " instead of "
+                  << full.size() << " instructions" << std::endl;
+    } else {
+        std::cout << "❌ " << lazy.getStats().scenesDeferred << " SCENEs deferred" << std::endl;
+    }
+
+    // Test 2: same results as the eager build
+    std::cout << "\n=== Test 2: Same run as -O0 ===" << std::endl;
+    Compiler lazyRun(lazyOptions);
+    VM lazyVM;
+    run(lazyRun, lazyVM);
+    Compiler eagerRun(eagerOptions);
+    VM eagerVM;
+    run(eagerRun, eagerVM);
+    bool same = true;
+    for (const char* name : {"f", "c", "r", "last", "total"}) {
+        same = same && lazyVM.vars[name] == eagerVM.vars[name];
+    }
+    if (same && lazyVM.vars["f"] == 720 && lazyVM.vars["c"] == 69) {
+        std::cout << "✅ f = 720, c = 69, r = " << lazyVM.vars["r"] << ", last = " << lazyVM.vars["last"]
+                  << std::endl;
+    } else {
+        std::cout << "❌ f = " << lazyVM.vars["f"] << ", c = " << lazyVM.vars["c"] << " (expected 720, 69)"
+                  << std::endl;
+    }
+
+    // Test 3: compiled once each, the uncalled SCENE never
+    std::cout << "\n=== Test 3: Compiled on the first call only ===" << std::endl;
+    if (lazyRun.getStats().scenesCompiled == 2 && stubs(lazyVM) == 1) {
+        std::cout << "✅ fact and count compiled once, never still a COMPILE stub" << std::endl;
+    } else {
+        std::cout << "❌ " << lazyRun.getStats().scenesCompiled << " compiled, " << stubs(lazyVM)
+                  << " stubs left" << std::endl;
+    }
+
+    // Test 4: errors in a deferred body show up when it is called
+    std::cout << "\n=== Test 4: Errors on the first call ===" << std::endl;
+    Compiler broken(lazyOptions);
+    VM brokenVM;
+    brokenVM.trace = false;
+    brokenVM.compileScene = [&broken](const std::string& scene, Bytecode& program) {
+        return broken.compileScene(scene, program);
+    };
+    const Bytecode& program = broken.compileProgram("SCENE bad(x) { SHOT x + oops; }\nTAKE a = 1;\nTAKE b = bad(a);\n");
+    bool compiled = !broken.hadError();
+    bool threw = false;
+    try {
+        brokenVM.run(program);
+    } catch (const std::exception&) {
+        threw = true;
+    }
+    if (compiled && threw && broken.hadError() && brokenVM.vars["a"] == 1) {
+        std::cout << "✅ Compiled, ran until the call: " << broken.getErrors().front() << std::endl;
+    } else {
+        std::cout << "❌ Error in the deferred SCENE not reported at its call" << std::endl;
+    }
+
+    // Test 5: a deferred body sees the globals declared before its SCENE only
+    std::cout << "\n=== Test 5: Globals declared after the SCENE ===" << std::endl;
+    const char* late = "SCENE f() { SHOT x; }\nPOUR f();\nTAKE x = 5;\nPOUR f();\n";
+    Compiler rejected(eagerOptions);
+    rejected.compileProgram(late);
+    Compiler deferred(lazyOptions);
+    VM deferredVM;
+    deferredVM.trace = false;
+    deferredVM.compileScene = [&deferred](const std::string& scene, Bytecode& program) {
+        return deferred.compileScene(scene, program);
+    };
+    threw = false;
+    try {
+        deferredVM.run(deferred.compileProgram(late));
+    } catch (const std::exception&) {
+        threw = true;
+    }
+    if (rejected.hadError() && threw && deferred.hadError() &&
+        deferred.getErrors().front() == rejected.getErrors().front()) {
+        std::cout << "✅ Rejected at the call, as by the eager build: " << deferred.getErrors().front()
+                  << std::endl;
+    } else {
+        std::cout << "❌ Deferred SCENE sees a global declared after it" << std::endl;
+    }
+
+    return 0;
+}
@@ -121,6 +121,14 @@ int main() {
         "Test 11: Illegal Identifier (should error)"
     );
     
+    // Test 12: Float and fixed-point literals
+    testLexer(
+        "TAKE speed = 2.5;\n"
+        "TAKE pos = 1.25q;\n"
+        "TAKE step = 3q;",
+        "Test 12: Float and Fixed Literals"
+    );
+    
     std::cout << "\n========================================" << std::endl;
     std::cout << "All tests completed!" << std::endl;
     std::cout << "========================================" << std::endl;
@@ -0,0 +1,108 @@
+/**
+ * Object Model Test Program
+ *
+ * Tests dynamic objects, shared shapes and inline-cache counters.
+ */
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/vm.h"
+#include <iostream>
+
+void testObjects(const std::string& source, const std::string& description,
+                 long long expectedHits, long long expectedMisses) {
+    std::cout << "\n=== " << description << " ===" << std::endl;
+    std::cout << "Source code:" << std::endl;
+    std::cout << source << std::endl;
+    std::cout << std::endl;
+
+    Compiler compiler;
+    std::vector<std::string> bytecode = compiler.compile(source);
+
+    if (compiler.hadError()) {
+        std::cout << "Compilation Errors:" << std::endl;
+        for (const auto& error : compiler.getErrors()) {
+            std::cout << "  " << error << std::endl;
+        }
+        std::cout << "❌ FAILED: Expected program to compile" << std::endl;
+        return;
+    }
+
+    std::cout << "Execution:" << std::endl;
+    std::cout << "----------------------------------------" << std::endl;
+    VM vm;
+    vm.run(bytecode);
+    std::cout << "----------------------------------------" << std::endl;
+    vm.printStats();
+
+    if (vm.stats.inlineCacheHits == expectedHits &&
+        vm.stats.inlineCacheMisses == expectedMisses) {
+        std::cout << "✅ PASSED: " << expectedHits << " hits, "
+                  << expectedMisses << " misses" << std::endl;
+    } else {
+        std::cout << "❌ FAILED: Expected " << expectedHits << " hits and "
+                  << expectedMisses << " misses" << std::endl;
+    }
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "   CINEBREW Object Model Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    // Test 1: Literal fields and property reads (every site runs once)
+    testObjects(
+        "TAKE p = { x: 3, y: 4 };\n"
+        "POUR p.x + p.y;",
+        "Test 1: Object Literal (should print 7)",
+        0, 4
+    );
+
+    // Test 2: Adding fields at runtime
+    testObjects(
+        "TAKE p = {};\n"
+        "p.score = 10;\n"
+        "p.score = p.score + 5;\n"
+        "POUR p.score;",
+        "Test 2: Dynamic Fields (should print 15)",
+        0, 4
+    );
+
+    // Test 3: Monomorphic site in a loop - only the first access misses
+    testObjects(
+        "TAKE p = { x: 0 };\n"
+        "TAKE i = 0;\n"
+        "LOOP i < 10 {\n"
+        "    p.x = p.x + 1;\n"
+        "    i = i + 1;\n"
+        "}\n"
+        "POUR p.x;",
+        "Test 3: Monomorphic Inline Cache (should print 10)",
+        18, 4
+    );
+
+    // Test 4: Objects built in the same order share a shape, so one
+    // GETPROP site reading from both of them stays monomorphic
+    testObjects(
+        "TAKE a = { x: 1, y: 2 };\n"
+        "TAKE b = {};\n"
+        "b.x = 10;\n"
+        "b.y = 20;\n"
+        "TAKE cur = a;\n"
+        "TAKE i = 0;\n"
+        "TAKE sum = 0;\n"
+        "LOOP i < 4 {\n"
+        "    sum = sum + cur.y;\n"
+        "    IF cur == a { cur = b; } ELSE { cur = a; }\n"
+        "    i = i + 1;\n"
+        "}\n"
+        "POUR sum;",
+        "Test 4: Shared Shapes (should print 44)",
+        3, 5
+    );
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "All tests completed!" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,592 @@
+/**
+ * Optimizer Test Program
+ *
+ * Tests constant folding, constant propagation, CONST declarations, dead
+ * code elimination, peephole rules, the SSA IR, inlining and the loop
+ * passes, CSE, range analysis, compile-time calls, memoization,
+ * profile-guided optimization and the optimization levels: the optimized
+ * program must print the same thing and execute no more instructions.
+ */
+
+#include "../src/compiler/compiler.h"
+#include "../src/vm/vm.h"
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+// Hidden compiler globals (__match_N, ...) only exist in unoptimized code
+static std::map<std::string, int> userVars(const VM& vm) {
+    std::map<std::string, int> vars;
+    for (const auto& var : vm.vars) {
+        if (var.first.compare(0, 2, "__") != 0) vars.insert(var);
+    }
+    return vars;
+}
+
+static int countOpcode(const std::vector<std::string>& bytecode, const std::string& opcode) {
+    int count = 0;
+    for (const auto& instr : bytecode) {
+        if (instr.compare(0, opcode.size() + 1, opcode + " ") == 0) count++;
+    }
+    return count;
+}
+
+void testOptimizer(const std::string& source, const std::string& description) {
+    std::cout << "\n=== " << description << " ===" << std::endl;
+    std::cout << "Source code:" << std::endl;
+    std::cout << source << std::endl;
+    std::cout << std::endl;
+
+    CompilerOptions plain;
+    plain.optLevel = 0;
+    Compiler unoptimized(plain);
+    Compiler optimized;
+    std::vector<std::string> before = unoptimized.compile(source);
+    std::vector<std::string> after = optimized.compile(source);
+
+    if (optimized.hadError() || unoptimized.hadError()) {
+        std::cout << "Compilation Errors:" << std::endl;
+        for (const auto& error : optimized.getErrors()) {
+            std::cout << "  " << error << std::endl;
+        }
+        std::cout << "❌ FAILED: Expected program to compile" << std::endl;
+        return;
+    }
+
+    std::cout << "Optimized bytecode:" << std::endl;
+    for (size_t i = 0; i < after.size(); i++) {
+        std::cout << "  " << i << ": " << after[i] << std::endl;
+    }
+
+    if (!optimized.getStats().inlineDecisions.empty()) {
+        optimized.printInlineReport();
+    }
+
+    std::cout << "Execution (unoptimized, then optimized):" << std::endl;
+    std::cout << "----------------------------------------" << std::endl;
+    VM slow;
+    slow.trace = false;
+    slow.run(before);
+    VM fast;
+    fast.trace = false;
+    fast.run(after);
+    std::cout << "----------------------------------------" << std::endl;
+
+    std::cout << "instructions: " << before.size() << " -> " << after.size()
+              << ", LOADs: " << countOpcode(before, "LOAD") << " -> "
+              << countOpcode(after, "LOAD") << ", executed: " << slow.stats.instructions
+              << " -> " << fast.stats.instructions << std::endl;
+    if (optimized.getStats().safetyChecks > 0) {
+        std::cout << "safety checks removed: " << optimized.getStats().checksRemoved << " / "
+                  << optimized.getStats().safetyChecks << std::endl;
+    }
+    if (optimized.getStats().callsEvaluated + optimized.getStats().callsDeferred > 0) {
+        std::cout << "calls evaluated at compile time: " << optimized.getStats().callsEvaluated
+                  << " (" << optimized.getStats().callsDeferred << " left to run time)"
+                  << std::endl;
+    }
+    if (fast.stats.memoHits + fast.stats.memoMisses > 0) {
+        std::cout << "memo hits / misses: " << fast.stats.memoHits << " / "
+                  << fast.stats.memoMisses << std::endl;
+    }
+
+    // Loop passes may grow the code (unrolling, stores on loop exits):
+    // what must not grow is the work done
+    if (userVars(fast) == userVars(slow) && fast.stats.instructions <= slow.stats.instructions) {
+        std::cout << "✅ PASSED: Same result, no slower" << std::endl;
+    } else {
+        std::cout << "❌ FAILED: Optimized program differs" << std::endl;
+    }
+}
+
+/**
+ * Instrumented run → profile file → build optimized for it. Compared with
+ * the ordinary optimized build: same result, no more instructions.
+ */
+void testProfileGuided(const std::string& source, const std::string& description) {
+    std::cout << "\n=== " << description << " ===" << std::endl;
+    std::cout << "Source code:" << std::endl;
+    std::cout << source << std::endl;
+    std::cout << std::endl;
+
+    CompilerOptions instrumented;
+    instrumented.instrument = true;
+    Compiler recorder(instrumented);
+    std::vector<std::string> recording = recorder.compile(source);
+    Compiler optimized;
+    std::vector<std::string> before = optimized.compile(source);
+    if (recorder.hadError() || optimized.hadError()) {
+        std::cout << "❌ FAILED: Expected program to compile" << std::endl;
+        return;
+    }
+
+    std::cout << "Execution (instrumented, optimized, profile-guided):" << std::endl;
+    std::cout << "----------------------------------------" << std::endl;
+    VM profiler;
+    profiler.trace = false;
+    profiler.profiling = true;
+    profiler.run(recording);
+
+    std::string path = "test_optimizer.prof";
+    Profile profile;
+    if (!Profile::fromRun(profiler.profile, Bytecode::assemble(recording)).save(path) || !profile.load(path)) {
+        std::cout << "❌ FAILED: Profile did not survive the file" << std::endl;
+        return;
+    }
+    std::remove(path.c_str());
+
+    CompilerOptions guided;
+    guided.profile = &profile;
+    Compiler pgo(guided);
+    std::vector<std::string> after = pgo.compile(source);
+
+    VM plain;
+    plain.trace = false;
+    plain.run(before);
+    VM fast;
+    fast.trace = false;
+    fast.run(after);
+    std::cout << "----------------------------------------" << std::endl;
+
+    std::cout << "Profile-guided bytecode:" << std::endl;
+    for (size_t i = 0; i < after.size(); i++) {
+        std::cout << "  " << i << ": " << after[i] << std::endl;
+    }
+    pgo.printInlineReport();
+    std::cout << "profile: " << profile.instructionCount() << " instructions, blocks moved: "
+              << pgo.getStats().blocksMoved << ", superinstructions:";
+    for (const std::string& rule : pgo.getStats().superinstructions) {
+        std::cout << " " << rule;
+    }
+    std::cout << std::endl;
+    std::cout << "executed: " << plain.stats.instructions << " -> " << fast.stats.instructions
+              << std::endl;
+
+    if (userVars(fast) == userVars(plain) && userVars(profiler) == userVars(plain) &&
+        fast.stats.instructions <= plain.stats.instructions) {
+        std::cout << "✅ PASSED: Same result, no slower than the optimized build" << std::endl;
+    } else {
+        std::cout << "❌ FAILED: Profile-guided program differs or is slower" << std::endl;
+    }
+}
+
+/**
+ * The same program at -O0, -O1 and -O2: same result, each level runs no
+ * more instructions than -O0 and only the passes of its pipeline.
+ */
+void testLevels(const std::string& source, const std::string& description) {
+    std::cout << "\n=== " << description << " ===" << std::endl;
+    std::cout << "Source code:" << std::endl;
+    std::cout << source << std::endl;
+    std::cout << std::endl;
+
+    std::map<std::string, int> expected;
+    long long baseline = 0;
+    bool passed = true;
+    for (int level = 0; level <= 2; level++) {
+        CompilerOptions options;
+        options.optLevel = level;
+        Compiler compiler(options);
+        std::vector<std::string> bytecode = compiler.compile(source);
+        if (compiler.hadError()) {
+            std::cout << "❌ FAILED: Expected program to compile at -O" << level << std::endl;
+            return;
+        }
+
+        VM vm;
+        vm.trace = false;
+        vm.run(bytecode);
+        if (level == 0) {
+            expected = userVars(vm);
+            baseline = vm.stats.instructions;
+        }
+
+        int irPasses = 0;
+        bool hasLoopPasses = false;
+        std::cout << "-O" << level << ":";
+        for (const PassRecord& pass : compiler.getStats().passes) {
+            std::cout << " " << pass.name;
+            if (pass.name.compare(0, 3, "ir ") == 0) irPasses++;
+            if (pass.name == "ir licm") hasLoopPasses = true;
+        }
+        std::cout << std::endl;
+        std::cout << "  size " << bytecode.size() << ", executed " << vm.stats.instructions << std::endl;
+
+        bool pipeline = level == 0 ? irPasses == 0 : (level == 1) != hasLoopPasses;
+        if (!pipeline || userVars(vm) != expected || vm.stats.instructions > baseline) passed = false;
+    }
+
+    if (passed) {
+        std::cout << "✅ PASSED: Same result at every level, each pipeline as configured" << std::endl;
+    } else {
+        std::cout << "❌ FAILED: Levels differ" << std::endl;
+    }
+}
+
+// A SCENE reading its arguments with LOADARGU refuses host calls that
+// pass another count (VM::call checks the SCENE label's arity)
+void testHostCall(const std::string& source, const std::string& scene, int argc,
+                  const std::string& description) {
+    std::cout << "\n=== " << description << " ===" << std::endl;
+    Compiler compiler;
+    const Bytecode& program = compiler.compileProgram(source);
+    int unchecked = countOpcode(program.disassemble(), "LOADARGU");
+    VM vm;
+    vm.trace = false;
+    vm.run(program);
+    try {
+        vm.call(scene, argc);
+        std::cout << "❌ FAILED: " << scene << " called with " << argc << " arguments" << std::endl;
+    } catch (const std::exception& ex) {
+        if (unchecked > 0) {
+            std::cout << "✅ PASSED: " << unchecked << " LOADARGU, call refused: " << ex.what() << std::endl;
+        } else {
+            std::cout << "❌ FAILED: expected LOADARGU in " << scene << std::endl;
+        }
+    }
+}
+
+// What the VM writes to std::cerr (warnings) while running `program`
+static std::string diagnostics(const std::vector<std::string>& program, std::map<std::string, int>& vars) {
+    std::ostringstream captured;
+    std::streambuf* saved = std::cerr.rdbuf(captured.rdbuf());
+    VM vm;
+    vm.trace = false;
+    vm.run(program);
+    std::cerr.rdbuf(saved);
+    vars = userVars(vm);
+    return captured.str();
+}
+
+// -O2 must not warn where -O0 does not (a global read before it exists),
+// nor leave globals behind that -O0 never creates
+void testDiagnostics(const std::string& source, const std::string& description) {
+    std::cout << "\n=== " << description << " ===" << std::endl;
+    std::cout << "Source code:" << std::endl;
+    std::cout << source << std::endl;
+    std::cout << std::endl;
+
+    CompilerOptions plain;
+    plain.optLevel = 0;
+    Compiler unoptimized(plain);
+    Compiler optimized;
+    std::vector<std::string> before = unoptimized.compile(source);
+    std::vector<std::string> after = optimized.compile(source);
+    if (optimized.hadError() || unoptimized.hadError()) {
+        std::cout << "❌ FAILED: Expected program to compile" << std::endl;
+        return;
+    }
+
+    std::map<std::string, int> slowVars, fastVars;
+    std::string slow = diagnostics(before, slowVars);
+    std::string fast = diagnostics(after, fastVars);
+    if (slow == fast && slowVars == fastVars) {
+        std::cout << "✅ PASSED: Same diagnostics and globals at -O0 and -O2" << std::endl;
+    } else {
+        std::cout << "-O0 diagnostics:\n" << slow << "-O2 diagnostics:\n" << fast;
+        std::cout << "❌ FAILED: -O2 run differs" << std::endl;
+    }
+}
+
+void testError(const std::string& source, const std::string& description) {
+    std::cout << "\n=== " << description << " ===" << std::endl;
+    std::cout << "Source code:" << std::endl;
+    std::cout << source << std::endl;
+    std::cout << std::endl;
+
+    Compiler compiler;
+    compiler.compile(source);
+
+    if (compiler.hadError()) {
+        for (const auto& error : compiler.getErrors()) {
+            std::cout << "  " << error << std::endl;
+        }
+        std::cout << "✅ PASSED: Error detected" << std::endl;
+    } else {
+        std::cout << "❌ FAILED: Expected a compile error" << std::endl;
+    }
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "   CINEBREW Optimizer Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    // Test 1: Literal arithmetic in every numeric type
+    testOptimizer(
+        "TAKE a = (3 + 5) * 2 - 7 % 4;\n"
+        "TAKE f = 1.5 * 4.0;\n"
+        "TAKE q = 2.5q * 2;\n"
+        "TAKE b = (1 << 4) | 3 AND !0;\n"
+        "POUR a;\n"
+        "POUR f;\n"
+        "POUR q;\n"
+        "POUR b;",
+        "Test 1: Constant Folding (should print 13, 6, 5, 1)"
+    );
+
+    // Test 2: Pong-style key constants and frame code: no LOADs left for
+    // KEY_UP, SPEED or TOP, only for the state that really changes
+    testOptimizer(
+        "CONST SPEED = 5;\n"
+        "CONST TOP = 600 - 100;\n"
+        "TAKE KEY_UP = 82;\n"
+        "TAKE paddleY = 250;\n"
+        "SCENE update() {\n"
+        "    IF KEY_UP == 82 { paddleY = paddleY + SPEED * 2; }\n"
+        "    IF paddleY > TOP { paddleY = TOP; }\n"
+        "    SHOT 0;\n"
+        "}\n"
+        "update();\n"
+        "POUR paddleY;",
+        "Test 2: Constant Propagation (should print 260)"
+    );
+
+    // Test 3: Division by zero is left for the VM
+    testOptimizer(
+        "TAKE zero = 0;\n"
+        "TAKE x = 10 / zero;\n"
+        "POUR x;",
+        "Test 3: Division By Zero Not Folded"
+    );
+
+    // Test 4: Dead code - constant branches, the PUSH 0 / RET after SHOT
+    // and a SCENE nothing calls all disappear; update stays for the game loop
+    testOptimizer(
+        "CONST DEBUG = 0;\n"
+        "SCENE unused(a) { SHOT a * 2; }\n"
+        "SCENE helper(a) { SHOT a + 1; }\n"
+        "SCENE update() { SHOT 0; }\n"
+        "IF DEBUG { POUR 99; } ELSE { POUR helper(4); }\n"
+        "TAKE i = 0;\n"
+        "LOOP true { i = i + 1; IF i > 3 { BREAK; } }\n"
+        "POUR i;",
+        "Test 4: Dead Code Elimination (should print 5, 4)"
+    );
+
+    // Test 5: Peephole rewrites - NEG, DUP for x * x and STORE/LOAD,
+    // JNZ for the BREAK, JNZ for the == 0 test
+    testOptimizer(
+        "SCENE f(a) { SHOT -a + a * a; }\n"
+        "TAKE i = 0;\n"
+        "TAKE t = 0;\n"
+        "LOOP true {\n"
+        "    i = i + 1;\n"
+        "    t = t + f(i);\n"
+        "    IF i % 2 == 0 { t = t - 1; }\n"
+        "    IF i > 3 { BREAK; }\n"
+        "}\n"
+        "POUR t;",
+        "Test 5: Peephole Rules (should print 18)"
+    );
+
+    // Test 6: SSA IR - a reassigned parameter becomes phis in the loop
+    // and MATCH arms, kept in local slots instead of STOREARG / LOADARG
+    testOptimizer(
+        "SCENE collatz(n) {\n"
+        "    TAKE steps = 0;\n"
+        "    LOOP n != 1 {\n"
+        "        MATCH n % 2 {\n"
+        "            CASE 0 { n = n / 2; }\n"
+        "            ELSE { n = 3 * n + 1; }\n"
+        "        }\n"
+        "        steps = steps + 1;\n"
+        "    }\n"
+        "    SHOT steps;\n"
+        "}\n"
+        "SCENE pick(k) {\n"
+        "    MATCH k { CASE 1 { SHOT 10; } CASE 2 { SHOT 20; } CASE 3, 4 { SHOT 30; } ELSE { SHOT 0; } }\n"
+        "}\n"
+        "TAKE total = 0;\n"
+        "FOR i = 0 TO 5 { total = total + pick(i); }\n"
+        "POUR collatz(27);\n"
+        "POUR total;",
+        "Test 6: SSA IR (should print 111, 90)"
+    );
+
+    // Test 7: Inlining - small leaves and INLINE SCENEs disappear, the
+    // recursive and NOINLINE ones keep their CALL
+    testOptimizer(
+        "SCENE clamp(v) { IF v > 100 { SHOT 100; } SHOT v; }\n"
+        "SCENE twice(v) { SHOT clamp(v * 2); }\n"
+        "INLINE SCENE fib(n) { IF n < 2 { SHOT n; } SHOT fib(n - 1) + fib(n - 2); }\n"
+        "NOINLINE SCENE square(v) { SHOT v * v; }\n"
+        "INLINE SCENE mix(a, b) {\n"
+        "    TAKE s = 0;\n"
+        "    FOR k = 1 TO a { s = s + square(k) + b; }\n"
+        "    SHOT s;\n"
+        "}\n"
+        "POUR twice(30);\n"
+        "POUR twice(70);\n"
+        "POUR fib(10);\n"
+        "POUR mix(3, 1);",
+        "Test 7: Inlining (should print 60, 100, 55, 17)"
+    );
+
+    // Test 8: Loops - the inner FOR is unrolled, globals live in locals
+    // while the loops run, width + ... is hoisted and (i * 4 + width) * 2
+    // advances by 8 per iteration (BREAK must still store everything back)
+    testOptimizer(
+        "TAKE width = 7;\n"
+        "width = width + 1;\n"
+        "TAKE sum = 0;\n"
+        "TAKE hits = 0;\n"
+        "FOR y = 0 TO 9 {\n"
+        "    FOR x = 1 TO 3 { sum = sum + x * y; }\n"
+        "}\n"
+        "TAKE i = 0;\n"
+        "LOOP i < 50 {\n"
+        "    hits = hits + (i * 4 + width) * 2;\n"
+        "    IF hits > 5000 { BREAK; }\n"
+        "    i = i + 1;\n"
+        "}\n"
+        "POUR sum;\n"
+        "POUR hits;\n"
+        "POUR i;",
+        "Test 8: Loop Optimizer (should print 270, 5032, 33)"
+    );
+
+    // Test 9: Common subexpressions - (d * 3 + 4) * 2 and the frame-stable
+    // getScreenWidth() are computed once, d * 3 alone is not worth a slot
+    testOptimizer(
+        "TAKE d = 5;\n"
+        "d = d - 12;\n"
+        "TAKE a = (d * 3 + 4) * 2 + getScreenWidth();\n"
+        "TAKE b = d * 3;\n"
+        "IF a > 0 { b = b + (d * 3 + 4) * 2 - getScreenWidth(); }\n"
+        "ELSE { b = max((d * 3 + 4) * 2, 1); }\n"
+        "POUR a - getScreenWidth();\n"
+        "POUR b;",
+        "Test 9: Common Subexpressions (should print -34, -855)"
+    );
+
+    // Test 10: Ranges - every divisor but z is provably nonzero (DIVNZ /
+    // MODNZ: w > 0, d != 0, 1 <= i < 10, b % 8 + 9 >= 2), f's parameters
+    // are always passed (LOADARGU)
+    testOptimizer(
+        "NOINLINE SCENE f(a, b) { SHOT a / (b % 8 + 9); }\n"
+        "TAKE w = getScreenWidth() % 7 + 1;\n"
+        "TAKE s = 0;\n"
+        "IF w > 0 { s = 100 / w; }\n"
+        "TAKE d = keyPressed(32);\n"
+        "IF d != 0 { s = s + 50 / d; }\n"
+        "TAKE z = 0;\n"
+        "s = s + 7 / z;\n"
+        "TAKE i = 1;\n"
+        "LOOP i < 10 { s = s + 100 % i + w * 2; i = i + 1; }\n"
+        "POUR s + f(w, 3);",
+        "Test 10: Range Analysis (should print 99, division by zero once per run)"
+    );
+
+    // Test 11: Compile-time calls - factorial(10), gcd and what depends on
+    // them become literals; PRINT, globals (digits' TAKE c is one),
+    // keyPressed and a recursion deeper than the budget keep their calls
+    testOptimizer(
+        "SCENE factorial(n) { IF n <= 1 { SHOT 1; } SHOT n * factorial(n - 1); }\n"
+        "SCENE gcd(a, b) { LOOP a != b { IF a > b { a = a - b; } ELSE { b = b - a; } } SHOT a; }\n"
+        "SCENE digits(n) { TAKE c = 1; LOOP n >= 10 { n = n / 10; c = c + 1; } SHOT c; }\n"
+        "NOINLINE SCENE noisy(n) { POUR n; SHOT n + 1; }\n"
+        "NOINLINE SCENE pressed(k) { SHOT keyPressed(k) + k; }\n"
+        "NOINLINE SCENE sum(n) { IF n == 0 { SHOT 0; } SHOT n + sum(n - 1); }\n"
+        "TAKE size = factorial(10);\n"
+        "TAKE step = gcd(size, 1001) * abs(-2);\n"
+        "POUR size / step;\n"
+        "POUR digits(size);\n"
+        "POUR noisy(4);\n"
+        "POUR pressed(32);\n"
+        "POUR sum(20000);",
+        "Test 11: Compile-Time Calls (should print 259200, 7, 4, 5, 32, 200010000)"
+    );
+
+    // Test 12: Memoization - fib and the MEMO cost are pure and remember
+    // their results; walk reads a global and stays an ordinary recursion
+    testOptimizer(
+        "SCENE fib(n) { IF n < 2 { SHOT n; } SHOT fib(n - 1) + fib(n - 2); }\n"
+        "MEMO SCENE cost(x, y) { SHOT min(x * x + y, 1000) % 97; }\n"
+        "TAKE limit = 3;\n"
+        "SCENE walk(n) { IF n <= limit { SHOT n; } SHOT walk(n - 2) + 1; }\n"
+        "TAKE n = 20;\n"
+        "n = n + 2;\n"
+        "TAKE total = 0;\n"
+        "FOR i = 1 TO 40 { total = total + cost(i % 5, n); }\n"
+        "POUR fib(n);\n"
+        "POUR total;\n"
+        "POUR walk(n);",
+        "Test 12: Memoization (should print 17711, 1120, 12)"
+    );
+
+    // Test 13: Profile-guided - step is hot (inlined despite its size),
+    // the rare branches move out of the loop, the counter and the loop
+    // test become superinstructions
+    testProfileGuided(
+        "SCENE step(v) {\n"
+        "    IF v % 3 == 0 { SHOT v / 3; }\n"
+        "    IF v > 1000 { SHOT v - 1000; }\n"
+        "    SHOT v + 1;\n"
+        "}\n"
+        "TAKE total = 0;\n"
+        "TAKE n = 0;\n"
+        "LOOP n < 3000 {\n"
+        "    total = total + step(n);\n"
+        "    IF total < 0 { POUR 0 - 1; }\n"
+        "    n = n + 1;\n"
+        "}\n"
+        "POUR total;",
+        "Test 13: Profile-Guided Optimization (should print 2167167 three times)"
+    );
+
+    // Test 14: Optimization levels
+    testLevels(
+        "SCENE area(w, h) { SHOT w * h; }\n"
+        "TAKE total = 0;\n"
+        "FOR i = 1 TO 50 { total = total + area(i, 3) + getScreenWidth() / 8; }\n"
+        "POUR total;",
+        "Test 14: Optimization Levels (should print 8825 three times)"
+    );
+
+    // Test 15: A CONST must be computable
+    testError(
+        "CONST BAD = 1 / 0;",
+        "Test 15: CONST Division By Zero (should fail)"
+    );
+
+    // Test 16: The host cannot call past the proven argument count
+    testHostCall(
+        "NOINLINE SCENE f(a, b) { SHOT a * 10 + b; }\n"
+        "POUR f(getScreenWidth(), 2);",
+        "f", 1,
+        "Test 16: Host Calls Check Arity (should refuse f with 1 argument)"
+    );
+
+    // Test 17: Globals first assigned inside a loop are not promoted
+    testDiagnostics(
+        "TAKE a = 10;\n"
+        "TAKE b = 4;\n"
+        "LOOP b != 0 { TAKE t = a % b; a = b; b = t; }\n"
+        "NOINLINE SCENE gcd(x, y) {\n"
+        "    LOOP y != 0 { TAKE r = x % y; x = y; y = r; }\n"
+        "    SHOT x;\n"
+        "}\n"
+        "TAKE n = getScreenWidth() / 100;\n"
+        "IF n > 100 { TAKE late = 0; LOOP late < n { late = late + 1; } }\n"
+        "FOR i = 1 TO 3 { TAKE sum = 0; FOR j = 1 TO n { sum = sum + j; } }\n"
+        "POUR a;\n"
+        "POUR gcd(1071, 462);",
+        "Test 17: No New Diagnostics At -O2 (should print 2, 21)"
+    );
+
+    // Test 18: d is nonzero but may be -1, so INT_MIN / d keeps its check
+    testOptimizer(
+        "TAKE m = getScreenWidth() * 0 - 2147483647 - 1;\n"
+        "TAKE d = keyPressed(32) - 1;\n"
+        "IF d != 0 { POUR m / d; POUR m % d; }",
+        "Test 18: INT_MIN / -1 (should print -2147483648, 0)"
+    );
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "All tests completed!" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return 0;
+}
@@ -161,6 +161,65 @@ int main() {
         true
     );
     
+    // Test 11: FLOAT and FIXED do not mix implicitly
+    testSemantic(
+        "TAKE a = 1.5;\n"
+        "TAKE b = 2q;\n"
+        "TAKE c = a + b;",
+        "Test 11: Mixed Float and Fixed (should fail)",
+        false
+    );
+    
+    // Test 12: The FOR variable is read-only inside its loop
+    testSemantic(
+        "FOR i = 1 TO 10 {\n"
+        "    i = i + 1;\n"
+        "}",
+        "Test 12: Assign to FOR Variable (should fail)",
+        false
+    );
+    
+    // Test 13: A value may appear in only one CASE
+    testSemantic(
+        "TAKE s = 1;\n"
+        "MATCH s {\n"
+        "    CASE 1, 2 { POUR 1; }\n"
+        "    CASE 2 { POUR 2; }\n"
+        "}",
+        "Test 13: Duplicate CASE Value (should fail)",
+        false
+    );
+    
+    // Test 14: CONSTs cannot be reassigned
+    testSemantic(
+        "CONST SPEED = 5;\n"
+        "SPEED = 6;",
+        "Test 14: Assign To CONST (should fail)",
+        false
+    );
+    
+    // Test 15: MEMO needs a pure SCENE (this one reads a global)
+    testSemantic(
+        "TAKE scale = 3;\n"
+        "MEMO SCENE cost(x) {\n"
+        "    SHOT x * scale;\n"
+        "}",
+        "Test 15: MEMO On Impure SCENE (should fail)",
+        false
+    );
+    
+    // Test 16: CONSTs, parameters and pure built-ins keep a SCENE pure
+    testSemantic(
+        "CONST BASE = 10;\n"
+        "MEMO SCENE cost(x, y) {\n"
+        "    x = abs(x) + BASE;\n"
+        "    SHOT max(x, y);\n"
+        "}\n"
+        "POUR cost(-4, 2);",
+        "Test 16: MEMO On Pure SCENE (should pass)",
+        true
+    );
+    
     std::cout << "\n========================================" << std::endl;
     std::cout << "All tests completed!" << std::endl;
     std::cout << "========================================" << std::endl;